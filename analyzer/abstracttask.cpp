@@ -56,9 +56,6 @@
 #include "ui/taskgraph.h"
 #include "vtl/tlist.h"
 
-#define SCHED_HEIGHT ((double) 0.5)
-#define FLOOR_HEIGHT ((double) 0)
-
 #define ABSTRACT_TASK_TIME_ZERO vtl::Time(false, 0, 0, 6)
 
 AbstractTask::AbstractTask() :
@@ -72,17 +69,6 @@ AbstractTask::~AbstractTask()
 		delete graph;
 }
 
-bool AbstractTask::doScale()
-{
-	int i;
-	int s = schedData.size();
-	double schedScale = scale * SCHED_HEIGHT;
-	scaledSchedData.resize(s);
-	for (i = 0; i < s; i++)
-		scaledSchedData[i] = schedData.read(i) * schedScale + offset;
-	return false; /* No error */
-}
-
 bool AbstractTask::doStats()
 {
 	int startidx, endidx;
@@ -103,6 +89,8 @@ bool AbstractTask::doStats()
 		return false;
 	}
 
+	computeSchedAccTime();
+
 	start = startTime;
 	end = endTime;
 	delta = end - start;
@@ -166,15 +154,8 @@ bool AbstractTask::doStats()
 
 bool AbstractTask::doStatsTimeLimited()
 {
-	int startidx, endidx;
-	int i;
-	vtl::Time startIdxTime, endIdxTime;
 	vtl::Time delta;
 	int s = schedEventIdx.size();
-	unsigned int prevState;
-	vtl::Time prevTime;
-	vtl::Time t;
-	unsigned int state;
 
 	cursorTime = ABSTRACT_TASK_TIME_ZERO;
 	cursorPct = 0;
@@ -183,115 +164,84 @@ bool AbstractTask::doStatsTimeLimited()
 		return false;
 	}
 
+	/*
+	 * This is normally computed by doStats() but we may get here before
+	 * it has been called
+	 */
+	if (schedAccTime.size() != s)
+		computeSchedAccTime();
 
 	const vtl::Time &start = lowerTimeLimit;
 	const vtl::Time &end = higherTimeLimit;
 	delta = end - start;
 
-	vtl::Time firstTime = (*events)[schedEventIdx[0]].time;
-
-	if (s < 2) {
-		if (firstTime < start) {
-			if (schedData.read(0) == SCHED_BIT) {
-				cursorTime = delta;
-				cursorPct = 10000;
-			}
-			return false;
-		}
-		if (firstTime > end) {
-			return false;
-		}
-		if (schedData.read(0) == SCHED_BIT) {
-			cursorTime = end - firstTime;
-			cursorPct = (unsigned)
-				(10000 * (cursorTime.toDouble()
-					  / delta.toDouble() + 0.00005));
-		}
-		return false;
-	}
-
-	vtl::Time lastTime = (*events)[schedEventIdx[s - 1]].time;
-
-
-	if (lastTime < start)
-		return false;
-
-	if (firstTime > start) {
-		/* Normal case, do nothing */
-	}
-
-	if (lastTime < end) {
-		/* Normal case, Do nothing */
-	}
-
-	if (firstTime > end)
-		return false;
-
-	startidx = findLower(start);
-	endidx = findLower(end);
-
-	startIdxTime = (*events)[schedEventIdx[startidx]].time;
-
-	if (startIdxTime >= end)
-		return false;
-
-	if (startIdxTime < start)
-		prevTime = start;
-	else
-		prevTime = startIdxTime;
-	prevState = schedData.read(startidx);
-
-	for (i = startidx + 1; i <= endidx; i++) {
-		t = (*events)[schedEventIdx[i]].time;
-		state = schedData.read(i);
-		if (SCHED_BIT == prevState) {
-			cursorTime += t - prevTime;
-		}
-		prevTime = t;
-		prevState = state;
-	}
-
-	if (prevTime < end && prevState == SCHED_BIT) {
-		cursorTime += end - prevTime;
-	}
+	cursorTime = schedTimeUntil(end) - schedTimeUntil(start);
 	cursorPct = (unsigned) (10000 * (cursorTime.toDouble()
 					 / delta.toDouble() + 0.00005));
 	return false;
 }
 
-bool AbstractTask::doScaleRunning()
+/*
+ * This computes the schedAccTime vector, so that the time that the task is
+ * scheduled between two points in time can be found with two binary searches
+ * and a subtraction.
+ */
+void AbstractTask::computeSchedAccTime()
 {
-	return fillDataVector(runningTimev, scaledRunningData, nullptr,
-			      FLOOR_HEIGHT);
-}
+	int i;
+	int s = schedEventIdx.size();
+	vtl::Time acc = ABSTRACT_TASK_TIME_ZERO;
+	vtl::Time prevTime;
+	vtl::Time t;
+	unsigned int prevState;
 
-bool AbstractTask::doScalePreempted()
-{
-	return fillDataVector(preemptedTimev, scaledPreemptedData, nullptr,
-			      FLOOR_HEIGHT);
-}
+	schedAccTime.resize(s);
+	if (s < 1)
+		return;
 
-bool AbstractTask::doScaleUnint()
-{
-	return fillDataVector(uninterruptibleTimev, scaledUninterruptibleData,
-			      nullptr,  FLOOR_HEIGHT);
+	prevTime = (*events)[schedEventIdx[0]].time;
+	prevState = schedData.read(0);
+	schedAccTime[0] = acc;
+
+	for (i = 1; i < s; i++) {
+		t = (*events)[schedEventIdx[i]].time;
+		if (SCHED_BIT == prevState)
+			acc += t - prevTime;
+		schedAccTime[i] = acc;
+		prevTime = t;
+		prevState = schedData.read(i);
+	}
 }
 
-bool AbstractTask::doScaleWakeup()
+/*
+ * Returns the time that the task has been scheduled from the first element
+ * of schedEventIdx until time. If the task is scheduled after the last element
+ * of schedEventIdx, then it is assumed to remain scheduled.
+ */
+vtl::Time AbstractTask::schedTimeUntil(const vtl::Time &time)
 {
-	return fillDataVector(wakeDelay, wakeHeight, &wakeZero, WAKEUP_HEIGHT);
+	int idx;
+	vtl::Time acc;
+	vtl::Time idxtime = (*events)[schedEventIdx[0]].time;
+
+	if (time <= idxtime)
+		return ABSTRACT_TASK_TIME_ZERO;
+
+	idx = findLower(time);
+	idxtime = (*events)[schedEventIdx[idx]].time;
+	acc = schedAccTime[idx];
+	if (schedData.read(idx) == SCHED_BIT && idxtime < time)
+		acc += time - idxtime;
+	return acc;
 }
 
-bool  AbstractTask::fillDataVector(QVector<double> &timev,
-				   QVector<double> &data,
-				   QVector<double> *zerov,
-				   double height)
+/*
+ * The wakeup graphs are plotted with the heights of the graphs, so only the
+ * zero vector that is needed by the error bars is computed here.
+ */
+bool AbstractTask::doScaleWakeup()
 {
-	int s = timev.size();
-	double scaledHeight = height * scale + offset;
-	data.fill(scaledHeight, s);
-	if (zerov != nullptr)
-		zerov->fill(0, s);
+	wakeZero.fill(0, wakeDelay.size());
 	return false; /* No error */
 }
 
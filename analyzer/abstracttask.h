@@ -67,6 +67,9 @@ class TraceAnalyzer;
 #define SCHED_BIT 0x1
 #define FLOOR_BIT 0x0
 
+#define SCHED_HEIGHT ((double) 0.5)
+#define FLOOR_HEIGHT ((double) 0)
+
 namespace vtl {
 	template<class T> class TList;
 }
@@ -85,17 +88,17 @@ public:
 	QVector<double> schedTimev;
 	QVector<int>    schedEventIdx;
 	vtl::BitVector  schedData;
-	QVector<double> scaledSchedData;
+	/*
+	 * The accumulated time that the task has been scheduled, from the
+	 * first element of schedEventIdx until the corresponding element
+	 */
+	QVector<vtl::Time> schedAccTime;
 	QVector<double> wakeTimev;
 	QVector<double> wakeDelay;
-	QVector<double> wakeHeight;
 	QVector<double> wakeZero;
 	QVector<double> preemptedTimev;
 	QVector<double> runningTimev;
 	QVector<double> uninterruptibleTimev;
-	QVector<double> scaledPreemptedData;
-	QVector<double> scaledRunningData;
-	QVector<double> scaledUninterruptibleData;
 
 	vtl::Time accTime;             /* Total time consumption        */
 	unsigned  accPct;              /* Percentage of the above       */
@@ -105,17 +108,18 @@ public:
 	/* Only used during extraction */
 	bool isNew;
 
-	/* These are for scaling purposes */
+	/*
+	 * These are for scaling purposes. The graphs share the data vectors
+	 * above and apply the scaling when they are plotted.
+	 */
 	double offset;
 	double scale;
 
-	bool doScale();
 	bool doStats();
 	bool doStatsTimeLimited();
 	bool doScaleWakeup();
-	bool doScaleRunning();
-	bool doScalePreempted();
-	bool doScaleUnint();
+	vtl_always_inline double getSchedScale() const;
+	vtl_always_inline double getScaledHeight(double height) const;
 
 	static void setCursorTime(enum TShark::CursorIdx cursor,
 				  const vtl::Time &time);
@@ -129,8 +133,8 @@ private:
 	vtl_always_inline int binarySearch(const vtl::Time &time);
 	int findLower(const vtl::Time &time);
 	int findHigher(const vtl::Time &time);
-	bool fillDataVector(QVector<double> &timev, QVector<double> &data,
-			    QVector<double> *zerov, double height);
+	void computeSchedAccTime();
+	vtl::Time schedTimeUntil(const vtl::Time &time);
 protected:
 	static vtl::Time lowerTimeLimit;
 	static vtl::Time higherTimeLimit;
@@ -140,5 +144,17 @@ protected:
 	vtl::TList<TraceEvent> *events;
 };
 
+/* The factor that converts schedData to the height of the graph */
+vtl_always_inline double AbstractTask::getSchedScale() const
+{
+	return SCHED_HEIGHT * scale;
+}
+
+/* Returns the position of something that is drawn at height in the graph */
+vtl_always_inline double AbstractTask::getScaledHeight(double height) const
+{
+	return height * scale + offset;
+}
+
 #endif /* ABSTRACTTASK_H */
 
@@ -0,0 +1,875 @@
+// SPDX-License-Identifier: (GPL-2.0-or-later OR BSD-2-Clause)
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2020  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <climits>
+#include <cstring>
+
+#include "analyzer/argfilter.h"
+#include "parser/paramhelpers.h"
+
+typedef enum : int {
+	TOK_END = 0,
+	TOK_ERROR,
+	TOK_IDENT,
+	TOK_NUMBER,
+	TOK_STRING,
+	TOK_AND,
+	TOK_OR,
+	TOK_NOT,
+	TOK_LPAREN,
+	TOK_RPAREN,
+	TOK_LBRACE,
+	TOK_RBRACE,
+	TOK_COMMA,
+	TOK_CMP,
+	TOK_IN
+} token_t;
+
+/*
+ * A simple recursive descent parser for the following grammar:
+ *
+ * expr  := and ( "||" and )*
+ * and   := unary ( "&&" unary )*
+ * unary := "!" unary | "(" expr ")" | field cmpop value |
+ *          field "in" "{" value ( "," value )* "}"
+ * value := number | identifier | 'string' | "string"
+ */
+class ArgFilterParser {
+public:
+	ArgFilterParser(const QByteArray &e, QVector<ArgFilter::Node> &n);
+	int parse();
+	QString errmsg;
+private:
+	void next();
+	int parseOr();
+	int parseAnd();
+	int parseUnary();
+	int parseLeaf();
+	bool parseValue(ArgFilter::Node &node, bool inset);
+	bool resolveField(ArgFilter::Node &node);
+	int addNode(const ArgFilter::Node &node);
+	int error(const QString &msg);
+	const QByteArray &expr;
+	QVector<ArgFilter::Node> &nodes;
+	int pos;
+	token_t tok;
+	QByteArray tokstr;
+	ArgFilter::cmp_t tokcmp;
+};
+
+ArgFilterParser::ArgFilterParser(const QByteArray &e,
+				 QVector<ArgFilter::Node> &n):
+	expr(e), nodes(n), pos(0), tok(TOK_END),
+	tokcmp(ArgFilter::CMP_EQ)
+{}
+
+static vtl_always_inline bool is_ident_start(char c)
+{
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+static vtl_always_inline bool is_digit(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+/* Returns the value of a decimal or hexadecimal digit, or -1 */
+static vtl_always_inline int digit_value(char c)
+{
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	return -1;
+}
+
+/*
+ * Parses the integer in [c, end), which is decimal, or hexadecimal if it
+ * starts with 0x. Returns false if it is not a number or doesn't fit in a
+ * long long.
+ */
+static bool parse_int(const char *c, const char *end, long long &value)
+{
+	unsigned long long v = 0;
+	unsigned long long limit = LLONG_MAX;
+	unsigned int base = 10;
+	bool neg = false;
+	int d;
+
+	if (c < end && *c == '-') {
+		neg = true;
+		limit++;
+		c++;
+	}
+	if (end - c > 2 && c[0] == '0' && (c[1] == 'x' || c[1] == 'X')) {
+		base = 16;
+		c += 2;
+	}
+	if (c >= end)
+		return false;
+	for (; c < end; c++) {
+		d = digit_value(*c);
+		if (d < 0 || (unsigned int) d >= base)
+			return false;
+		if (v > (limit - d) / base)
+			return false;
+		v = v * base + d;
+	}
+	if (!neg)
+		value = (long long) v;
+	else if (v == limit)
+		value = LLONG_MIN;
+	else
+		value = -(long long) v;
+	return true;
+}
+
+void ArgFilterParser::next()
+{
+	int len = expr.size();
+	const char *s = expr.constData();
+	int start;
+	char c, quote;
+
+	while (pos < len && (s[pos] == ' ' || s[pos] == '\t'))
+		pos++;
+
+	tokstr.clear();
+	if (pos >= len) {
+		tok = TOK_END;
+		return;
+	}
+
+	c = s[pos];
+	start = pos;
+	if (is_ident_start(c)) {
+		while (pos < len && (is_ident_start(s[pos]) ||
+				     is_digit(s[pos])))
+			pos++;
+		tokstr = expr.mid(start, pos - start);
+		tok = (tokstr == "in") ? TOK_IN : TOK_IDENT;
+		return;
+	}
+	if (is_digit(c) ||
+	    (c == '-' && pos + 1 < len && is_digit(s[pos + 1]))) {
+		pos++;
+		while (pos < len && is_digit(s[pos]))
+			pos++;
+		tokstr = expr.mid(start, pos - start);
+		tok = TOK_NUMBER;
+		return;
+	}
+	if (c == '\'' || c == '"') {
+		quote = c;
+		pos++;
+		start = pos;
+		while (pos < len && s[pos] != quote)
+			pos++;
+		if (pos >= len) {
+			tok = TOK_ERROR;
+			return;
+		}
+		tokstr = expr.mid(start, pos - start);
+		pos++;
+		tok = TOK_STRING;
+		return;
+	}
+
+	pos++;
+	tok = TOK_CMP;
+	switch (c) {
+	case '&':
+		if (pos < len && s[pos] == '&') {
+			pos++;
+			tok = TOK_AND;
+			return;
+		}
+		break;
+	case '|':
+		if (pos < len && s[pos] == '|') {
+			pos++;
+			tok = TOK_OR;
+			return;
+		}
+		break;
+	case '(':
+		tok = TOK_LPAREN;
+		return;
+	case ')':
+		tok = TOK_RPAREN;
+		return;
+	case '{':
+		tok = TOK_LBRACE;
+		return;
+	case '}':
+		tok = TOK_RBRACE;
+		return;
+	case ',':
+		tok = TOK_COMMA;
+		return;
+	case '=':
+		if (pos < len && s[pos] == '=')
+			pos++;
+		tokcmp = ArgFilter::CMP_EQ;
+		return;
+	case '!':
+		if (pos < len && s[pos] == '=') {
+			pos++;
+			tokcmp = ArgFilter::CMP_NE;
+			return;
+		}
+		tok = TOK_NOT;
+		return;
+	case '<':
+		if (pos < len && s[pos] == '=') {
+			pos++;
+			tokcmp = ArgFilter::CMP_LE;
+			return;
+		}
+		tokcmp = ArgFilter::CMP_LT;
+		return;
+	case '>':
+		if (pos < len && s[pos] == '=') {
+			pos++;
+			tokcmp = ArgFilter::CMP_GE;
+			return;
+		}
+		tokcmp = ArgFilter::CMP_GT;
+		return;
+	default:
+		break;
+	}
+	tok = TOK_ERROR;
+}
+
+int ArgFilterParser::error(const QString &msg)
+{
+	if (errmsg.isEmpty())
+		errmsg = msg + QString(" at position ") + QString::number(pos);
+	return -1;
+}
+
+int ArgFilterParser::addNode(const ArgFilter::Node &node)
+{
+	nodes.append(node);
+	return nodes.size() - 1;
+}
+
+int ArgFilterParser::parse()
+{
+	int root;
+
+	next();
+	if (tok == TOK_END)
+		return error(QString("Empty expression"));
+	root = parseOr();
+	if (root < 0)
+		return -1;
+	if (tok != TOK_END)
+		return error(QString("Unexpected input"));
+	return root;
+}
+
+int ArgFilterParser::parseOr()
+{
+	ArgFilter::Node node;
+	int left, right;
+
+	left = parseAnd();
+	while (left >= 0 && tok == TOK_OR) {
+		next();
+		right = parseAnd();
+		if (right < 0)
+			return -1;
+		node.type = ArgFilter::NODE_OR;
+		node.left = left;
+		node.right = right;
+		left = addNode(node);
+	}
+	return left;
+}
+
+int ArgFilterParser::parseAnd()
+{
+	ArgFilter::Node node;
+	int left, right;
+
+	left = parseUnary();
+	while (left >= 0 && tok == TOK_AND) {
+		next();
+		right = parseUnary();
+		if (right < 0)
+			return -1;
+		node.type = ArgFilter::NODE_AND;
+		node.left = left;
+		node.right = right;
+		left = addNode(node);
+	}
+	return left;
+}
+
+int ArgFilterParser::parseUnary()
+{
+	ArgFilter::Node node;
+	int idx;
+
+	if (tok == TOK_NOT) {
+		next();
+		idx = parseUnary();
+		if (idx < 0)
+			return -1;
+		node.type = ArgFilter::NODE_NOT;
+		node.left = idx;
+		return addNode(node);
+	}
+	if (tok == TOK_LPAREN) {
+		next();
+		idx = parseOr();
+		if (idx < 0)
+			return -1;
+		if (tok != TOK_RPAREN)
+			return error(QString("Expected )"));
+		next();
+		return idx;
+	}
+	return parseLeaf();
+}
+
+int ArgFilterParser::parseLeaf()
+{
+	ArgFilter::Node node;
+
+	if (tok != TOK_IDENT)
+		return error(QString("Expected a field name"));
+	if (!resolveField(node))
+		return -1;
+	next();
+
+	if (tok == TOK_IN) {
+		node.type = ArgFilter::NODE_IN;
+		next();
+		if (tok != TOK_LBRACE)
+			return error(QString("Expected {"));
+		do {
+			next();
+			if (!parseValue(node, true))
+				return -1;
+			next();
+		} while (tok == TOK_COMMA);
+		if (tok != TOK_RBRACE)
+			return error(QString("Expected }"));
+		next();
+		return addNode(node);
+	}
+
+	if (tok != TOK_CMP)
+		return error(QString("Expected a comparison operator"));
+	node.type = ArgFilter::NODE_CMP;
+	node.cmp = tokcmp;
+	next();
+	if (!parseValue(node, false))
+		return -1;
+	next();
+	return addNode(node);
+}
+
+bool ArgFilterParser::resolveField(ArgFilter::Node &node)
+{
+	if (tokstr == "cpu")
+		node.field = ArgFilter::FIELD_CPU;
+	else if (tokstr == "pid")
+		node.field = ArgFilter::FIELD_PID;
+	else if (tokstr == "comm")
+		node.field = ArgFilter::FIELD_COMM;
+	else if (tokstr == "event")
+		node.field = ArgFilter::FIELD_EVENT;
+	else if (tokstr == "prev_pid")
+		node.field = ArgFilter::FIELD_PREV_PID;
+	else if (tokstr == "next_pid")
+		node.field = ArgFilter::FIELD_NEXT_PID;
+	else if (tokstr == "prev_state")
+		node.field = ArgFilter::FIELD_PREV_STATE;
+	else if (tokstr == "freq")
+		node.field = ArgFilter::FIELD_FREQ;
+	else {
+		node.field = ArgFilter::FIELD_ARG;
+		node.name = tokstr;
+		node.name.append('=');
+	}
+	return true;
+}
+
+/*
+ * Parses the current token as a value for the node. The type of the value
+ * depends on the field and for FIELD_ARG on the token.
+ */
+bool ArgFilterParser::parseValue(ArgFilter::Node &node, bool inset)
+{
+	bool isString;
+	bool ok;
+	long long value = 0;
+	int i, nr;
+	TString ts;
+	taskstate_t state;
+
+	if (tok != TOK_NUMBER && tok != TOK_IDENT && tok != TOK_STRING) {
+		error(QString("Expected a value"));
+		return false;
+	}
+	isString = tok != TOK_NUMBER;
+
+	switch (node.field) {
+	case ArgFilter::FIELD_CPU:
+	case ArgFilter::FIELD_PID:
+	case ArgFilter::FIELD_PREV_PID:
+	case ArgFilter::FIELD_NEXT_PID:
+	case ArgFilter::FIELD_FREQ:
+		if (isString) {
+			error(QString("Expected a number"));
+			return false;
+		}
+		break;
+	case ArgFilter::FIELD_COMM:
+		isString = true;
+		break;
+	case ArgFilter::FIELD_EVENT:
+		/* Event names are translated to event types */
+		nr = TraceEvent::getNrEvents();
+		for (i = 0; i < nr; i++) {
+			const TString *name = TraceEvent::getEventName(
+				(event_t) i);
+			if (name != nullptr && name->len == tokstr.size() &&
+			    !strncmp(name->ptr, tokstr.constData(), name->len))
+				break;
+		}
+		if (i >= nr) {
+			error(QString("Unknown event ") +
+			      QString(tokstr.constData()));
+			return false;
+		}
+		isString = false;
+		value = i;
+		goto store;
+	case ArgFilter::FIELD_PREV_STATE:
+		ts.ptr = tokstr.data();
+		ts.len = tokstr.size();
+		state = sched_state_from_tstring_(&ts);
+		if (state == TASK_STATE_PARSER_ERROR) {
+			error(QString("Invalid task state ") +
+			      QString(tokstr.constData()));
+			return false;
+		}
+		isString = false;
+		value = state;
+		goto store;
+	case ArgFilter::FIELD_ARG:
+	default:
+		break;
+	}
+
+	if (!isString) {
+		value = tokstr.toLongLong(&ok);
+		if (!ok) {
+			error(QString("Invalid number"));
+			return false;
+		}
+	}
+
+store:
+	if (isString && !inset && node.cmp != ArgFilter::CMP_EQ &&
+	    node.cmp != ArgFilter::CMP_NE) {
+		error(QString("Only == and != can be used with strings"));
+		return false;
+	}
+	if (inset && node.set.size() + node.strset.size() > 0 &&
+	    isString != node.isString) {
+		error(QString("Mixed value types in set"));
+		return false;
+	}
+	if ((node.field == ArgFilter::FIELD_EVENT ||
+	     node.field == ArgFilter::FIELD_PREV_STATE) && !inset &&
+	    node.cmp != ArgFilter::CMP_EQ && node.cmp != ArgFilter::CMP_NE) {
+		error(QString("Only == and != can be used with this field"));
+		return false;
+	}
+
+	node.isString = isString;
+	if (inset) {
+		if (isString)
+			node.strset.append(tokstr);
+		else
+			node.set.append(value);
+	} else {
+		if (isString)
+			node.str = tokstr;
+		else
+			node.value = value;
+	}
+	return true;
+}
+
+ArgFilter::Node::Node():
+	type(NODE_FALSE), left(-1), right(-1), field(FIELD_CPU), cmp(CMP_EQ),
+	isString(false), value(0), argIndex(-1)
+{}
+
+ArgFilter::ArgFilter():
+	nrTypes(0), ttype(TRACE_TYPE_FTRACE)
+{}
+
+bool ArgFilter::compile(const QString &expr, tracetype_t tt, QString *errmsg)
+{
+	QVector<Node> tree;
+	QByteArray bytes = expr.toLocal8Bit();
+	ArgFilterParser parser(bytes, tree);
+	Node constNode;
+	int root;
+	int type;
+
+	root = parser.parse();
+	if (root < 0) {
+		if (errmsg != nullptr)
+			*errmsg = parser.errmsg;
+		return false;
+	}
+
+	clear();
+	ttype = tt;
+	nrTypes = TraceEvent::getNrEvents();
+
+	/* The constants false and true are always at index 0 and 1 */
+	constNode.type = NODE_FALSE;
+	code.append(constNode);
+	constNode.type = NODE_TRUE;
+	code.append(constNode);
+
+	/* The last root is for events with an unknown type */
+	typeRoot.resize(nrTypes + 1);
+	for (type = 0; type <= nrTypes; type++)
+		typeRoot[type] = specialize(tree, root, type);
+	return true;
+}
+
+void ArgFilter::clear()
+{
+	code.clear();
+	typeRoot.clear();
+	nrTypes = 0;
+}
+
+bool ArgFilter::isEmpty() const
+{
+	return typeRoot.isEmpty();
+}
+
+bool ArgFilter::fieldApplies(field_t field, int type)
+{
+	switch (field) {
+	case FIELD_PREV_PID:
+	case FIELD_NEXT_PID:
+	case FIELD_PREV_STATE:
+		return type == SCHED_SWITCH;
+	case FIELD_FREQ:
+		return type == CPU_FREQUENCY;
+	default:
+		return true;
+	}
+}
+
+/*
+ * Copies the subtree at idx of tree into code, while folding away all
+ * comparisons that can be decided by knowing that the event type is type.
+ * Returns the index of the copy in code.
+ */
+int ArgFilter::specialize(const QVector<Node> &tree, int idx, int type)
+{
+	const Node &node = tree[idx];
+	Node copy;
+	bool match;
+	int left, right;
+
+	switch (node.type) {
+	case NODE_AND:
+		left = specialize(tree, node.left, type);
+		if (left == NODE_FALSE)
+			return NODE_FALSE;
+		right = specialize(tree, node.right, type);
+		if (right == NODE_FALSE)
+			return NODE_FALSE;
+		if (left == NODE_TRUE)
+			return right;
+		if (right == NODE_TRUE)
+			return left;
+		break;
+	case NODE_OR:
+		left = specialize(tree, node.left, type);
+		if (left == NODE_TRUE)
+			return NODE_TRUE;
+		right = specialize(tree, node.right, type);
+		if (right == NODE_TRUE)
+			return NODE_TRUE;
+		if (left == NODE_FALSE)
+			return right;
+		if (right == NODE_FALSE)
+			return left;
+		break;
+	case NODE_NOT:
+		left = specialize(tree, node.left, type);
+		if (left == NODE_FALSE)
+			return NODE_TRUE;
+		if (left == NODE_TRUE)
+			return NODE_FALSE;
+		right = -1;
+		break;
+	case NODE_CMP:
+	case NODE_IN:
+		if (!fieldApplies(node.field, type))
+			return NODE_FALSE;
+		if (node.field == FIELD_EVENT) {
+			if (node.type == NODE_IN)
+				match = node.set.contains(type);
+			else if (node.cmp == CMP_EQ)
+				match = node.value == type;
+			else
+				match = node.value != type;
+			return match ? NODE_TRUE : NODE_FALSE;
+		}
+		code.append(node);
+		return code.size() - 1;
+	default:
+		return node.type == NODE_TRUE ? NODE_TRUE : NODE_FALSE;
+	}
+
+	copy.type = node.type;
+	copy.left = left;
+	copy.right = right;
+	code.append(copy);
+	return code.size() - 1;
+}
+
+bool ArgFilter::eval(int idx, Context &ctx) const
+{
+	const Node &node = code[idx];
+
+	switch (node.type) {
+	case NODE_FALSE:
+		return false;
+	case NODE_TRUE:
+		return true;
+	case NODE_AND:
+		return eval(node.left, ctx) && eval(node.right, ctx);
+	case NODE_OR:
+		return eval(node.left, ctx) || eval(node.right, ctx);
+	case NODE_NOT:
+		return !eval(node.left, ctx);
+	case NODE_CMP:
+	case NODE_IN:
+		return evalLeaf(node, ctx);
+	default:
+		return false;
+	}
+}
+
+bool ArgFilter::evalLeaf(const Node &node, Context &ctx) const
+{
+	const char *str;
+	int len;
+	int i, s;
+	long long value;
+	bool eq;
+
+	if (node.isString) {
+		if (!getString(node, ctx, str, len))
+			return false;
+		if (node.type == NODE_IN) {
+			s = node.strset.size();
+			for (i = 0; i < s; i++) {
+				const QByteArray &b = node.strset[i];
+				if (b.size() == len &&
+				    !strncmp(b.constData(), str, len))
+					return true;
+			}
+			return false;
+		}
+		eq = node.str.size() == len &&
+			!strncmp(node.str.constData(), str, len);
+		return node.cmp == CMP_EQ ? eq : !eq;
+	}
+
+	if (!getInt(node, ctx, value))
+		return false;
+	if (node.type == NODE_IN)
+		return node.set.contains(value);
+
+	switch (node.cmp) {
+	case CMP_EQ:
+		return value == node.value;
+	case CMP_NE:
+		return value != node.value;
+	case CMP_LT:
+		return value < node.value;
+	case CMP_LE:
+		return value <= node.value;
+	case CMP_GT:
+		return value > node.value;
+	case CMP_GE:
+		return value >= node.value;
+	default:
+		return false;
+	}
+}
+
+/* The sched_switch arguments are parsed at most once per event */
+bool ArgFilter::switchParsed(Context &ctx)
+{
+	if (!ctx.swParsed) {
+		ctx.swOK = sched_switch_parse(ctx.ttype, ctx.event,
+					      ctx.swHandle);
+		ctx.swParsed = true;
+	}
+	return ctx.swOK;
+}
+
+const TString *ArgFilter::findArg(const TraceEvent &event,
+				  const Node &node)
+{
+	const char *name = node.name.constData();
+	int nlen = node.name.size();
+	int i = node.argIndex.loadAcquire();
+	const TString *arg;
+
+	if (i >= 0 && i < event.argc) {
+		arg = event.argv[i];
+		if (arg->len >= nlen && !strncmp(arg->ptr, name, nlen))
+			return arg;
+	}
+
+	for (i = 0; i < event.argc; i++) {
+		arg = event.argv[i];
+		if (arg->len >= nlen && !strncmp(arg->ptr, name, nlen)) {
+			node.argIndex.storeRelease(i);
+			return arg;
+		}
+	}
+	return nullptr;
+}
+
+bool ArgFilter::getInt(const Node &node, Context &ctx, long long &value)
+{
+	const TString *arg;
+
+	switch (node.field) {
+	case FIELD_CPU:
+		value = ctx.event.cpu;
+		return true;
+	case FIELD_PID:
+		value = ctx.event.pid;
+		return true;
+	case FIELD_PREV_PID:
+		if (!switchParsed(ctx))
+			return false;
+		value = sched_switch_handle_oldpid(ctx.ttype, ctx.event,
+						   ctx.swHandle);
+		return true;
+	case FIELD_NEXT_PID:
+		if (!switchParsed(ctx))
+			return false;
+		value = sched_switch_handle_newpid(ctx.ttype, ctx.event,
+						   ctx.swHandle);
+		return true;
+	case FIELD_PREV_STATE:
+		if (!switchParsed(ctx))
+			return false;
+		value = sched_switch_handle_state(ctx.ttype, ctx.event,
+						  ctx.swHandle);
+		return true;
+	case FIELD_FREQ:
+		if (!cpufreq_args_ok(ctx.ttype, ctx.event))
+			return false;
+		value = cpufreq_freq(ctx.ttype, ctx.event);
+		return true;
+	case FIELD_ARG:
+		arg = findArg(ctx.event, node);
+		if (arg == nullptr)
+			return false;
+		return parse_int(arg->ptr + node.name.size(),
+				 arg->ptr + arg->len, value);
+	default:
+		return false;
+	}
+}
+
+bool ArgFilter::getString(const Node &node, Context &ctx, const char *&str,
+			  int &len)
+{
+	const TString *arg;
+
+	switch (node.field) {
+	case FIELD_COMM:
+		if (ctx.event.taskName == nullptr)
+			return false;
+		str = ctx.event.taskName->ptr;
+		len = ctx.event.taskName->len;
+		return true;
+	case FIELD_ARG:
+		arg = findArg(ctx.event, node);
+		if (arg == nullptr)
+			return false;
+		str = arg->ptr + node.name.size();
+		len = arg->len - node.name.size();
+		return true;
+	default:
+		return false;
+	}
+}
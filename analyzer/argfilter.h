@@ -0,0 +1,185 @@
+// SPDX-License-Identifier: (GPL-2.0-or-later OR BSD-2-Clause)
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2020  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ARGFILTER_H
+#define ARGFILTER_H
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+#include "parser/genericparams.h"
+#include "parser/traceevent.h"
+#include "misc/traceshark.h"
+#include "vtl/compiler.h"
+
+/*
+ * The argument filter filters events with an expression such as:
+ *
+ * prev_state == D && next_pid in {123, 456}
+ * freq > 2000000 || event == cpu_idle
+ * comm != swapper && !(target_cpu == 3)
+ *
+ * The fields cpu, pid, comm and event refer to the event itself. The fields
+ * prev_pid, next_pid, prev_state and freq are parsed from the arguments of
+ * sched_switch and cpu_frequency events. Any other name refers to an argument
+ * of the form name=value. A comparison with a field that the event does not
+ * have is always false.
+ *
+ * The expression is compiled into a tree, which is then specialized for each
+ * event type, so that all comparisons that can be decided by the event type
+ * alone are folded away before any events are evaluated.
+ */
+class ArgFilter {
+public:
+	typedef enum : int {
+		FIELD_CPU = 0,
+		FIELD_PID,
+		FIELD_COMM,
+		FIELD_EVENT,
+		FIELD_PREV_PID,
+		FIELD_NEXT_PID,
+		FIELD_PREV_STATE,
+		FIELD_FREQ,
+		FIELD_ARG
+	} field_t;
+	typedef enum : int {
+		NODE_FALSE = 0,
+		NODE_TRUE,
+		NODE_AND,
+		NODE_OR,
+		NODE_NOT,
+		NODE_CMP,
+		NODE_IN
+	} node_t;
+	typedef enum : int {
+		CMP_EQ = 0,
+		CMP_NE,
+		CMP_LT,
+		CMP_LE,
+		CMP_GT,
+		CMP_GE
+	} cmp_t;
+	class Node {
+	public:
+		Node();
+		node_t type;
+		int left;
+		int right;
+		field_t field;
+		cmp_t cmp;
+		bool isString;
+		long long value;
+		QVector<long long> set;
+		QByteArray str;
+		QVector<QByteArray> strset;
+		/* The argument name with '=' appended, used with FIELD_ARG */
+		QByteArray name;
+		/*
+		 * The index in argv where the argument was last found. The
+		 * nodes are specialized for one event type, so it is nearly
+		 * always at the same index. It is only a hint, which is
+		 * checked before it is used, so the races of the filtering
+		 * threads are harmless.
+		 */
+		mutable QAtomicInt argIndex;
+	};
+	ArgFilter();
+	bool compile(const QString &expr, tracetype_t ttype, QString *errmsg);
+	void clear();
+	bool isEmpty() const;
+	vtl_always_inline bool match(const TraceEvent &event) const;
+private:
+	class Context {
+	public:
+		vtl_always_inline Context(const TraceEvent &e, tracetype_t tt);
+		const TraceEvent &event;
+		tracetype_t ttype;
+		bool swParsed;
+		bool swOK;
+		sched_switch_handle_t swHandle;
+	};
+	int specialize(const QVector<Node> &tree, int idx, int type);
+	bool eval(int idx, Context &ctx) const;
+	bool evalLeaf(const Node &node, Context &ctx) const;
+	static bool fieldApplies(field_t field, int type);
+	static bool getInt(const Node &node, Context &ctx, long long &value);
+	static bool getString(const Node &node, Context &ctx, const char *&str,
+			      int &len);
+	static bool switchParsed(Context &ctx);
+	static const TString *findArg(const TraceEvent &event,
+				      const Node &node);
+	/* The specialized trees of all event types are stored in code */
+	QVector<Node> code;
+	/* The root in code of each event type, the last is for unknown types */
+	QVector<int> typeRoot;
+	int nrTypes;
+	tracetype_t ttype;
+};
+
+vtl_always_inline ArgFilter::Context::Context(const TraceEvent &e,
+					      tracetype_t tt):
+	event(e), ttype(tt), swParsed(false), swOK(false)
+{}
+
+vtl_always_inline bool ArgFilter::match(const TraceEvent &event) const
+{
+	int type = event.type;
+	Context ctx(event, ttype);
+
+	if (type < 0 || type >= nrTypes)
+		type = nrTypes;
+	return eval(typeRoot[type], ctx);
+}
+
+#endif /* ARGFILTER_H */
@@ -53,6 +53,9 @@
 #ifndef CPU_H
 #define CPU_H
 
+#include <QVector>
+
+#include "analyzer/latencyhistogram.h"
 #include "vtl/time.h"
 
 class CPU {
@@ -68,6 +71,16 @@ public:
 
 	vtl::Time lastEnterIdle;
 	vtl::Time lastExitIdle;
+
+	/* The wakeup latencies of all tasks scheduled on this CPU */
+	QVector<double> wakeTimev;
+	QVector<double> wakeDelay;
+	LatencyIndex wakeLatency;
+
+	bool doLatencyStats() {
+		wakeLatency.build(wakeDelay);
+		return false; /* No error */
+	}
 };
 
 #endif /* CPU_H */
@@ -59,10 +59,9 @@ class CpuFreq {
 public:
 	QVector<double> timev;
 	QVector<double> data;
-	QVector<double> scaledData;
+	/* These are applied when the data is plotted */
 	double offset;
 	double scale;
-	bool doScale();
 };
 
 #endif /* CPUFREQ_H*/
@@ -59,10 +59,9 @@ class CpuIdle {
 public:
 	QVector<double> timev;
 	QVector<double> data;
-	QVector<double> scaledData;
+	/* These are applied when the data is plotted */
 	double offset;
 	double scale;
-	bool doScale();
 };
 
 #endif /* CPUIDLE_H */
@@ -55,7 +55,10 @@
 #include "analyzer/traceanalyzer.h"
 
 CPUTask::CPUTask() :
-	AbstractTask()
+	AbstractTask(), horizontalWakeupGraph(nullptr),
+	horizontalErrorBars(nullptr), verticalWakeupGraph(nullptr),
+	verticalErrorBars(nullptr), preemptedGraph(nullptr),
+	runningGraph(nullptr), uninterruptibleGraph(nullptr)
 {}
 
 bool CPUTask::doScaleWakeup() {
@@ -71,6 +74,21 @@ bool CPUTask::doScaleWakeup() {
 	return AbstractTask::doScaleWakeup();
 }
 
+/* The pyramid doesn't depend on the scaling, so it's only built once */
+bool CPUTask::doSchedLOD()
+{
+	if (!schedLOD.isBuilt())
+		schedLOD.build(schedTimev, schedData, startTime.toDouble(),
+			       endTime.toDouble());
+	return false; /* No error */
+}
+
+void CPUTask::getLODData(int level, QVector<double> &keys,
+			 QVector<double> &values) const
+{
+	schedLOD.levelData(level, offset, scale * SCHED_HEIGHT, keys, values);
+}
+
 void CPUTask::setVerticalWakeupMAX(int w)
 {
 	wakeup_max = (double) w / 1000;
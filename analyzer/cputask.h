@@ -55,12 +55,32 @@
 
 #include <QVector>
 #include "analyzer/abstracttask.h"
+#include "analyzer/schedlod.h"
+
+class QCPErrorBars;
+class QCPGraph;
 
 class CPUTask: public AbstractTask {
 public:
 	CPUTask();
 	QVector<double> verticalDelay;
 	bool doScaleWakeup();
+	bool doSchedLOD();
+	void getLODData(int level, QVector<double> &keys,
+			QVector<double> &values) const;
+	/* The level-of-detail pyramid of the scheduling graph */
+	SchedLOD schedLOD;
+	/*
+	 * Pointers to the accessory graphs of the scheduling graph, so that
+	 * changed settings can be applied to them without rebuilding the plot
+	 */
+	QCPGraph *horizontalWakeupGraph;
+	QCPErrorBars *horizontalErrorBars;
+	QCPGraph *verticalWakeupGraph;
+	QCPErrorBars *verticalErrorBars;
+	QCPGraph *preemptedGraph;
+	QCPGraph *runningGraph;
+	QCPGraph *uninterruptibleGraph;
 	static void setVerticalWakeupMAX(int w);
 private:
 	static double wakeup_max;
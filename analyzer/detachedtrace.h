@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: (GPL-2.0-or-later OR BSD-2-Clause)
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2020  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef DETACHEDTRACE_H
+#define DETACHEDTRACE_H
+
+#include <QList>
+#include <QVector>
+
+#include "vtl/avltree.h"
+#include "vtl/tlist.h"
+
+#include "analyzer/cpu.h"
+#include "analyzer/cpufreq.h"
+#include "analyzer/cpuidle.h"
+#include "analyzer/cputask.h"
+#include "analyzer/migration.h"
+#include "analyzer/task.h"
+#include "analyzer/tcolor.h"
+#include "parser/traceevent.h"
+
+/*
+ * This class holds the data structures of a trace that has been closed. Freeing
+ * them is slow for large traces, since it means that every Task and CPUTask
+ * must be deleted and that all the maps of the event lists must be unmapped.
+ * The TraceAnalyzer therefore moves them here when it is closed and lets a
+ * background thread call free(), so that the next trace can be opened
+ * immediately.
+ */
+class DetachedTrace {
+public:
+	DetachedTrace();
+	~DetachedTrace();
+	void free();
+	vtl::AVLTree<int, CPUTask, vtl::AVLBALANCE_USEPOINTERS> *cpuTaskMaps;
+	vtl::AVLTree<int, TaskHandle> taskMap;
+	vtl::AVLTree<int, TColor> colorMap;
+	CpuFreq *cpuFreq;
+	CpuIdle *cpuIdle;
+	CPU *CPUs;
+	QList<Migration> migrations;
+	QVector<double> wakeTimev;
+	QVector<double> wakeDelay;
+	vtl::TList<TraceEvent> *ftraceEvents;
+	vtl::TList<TraceEvent> *perfEvents;
+};
+
+#endif /* DETACHEDTRACE_H */
@@ -0,0 +1,471 @@
+// SPDX-License-Identifier: (GPL-2.0-or-later OR BSD-2-Clause)
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2020  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <algorithm>
+#include <cmath>
+
+#include "analyzer/eventrateindex.h"
+#include "misc/traceshark.h"
+#include "parser/traceevent.h"
+
+/* The width of the buckets, in seconds, unless the memory budget is exceeded */
+#define BASE_BUCKET_WIDTH (0.00001)
+
+EventRateCounts::EventRateCounts():
+	allocated(0)
+{}
+
+EventRateCounts::~EventRateCounts()
+{
+	clear();
+}
+
+void EventRateCounts::clear()
+{
+	int c, s;
+
+	s = chunks.size();
+	for (c = 0; c < s; c++)
+		delete[] chunks[c];
+	chunks.clear();
+	allocated = 0;
+}
+
+quint32 *EventRateCounts::allocChunk(int c)
+{
+	chunks[c] = new quint32[CHUNK_SIZE]();
+	allocated++;
+	return chunks[c];
+}
+
+/* Adds the counts of other to these counts, which must have the same width */
+void EventRateCounts::add(const EventRateCounts &other)
+{
+	const quint32 *src;
+	quint32 *dst;
+	int c, i, s;
+
+	s = other.chunks.size();
+	if (s > chunks.size())
+		chunks.resize(s);
+	for (c = 0; c < s; c++) {
+		src = other.chunks[c];
+		if (src == nullptr)
+			continue;
+		dst = chunks[c];
+		if (dst == nullptr)
+			dst = allocChunk(c);
+		for (i = 0; i < CHUNK_SIZE; i++)
+			dst[i] += src[i];
+	}
+}
+
+/* Replaces these counts with the pairwise sums of the buckets of finer */
+void EventRateCounts::halve(const EventRateCounts &finer)
+{
+	const int half = CHUNK_SIZE / 2;
+	const quint32 *a, *b;
+	quint32 *dst;
+	int c, i, s;
+
+	clear();
+	s = (finer.nrChunks() + 1) / 2;
+	chunks.resize(s);
+	for (c = 0; c < s; c++) {
+		a = finer.getChunk(2 * c);
+		b = finer.getChunk(2 * c + 1);
+		if (a == nullptr && b == nullptr)
+			continue;
+		dst = allocChunk(c);
+		if (a != nullptr) {
+			for (i = 0; i < half; i++)
+				dst[i] = a[2 * i] + a[2 * i + 1];
+		}
+		if (b != nullptr) {
+			for (i = 0; i < half; i++)
+				dst[half + i] = b[2 * i] + b[2 * i + 1];
+		}
+	}
+}
+
+/* Doubles the width of the buckets by merging them pairwise */
+void EventRateCounts::coarsen()
+{
+	EventRateCounts coarser;
+
+	coarser.halve(*this);
+	chunks.swap(coarser.chunks);
+	std::swap(allocated, coarser.allocated);
+}
+
+size_t EventRateCounts::memoryUsage() const
+{
+	return chunks.size() * sizeof(quint32*) +
+		allocated * CHUNK_SIZE * sizeof(quint32);
+}
+
+EventRateSeries::EventRateSeries(int cpu_, int type_):
+	cpu(cpu_), type(type_)
+{
+	levels.append(new EventRateCounts());
+}
+
+EventRateSeries::~EventRateSeries()
+{
+	int i, s;
+
+	s = levels.size();
+	for (i = 0; i < s; i++)
+		delete levels[i];
+}
+
+EventRateIndex::EventRateIndex():
+	tableCPUs(0), tableTypes(0), startTime(0), endTime(0),
+	width(BASE_BUCKET_WIDTH), scale(1 / BASE_BUCKET_WIDTH), memoryUsed(0),
+	memoryLimit(MEMORY_BUDGET), finished(false)
+{}
+
+EventRateIndex::~EventRateIndex()
+{
+	clear();
+}
+
+void EventRateIndex::clear()
+{
+	int i, s;
+
+	s = series.size();
+	for (i = 0; i < s; i++)
+		delete series[i];
+	series.clear();
+	seriesTable.clear();
+	table.clear();
+	tableCPUs = 0;
+	tableTypes = 0;
+	startTime = 0;
+	endTime = 0;
+	width = BASE_BUCKET_WIDTH;
+	scale = 1 / BASE_BUCKET_WIDTH;
+	memoryUsed = 0;
+	memoryLimit = MEMORY_BUDGET;
+	finished = false;
+}
+
+/* Starts counting with the first bucket at time */
+void EventRateIndex::start(double time)
+{
+	clear();
+	startTime = time;
+	/* The known event types of the first CPU, so that add() rarely grows */
+	growTable(0, EVENT_UNKNOWN);
+}
+
+EventRateSeries *EventRateIndex::getSeries(int cpu, int type)
+{
+	int c = cpu + 1;
+	int t = type + 1;
+
+	if (c >= seriesTable.size())
+		seriesTable.resize(c + 1);
+	QVector<EventRateSeries*> &row = seriesTable[c];
+	if (t >= row.size())
+		row.resize(t + 1);
+	if (row[t] == nullptr) {
+		row[t] = new EventRateSeries(cpu, type);
+		series.append(row[t]);
+	}
+	return row[t];
+}
+
+const EventRateSeries *EventRateIndex::findSeries(int cpu, int type) const
+{
+	int c = cpu + 1;
+	int t = type + 1;
+
+	if (c < 0 || c >= seriesTable.size() || t < 0 ||
+	    t >= seriesTable[c].size())
+		return nullptr;
+	return seriesTable[c][t];
+}
+
+/*
+ * Makes room in the table for cpu and type. This only happens when a CPU or
+ * an event type is seen for the first time.
+ */
+void EventRateIndex::growTable(unsigned int cpu, int type)
+{
+	unsigned int cpus = TSMAX(tableCPUs, cpu + 1);
+	int types = TSMAX(tableTypes, type + 1);
+	unsigned int c;
+	int t;
+
+	table.resize(cpus * types);
+	for (c = 0; c < cpus; c++) {
+		for (t = 0; t < types; t++)
+			table[c * types + t] = getSeries(c, t)->levels[0];
+	}
+	tableCPUs = cpus;
+	tableTypes = types;
+}
+
+void EventRateIndex::updateMemoryUsage()
+{
+	int i, j, s;
+
+	memoryUsed = 0;
+	s = series.size();
+	for (i = 0; i < s; i++) {
+		const QVector<EventRateCounts*> &levels = series[i]->levels;
+		for (j = 0; j < levels.size(); j++)
+			memoryUsed += levels[j]->memoryUsage();
+	}
+}
+
+/*
+ * Doubles the width of the buckets by merging them pairwise. This is only
+ * called before the coarser levels have been built.
+ */
+void EventRateIndex::coarsen()
+{
+	int i, s;
+
+	width *= 2;
+	scale = 1 / width;
+	s = series.size();
+	for (i = 0; i < s; i++)
+		series[i]->levels[0]->coarsen();
+
+	updateMemoryUsage();
+	if (memoryUsed < MEMORY_BUDGET)
+		memoryLimit = MEMORY_BUDGET;
+	else
+		memoryLimit = 2 * memoryUsed;
+}
+
+/*
+ * Sets the end of the trace, adds up the series of all CPUs and of all event
+ * types, and builds the coarser levels. The levels are built until a level
+ * fits in one chunk.
+ */
+void EventRateIndex::finish(double time)
+{
+	const EventRateCounts *counts;
+	EventRateCounts *coarser;
+	unsigned int cpu;
+	int type, i, s, n;
+	int nrBuckets;
+	size_t before;
+
+	endTime = time;
+
+	for (cpu = 0; cpu < tableCPUs; cpu++) {
+		for (type = 0; type < tableTypes; type++) {
+			counts = table[cpu * tableTypes + type];
+			getSeries(cpu, ALL)->levels[0]->add(*counts);
+			getSeries(ALL, type)->levels[0]->add(*counts);
+			getSeries(ALL, ALL)->levels[0]->add(*counts);
+		}
+	}
+
+	/*
+	 * Leave room for the coarser levels, which don't take up much more
+	 * memory than the finest level. If merging doesn't help, then there is
+	 * nothing more to do about it.
+	 */
+	updateMemoryUsage();
+	while (memoryUsed > MEMORY_BUDGET / 2) {
+		before = memoryUsed;
+		coarsen();
+		if (memoryUsed >= before)
+			break;
+	}
+
+	nrBuckets = (int) std::floor((endTime - startTime) * scale) + 1;
+	s = series.size();
+	for (i = 0; i < s; i++) {
+		QVector<EventRateCounts*> &levels = series[i]->levels;
+		n = nrBuckets;
+		while (n > EventRateCounts::CHUNK_SIZE) {
+			coarser = new EventRateCounts();
+			coarser->halve(*levels.last());
+			levels.append(coarser);
+			n = (n + 1) / 2;
+		}
+	}
+	finished = true;
+}
+
+int EventRateIndex::nrLevels() const
+{
+	const EventRateSeries *total = findSeries(ALL, ALL);
+
+	if (total == nullptr)
+		return 0;
+	return total->levels.size();
+}
+
+/* Finds the buckets of width bwidth that overlap the range from start to end */
+void EventRateIndex::bucketRange(double bwidth, double start, double end,
+				 int &first, int &last) const
+{
+	first = (int) std::floor((start - startTime) / bwidth);
+	last = (int) std::ceil((end - startTime) / bwidth) - 1;
+	first = TSMAX(first, 0);
+	last = TSMIN(last, (int) std::floor((endTime - startTime) / bwidth));
+}
+
+/*
+ * Returns the number of events from start to end, where the buckets that are
+ * only partially within the range are counted in proportion to the overlap.
+ * The chunks that have no events are skipped.
+ */
+double EventRateIndex::sumRange(const EventRateCounts &counts, double bwidth,
+				double start, double end) const
+{
+	const quint32 *chunk;
+	double sum = 0;
+	double bstart, overlap;
+	int first, last, j;
+	quint32 n;
+
+	bucketRange(bwidth, start, end, first, last);
+	for (j = first; j <= last; j++) {
+		chunk = counts.getChunk(j >> EventRateCounts::CHUNK_SHIFT);
+		if (chunk == nullptr) {
+			j |= EventRateCounts::CHUNK_MASK;
+			continue;
+		}
+		n = chunk[j & EventRateCounts::CHUNK_MASK];
+		if (n == 0)
+			continue;
+		bstart = startTime + j * bwidth;
+		overlap = TSMIN(end, bstart + bwidth) - TSMAX(start, bstart);
+		if (overlap > 0)
+			sum += n * overlap / bwidth;
+	}
+	return sum;
+}
+
+/*
+ * Computes the rate of events, in events per second, in n columns from start
+ * to end. The coarsest level whose buckets are not wider than a column is
+ * used, so that the cost depends on n and not on the length of the range.
+ */
+void EventRateIndex::getRates(double start, double end, int n, int cpu,
+			      int type, QVector<double> &rates) const
+{
+	const EventRateSeries *s = findSeries(cpu, type);
+	double cwidth, c0;
+	int level, i;
+
+	rates.fill(0, TSMAX(n, 0));
+	if (s == nullptr || !finished || n <= 0 || !(end > start))
+		return;
+
+	cwidth = (end - start) / n;
+	level = 0;
+	while (level + 1 < s->levels.size() &&
+	       getBucketWidth(level + 1) <= cwidth)
+		level++;
+
+	const EventRateCounts &counts = *s->levels[level];
+	for (i = 0; i < n; i++) {
+		c0 = start + i * cwidth;
+		rates[i] = sumRange(counts, getBucketWidth(level), c0,
+				    c0 + cwidth) / cwidth;
+	}
+}
+
+/* Returns the number of events from start to end */
+double EventRateIndex::countEvents(double start, double end, int cpu,
+				   int type) const
+{
+	const EventRateSeries *s = findSeries(cpu, type);
+
+	if (s == nullptr || !finished || !(end > start))
+		return 0;
+	return sumRange(*s->levels[0], width, start, end);
+}
+
+/*
+ * Finds the finest bucket from start to end with the most events and sets
+ * time to the middle of it. Returns false if there are no events in the range.
+ */
+bool EventRateIndex::findPeak(double start, double end, int cpu, int type,
+			      double &time) const
+{
+	const EventRateSeries *s = findSeries(cpu, type);
+	const quint32 *chunk;
+	quint32 max = 0;
+	quint32 n;
+	int first, last, j;
+
+	if (s == nullptr || !finished)
+		return false;
+
+	bucketRange(width, start, end, first, last);
+	for (j = first; j <= last; j++) {
+		chunk = s->levels[0]->getChunk(j >>
+					       EventRateCounts::CHUNK_SHIFT);
+		if (chunk == nullptr) {
+			j |= EventRateCounts::CHUNK_MASK;
+			continue;
+		}
+		n = chunk[j & EventRateCounts::CHUNK_MASK];
+		if (n > max) {
+			max = n;
+			time = startTime + (j + 0.5) * width;
+		}
+	}
+	return max > 0;
+}
@@ -0,0 +1,251 @@
+// SPDX-License-Identifier: (GPL-2.0-or-later OR BSD-2-Clause)
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2020  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef EVENTRATEINDEX_H
+#define EVENTRATEINDEX_H
+
+#include <QVector>
+#include <QtGlobal>
+
+#include <climits>
+
+#include "misc/traceshark.h"
+#include "vtl/compiler.h"
+
+/*
+ * The counts of one series in buckets of equal width. The buckets are stored
+ * in chunks of CHUNK_SIZE buckets, which are only allocated when an event
+ * falls into them, so that a series with few events doesn't take up memory
+ * for the whole length of the trace.
+ */
+class EventRateCounts {
+public:
+	EventRateCounts();
+	~EventRateCounts();
+	void clear();
+	vtl_always_inline size_t increment(int bucket);
+	vtl_always_inline quint32 read(int bucket) const;
+	vtl_always_inline const quint32 *getChunk(int c) const;
+	vtl_always_inline int nrChunks() const;
+	void add(const EventRateCounts &other);
+	void halve(const EventRateCounts &finer);
+	void coarsen();
+	size_t memoryUsage() const;
+	static const int CHUNK_SHIFT = 9;
+	static const int CHUNK_SIZE = 1 << CHUNK_SHIFT;
+	static const int CHUNK_MASK = CHUNK_SIZE - 1;
+private:
+	EventRateCounts(const EventRateCounts &);
+	EventRateCounts &operator=(const EventRateCounts &);
+	quint32 *allocChunk(int c);
+	QVector<quint32*> chunks;
+	int allocated;
+};
+
+/* The event counts of one CPU and event type, or of all of them */
+class EventRateSeries {
+public:
+	EventRateSeries(int cpu_, int type_);
+	~EventRateSeries();
+	int cpu;
+	int type;
+	/* levels[0] has the finest buckets, the width doubles for each level */
+	QVector<EventRateCounts*> levels;
+};
+
+/*
+ * This counts the events of each type on each CPU in time buckets while the
+ * trace is being processed, so that bursts of events can be found without
+ * another pass over the events. The buckets start with a fixed width of
+ * BASE_BUCKET_WIDTH. Only if the counts would take more than MEMORY_BUDGET
+ * bytes are they merged pairwise, which doubles the width, so a trace with a
+ * reasonable number of events keeps the base resolution regardless of its
+ * length. When the trace has been processed, finish() adds up the series of
+ * all CPUs and of all event types, and derives the coarser levels that are
+ * used for zoomed out views. Half of the budget is kept for the coarser
+ * levels.
+ *
+ * The queries take a CPU and an event type, where ALL means the sum of all
+ * CPUs or of all event types.
+ */
+class EventRateIndex {
+public:
+	EventRateIndex();
+	~EventRateIndex();
+	void clear();
+	void start(double time);
+	vtl_always_inline void add(double time, unsigned int cpu, int type);
+	void finish(double time);
+	vtl_always_inline bool isFinished() const;
+	int nrLevels() const;
+	vtl_always_inline double getBucketWidth(int level) const;
+	void getRates(double start, double end, int n, int cpu, int type,
+		      QVector<double> &rates) const;
+	double countEvents(double start, double end, int cpu, int type) const;
+	bool findPeak(double start, double end, int cpu, int type,
+		      double &time) const;
+	static const int ALL = -1;
+	static const size_t MEMORY_BUDGET = 64 << 20;
+private:
+	EventRateSeries *getSeries(int cpu, int type);
+	const EventRateSeries *findSeries(int cpu, int type) const;
+	void growTable(unsigned int cpu, int type);
+	void coarsen();
+	void updateMemoryUsage();
+	void bucketRange(double bwidth, double start, double end, int &first,
+			 int &last) const;
+	double sumRange(const EventRateCounts &counts, double bwidth,
+			double start, double end) const;
+	/*
+	 * The counts of each CPU and event type, at table[cpu * tableTypes +
+	 * type]. This is all that add() touches.
+	 */
+	QVector<EventRateCounts*> table;
+	unsigned int tableCPUs;
+	int tableTypes;
+	/* seriesTable[cpu + 1][type + 1] is the series of cpu and type */
+	QVector<QVector<EventRateSeries*>> seriesTable;
+	QVector<EventRateSeries*> series;
+	double startTime;
+	double endTime;
+	double width;
+	/* The inverse of width, so that add() doesn't need to divide */
+	double scale;
+	size_t memoryUsed;
+	/*
+	 * Normally MEMORY_BUDGET, but raised if merging the buckets can't
+	 * bring the memory use below it, e.g. because there are so many series
+	 * that their first chunks alone exceed it.
+	 */
+	size_t memoryLimit;
+	bool finished;
+};
+
+vtl_always_inline size_t EventRateCounts::increment(int bucket)
+{
+	int c = bucket >> CHUNK_SHIFT;
+	quint32 *chunk;
+	size_t added = 0;
+
+	if (c >= chunks.size()) {
+		added = (c + 1 - chunks.size()) * sizeof(quint32*);
+		chunks.resize(c + 1);
+	}
+	chunk = chunks[c];
+	if (chunk == nullptr) {
+		chunk = allocChunk(c);
+		added += CHUNK_SIZE * sizeof(quint32);
+	}
+	chunk[bucket & CHUNK_MASK]++;
+	return added;
+}
+
+vtl_always_inline quint32 EventRateCounts::read(int bucket) const
+{
+	const quint32 *chunk = getChunk(bucket >> CHUNK_SHIFT);
+
+	return chunk == nullptr ? 0 : chunk[bucket & CHUNK_MASK];
+}
+
+/* Returns the chunk c, or nullptr if it has no events */
+vtl_always_inline const quint32 *EventRateCounts::getChunk(int c) const
+{
+	if (c < 0 || c >= chunks.size())
+		return nullptr;
+	return chunks[c];
+}
+
+vtl_always_inline int EventRateCounts::nrChunks() const
+{
+	return chunks.size();
+}
+
+/*
+ * This is called for every event, so it computes the bucket only once and
+ * counts only the series of the CPU and the event type. The series of all
+ * CPUs and all event types are added up by finish().
+ */
+vtl_always_inline void EventRateIndex::add(double time, unsigned int cpu,
+					   int type)
+{
+	double b;
+	int bucket;
+
+	if (type < 0)
+		return;
+	if (cpu >= tableCPUs || type >= tableTypes)
+		growTable(cpu, type);
+
+	b = (time - startTime) * scale;
+	/* Keep the bucket within the range of an int */
+	while (b >= (double) (INT_MAX - EventRateCounts::CHUNK_SIZE)) {
+		coarsen();
+		b = (time - startTime) * scale;
+	}
+	bucket = TSMAX((int) b, 0);
+
+	memoryUsed += table[cpu * tableTypes + type]->increment(bucket);
+	if (memoryUsed > memoryLimit)
+		coarsen();
+}
+
+vtl_always_inline bool EventRateIndex::isFinished() const
+{
+	return finished;
+}
+
+vtl_always_inline double EventRateIndex::getBucketWidth(int level) const
+{
+	return width * (1 << level);
+}
+
+#endif /* EVENTRATEINDEX_H */
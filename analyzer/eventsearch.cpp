@@ -0,0 +1,301 @@
+// SPDX-License-Identifier: (GPL-2.0-or-later OR BSD-2-Clause)
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2020  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cstring>
+#include <QHash>
+
+#include "analyzer/eventsearch.h"
+#include "parser/traceevent.h"
+#include "misc/traceshark.h"
+#include "misc/tstring.h"
+#include "vtl/tlist.h"
+
+/* The number of events that are searched by one work item */
+#define SEARCH_CHUNK_SIZE (65536)
+
+/* How often the search checks whether it has been aborted */
+#define SEARCH_ABORT_MASK (4095)
+
+/* The memory of a chunk is cleared when it has seen this many strings */
+#define SEARCH_MEMO_MAX (65536)
+
+bool SearchChunk::search()
+{
+	owner->searchChunk(this);
+	/* The WorkQueue interprets true as an error */
+	return false;
+}
+
+EventSearch::EventSearch():
+	events(nullptr), eventsPtrs(nullptr), useRegex(false), nextChunk(0),
+	active(false)
+{
+	searchThread = new WorkThread<EventSearch>
+		(QString("searchThread"), this, &EventSearch::threadSearch);
+}
+
+EventSearch::~EventSearch()
+{
+	stop();
+	delete searchThread;
+}
+
+/*
+ * Starts a search of e or eptrs, whichever isn't nullptr, in the background.
+ * The events must not be modified before stop() has been called. Returns false
+ * and sets errmsg if pattern is not a valid search.
+ */
+bool EventSearch::start(const QString &pattern, bool regex,
+			vtl::TList<TraceEvent> *e,
+			vtl::TList<const TraceEvent*> *eptrs, QString *errmsg)
+{
+	SearchChunk *chunk;
+	const TString *name;
+	int size;
+	int begin;
+	int nr;
+	int t;
+
+	stop();
+
+	if (pattern.isEmpty()) {
+		*errmsg = QString("The search string is empty");
+		return false;
+	}
+
+	useRegex = regex;
+	if (regex) {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+		regExp.setPattern(pattern);
+		if (!regExp.isValid()) {
+			*errmsg = regExp.errorString();
+			return false;
+		}
+		regExp.optimize();
+#else
+		regExp = QRegExp(pattern, Qt::CaseSensitive, QRegExp::RegExp2);
+		if (!regExp.isValid()) {
+			*errmsg = regExp.errorString();
+			return false;
+		}
+#endif
+	} else {
+		literal = pattern.toUtf8();
+	}
+
+	events = e;
+	eventsPtrs = eptrs;
+	if (events != nullptr)
+		size = events->size();
+	else if (eventsPtrs != nullptr)
+		size = eventsPtrs->size();
+	else
+		size = 0;
+
+	/* Every event type whose name matches is a match for all its events */
+	nr = TraceEvent::getNrEvents();
+	typeMatches.fill(0, nr);
+	for (t = 0; t < nr; t++) {
+		name = TraceEvent::getEventName((event_t) t);
+		if (name != nullptr && matchString(regExp, name))
+			typeMatches[t] = 1;
+	}
+
+	for (begin = 0; begin < size; begin += SEARCH_CHUNK_SIZE) {
+		chunk = new SearchChunk();
+		chunk->owner = this;
+		chunk->begin = begin;
+		chunk->end = TSMIN(begin + SEARCH_CHUNK_SIZE, size);
+		chunk->done.storeRelease(0);
+		chunks.append(chunk);
+		workItems.append(new WorkItem<SearchChunk>
+				 (chunk, &SearchChunk::search));
+	}
+
+	nextChunk = 0;
+	abortRequested.storeRelease(0);
+	active = true;
+	searchThread->start();
+	return true;
+}
+
+/* Aborts the search, if it is running, and frees its results */
+void EventSearch::stop()
+{
+	if (!active)
+		return;
+	abortRequested.storeRelease(1);
+	searchThread->wait();
+	freeChunks();
+	events = nullptr;
+	eventsPtrs = nullptr;
+	active = false;
+}
+
+bool EventSearch::isActive() const
+{
+	return active;
+}
+
+/*
+ * Appends the matches of the chunks that have been completed since the last
+ * call to matches, in the order of the events. Returns true when all matches
+ * have been collected.
+ */
+bool EventSearch::collectMatches(QVector<int> &matches)
+{
+	SearchChunk *chunk;
+	int i;
+
+	while (nextChunk < chunks.size()) {
+		chunk = chunks[nextChunk];
+		if (chunk->done.loadAcquire() == 0)
+			return false;
+		for (i = 0; i < chunk->matches.size(); i++)
+			matches.append(chunk->matches[i]);
+		nextChunk++;
+	}
+	return true;
+}
+
+void EventSearch::threadSearch()
+{
+	int i;
+
+	for (i = 0; i < workItems.size(); i++)
+		searchQueue.addWorkItem(workItems[i]);
+	searchQueue.start();
+	searchQueue.wait();
+}
+
+void EventSearch::freeChunks()
+{
+	int i;
+
+	for (i = 0; i < workItems.size(); i++)
+		delete workItems[i];
+	for (i = 0; i < chunks.size(); i++)
+		delete chunks[i];
+	workItems.clear();
+	chunks.clear();
+	nextChunk = 0;
+}
+
+/*
+ * The regexp is passed by the caller, so that every chunk can use its own
+ * copy, because a QRegExp cannot be used by several threads at the same time.
+ */
+bool EventSearch::matchString(const SearchRegExp &re, const TString *str) const
+{
+	if (useRegex) {
+		QString qstr = QString::fromUtf8(str->ptr, str->len);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+		return re.match(qstr).hasMatch();
+#else
+		return re.indexIn(qstr) >= 0;
+#endif
+	}
+	if (str->len < literal.size())
+		return false;
+	return memmem(str->ptr, str->len, literal.constData(),
+		      literal.size()) != nullptr;
+}
+
+void EventSearch::searchChunk(SearchChunk *chunk)
+{
+	QHash<const TString*, bool> memo;
+	QHash<const TString*, bool>::const_iterator iter;
+	SearchRegExp re = regExp;
+	const TraceEvent *event;
+	const TString *str;
+	bool match;
+	int i;
+	int j;
+
+	for (i = chunk->begin; i < chunk->end; i++) {
+		if ((i & SEARCH_ABORT_MASK) == 0 &&
+		    abortRequested.loadAcquire() != 0)
+			break;
+		event = getEventAt(i);
+		if (event->type >= 0 && event->type < typeMatches.size() &&
+		    typeMatches[event->type]) {
+			chunk->matches.append(i);
+			continue;
+		}
+		match = false;
+		/* The task name first, then the arguments */
+		for (j = -1; j < event->argc && !match; j++) {
+			str = j < 0 ? event->taskName : event->argv[j];
+			if (str == nullptr)
+				continue;
+			iter = memo.constFind(str);
+			if (iter != memo.constEnd()) {
+				match = iter.value();
+				continue;
+			}
+			match = matchString(re, str);
+			if (memo.size() >= SEARCH_MEMO_MAX)
+				memo.clear();
+			memo.insert(str, match);
+		}
+		if (match)
+			chunk->matches.append(i);
+	}
+	chunk->done.storeRelease(1);
+}
+
+const TraceEvent *EventSearch::getEventAt(int index) const
+{
+	if (events != nullptr)
+		return &events->at(index);
+	return eventsPtrs->at(index);
+}
@@ -0,0 +1,140 @@
+// SPDX-License-Identifier: (GPL-2.0-or-later OR BSD-2-Clause)
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2020  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef EVENTSEARCH_H
+#define EVENTSEARCH_H
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+#include <QRegularExpression>
+typedef QRegularExpression SearchRegExp;
+#else
+#include <QRegExp>
+typedef QRegExp SearchRegExp;
+#endif
+
+#include "threads/workitem.h"
+#include "threads/workqueue.h"
+#include "threads/workthread.h"
+#include "vtl/compiler.h"
+
+class TraceEvent;
+class TString;
+namespace vtl {
+	template<class T> class TList;
+}
+
+class EventSearch;
+
+/* A range of event indices that is searched by one work item */
+class SearchChunk {
+public:
+	bool search();
+	EventSearch *owner;
+	int begin;
+	int end;
+	QVector<int> matches;
+	QAtomicInt done;
+};
+
+/*
+ * This searches the task names, event names and arguments of a list of events
+ * for a string or a regular expression. The list is split into chunks that are
+ * searched by a WorkQueue on all cores, while the caller collects the matches
+ * of the chunks that have been completed, so that the first matches can be
+ * shown long before the search of a huge trace has finished.
+ *
+ * Task names and arguments are interned strings in most cases, so each chunk
+ * remembers the result for every string pointer that it has seen and matches
+ * each unique string only once. The event names are matched once per event
+ * type before the search starts.
+ */
+class EventSearch {
+	friend class SearchChunk;
+public:
+	EventSearch();
+	~EventSearch();
+	bool start(const QString &pattern, bool regex,
+		   vtl::TList<TraceEvent> *e,
+		   vtl::TList<const TraceEvent*> *eptrs, QString *errmsg);
+	void stop();
+	bool collectMatches(QVector<int> &matches);
+	bool isActive() const;
+	void threadSearch();
+private:
+	void searchChunk(SearchChunk *chunk);
+	bool matchString(const SearchRegExp &re, const TString *str) const;
+	const TraceEvent *getEventAt(int index) const;
+	void freeChunks();
+	vtl::TList<TraceEvent> *events;
+	vtl::TList<const TraceEvent*> *eventsPtrs;
+	bool useRegex;
+	QByteArray literal;
+	SearchRegExp regExp;
+	QVector<char> typeMatches;
+	QList<SearchChunk*> chunks;
+	QList<WorkItem<SearchChunk>*> workItems;
+	WorkQueue searchQueue;
+	WorkThread<EventSearch> *searchThread;
+	/* The index of the first chunk whose matches have not been collected */
+	int nextChunk;
+	bool active;
+	QAtomicInt abortRequested;
+};
+
+#endif /* EVENTSEARCH_H */
@@ -0,0 +1,223 @@
+// SPDX-License-Identifier: (GPL-2.0-or-later OR BSD-2-Clause)
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2020  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "analyzer/latencyhistogram.h"
+#include "misc/traceshark.h"
+
+/* The values are in nanoseconds, so we print them with nine decimals */
+#define LATENCY_PRECISION (9)
+
+LatencyHistogram::LatencyHistogram():
+	total(0), maxValue(0)
+{}
+
+void LatencyHistogram::addValue(unsigned long long value)
+{
+	int idx = bucketIndex(value);
+
+	if (idx >= counts.size())
+		counts.resize(idx + 1);
+	counts[idx]++;
+	total++;
+	maxValue = TSMAX(maxValue, value);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other)
+{
+	int i;
+	int s = other.counts.size();
+
+	if (s > counts.size())
+		counts.resize(s);
+	for (i = 0; i < s; i++)
+		counts[i] += other.counts[i];
+	total += other.total;
+	maxValue = TSMAX(maxValue, other.maxValue);
+}
+
+void LatencyHistogram::clear()
+{
+	counts.clear();
+	total = 0;
+	maxValue = 0;
+}
+
+/*
+ * Returns the smallest value such that at least pct percent of the samples
+ * are less than or equal to it, rounded up to the highest value of its
+ * bucket, but never more than the maximum.
+ */
+vtl::Time LatencyHistogram::percentile(double pct) const
+{
+	unsigned long long target;
+	unsigned long long acc = 0;
+	unsigned long long value;
+	int i, s;
+
+	if (total == 0)
+		return vtl::Time(false, 0, 0, LATENCY_PRECISION);
+
+	target = (unsigned long long) (pct / 100 * total + 0.5);
+	target = TSMAX(target, 1ULL);
+	target = TSMIN(target, (unsigned long long) total);
+
+	s = counts.size();
+	for (i = 0; i < s; i++) {
+		acc += counts[i];
+		if (acc >= target)
+			break;
+	}
+	value = TSMIN(bucketHighest(i), maxValue);
+	return vtl::Time(false, 0, value, LATENCY_PRECISION);
+}
+
+vtl::Time LatencyHistogram::max() const
+{
+	return vtl::Time(false, 0, maxValue, LATENCY_PRECISION);
+}
+
+LatencyIndex::LatencyIndex()
+{}
+
+void LatencyIndex::build(const QVector<double> &delayv)
+{
+	int nrBlocks = delayv.size() / LATENCY_BLOCK_SIZE;
+	int b, i, end;
+	int s = delayv.size();
+
+	clear();
+	blocks.resize(nrBlocks);
+	i = 0;
+	for (b = 0; b < nrBlocks; b++) {
+		LatencyHistogram &block = blocks[b];
+		end = i + LATENCY_BLOCK_SIZE;
+		for (; i < end; i++)
+			block.add(delayv[i]);
+		total.merge(block);
+	}
+
+	/* The samples after the last full block are not part of any block */
+	for (; i < s; i++)
+		total.add(delayv[i]);
+}
+
+void LatencyIndex::clear()
+{
+	blocks.clear();
+	total.clear();
+}
+
+const LatencyHistogram &LatencyIndex::getTotal() const
+{
+	return total;
+}
+
+int LatencyIndex::lowerBound(const QVector<double> &timev, double time)
+{
+	int low = 0;
+	int high = timev.size();
+	int pivot;
+
+	while (low < high) {
+		pivot = (low + high) / 2;
+		if (timev[pivot] < time)
+			low = pivot + 1;
+		else
+			high = pivot;
+	}
+	return low;
+}
+
+int LatencyIndex::upperBound(const QVector<double> &timev, double time)
+{
+	int low = 0;
+	int high = timev.size();
+	int pivot;
+
+	while (low < high) {
+		pivot = (low + high) / 2;
+		if (timev[pivot] <= time)
+			low = pivot + 1;
+		else
+			high = pivot;
+	}
+	return low;
+}
+
+/*
+ * Adds the samples with a time in [start, end] to hist. The vectors must be
+ * the same ones that the index was built from.
+ */
+void LatencyIndex::addRange(LatencyHistogram &hist,
+			    const QVector<double> &timev,
+			    const QVector<double> &delayv,
+			    double start, double end) const
+{
+	int low = lowerBound(timev, start);
+	int high = upperBound(timev, end);
+	int firstBlock = (low + LATENCY_BLOCK_SIZE - 1) / LATENCY_BLOCK_SIZE;
+	int lastBlock = TSMIN(high / LATENCY_BLOCK_SIZE, blocks.size());
+	int b, i;
+
+	if (firstBlock >= lastBlock) {
+		for (i = low; i < high; i++)
+			hist.add(delayv[i]);
+		return;
+	}
+
+	for (i = low; i < firstBlock * LATENCY_BLOCK_SIZE; i++)
+		hist.add(delayv[i]);
+	for (b = firstBlock; b < lastBlock; b++)
+		hist.merge(blocks[b]);
+	for (i = lastBlock * LATENCY_BLOCK_SIZE; i < high; i++)
+		hist.add(delayv[i]);
+}
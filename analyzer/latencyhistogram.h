@@ -0,0 +1,154 @@
+// SPDX-License-Identifier: (GPL-2.0-or-later OR BSD-2-Clause)
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2020  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <QVector>
+
+#include "vtl/compiler.h"
+#include "vtl/time.h"
+
+/*
+ * A log-linear histogram of latencies in nanoseconds, in the style of
+ * HdrHistogram. Each power of two range is divided into 2^SUB_BITS linear
+ * buckets, so the relative error of a reported value is below 2^-SUB_BITS,
+ * while the number of buckets only grows with the logarithm of the largest
+ * value. Histograms can be merged, which allows us to compute the histogram
+ * of a range by merging precomputed histograms of blocks.
+ */
+class LatencyHistogram {
+public:
+	LatencyHistogram();
+	vtl_always_inline void add(double delay);
+	void addValue(unsigned long long value);
+	void merge(const LatencyHistogram &other);
+	void clear();
+	vtl_always_inline unsigned int count() const;
+	vtl::Time percentile(double pct) const;
+	vtl::Time max() const;
+	static const int SUB_BITS = 6;
+	static const unsigned long long SUB_COUNT = 1ULL << SUB_BITS;
+private:
+	static vtl_always_inline int bucketIndex(unsigned long long value);
+	static vtl_always_inline unsigned long long
+		bucketHighest(int idx);
+	QVector<unsigned int> counts;
+	unsigned int total;
+	unsigned long long maxValue;
+};
+
+vtl_always_inline int LatencyHistogram::bucketIndex(unsigned long long value)
+{
+	int msb;
+	int shift;
+
+	if (value < SUB_COUNT)
+		return (int) value;
+	msb = 63 - __builtin_clzll(value);
+	shift = msb - SUB_BITS;
+	return (shift << SUB_BITS) + (int) (value >> shift);
+}
+
+/* Returns the highest value that is counted in the bucket idx */
+vtl_always_inline unsigned long long LatencyHistogram::bucketHighest(int idx)
+{
+	int shift;
+	unsigned long long mant;
+
+	if ((unsigned) idx < 2 * SUB_COUNT)
+		return idx;
+	shift = (idx >> SUB_BITS) - 1;
+	mant = idx - ((unsigned long long) shift << SUB_BITS);
+	return ((mant + 1) << shift) - 1;
+}
+
+/* The delay is in seconds, as in the wakeDelay vectors of the tasks */
+vtl_always_inline void LatencyHistogram::add(double delay)
+{
+	if (delay < 0)
+		delay = 0;
+	addValue((unsigned long long) (delay * NSECS_PER_SEC + 0.5));
+}
+
+vtl_always_inline unsigned int LatencyHistogram::count() const
+{
+	return total;
+}
+
+#define LATENCY_BLOCK_SIZE (1024)
+
+/*
+ * An index of a sequence of latency samples, sorted by time, that consists of
+ * the histograms of consecutive blocks of LATENCY_BLOCK_SIZE samples. The
+ * histogram of an arbitrary time range is computed by merging the histograms
+ * of the blocks that are entirely inside the range, so that only the samples
+ * at the edges of the range need to be added individually.
+ */
+class LatencyIndex {
+public:
+	LatencyIndex();
+	void build(const QVector<double> &delayv);
+	void clear();
+	const LatencyHistogram &getTotal() const;
+	void addRange(LatencyHistogram &hist,
+		      const QVector<double> &timev,
+		      const QVector<double> &delayv,
+		      double start, double end) const;
+private:
+	static int lowerBound(const QVector<double> &timev, double time);
+	static int upperBound(const QVector<double> &timev, double time);
+	QVector<LatencyHistogram> blocks;
+	LatencyHistogram total;
+};
+
+#endif /* LATENCYHISTOGRAM_H */
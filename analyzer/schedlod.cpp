@@ -0,0 +1,218 @@
+// SPDX-License-Identifier: (GPL-2.0-or-later OR BSD-2-Clause)
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2020  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+
+#include "analyzer/schedlod.h"
+#include "misc/traceshark.h"
+
+SchedLOD::SchedLOD():
+	startTime(0), endTime(0), built(false)
+{}
+
+void SchedLOD::clear()
+{
+	levels.clear();
+	built = false;
+}
+
+/*
+ * Builds the pyramid from a scheduling graph, where data[i] is the value of
+ * the graph from timev[i] until timev[i + 1]. The last value extends until
+ * end.
+ */
+void SchedLOD::build(const QVector<double> &timev, const vtl::BitVector &data,
+		     double start, double end)
+{
+	int s = timev.size();
+	int shift = 0;
+
+	clear();
+	built = true;
+	startTime = start;
+	endTime = end;
+
+	if (!(end > start))
+		return;
+
+	while (shift < LOD_MAX_SHIFT &&
+	       (2 << shift) <= s / LOD_REDUCTION)
+		shift++;
+	if ((1 << shift) <= LOD_MIN_BUCKETS)
+		return;
+
+	buildFinest(timev, data, 1 << shift);
+	while (levels.last().buckets.size() > LOD_MIN_BUCKETS)
+		buildCoarser();
+}
+
+void SchedLOD::buildFinest(const QVector<double> &timev,
+			   const vtl::BitVector &data, int nrBuckets)
+{
+	SchedLODLevel level;
+	double width = (endTime - startTime) / nrBuckets;
+	double a, b, bstart, bend;
+	unsigned char v;
+	int s = timev.size();
+	int i, j, first, last;
+
+	level.width = width;
+	level.buckets.resize(nrBuckets);
+	SchedLODBucket *buckets = level.buckets.data();
+
+	/* Segment i is [a, b) with the value v, the one before timev[0] is 0 */
+	for (i = -1; i < s; i++) {
+		a = i < 0 ? startTime : TSMAX(timev[i], startTime);
+		b = i + 1 < s ? TSMIN(timev[i + 1], endTime) : endTime;
+		if (!(b > a))
+			continue;
+		v = i < 0 ? 0 : data.read(i);
+		first = (int) ((a - startTime) / width);
+		last = (int) std::ceil((b - startTime) / width) - 1;
+		first = TSMAX(0, TSMIN(first, nrBuckets - 1));
+		last = TSMAX(first, TSMIN(last, nrBuckets - 1));
+		for (j = first; j <= last; j++) {
+			SchedLODBucket &bucket = buckets[j];
+			bucket.minv = TSMIN(bucket.minv, v);
+			bucket.maxv = TSMAX(bucket.maxv, v);
+			bucket.lastv = v;
+			if (v != 0) {
+				bstart = startTime + j * width;
+				bend = bstart + width;
+				bucket.busy += TSMIN(b, bend) -
+					TSMAX(a, bstart);
+			}
+		}
+	}
+	levels.append(level);
+}
+
+void SchedLOD::buildCoarser()
+{
+	const SchedLODLevel &finer = levels.last();
+	SchedLODLevel level;
+	int s = finer.buckets.size() / 2;
+	int i;
+
+	level.width = finer.width * 2;
+	level.buckets.resize(s);
+	for (i = 0; i < s; i++) {
+		const SchedLODBucket &f0 = finer.buckets[2 * i];
+		const SchedLODBucket &f1 = finer.buckets[2 * i + 1];
+		SchedLODBucket &bucket = level.buckets[i];
+		bucket.busy = f0.busy + f1.busy;
+		bucket.minv = TSMIN(f0.minv, f1.minv);
+		bucket.maxv = TSMAX(f0.maxv, f1.maxv);
+		bucket.lastv = f1.lastv;
+	}
+	levels.append(level);
+}
+
+/*
+ * Returns the coarsest level whose buckets are not wider than pixelWidth, or
+ * -1 if the raw data should be used because even the finest level is too
+ * coarse.
+ */
+int SchedLOD::findLevel(double pixelWidth) const
+{
+	int level;
+
+	if (levels.isEmpty() || pixelWidth < levels[0].width)
+		return -1;
+	level = (int) std::floor(std::log2(pixelWidth / levels[0].width));
+	return TSMIN(level, levels.size() - 1);
+}
+
+/*
+ * Generates a step graph from a level. A bucket in which the graph has both
+ * values is drawn as a pulse, which will be narrower than a pixel when the
+ * level has been chosen with findLevel().
+ */
+void SchedLOD::levelData(int level, double offset, double height,
+			 QVector<double> &keys, QVector<double> &values) const
+{
+	const SchedLODLevel &l = levels[level];
+	int s = l.buckets.size();
+	double bstart;
+	int cur = -1;
+	int i;
+
+	keys.resize(0);
+	values.resize(0);
+
+	for (i = 0; i < s; i++) {
+		const SchedLODBucket &bucket = l.buckets[i];
+		bstart = startTime + i * l.width;
+		if (bucket.minv == bucket.maxv) {
+			if (bucket.minv != cur) {
+				cur = bucket.minv;
+				keys.append(bstart);
+				values.append(cur * height + offset);
+			}
+			continue;
+		}
+		if (cur != 1) {
+			keys.append(bstart);
+			values.append(height + offset);
+		}
+		keys.append(bstart + l.width / 2);
+		values.append(offset);
+		cur = 0;
+		if (bucket.lastv != 0) {
+			keys.append(bstart + l.width * 3 / 4);
+			values.append(height + offset);
+			cur = 1;
+		}
+	}
+	keys.append(endTime);
+	values.append(TSMAX(cur, 0) * height + offset);
+}
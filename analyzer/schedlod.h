@@ -0,0 +1,134 @@
+// SPDX-License-Identifier: (GPL-2.0-or-later OR BSD-2-Clause)
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2020  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SCHEDLOD_H
+#define SCHEDLOD_H
+
+#include <QVector>
+
+#include "vtl/bitvector.h"
+#include "vtl/compiler.h"
+
+/*
+ * The state of the scheduling graph during one bucket of a level. The busy
+ * member is the time that the task was scheduled during the bucket, minv and
+ * maxv tell whether the graph was low or high at some point, and lastv is
+ * the value at the end of the bucket.
+ */
+class SchedLODBucket {
+public:
+	SchedLODBucket(): busy(0), minv(1), maxv(0), lastv(0) {}
+	double busy;
+	unsigned char minv;
+	unsigned char maxv;
+	unsigned char lastv;
+};
+
+class SchedLODLevel {
+public:
+	double width;
+	QVector<SchedLODBucket> buckets;
+};
+
+/*
+ * A level-of-detail pyramid of a scheduling graph. Level 0 has the finest
+ * buckets and the bucket width doubles for each level. The levels are only
+ * built if they are at least LOD_REDUCTION times smaller than the raw data,
+ * otherwise the raw data is cheap enough to draw.
+ */
+class SchedLOD {
+public:
+	SchedLOD();
+	void build(const QVector<double> &timev, const vtl::BitVector &data,
+		   double start, double end);
+	void clear();
+	vtl_always_inline bool isBuilt() const;
+	vtl_always_inline int nrLevels() const;
+	vtl_always_inline const SchedLODLevel &getLevel(int level) const;
+	int findLevel(double pixelWidth) const;
+	void levelData(int level, double offset, double height,
+		       QVector<double> &keys, QVector<double> &values) const;
+	vtl_always_inline double getStart() const;
+	static const int LOD_REDUCTION = 4;
+	static const int LOD_MIN_BUCKETS = 512;
+	static const int LOD_MAX_SHIFT = 24;
+private:
+	void buildFinest(const QVector<double> &timev,
+			 const vtl::BitVector &data, int nrBuckets);
+	void buildCoarser();
+	QVector<SchedLODLevel> levels;
+	double startTime;
+	double endTime;
+	bool built;
+};
+
+vtl_always_inline bool SchedLOD::isBuilt() const
+{
+	return built;
+}
+
+vtl_always_inline int SchedLOD::nrLevels() const
+{
+	return levels.size();
+}
+
+vtl_always_inline const SchedLODLevel &SchedLOD::getLevel(int level) const
+{
+	return levels[level];
+}
+
+vtl_always_inline double SchedLOD::getStart() const
+{
+	return startTime;
+}
+
+#endif /* SCHEDLOD_H */
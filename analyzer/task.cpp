@@ -61,8 +61,8 @@ TaskName::TaskName():
 Task::Task():
 	AbstractTask(), taskName(nullptr), exitStatus(STATUS_ALIVE),
 	lastWakeUP(0), lastSleepEntry(0), wakeUpGraph(nullptr),
-	preemptedGraph(nullptr), runningGraph(nullptr),
-	uninterruptibleGraph(nullptr)
+	wakeUpErrorBars(nullptr), preemptedGraph(nullptr),
+	runningGraph(nullptr), uninterruptibleGraph(nullptr)
 {
 	displayName = new QString();
 }
@@ -114,3 +114,9 @@ QString Task::getLastName() const
 		return QString(taskName->str);
 	return empty;
 }
+
+bool Task::doLatencyStats()
+{
+	wakeLatency.build(wakeDelay);
+	return false; /* No error */
+}
@@ -56,11 +56,14 @@
 #include <cstring>
 
 #include <QString>
+#include <QVector>
 
 #include "analyzer/abstracttask.h"
+#include "analyzer/latencyhistogram.h"
 #include "vtl/compiler.h"
 #include "vtl/time.h"
 
+class QCPErrorBars;
 class QCPGraph;
 class TaskGraph;
 class Task;
@@ -94,6 +97,11 @@ public:
 	vtl_always_inline void checkName(const char *name, bool forkname = false);
 	void generateDisplayName();
 	QString getLastName() const;
+	bool doLatencyStats();
+	static vtl_always_inline int findIdxBefore(const QVector<int> &idxv,
+						   int idx);
+	static vtl_always_inline int findIdxAfter(const QVector<int> &idxv,
+						  int idx);
 
 	TaskName     *taskName;
 	exitstatus_t exitStatus;
@@ -103,12 +111,29 @@ public:
 
 	vtl::Time    lastSleepEntry;
 
+	/*
+	 * Indices into the events list of the events that concern this task,
+	 * in ascending order. These allow us to navigate between the sched
+	 * events of a task without scanning the whole trace.
+	 */
+	QVector<int> schedInIdx;       /* sched_switch to this task      */
+	QVector<int> sleepIdx;         /* sched_switch from this task to
+					* a non runnable state           */
+	QVector<int> wakeupIdx;        /* sched_wakeup and
+					* sched_wakeup_new               */
+	QVector<int> wakeupNewIdx;     /* sched_wakeup_new only          */
+	QVector<int> wakingIdx;        /* sched_waking                   */
+
+	/* Histograms of the samples in wakeDelay */
+	LatencyIndex wakeLatency;
+
 	/*
 	 * The unified task needs to save pointers to these graphs so that they
 	 * can be deleted when the user requests the unified task to be 
 	 * removed
 	 */
 	QCPGraph     *wakeUpGraph;
+	QCPErrorBars *wakeUpErrorBars;
 	QCPGraph     *preemptedGraph;
 	QCPGraph     *runningGraph;
 	QCPGraph     *uninterruptibleGraph;
@@ -125,6 +150,50 @@ vtl_always_inline void Task::checkName(const char *name, bool forkname)
 	}
 }
 
+/*
+ * Returns the greatest index in idxv that is less than or equal to idx, or -1
+ * if there is no such index. idxv must be sorted in ascending order.
+ */
+vtl_always_inline int Task::findIdxBefore(const QVector<int> &idxv, int idx)
+{
+	int low = 0;
+	int high = idxv.size();
+	int pivot;
+
+	while (low < high) {
+		pivot = (low + high) / 2;
+		if (idxv[pivot] <= idx)
+			low = pivot + 1;
+		else
+			high = pivot;
+	}
+	if (low == 0)
+		return -1;
+	return idxv[low - 1];
+}
+
+/*
+ * Returns the smallest index in idxv that is greater than or equal to idx, or
+ * -1 if there is no such index. idxv must be sorted in ascending order.
+ */
+vtl_always_inline int Task::findIdxAfter(const QVector<int> &idxv, int idx)
+{
+	int low = 0;
+	int high = idxv.size();
+	int pivot;
+
+	while (low < high) {
+		pivot = (low + high) / 2;
+		if (idxv[pivot] < idx)
+			low = pivot + 1;
+		else
+			high = pivot;
+	}
+	if (low == idxv.size())
+		return -1;
+	return idxv[low];
+}
+
 vtl_always_inline Task &TaskHandle::getTask()
 {
 	if (task == nullptr)
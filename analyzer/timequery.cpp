@@ -0,0 +1,358 @@
+// SPDX-License-Identifier: (GPL-2.0-or-later OR BSD-2-Clause)
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2020  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+
+#include "analyzer/cpufreq.h"
+#include "analyzer/cpuidle.h"
+#include "analyzer/cputask.h"
+#include "analyzer/timequery.h"
+#include "analyzer/traceanalyzer.h"
+#include "misc/traceshark.h"
+#include "threads/workitem.h"
+
+static bool startsBefore(const RunInterval &a, const RunInterval &b)
+{
+	return a.start < b.start;
+}
+
+/* For std::upper_bound(), finds the first interval that ends after time */
+static bool endsAfter(double time, const RunInterval &r)
+{
+	return time < r.end;
+}
+
+CPURunIndex::CPURunIndex():
+	cpu(0), owner(nullptr)
+{}
+
+/*
+ * Extracts the intervals from the scheduling graphs of the tasks that have
+ * run on the CPU. The idle task is left out, so a time that is not covered by
+ * any interval means that the CPU was idle.
+ */
+bool CPURunIndex::build()
+{
+	const TraceAnalyzer *analyzer = owner->analyzer;
+	const double endTime = analyzer->getEndTime().toDouble();
+	RunInterval r;
+	int i, s;
+
+	intervals.clear();
+	r.cpu = cpu;
+
+	DEFINE_CPUTASKMAP_ITERATOR(iter);
+	for (iter = analyzer->cpuTaskMaps[cpu].begin();
+	     iter != analyzer->cpuTaskMaps[cpu].end();
+	     iter++) {
+		const CPUTask &task = iter.value();
+		const QVector<double> &timev = task.schedTimev;
+		if (task.pid == 0)
+			continue;
+		r.pid = task.pid;
+		s = timev.size();
+		for (i = 0; i < s; i++) {
+			if (task.schedData.read(i) != SCHED_BIT)
+				continue;
+			r.start = timev[i];
+			r.end = i + 1 < s ? timev[i + 1] : endTime;
+			if (r.end > r.start)
+				intervals.append(r);
+		}
+	}
+
+	TimeQuery::sortIntervals(intervals);
+	return false; /* No error */
+}
+
+TimeQuery::TimeQuery():
+	analyzer(nullptr), built(false)
+{}
+
+TimeQuery::~TimeQuery()
+{
+	clear();
+}
+
+void TimeQuery::clear()
+{
+	cpus.clear();
+	tasks.clear();
+	analyzer = nullptr;
+	built = false;
+}
+
+/*
+ * Builds the index from the scheduling graphs of analyzer, which must have
+ * been processed. The CPUs are indexed in parallel.
+ */
+void TimeQuery::build(TraceAnalyzer *a)
+{
+	QList<WorkItem<CPURunIndex>*> workList;
+	unsigned int cpu, nrCPUs;
+	int i, s;
+
+	clear();
+	analyzer = a;
+	nrCPUs = analyzer->getNrCPUs();
+	cpus.resize(nrCPUs);
+
+	/* The vector is not resized after this, so it can be pointed to */
+	for (cpu = 0; cpu < nrCPUs; cpu++) {
+		cpus[cpu].cpu = cpu;
+		cpus[cpu].owner = this;
+		WorkItem<CPURunIndex> *item = new WorkItem<CPURunIndex>
+			(&cpus[cpu], &CPURunIndex::build);
+		workList.append(item);
+		queue.addWorkItem(item);
+	}
+	queue.start();
+	queue.wait();
+
+	s = workList.size();
+	for (i = 0; i < s; i++)
+		delete workList[i];
+
+	buildTaskIndex();
+	built = true;
+}
+
+/* Collects the intervals of each task from the CPUs that it has run on */
+void TimeQuery::buildTaskIndex()
+{
+	QHash<int, QVector<RunInterval>>::iterator iter;
+	int i, j, s;
+
+	for (i = 0; i < cpus.size(); i++) {
+		const QVector<RunInterval> &v = cpus[i].intervals;
+		s = v.size();
+		for (j = 0; j < s; j++)
+			tasks[v[j].pid].append(v[j]);
+	}
+
+	for (iter = tasks.begin(); iter != tasks.end(); iter++)
+		sortIntervals(iter.value());
+}
+
+/*
+ * Sorts the intervals by their start. A trace with lost events can claim that
+ * a CPU ran two tasks at the same time, or that a task ran on two CPUs at the
+ * same time, so an interval that overlaps the next one is cut where the next
+ * one starts. After this, the ends are sorted too.
+ */
+void TimeQuery::sortIntervals(QVector<RunInterval> &v)
+{
+	int i, s;
+
+	std::sort(v.begin(), v.end(), startsBefore);
+	s = v.size();
+	for (i = 0; i < s - 1; i++) {
+		if (v[i].end > v[i + 1].start)
+			v[i].end = v[i + 1].start;
+	}
+}
+
+/* Returns the index of the interval that contains time, or NONE */
+int TimeQuery::findAt(const QVector<RunInterval> &v, double time)
+{
+	int idx = std::upper_bound(v.begin(), v.end(), time, endsAfter) -
+		v.begin();
+
+	if (idx < v.size() && v[idx].start <= time)
+		return idx;
+	return NONE;
+}
+
+/* Appends the intervals that overlap [start, end), clipped to it */
+void TimeQuery::findRange(const QVector<RunInterval> &v, double start,
+			  double end, QVector<RunInterval> &result)
+{
+	RunInterval r;
+	int i = std::upper_bound(v.begin(), v.end(), start, endsAfter) -
+		v.begin();
+	int s = v.size();
+
+	for (; i < s && v[i].start < end; i++) {
+		r = v[i];
+		r.start = TSMAX(r.start, start);
+		r.end = TSMIN(r.end, end);
+		result.append(r);
+	}
+}
+
+/* Returns the pid of the task that was running on cpu at time, or NONE */
+int TimeQuery::taskOnCPU(unsigned int cpu, double time) const
+{
+	int idx;
+
+	if (cpu >= (unsigned) cpus.size())
+		return NONE;
+	const QVector<RunInterval> &v = cpus[cpu].intervals;
+	idx = findAt(v, time);
+	return idx != NONE ? v[idx].pid : NONE;
+}
+
+/*
+ * Looks up the task on cpu at each of times, which must be sorted. Each
+ * search starts where the previous one ended.
+ */
+void TimeQuery::taskOnCPU(unsigned int cpu, const QVector<double> &times,
+			  QVector<int> &pids) const
+{
+	QVector<RunInterval>::const_iterator iter;
+	int i, s;
+
+	s = times.size();
+	pids.fill(NONE, s);
+	if (cpu >= (unsigned) cpus.size())
+		return;
+
+	const QVector<RunInterval> &v = cpus[cpu].intervals;
+	iter = v.begin();
+	for (i = 0; i < s; i++) {
+		iter = std::upper_bound(iter, v.end(), times[i], endsAfter);
+		if (iter == v.end())
+			break;
+		if (iter->start <= times[i])
+			pids[i] = iter->pid;
+	}
+}
+
+/* Looks up the task that was running on each CPU at time */
+void TimeQuery::tasksAt(double time, QVector<int> &pids) const
+{
+	int cpu;
+
+	pids.resize(cpus.size());
+	for (cpu = 0; cpu < cpus.size(); cpu++)
+		pids[cpu] = taskOnCPU(cpu, time);
+}
+
+/* Returns the intervals on cpu that overlap [start, end), clipped to it */
+void TimeQuery::cpuIntervals(unsigned int cpu, double start, double end,
+			     QVector<RunInterval> &result) const
+{
+	result.clear();
+	if (cpu < (unsigned) cpus.size())
+		findRange(cpus[cpu].intervals, start, end, result);
+}
+
+/* Returns when and where pid ran during [start, end), clipped to it */
+void TimeQuery::taskIntervals(int pid, double start, double end,
+			      QVector<RunInterval> &result) const
+{
+	QHash<int, QVector<RunInterval>>::const_iterator iter;
+
+	result.clear();
+	iter = tasks.constFind(pid);
+	if (iter != tasks.constEnd())
+		findRange(iter.value(), start, end, result);
+}
+
+/* Returns how long pid was running on any CPU during [start, end) */
+double TimeQuery::taskRunTime(int pid, double start, double end) const
+{
+	QVector<RunInterval> v;
+	double sum = 0;
+	int i;
+
+	taskIntervals(pid, start, end, v);
+	for (i = 0; i < v.size(); i++)
+		sum += v[i].end - v[i].start;
+	return sum;
+}
+
+/* Returns the CPU that pid was running on at time, or NONE */
+int TimeQuery::cpuOfTask(int pid, double time) const
+{
+	QHash<int, QVector<RunInterval>>::const_iterator iter;
+	int idx;
+
+	iter = tasks.constFind(pid);
+	if (iter == tasks.constEnd())
+		return NONE;
+	idx = findAt(iter.value(), time);
+	return idx != NONE ? (int) iter.value()[idx].cpu : NONE;
+}
+
+/*
+ * Returns the frequency of cpu at time, in the unit of the trace, or 0 if it
+ * is not known. Each frequency event is valid until the next one.
+ */
+double TimeQuery::cpuFrequency(unsigned int cpu, double time) const
+{
+	int idx;
+
+	if (cpu >= (unsigned) cpus.size())
+		return 0;
+	const CpuFreq &freq = analyzer->cpuFreq[cpu];
+	idx = std::upper_bound(freq.timev.begin(), freq.timev.end(), time) -
+		freq.timev.begin() - 1;
+	return idx >= 0 ? freq.data[idx] : 0;
+}
+
+/*
+ * Returns the idle state of cpu at time, which is NOT_IDLE if the CPU was
+ * running, or IDLE_UNKNOWN if there was no idle event before time.
+ */
+int TimeQuery::cpuIdleState(unsigned int cpu, double time) const
+{
+	int idx;
+
+	if (cpu >= (unsigned) cpus.size())
+		return IDLE_UNKNOWN;
+	const CpuIdle &idle = analyzer->cpuIdle[cpu];
+	idx = std::upper_bound(idle.timev.begin(), idle.timev.end(), time) -
+		idle.timev.begin() - 1;
+	/* The analyzer stores the idle state plus one */
+	return idx >= 0 ? (int) idle.data[idx] - 1 : IDLE_UNKNOWN;
+}
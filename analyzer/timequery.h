@@ -0,0 +1,149 @@
+// SPDX-License-Identifier: (GPL-2.0-or-later OR BSD-2-Clause)
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2020  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TIMEQUERY_H
+#define TIMEQUERY_H
+
+#include <QHash>
+#include <QVector>
+
+#include "threads/workqueue.h"
+#include "vtl/compiler.h"
+
+class TimeQuery;
+class TraceAnalyzer;
+
+/* A time during which the task pid was running on cpu */
+class RunInterval {
+public:
+	double start;
+	double end;
+	int pid;
+	unsigned int cpu;
+};
+
+/*
+ * The run intervals of the non-idle tasks of one CPU, sorted by their start.
+ * The intervals never overlap, so they are sorted by their end as well and
+ * both point and range queries are binary searches.
+ */
+class CPURunIndex {
+	friend class TimeQuery;
+public:
+	CPURunIndex();
+	bool build();
+	unsigned int cpu;
+	QVector<RunInterval> intervals;
+private:
+	const TimeQuery *owner;
+};
+
+/*
+ * Answers questions such as which task was running on a CPU at a given time,
+ * what a task did during a time range and which frequency or idle state a CPU
+ * was in at a given time. The run intervals are extracted once from the
+ * scheduling graphs of the CPUs, in parallel, and are then indexed both by CPU
+ * and by task, so that every query is a binary search. The queries that take a
+ * vector of times expect the times to be sorted and continue each search where
+ * the previous one ended.
+ */
+class TimeQuery {
+	friend class CPURunIndex;
+public:
+	TimeQuery();
+	~TimeQuery();
+	void build(TraceAnalyzer *analyzer);
+	void clear();
+	vtl_always_inline bool isBuilt() const;
+	int taskOnCPU(unsigned int cpu, double time) const;
+	void taskOnCPU(unsigned int cpu, const QVector<double> &times,
+		       QVector<int> &pids) const;
+	void tasksAt(double time, QVector<int> &pids) const;
+	void cpuIntervals(unsigned int cpu, double start, double end,
+			  QVector<RunInterval> &result) const;
+	void taskIntervals(int pid, double start, double end,
+			   QVector<RunInterval> &result) const;
+	double taskRunTime(int pid, double start, double end) const;
+	int cpuOfTask(int pid, double time) const;
+	double cpuFrequency(unsigned int cpu, double time) const;
+	int cpuIdleState(unsigned int cpu, double time) const;
+	vtl_always_inline unsigned int getNrCPUs() const;
+	/* Returned instead of a pid or a CPU when there is none */
+	static const int NONE = -1;
+	/* Returned by cpuIdleState() when the CPU is running */
+	static const int NOT_IDLE = -1;
+	/* Returned by cpuIdleState() when the state is not known */
+	static const int IDLE_UNKNOWN = -2;
+private:
+	static int findAt(const QVector<RunInterval> &v, double time);
+	static void findRange(const QVector<RunInterval> &v, double start,
+			      double end, QVector<RunInterval> &result);
+	static void sortIntervals(QVector<RunInterval> &v);
+	void buildTaskIndex();
+	TraceAnalyzer *analyzer;
+	QVector<CPURunIndex> cpus;
+	QHash<int, QVector<RunInterval>> tasks;
+	WorkQueue queue;
+	bool built;
+};
+
+vtl_always_inline bool TimeQuery::isBuilt() const
+{
+	return built;
+}
+
+vtl_always_inline unsigned int TimeQuery::getNrCPUs() const
+{
+	return cpus.size();
+}
+
+#endif /* TIMEQUERY_H */
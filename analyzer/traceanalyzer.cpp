@@ -103,10 +103,17 @@ TraceAnalyzer::TraceAnalyzer(const SettingStore *sstore)
 	  startTimeDbl(0), endTimeIdx(0), maxFreq(0), minFreq(0),
 	  maxIdleState(0), minIdleState(0), timePrecision(0), CPUs(nullptr),
 	  customPlot(nullptr), pidFilterInclusive(false),
-	  OR_pidFilterInclusive(false), setstor(sstore)
+	  OR_pidFilterInclusive(false), filterIdxBegin(0), filterIdxEnd(0),
+	  OR_filterIdxBegin(0), OR_filterIdxEnd(0), setstor(sstore)
 {
 	taskNamePool = new StringPool<>(16384, 256);
 	parser = new TraceParser();
+	processingThread = new WorkThread<TraceAnalyzer>
+		(QString("processingThread"), this,
+		 &TraceAnalyzer::threadProcessAll);
+	teardownThread = new WorkThread<TraceAnalyzer>
+		(QString("teardownThread"), this,
+		 &TraceAnalyzer::threadTeardown);
 	filterState.disableAll();
 	OR_filterState.disableAll();
 }
@@ -116,6 +123,9 @@ TraceAnalyzer::~TraceAnalyzer()
 	int dummy;
 
 	TraceAnalyzer::close(&dummy);
+	teardownThread->wait();
+	delete teardownThread;
+	delete processingThread;
 	delete parser;
 	delete taskNamePool;
 }
@@ -157,38 +167,56 @@ bool TraceAnalyzer::isOpen() const
 
 void TraceAnalyzer::close(int *ts_errno)
 {
-	if (cpuTaskMaps != nullptr) {
-		delete[] cpuTaskMaps;
-		cpuTaskMaps = nullptr;
-	}
-	if (cpuFreq != nullptr) {
-		delete[] cpuFreq;
-		cpuFreq = nullptr;
-	}
-	if (cpuIdle != nullptr) {
-		delete[] cpuIdle;
-		cpuIdle = nullptr;
-	}
-	if (CPUs != nullptr) {
-		delete[] CPUs;
-		CPUs = nullptr;
-	}
+	abortProcessing();
+	processingPhase.storeRelease(PROCESSING_IDLE);
+	abortRequested.storeRelease(0);
 
-	DEFINE_TASKMAP_ITERATOR(iter) = taskMap.begin();
-	while (iter != taskMap.end()) {
-		Task *task = iter.value().task;
-		delete task;
-		iter++;
-	}
-
-	taskMap.clear();
 	disableAllFilters();
-	migrations.clear();
-	colorMap.clear();
+	detachTrace();
+	wakeLatency.clear();
+	pendingWakeIdx.clear();
+	eventRateIndex.clear();
+	timeQuery.clear();
+	wakeChain.clear();
 	parser->close(ts_errno);
 	taskNamePool->clear();
 }
 
+/*
+ * Moves the data structures of the trace that is being closed to the detached
+ * trace and frees them in the teardown thread. Only one detached trace is kept,
+ * so we need to wait for the previous teardown to complete before we can reuse
+ * it; normally it has completed long before the next trace is closed.
+ */
+void TraceAnalyzer::detachTrace()
+{
+	teardownThread->wait();
+
+	detached.cpuTaskMaps = cpuTaskMaps;
+	detached.cpuFreq = cpuFreq;
+	detached.cpuIdle = cpuIdle;
+	detached.CPUs = CPUs;
+	cpuTaskMaps = nullptr;
+	cpuFreq = nullptr;
+	cpuIdle = nullptr;
+	CPUs = nullptr;
+
+	detached.taskMap.swap(taskMap);
+	detached.colorMap.swap(colorMap);
+	detached.migrations.swap(migrations);
+	detached.wakeTimev.swap(wakeTimev);
+	detached.wakeDelay.swap(wakeDelay);
+	parser->detachEvents(&detached.ftraceEvents, &detached.perfEvents);
+	events = nullptr;
+
+	teardownThread->start();
+}
+
+void TraceAnalyzer::threadTeardown()
+{
+	detached.free();
+}
+
 void TraceAnalyzer::resetProperties()
 {
 	maxCPU = 0;
@@ -208,14 +236,157 @@ void TraceAnalyzer::resetProperties()
 void TraceAnalyzer::processTrace()
 {
 	resetProperties();
-	/*
-	 * We do the processing from the main thread, since otherwise
-	 * we would have to wait for it
-	 */
 	threadProcess();
+	if (processingAborted())
+		return;
 	colorizeTasks();
 }
 
+/*
+ * Starts the processing of a newly opened trace in the background. The caller
+ * can follow the progress with getProcessingPhase(). The data needed for the
+ * graphs is ready when the phase has reached PROCESSING_STATS, the statistics
+ * are ready when it has reached PROCESSING_DONE.
+ */
+void TraceAnalyzer::startProcessing()
+{
+	abortRequested.storeRelease(0);
+	processingPhase.storeRelease(PROCESSING_ANALYZE);
+	processingThread->start();
+}
+
+/*
+ * Stops the background processing as soon as possible and waits for it. The
+ * data structures are left in an incomplete state, so the trace should be
+ * closed afterwards.
+ */
+void TraceAnalyzer::abortProcessing()
+{
+	if (!processingThread->isRunning())
+		return;
+	abortRequested.storeRelease(1);
+	parser->abortParsing();
+	processingThread->wait();
+}
+
+/* Returns how many permille of the trace file that has been loaded */
+int TraceAnalyzer::getLoadProgress() const
+{
+	return parser->getProgress();
+}
+
+void TraceAnalyzer::threadProcessAll()
+{
+	processTrace();
+	if (processingAborted())
+		goto out;
+
+	processingPhase.storeRelease(PROCESSING_LOD);
+	doSchedLOD();
+	if (processingAborted())
+		goto out;
+	buildTimeQuery();
+	if (processingAborted())
+		goto out;
+	buildWakeChain();
+	if (processingAborted())
+		goto out;
+	doScaleSched();
+	if (processingAborted())
+		goto out;
+
+	processingPhase.storeRelease(PROCESSING_STATS);
+	doStats();
+	if (processingAborted())
+		goto out;
+	doLatencyStats();
+out:
+	processingPhase.storeRelease(PROCESSING_DONE);
+}
+
+/*
+ * Builds the level-of-detail pyramids of all scheduling graphs. They don't
+ * depend on the layout, so this can be done before the trace is shown.
+ */
+void TraceAnalyzer::doSchedLOD()
+{
+	QList<AbstractWorkItem*> workList;
+	unsigned int cpu;
+	int i, s;
+
+	for (cpu = 0; cpu <= getMaxCPU(); cpu++) {
+		DEFINE_CPUTASKMAP_ITERATOR(iter) = cpuTaskMaps[cpu].begin();
+		while (iter != cpuTaskMaps[cpu].end()) {
+			CPUTask &task = iter.value();
+			WorkItem<CPUTask> *taskItem = new WorkItem<CPUTask>
+				(&task, &CPUTask::doSchedLOD);
+			workList.append(taskItem);
+			scalingQueue.addWorkItem(taskItem);
+			iter++;
+		}
+	}
+
+	scalingQueue.start();
+	scalingQueue.wait();
+
+	s = workList.size();
+	for (i = 0; i < s; i++)
+		delete workList[i];
+}
+
+/*
+ * Computes the scaled wakeup vectors of the scheduling graphs, with the scale
+ * that has been set by setSchedScales() before the processing was started.
+ * The offsets are set later by doRelayout(), when the layout is known.
+ */
+void TraceAnalyzer::doScaleSched()
+{
+	QList<AbstractWorkItem*> workList;
+	unsigned int cpu;
+	double scale;
+	int i, s;
+
+	for (cpu = 0; cpu <= getMaxCPU(); cpu++) {
+		scale = schedScale.value(cpu);
+		DEFINE_CPUTASKMAP_ITERATOR(iter) = cpuTaskMaps[cpu].begin();
+		while (iter != cpuTaskMaps[cpu].end()) {
+			CPUTask &task = iter.value();
+			task.scale = scale;
+			WorkItem<CPUTask> *taskItem = new WorkItem<CPUTask>
+				(&task, &CPUTask::doScaleWakeup);
+			workList.append(taskItem);
+			scalingQueue.addWorkItem(taskItem);
+			iter++;
+		}
+	}
+
+	scalingQueue.start();
+	scalingQueue.wait();
+
+	s = workList.size();
+	for (i = 0; i < s; i++)
+		delete workList[i];
+}
+
+/*
+ * Indexes the run intervals of all CPUs and tasks, for the queries of
+ * getTimeQuery(). This must be done after processTrace().
+ */
+void TraceAnalyzer::buildTimeQuery()
+{
+	timeQuery.build(this);
+}
+
+/*
+ * Links every time that a task was switched in to the wakeup and the waker
+ * that preceded it, for the wake chains of getWakeChain(). This must be done
+ * after processTrace().
+ */
+void TraceAnalyzer::buildWakeChain()
+{
+	wakeChain.build(this);
+}
+
 void TraceAnalyzer::threadProcess()
 {
 	parser->waitForTraceType();
@@ -232,6 +403,33 @@ void TraceAnalyzer::threadProcess()
 	}
 	processSchedAddTail();
 	processFreqAddTail();
+	processPendingWakeIdx();
+}
+
+/*
+ * Gives the wakeup and waking events that were kept aside to the tasks that
+ * were created after them. The tasks that never got created are dropped, so
+ * that unsuccessful wakeups don't add tasks that never run. The kept events
+ * precede all the events of the task, since they were only kept aside while
+ * there was no task.
+ */
+void TraceAnalyzer::processPendingWakeIdx()
+{
+	QMap<int, PendingWakeIdx>::const_iterator iter;
+	Task *task;
+
+	for (iter = pendingWakeIdx.constBegin();
+	     iter != pendingWakeIdx.constEnd();
+	     iter++) {
+		const PendingWakeIdx &pending = iter.value();
+		task = findTask(iter.key());
+		if (task == nullptr)
+			continue;
+		task->wakeupIdx = pending.wakeupIdx + task->wakeupIdx;
+		task->wakeupNewIdx = pending.wakeupNewIdx + task->wakeupNewIdx;
+		task->wakingIdx = pending.wakingIdx + task->wakingIdx;
+	}
+	pendingWakeIdx.clear();
 }
 
 void TraceAnalyzer::processSchedAddTail()
@@ -484,18 +682,6 @@ int TraceAnalyzer::binarySearch(const vtl::Time &time, int start, int end)
 		return binarySearch(time, pivot, end);
 }
 
-int TraceAnalyzer::binarySearchFiltered(const vtl::Time &time, int start,
-					int end) const
-{
-	int pivot = (end + start) / 2;
-	if (pivot == start)
-		return pivot;
-	if (time < filteredEvents.at(pivot)->time)
-		return binarySearchFiltered(time, start, pivot);
-	else
-		return binarySearchFiltered(time, pivot, end);
-}
-
 int TraceAnalyzer::findIndexBefore(const vtl::Time &time) const
 {
 	if (events->size() < 1)
@@ -536,24 +722,44 @@ int TraceAnalyzer::findIndexAfter(const vtl::Time &time) const
 	return c;
 }
 
-int TraceAnalyzer::findFilteredIndexBefore(const vtl::Time &time) const
+/*
+ * Returns the index of the first event that does not have a time less than
+ * time, or the number of events if there is no such event.
+ */
+unsigned int TraceAnalyzer::lowerBound(const vtl::Time &time) const
 {
-	if (filteredEvents.size() < 1)
-		return -1;
-
-	int end = filteredEvents.size() - 1;
-
-	/* Basic sanity checks */
-	if (time > filteredEvents.at(end)->time)
-		return end;
-	if (time < filteredEvents.at(0)->time)
-		return 0;
-
-	int c = binarySearchFiltered(time, 0, end);
+	unsigned int low = 0;
+	unsigned int high = events->size();
+	unsigned int pivot;
+
+	while (low < high) {
+		pivot = (low + high) / 2;
+		if (events->at(pivot).time < time)
+			low = pivot + 1;
+		else
+			high = pivot;
+	}
+	return low;
+}
 
-	while (c > 0 && filteredEvents.at(c)->time >= time)
-		c--;
-	return c;
+/*
+ * Returns the index of the first event that has a time greater than time, or
+ * the number of events if there is no such event.
+ */
+unsigned int TraceAnalyzer::upperBound(const vtl::Time &time) const
+{
+	unsigned int low = 0;
+	unsigned int high = events->size();
+	unsigned int pivot;
+
+	while (low < high) {
+		pivot = (low + high) / 2;
+		if (events->at(pivot).time <= time)
+			low = pivot + 1;
+		else
+			high = pivot;
+	}
+	return low;
 }
 
 const TraceEvent *TraceAnalyzer::findPreviousSchedEvent(const vtl::Time &time,
@@ -561,21 +767,22 @@ const TraceEvent *TraceAnalyzer::findPreviousSchedEvent(const vtl::Time &time,
 							int *index) const
 {
 	int start = findIndexBefore(time);
+	const Task *task;
 	int i;
 
 	if (start < 0)
 		return nullptr;
 
-	for (i = start; i >= 0; i--) {
-		const TraceEvent &event = events->at(i);
-		if (event.type == SCHED_SWITCH  &&
-		    generic_sched_switch_newpid(event) == pid) {
-			if (index != nullptr)
-				*index = i;
-			return &event;
-		}
-	}
-	return nullptr;
+	task = findTask(pid);
+	if (task == nullptr)
+		return nullptr;
+
+	i = Task::findIdxBefore(task->schedInIdx, start);
+	if (i < 0)
+		return nullptr;
+	if (index != nullptr)
+		*index = i;
+	return &events->at(i);
 }
 
 const TraceEvent *TraceAnalyzer::findNextSchedSleepEvent(const vtl::Time &time,
@@ -583,48 +790,44 @@ const TraceEvent *TraceAnalyzer::findNextSchedSleepEvent(const vtl::Time &time,
 							 int *index) const
 {
 	int start = findIndexAfter(time);
+	const Task *task;
 	int i;
-	int s = events->size();
 
 	if (start < 0)
 		return nullptr;
 
-	for (i = start; i < s; i++) {
-		const TraceEvent &event = events->at(i);
-		if (event.type == SCHED_SWITCH &&
-		    generic_sched_switch_oldpid(event) == pid &&
-		    !task_state_is_runnable(
-			    generic_sched_switch_state(event))) {
-			if (index != nullptr)
-				*index = i;
-			return &event;
-		}
-	}
-	return nullptr;
+	task = findTask(pid);
+	if (task == nullptr)
+		return nullptr;
+
+	i = Task::findIdxAfter(task->sleepIdx, start);
+	if (i < 0)
+		return nullptr;
+	if (index != nullptr)
+		*index = i;
+	return &events->at(i);
 }
 
 const TraceEvent *TraceAnalyzer::findFilteredEvent(int index,
 						   int *filterIndex) const
 {
-	const TraceEvent *eptr = &events->at(index);
-	vtl::Time time = eptr->time;
-	int s = filteredEvents.size();
+	const unsigned int bpw = vtl::BitMap::BITS_PER_WORD;
+	unsigned int windex;
+	unsigned int bitnr;
+	vtl::BitMap::word_t mask;
 	int i;
-	int start = findFilteredIndexBefore(time);
 
-	if (start < 0)
+	if (index < 0 || !filteredBits.test(index))
 		return nullptr;
 
-	for (i = start; i < s; i++) {
-		const TraceEvent *cptr = filteredEvents[i];
-		if (cptr == eptr) {
-			*filterIndex = i;
-			return cptr;
-		}
-		if (cptr->time > time)
-			break;
-	}
-	return nullptr;
+	/* The index is the number of set bits that precede the bit */
+	windex = index / bpw;
+	bitnr = index % bpw;
+	mask = (((vtl::BitMap::word_t) 0x1) << bitnr) - 1;
+	i = filteredRank[windex] +
+		vtl::BitMap::popcount(filteredBits.word(windex) & mask);
+	*filterIndex = i;
+	return filteredEvents[i];
 }
 
 const TraceEvent *TraceAnalyzer::findPreviousWakEvent(int startidx,
@@ -633,32 +836,37 @@ const TraceEvent *TraceAnalyzer::findPreviousWakEvent(int startidx,
 						      int *index) const
 {
 	int i;
-	int epid = 0;
+	const Task *task;
+	const QVector<int> *idxv;
 
 	if (startidx < 0 || startidx >= (int) events->size())
 		return nullptr;
 
-	if (wanted != SCHED_WAKEUP && wanted != SCHED_WAKEUP_NEW &&
-	    wanted != SCHED_WAKING)
+	task = findTask(pid);
+	if (task == nullptr)
 		return nullptr;
 
-	for (i = startidx; i >= 0; i--) {
-		const TraceEvent &event = events->at(i);
-		if ((event.type == wanted ||
-		     (wanted == SCHED_WAKEUP &&
-		      event.type == SCHED_WAKEUP_NEW))) {
-			if (wanted == SCHED_WAKING)
-				epid = generic_sched_waking_pid(event);
-			else
-				epid = generic_sched_wakeup_pid(event);
-			if (epid != pid)
-				continue;
-			if (index != nullptr)
-				*index = i;
-			return &event;
-		}
+	switch (wanted) {
+	case SCHED_WAKEUP:
+		/* The wakeupIdx vector also contains the sched_wakeup_new */
+		idxv = &task->wakeupIdx;
+		break;
+	case SCHED_WAKEUP_NEW:
+		idxv = &task->wakeupNewIdx;
+		break;
+	case SCHED_WAKING:
+		idxv = &task->wakingIdx;
+		break;
+	default:
+		return nullptr;
 	}
-	return nullptr;
+
+	i = Task::findIdxBefore(*idxv, startidx);
+	if (i < 0)
+		return nullptr;
+	if (index != nullptr)
+		*index = i;
+	return &events->at(i);
 }
 
 const TraceEvent *TraceAnalyzer::findWakingEvent(const TraceEvent *wakeup,
@@ -667,7 +875,7 @@ const TraceEvent *TraceAnalyzer::findWakingEvent(const TraceEvent *wakeup,
 	int i;
 	int startidx = findIndexBefore(wakeup->time);
 	int wpid = generic_sched_wakeup_pid(*wakeup);
-	int pid;
+	const Task *task;
 
 	if (wpid == INT_MAX)
 		return nullptr;
@@ -675,24 +883,16 @@ const TraceEvent *TraceAnalyzer::findWakingEvent(const TraceEvent *wakeup,
 	if (startidx < 0 || startidx >= (int) events->size())
 		return nullptr;
 
-	for (i = startidx; i >= 0; i--) {
-		const TraceEvent &event = events->at(i);
-		if (event.type != SCHED_WAKING)
-			continue;
-		pid = generic_sched_waking_pid(event);
-		if (pid == wpid) {
-			if (index != nullptr)
-				*index = i;
-			return &event;
-		} else if (pid == INT_MAX) {
-			/*
-			 * If we encounter a single waking event where we
-			 * can not parse the arguments, then we give up
-			 */
-			return nullptr;
-		}
-	}
-	return nullptr;
+	task = findTask(wpid);
+	if (task == nullptr)
+		return nullptr;
+
+	i = Task::findIdxBefore(task->wakingIdx, startidx);
+	if (i < 0)
+		return nullptr;
+	if (index != nullptr)
+		*index = i;
+	return &events->at(i);
 }
 
 void TraceAnalyzer::setSchedOffset(unsigned int cpu, double offset)
@@ -705,6 +905,11 @@ void TraceAnalyzer::setSchedScale(unsigned int cpu, double scale)
 	schedScale[cpu] = scale;
 }
 
+void TraceAnalyzer::setSchedScales(double scale)
+{
+	schedScale.fill(scale);
+}
+
 void TraceAnalyzer::setCpuIdleOffset(unsigned int cpu, double offset)
 {
 	cpuIdleOffset[cpu] = offset;
@@ -740,30 +945,22 @@ void TraceAnalyzer::setQCustomPlot(QCustomPlot *plot)
 	customPlot = plot;
 }
 
-void TraceAnalyzer::addCpuFreqWork(unsigned int cpu,
-				   QList<AbstractWorkItem*> &list)
+/*
+ * The graphs apply the offset and the scale when they are plotted, so only
+ * the parameters need to be set here.
+ */
+void TraceAnalyzer::scaleCpuFreq(unsigned int cpu)
 {
-	double scale = cpuFreqScale.value(cpu);
-	double offset = cpuFreqOffset.value(cpu);
 	CpuFreq *freq = cpuFreq + cpu;
-	freq->scale = scale;
-	freq->offset = offset;
-	WorkItem<CpuFreq> *freqItem = new WorkItem<CpuFreq>
-		(freq, &CpuFreq::doScale);
-	list.append(freqItem);
+	freq->scale = cpuFreqScale.value(cpu);
+	freq->offset = cpuFreqOffset.value(cpu);
 }
 
-void TraceAnalyzer::addCpuIdleWork(unsigned int cpu,
-				   QList<AbstractWorkItem*> &list)
+void TraceAnalyzer::scaleCpuIdle(unsigned int cpu)
 {
-	double scale = cpuIdleScale.value(cpu);
-	double offset = cpuIdleOffset.value(cpu);
 	CpuIdle *idle = cpuIdle + cpu;
-	idle->scale = scale;
-	idle->offset = offset;
-	WorkItem<CpuIdle> *idleItem = new WorkItem<CpuIdle>
-		(idle, &CpuIdle::doScale);
-	list.append(idleItem);
+	idle->scale = cpuIdleScale.value(cpu);
+	idle->offset = cpuIdleOffset.value(cpu);
 }
 
 void TraceAnalyzer::addCpuSchedWork(unsigned int cpu,
@@ -777,19 +974,10 @@ void TraceAnalyzer::addCpuSchedWork(unsigned int cpu,
 		task.scale = scale;
 		task.offset = offset;
 		WorkItem<CPUTask> *taskItem = new WorkItem<CPUTask>
-			(&task, &CPUTask::doScale);
-		list.append(taskItem);
-		taskItem = new WorkItem<CPUTask>(&task,
-						 &CPUTask::doScaleWakeup);
+			(&task, &CPUTask::doScaleWakeup);
 		list.append(taskItem);
 		taskItem = new WorkItem<CPUTask>(&task,
-						 &CPUTask::doScaleRunning);
-		list.append(taskItem);
-		taskItem = new WorkItem<CPUTask>(&task,
-						 &CPUTask::doScalePreempted);
-		list.append(taskItem);
-		taskItem = new WorkItem<CPUTask>(&task,
-						 &CPUTask::doScaleUnint);
+						 &CPUTask::doSchedLOD);
 		list.append(taskItem);
 		iter++;
 	}
@@ -802,28 +990,29 @@ void TraceAnalyzer::addCpuSchedWork(unsigned int cpu,
  */
 void TraceAnalyzer::scaleMigration()
 {
-	QList<Migration>::iterator iter;
-	double unit = migrationScale / getNrCPUs();
+	QList<Migration>::const_iterator iter;
+	MigrationPlot *plot;
 	const int width = setstor->getValue(Setting::MIGRATION_WIDTH).intv();
+
+	/*
+	 * The constructor will save a pointer to the MigrationPlot object in
+	 * the customPlot object.
+	 */
+	plot = new MigrationPlot(customPlot->xAxis, customPlot->yAxis);
+	plot->setGeometry(migrationOffset, migrationScale / getNrCPUs());
+	plot->setWidth(width);
+	plot->reserve(migrations.size());
+	migrationPlot = plot;
 	for (iter = migrations.begin(); iter != migrations.end(); iter++) {
-		Migration &m = *iter;
-		double s = migrationOffset + (m.oldcpu + 1) * unit;
-		double e = migrationOffset + (m.newcpu + 1) * unit;
-		QColor color = getTaskColor(m.pid);
-		/*
-		 * The constructor will save a pointer to the MigrationArrow
-		 * object in the customPlot object.
-		 */
-		new MigrationArrow(s, e, m.time.toDouble(), color,
-				   customPlot, width);
+		const Migration &m = *iter;
+		plot->addMigration(m.time.toDouble(), m.oldcpu + 1,
+				   m.newcpu + 1, getTaskColor(m.pid));
 	}
 }
 
 bool TraceAnalyzer::enableMigrations()
 {
-	return (setstor->getValue(Setting::SHOW_MIGRATION_GRAPHS).boolv() &&
-		(setstor->getValue(Setting::SHOW_MIGRATION_UNLIMITED).boolv() ||
-		 migrations.size() < MAX_NR_MIGRATIONS));
+	return setstor->getValue(Setting::SHOW_MIGRATION_GRAPHS).boolv();
 }
 
 void TraceAnalyzer::doScale()
@@ -833,25 +1022,19 @@ void TraceAnalyzer::doScale()
 	int i;
 	int s = 0;
 	bool useWorkList =
-		setstor->getValue(Setting::SHOW_CPUFREQ_GRAPHS).boolv() ||
-		setstor->getValue(Setting::SHOW_CPUIDLE_GRAPHS).boolv() ||
 		setstor->getValue(Setting::SHOW_SCHED_GRAPHS).boolv();
 
+	for (cpu = 0; cpu <= getMaxCPU(); cpu++) {
+		if (setstor->getValue(Setting::SHOW_CPUFREQ_GRAPHS).boolv())
+			scaleCpuFreq(cpu);
+		if (setstor->getValue(Setting::SHOW_CPUIDLE_GRAPHS).boolv())
+			scaleCpuIdle(cpu);
+	}
+
 	if (useWorkList) {
-		for (cpu = 0; cpu <= getMaxCPU(); cpu++) {
-			/* CpuFreq items */
-			if (setstor->getValue(Setting::SHOW_CPUFREQ_GRAPHS)
-			    .boolv())
-				addCpuFreqWork(cpu, workList);
-			/* CpuIdle items */
-			if (setstor->getValue(Setting::SHOW_CPUIDLE_GRAPHS)
-			    .boolv())
-				addCpuIdleWork(cpu, workList);
-			/* Task items */
-			if (setstor->getValue(Setting::SHOW_SCHED_GRAPHS)
-			    .boolv())
-				addCpuSchedWork(cpu, workList);
-		}
+		/* Task items */
+		for (cpu = 0; cpu <= getMaxCPU(); cpu++)
+			addCpuSchedWork(cpu, workList);
 		s = workList.size();
 		for (i = 0; i < s; i++)
 			scalingQueue.addWorkItem(workList[i]);
@@ -869,6 +1052,66 @@ void TraceAnalyzer::doScale()
 	}
 }
 
+/*
+ * Recomputes the wakeup vectors of the scheduling graphs, which is needed
+ * when the maximum of the vertical wakeup graphs has been changed.
+ */
+void TraceAnalyzer::doScaleWakeup()
+{
+	QList<AbstractWorkItem*> workList;
+	unsigned int cpu;
+	int i, s;
+
+	for (cpu = 0; cpu <= getMaxCPU(); cpu++) {
+		DEFINE_CPUTASKMAP_ITERATOR(iter) = cpuTaskMaps[cpu].begin();
+		while (iter != cpuTaskMaps[cpu].end()) {
+			CPUTask &task = iter.value();
+			WorkItem<CPUTask> *taskItem = new WorkItem<CPUTask>
+				(&task, &CPUTask::doScaleWakeup);
+			workList.append(taskItem);
+			scalingQueue.addWorkItem(taskItem);
+			iter++;
+		}
+	}
+
+	scalingQueue.start();
+	scalingQueue.wait();
+
+	s = workList.size();
+	for (i = 0; i < s; i++)
+		delete workList[i];
+}
+
+/*
+ * Moves the graphs to the offsets that have been set by the layout functions,
+ * without redoing anything that depends on the scale. The migration graph is
+ * recreated, so the caller must have removed the old one.
+ */
+void TraceAnalyzer::doRelayout()
+{
+	unsigned int cpu;
+	double offset;
+
+	for (cpu = 0; cpu <= getMaxCPU(); cpu++) {
+		if (setstor->getValue(Setting::SHOW_CPUFREQ_GRAPHS).boolv())
+			scaleCpuFreq(cpu);
+		if (setstor->getValue(Setting::SHOW_CPUIDLE_GRAPHS).boolv())
+			scaleCpuIdle(cpu);
+		if (!setstor->getValue(Setting::SHOW_SCHED_GRAPHS).boolv())
+			continue;
+		offset = schedOffset.value(cpu);
+		DEFINE_CPUTASKMAP_ITERATOR(iter) = cpuTaskMaps[cpu].begin();
+		while (iter != cpuTaskMaps[cpu].end()) {
+			CPUTask &task = iter.value();
+			task.offset = offset;
+			iter++;
+		}
+	}
+
+	if (enableMigrations())
+		scaleMigration();
+}
+
 void TraceAnalyzer::doStats()
 {
 	QList<AbstractWorkItem*> workList;
@@ -913,6 +1156,127 @@ void TraceAnalyzer::doLimitedStats()
 		delete workList[i];
 }
 
+/*
+ * Builds the latency histograms of all tasks, all CPUs and of the whole
+ * trace. This needs to be done before getLatencyGroups() is used.
+ */
+void TraceAnalyzer::doLatencyStats()
+{
+	QList<AbstractWorkItem*> workList;
+	unsigned int cpu;
+	int i, s;
+
+	DEFINE_TASKMAP_ITERATOR(iter);
+	for(iter = taskMap.begin(); iter != taskMap.end(); iter++) {
+		Task *task = iter.value().task;
+		WorkItem<Task> *taskItem = new WorkItem<Task>
+			(task, &Task::doLatencyStats);
+		workList.append(taskItem);
+		statsQueue.addWorkItem(taskItem);
+	}
+
+	for (cpu = 0; cpu <= maxCPU; cpu++) {
+		WorkItem<CPU> *cpuItem = new WorkItem<CPU>
+			(&CPUs[cpu], &CPU::doLatencyStats);
+		workList.append(cpuItem);
+		statsQueue.addWorkItem(cpuItem);
+	}
+
+	statsQueue.start();
+	/* The global index is built while the work items are processed */
+	wakeLatency.build(wakeDelay);
+	statsQueue.wait();
+
+	s = workList.size();
+	for (i = 0; i < s; i++)
+		delete workList[i];
+}
+
+/*
+ * Computes the latency histograms of the requested type of groups. If limited
+ * is true, then only the wakeups between the cursors are included.
+ */
+void TraceAnalyzer::getLatencyGroups(latencygroup_t type, bool limited,
+				     QList<LatencyGroup> &groups) const
+{
+	double start = AbstractTask::lowerTimeLimit.toDouble();
+	double end = AbstractTask::higherTimeLimit.toDouble();
+	QMap<QString, int> nameMap;
+	QMap<QString, int>::iterator nameIter;
+	LatencyGroup group;
+	unsigned int cpu;
+	int idx;
+	DEFINE_TASKMAP_ITERATOR(iter);
+
+	groups.clear();
+
+	switch (type) {
+	case LATENCY_GLOBAL:
+		group.name = QString("All");
+		group.id = -1;
+		if (limited)
+			wakeLatency.addRange(group.hist, wakeTimev, wakeDelay,
+					     start, end);
+		else
+			group.hist = wakeLatency.getTotal();
+		groups.append(group);
+		break;
+	case LATENCY_CPU:
+		for (cpu = 0; cpu <= maxCPU; cpu++) {
+			const CPU &c = CPUs[cpu];
+			group.name = QString("cpu") + QString::number(cpu);
+			group.id = cpu;
+			group.hist.clear();
+			if (limited)
+				c.wakeLatency.addRange(group.hist,
+						       c.wakeTimev,
+						       c.wakeDelay,
+						       start, end);
+			else
+				group.hist = c.wakeLatency.getTotal();
+			groups.append(group);
+		}
+		break;
+	case LATENCY_NAME:
+	case LATENCY_TASK:
+		for(iter = taskMap.begin(); iter != taskMap.end(); iter++) {
+			const Task *task = iter.value().task;
+			if (task->wakeDelay.isEmpty())
+				continue;
+			if (type == LATENCY_NAME) {
+				group.name = task->getLastName();
+				group.id = -1;
+				nameIter = nameMap.find(group.name);
+				if (nameIter != nameMap.end()) {
+					idx = nameIter.value();
+				} else {
+					idx = groups.size();
+					nameMap[group.name] = idx;
+					group.hist.clear();
+					groups.append(group);
+				}
+			} else {
+				group.name = *task->displayName;
+				group.id = task->pid;
+				group.hist.clear();
+				idx = groups.size();
+				groups.append(group);
+			}
+			LatencyHistogram &hist = groups[idx].hist;
+			if (limited)
+				task->wakeLatency.addRange(hist,
+							   task->wakeTimev,
+							   task->wakeDelay,
+							   start, end);
+			else
+				hist.merge(task->wakeLatency.getTotal());
+		}
+		break;
+	default:
+		break;
+	}
+}
+
 void TraceAnalyzer::processFtrace()
 {
 	processGeneric(TRACE_TYPE_FTRACE);
@@ -923,61 +1287,203 @@ void TraceAnalyzer::processPerf()
 	processGeneric(TRACE_TYPE_PERF);
 }
 
-void TraceAnalyzer::processAllFilters()
+FilterChunk::FilterChunk():
+	analyzer(nullptr), beginWord(0), endWord(0)
+{}
+
+bool FilterChunk::process()
 {
-	int i;
-	int s = events->size();
-	const TraceEvent *eptr;
+	analyzer->processFilterWords(beginWord, endWord);
+	return false; /* No error */
+}
 
-	filteredEvents.clear();
+template<class T>
+static void filterMapToBits(const QMap<T, T> &map, vtl::BitMap &bits)
+{
+	typename QMap<T, T>::const_iterator iter;
+	int key;
+
+	if (map.isEmpty()) {
+		bits.clear();
+		return;
+	}
 
-	for (i = 0; i < s; i++) {
-		const TraceEvent &event = events->at(i);
-		eptr = &event;
-		/* OR filters */
-		if (OR_filterState.isEnabled(FilterState::FILTER_CPU)) {
-			if (OR_filterCPUMap.contains(event.cpu)) {
-				filteredEvents.append(eptr);
+	/*
+	 * The map is sorted, so the last key is the greatest. A huge key would
+	 * need a huge bitmap, so the keys from FILTER_BITS_MAX and up are left
+	 * to the map. The CPUs and the event types are always smaller.
+	 */
+	key = (int) map.lastKey();
+	key = TSMIN(key, FILTER_BITS_MAX - 1);
+	bits.resize(key >= 0 ? key + 1 : 0);
+	for (iter = map.begin(); iter != map.end(); iter++) {
+		key = (int) iter.key();
+		if (key >= 0 && key < FILTER_BITS_MAX)
+			bits.set(key);
+	}
+}
+
+void TraceAnalyzer::prepareFilterBits()
+{
+	filterMapToBits(filterCPUMap, filterCPUBits);
+	filterMapToBits(OR_filterCPUMap, OR_filterCPUBits);
+	filterMapToBits(filterEventMap, filterEventBits);
+	filterMapToBits(OR_filterEventMap, OR_filterEventBits);
+	filterMapToBits(filterPidMap, filterPidBits);
+	filterMapToBits(OR_filterPidMap, OR_filterPidBits);
+
+	/* The time filters are converted to index ranges */
+	filterIdxBegin = lowerBound(filterTimeLow);
+	filterIdxEnd = upperBound(filterTimeHigh);
+	OR_filterIdxBegin = lowerBound(OR_filterTimeLow);
+	OR_filterIdxEnd = upperBound(OR_filterTimeHigh);
+}
+
+void TraceAnalyzer::processFilterWords(unsigned int beginWord,
+				       unsigned int endWord)
+{
+	const unsigned int bpw = vtl::BitMap::BITS_PER_WORD;
+	const vtl::BitMap::word_t allbits = ~((vtl::BitMap::word_t) 0);
+	unsigned int s = events->size();
+	unsigned int w, i, n, base;
+	vtl::BitMap::word_t word, andmask, bit;
+
+	bool orCPU = OR_filterState.isEnabled(FilterState::FILTER_CPU);
+	bool orPid = OR_filterState.isEnabled(FilterState::FILTER_PID);
+	bool orEvent = OR_filterState.isEnabled(FilterState::FILTER_EVENT);
+	bool orTime = OR_filterState.isEnabled(FilterState::FILTER_TIME);
+	bool orArg = OR_filterState.isEnabled(FilterState::FILTER_ARG);
+	bool orAny = orCPU || orPid || orEvent || orArg;
+	bool andCPU = filterState.isEnabled(FilterState::FILTER_CPU);
+	bool andPid = filterState.isEnabled(FilterState::FILTER_PID);
+	bool andEvent = filterState.isEnabled(FilterState::FILTER_EVENT);
+	bool andTime = filterState.isEnabled(FilterState::FILTER_TIME);
+	bool andArg = filterState.isEnabled(FilterState::FILTER_ARG);
+
+	for (w = beginWord; w < endWord; w++) {
+		base = w * bpw;
+		n = TSMIN(bpw, s - base);
+
+		/* The time filters are applied to the whole word at once */
+		if (orTime)
+			word = vtl::BitMap::rangeMask(w, OR_filterIdxBegin,
+						      OR_filterIdxEnd);
+		else
+			word = 0;
+		if (andTime)
+			andmask = vtl::BitMap::rangeMask(w, filterIdxBegin,
+							 filterIdxEnd);
+		else
+			andmask = allbits;
+
+		/*
+		 * If there are no other OR filters, then we can skip the
+		 * whole word if all events that pass the AND time filter
+		 * have already passed the OR time filter
+		 */
+		if (!orAny && (andmask & ~word) == 0)
+			goto store;
+
+		for (i = 0; i < n; i++) {
+			bit = ((vtl::BitMap::word_t) 0x1) << i;
+			if ((word & bit) != 0)
+				continue;
+			const TraceEvent &event = events->at(base + i);
+			/* OR filters */
+			if (orCPU && OR_filterCPUBits.test(event.cpu)) {
+				word |= bit;
 				continue;
 			}
-		}
-		if (OR_filterState.isEnabled(FilterState::FILTER_PID) &&
-		    !processPidFilter(event, OR_filterPidMap,
-				      OR_pidFilterInclusive)) {
-			filteredEvents.append(eptr);
-			continue;
-		}
-		if (OR_filterState.isEnabled(FilterState::FILTER_EVENT)) {
-			if (OR_filterEventMap.contains(event.type) ) {
-				filteredEvents.append(eptr);
+			if (orPid &&
+			    !processPidFilter(event, OR_filterPidBits,
+					      OR_filterPidMap,
+					      OR_pidFilterInclusive)) {
+				word |= bit;
 				continue;
 			}
-		}
-		if (OR_filterState.isEnabled(FilterState::FILTER_TIME)) {
-			if (event.time >= OR_filterTimeLow &&
-			    event.time <= OR_filterTimeHigh) {
-				filteredEvents.append(eptr);
+			if (orEvent && OR_filterEventBits.test(event.type)) {
+				word |= bit;
 				continue;
 			}
+			if (orArg && OR_argFilter.match(event)) {
+				word |= bit;
+				continue;
+			}
+			/* AND filters */
+			if ((andmask & bit) == 0)
+				continue;
+			if (andCPU && !filterCPUBits.test(event.cpu))
+				continue;
+			if (andPid &&
+			    processPidFilter(event, filterPidBits,
+					     filterPidMap,
+					     pidFilterInclusive))
+				continue;
+			if (andEvent && !filterEventBits.test(event.type))
+				continue;
+			if (andArg && !argFilter.match(event))
+				continue;
+			word |= bit;
 		}
-		/* AND filters */
-		if (filterState.isEnabled(FilterState::FILTER_CPU) &&
-		    !filterCPUMap.contains(event.cpu)) {
-			continue;
-		}
-		if (filterState.isEnabled(FilterState::FILTER_PID) &&
-		    processPidFilter(event, filterPidMap,
-				     pidFilterInclusive)) {
-			continue;
-		}
-		if (filterState.isEnabled(FilterState::FILTER_EVENT) &&
-		    !filterEventMap.contains(event.type)) {
-			continue;
+	store:
+		/* Clear the bits that are beyond the last event */
+		if (n < bpw)
+			word &= ~(allbits << n);
+		filteredBits.setWord(w, word);
+	}
+}
+
+void TraceAnalyzer::processAllFilters()
+{
+	QList<AbstractWorkItem*> workList;
+	FilterChunk *chunks;
+	unsigned int nrWords;
+	unsigned int nrChunks;
+	unsigned int c, w, i;
+	unsigned int base;
+	vtl::BitMap::word_t word;
+	int count;
+	unsigned int s;
+
+	filteredEvents.clear();
+	prepareFilterBits();
+	filteredBits.resize(events->size());
+	nrWords = filteredBits.nrWords();
+
+	/* The words of the bitmap are computed in parallel */
+	nrChunks = (nrWords + FILTER_CHUNK_WORDS - 1) / FILTER_CHUNK_WORDS;
+	chunks = new FilterChunk[nrChunks];
+	for (c = 0; c < nrChunks; c++) {
+		chunks[c].analyzer = this;
+		chunks[c].beginWord = c * FILTER_CHUNK_WORDS;
+		chunks[c].endWord = TSMIN(nrWords,
+					  (c + 1) * FILTER_CHUNK_WORDS);
+		WorkItem<FilterChunk> *item = new WorkItem<FilterChunk>
+			(&chunks[c], &FilterChunk::process);
+		workList.append(item);
+		filterQueue.addWorkItem(item);
+	}
+
+	filterQueue.start();
+	filterQueue.wait();
+
+	s = workList.size();
+	for (i = 0; i < s; i++)
+		delete workList[i];
+	delete[] chunks;
+
+	/* ...then we collect the events and compute the ranks */
+	filteredRank.resize(nrWords);
+	count = 0;
+	for (w = 0; w < nrWords; w++) {
+		filteredRank[w] = count;
+		word = filteredBits.word(w);
+		count += vtl::BitMap::popcount(word);
+		base = w * vtl::BitMap::BITS_PER_WORD;
+		for (i = 0; word != 0; i++, word >>= 1) {
+			if ((word & 0x1) != 0)
+				filteredEvents.append(&events->at(base + i));
 		}
-		if (filterState.isEnabled(FilterState::FILTER_TIME) &&
-		    (event.time < filterTimeLow || event.time > filterTimeHigh))
-			continue;
-		filteredEvents.append(eptr);
 	}
 }
 
@@ -1079,6 +1585,33 @@ void TraceAnalyzer::createTimeFilter(const vtl::Time &low,
 		processAllFilters();
 }
 
+/*
+ * Compiles the expression, see argfilter.h for the syntax. An empty expression
+ * disables the argument filter. Returns false and sets errmsg if the
+ * expression could not be compiled.
+ */
+bool TraceAnalyzer::createArgFilter(const QString &expr, bool orlogic,
+				    QString *errmsg)
+{
+	ArgFilter &filter = orlogic ? OR_argFilter : argFilter;
+	FilterState &state = orlogic ? OR_filterState : filterState;
+
+	if (expr.isEmpty()) {
+		if (filterActive(FilterState::FILTER_ARG))
+			disableFilter(FilterState::FILTER_ARG);
+		return true;
+	}
+
+	if (!filter.compile(expr, getTraceType(), errmsg))
+		return false;
+
+	state.enable(FilterState::FILTER_ARG);
+	/* No need to process filters if we only have OR-filters */
+	if (filterState.isEnabled())
+		processAllFilters();
+	return true;
+}
+
 void TraceAnalyzer::disableFilter(FilterState::filter_t filter)
 {
 	filterState.disable(filter);
@@ -1100,15 +1633,19 @@ void TraceAnalyzer::disableFilter(FilterState::filter_t filter)
 		OR_filterCPUMap.clear();
 		break;
 	case FilterState::FILTER_ARG:
-		/* Argument filtering is not yet implemented */
+		argFilter.clear();
+		OR_argFilter.clear();
 		break;
 	default:
 		break;
 	}
-	if (filterState.isEnabled())
+	if (filterState.isEnabled()) {
 		processAllFilters();
-	else
+	} else {
 		filteredEvents.clear();
+		filteredBits.clear();
+		filteredRank.clear();
+	}
 }
 
 void TraceAnalyzer::addPidToFilter(int pid) {
@@ -1163,7 +1700,12 @@ void TraceAnalyzer::disableAllFilters()
 	filterEventMap.clear();
 	OR_filterEventMap.clear();
 
+	argFilter.clear();
+	OR_argFilter.clear();
+
 	filteredEvents.clear();
+	filteredBits.clear();
+	filteredRank.clear();
 }
 
 bool TraceAnalyzer::isFiltered() const
@@ -52,16 +52,19 @@
 #ifndef TRACEANALYZER_H
 #define TRACEANALYZER_H
 
+#include <QAtomicInt>
 #include <QColor>
 #include <QString>
 #include <QStringList>
 #include <QVector>
 #include <QList>
 #include <QMap>
+#include <QPointer>
 #include <QtGlobal>
 #include <limits>
 
 #include "vtl/avltree.h"
+#include "vtl/bitmap.h"
 #include "vtl/compiler.h"
 #include "vtl/tlist.h"
 
@@ -72,11 +75,17 @@
 #include "parser/genericparams.h"
 #include "mm/mempool.h"
 #include "analyzer/abstracttask.h"
+#include "analyzer/argfilter.h"
+#include "analyzer/latencyhistogram.h"
 #include "analyzer/cputask.h"
+#include "analyzer/detachedtrace.h"
+#include "analyzer/eventrateindex.h"
+#include "analyzer/timequery.h"
+#include "analyzer/wakechain.h"
 #include "analyzer/tcolor.h"
 #include "parser/traceevent.h"
 #include "analyzer/migration.h"
-#include "ui/migrationarrow.h"
+#include "ui/migrationplot.h"
 #include "analyzer/task.h"
 #include "parser/traceparser.h"
 #include "misc/traceshark.h"
@@ -97,23 +106,90 @@
  */
 #define WAKEUP_MAX ((double) 0.020)
 
+/*
+ * The filter bitmaps hold the keys that are smaller than this, which includes
+ * all pids, since pid_max can't be greater than 2^22. Greater keys are looked
+ * up in the filter maps instead.
+ */
+#define FILTER_BITS_MAX (1 << 22)
+
 class TraceFile;
 class QCustomPlot;
 class SettingStore;
+class TraceAnalyzer;
+
+/*
+ * The filters are processed in parallel, each FilterChunk processes a range of
+ * words in the bitmap of filtered events.
+ */
+#define FILTER_CHUNK_WORDS (1024)
+
+class FilterChunk {
+public:
+	FilterChunk();
+	bool process();
+	TraceAnalyzer *analyzer;
+	unsigned int beginWord;
+	unsigned int endWord;
+};
+
+/* The id is the pid or cpu of the group, or -1 if it has neither */
+class LatencyGroup {
+public:
+	QString name;
+	int id;
+	LatencyHistogram hist;
+};
+
+/*
+ * The indices of the wakeup and waking events of a pid that has no task yet.
+ * They are given to the task if it is created later in the trace.
+ */
+class PendingWakeIdx {
+public:
+	QVector<int> wakeupIdx;
+	QVector<int> wakeupNewIdx;
+	QVector<int> wakingIdx;
+};
 
 class TraceAnalyzer
 {
+	friend class FilterChunk;
 public:
 	typedef enum : int {
 		EXPORT_TYPE_ALL = 0,
 		EXPORT_TYPE_CPU_CYCLES
 	} exporttype_t;
+	typedef enum : int {
+		LATENCY_GLOBAL = 0,
+		LATENCY_CPU,
+		LATENCY_NAME,
+		LATENCY_TASK
+	} latencygroup_t;
+	/*
+	 * In PROCESSING_STATS, doStats() and doLatencyStats() are writing the
+	 * statistics members of the tasks and CPUs, i.e. accTime, accPct and
+	 * the latency indexes. These may only be read after statsReady() has
+	 * returned true, which is why the trace is not shown before that.
+	 */
+	typedef enum : int {
+		PROCESSING_IDLE = 0,
+		PROCESSING_ANALYZE,
+		PROCESSING_LOD,
+		PROCESSING_STATS,
+		PROCESSING_DONE
+	} processing_t;
 	TraceAnalyzer(const SettingStore *sstore);
 	~TraceAnalyzer();
 	int open(const QString &fileName);
 	bool isOpen() const;
 	void close(int *ts_errno);
 	void processTrace();
+	void startProcessing();
+	void abortProcessing();
+	vtl_always_inline processing_t getProcessingPhase() const;
+	vtl_always_inline bool statsReady() const;
+	int getLoadProgress() const;
 	const TraceEvent *findPreviousSchedEvent(const vtl::Time &time,
 						 int pid,
 						 int *index) const;
@@ -140,6 +216,7 @@ public:
 	vtl_always_inline tracetype_t getTraceType() const;
 	void setSchedOffset(unsigned int cpu, double offset);
 	void setSchedScale(unsigned int cpu, double scale);
+	void setSchedScales(double scale);
 	void setCpuIdleOffset(unsigned int cpu, double offset);
 	void setCpuIdleScale(unsigned int cpu, double scale);
 	void setCpuFreqOffset(unsigned int cpu, double offset);
@@ -147,17 +224,31 @@ public:
 	void setMigrationOffset(double offset);
 	void setMigrationScale(double scale);
 	bool enableMigrations();
+	vtl_always_inline MigrationPlot *getMigrationPlot();
+	vtl_always_inline const EventRateIndex *getEventRateIndex() const;
+	vtl_always_inline const TimeQuery *getTimeQuery() const;
+	vtl_always_inline const WakeChain *getWakeChain() const;
 	void doScale();
+	void doScaleWakeup();
+	void doRelayout();
 	void doStats();
 	void doLimitedStats();
+	void doLatencyStats();
+	void buildTimeQuery();
+	void buildWakeChain();
+	void getLatencyGroups(latencygroup_t type, bool limited,
+			      QList<LatencyGroup> &groups) const;
 	void setQCustomPlot(QCustomPlot *plot);
 	vtl_always_inline Task *findTask(int pid);
+	vtl_always_inline const Task *findTask(int pid) const;
 	void createPidFilter(QMap<int, int> &map,
 			     bool orlogic, bool inclusive);
 	void createCPUFilter(QMap<unsigned, unsigned> &map, bool orlogic);
 	void createEventFilter(QMap<event_t, event_t> &map, bool orlogic);
 	void createTimeFilter(const vtl::Time &low,
 			      const vtl::Time &high, bool orlogic);
+	bool createArgFilter(const QString &expr, bool orlogic,
+			     QString *errmsg);
 	void disableFilter(FilterState::filter_t filter);
 	void addPidToFilter(int pid);
 	void removePidFromFilter(int pid);
@@ -181,13 +272,12 @@ private:
 	void resetProperties();
 	void threadProcess();
 	int binarySearch(const vtl::Time &time, int start, int end) const;
-	int binarySearchFiltered(const vtl::Time &time, int start, int end)
-		const;
 	void colorizeTasks();
 	event_t determineCPUEvent(bool &ok);
 	int findIndexBefore(const vtl::Time &time) const;
 	int findIndexAfter(const vtl::Time &time) const;
-	int findFilteredIndexBefore(const vtl::Time &time) const;
+	unsigned int lowerBound(const vtl::Time &time) const;
+	unsigned int upperBound(const vtl::Time &time) const;
 	vtl_always_inline int
 		generic_sched_switch_newpid(const TraceEvent &event) const;
 	vtl_always_inline int
@@ -216,6 +306,9 @@ private:
 	vtl_always_inline void processWakeupEvent(tracetype_t ttype,
 						  const TraceEvent &event,
 						  int idx);
+	vtl_always_inline void processWakingEvent(tracetype_t ttype,
+						  const TraceEvent &event,
+						  int idx);
 	vtl_always_inline void processCPUfreqEvent(tracetype_t ttype,
 						   const TraceEvent &event,
 						   int idx);
@@ -231,15 +324,14 @@ private:
 	vtl_always_inline void processExitEvent(tracetype_t ttype,
 						const TraceEvent &event,
 						int idx);
-	void addCpuFreqWork(unsigned int cpu,
-			    QList<AbstractWorkItem*> &list);
-	void addCpuIdleWork(unsigned int cpu,
-			    QList<AbstractWorkItem*> &list);
+	void scaleCpuFreq(unsigned int cpu);
+	void scaleCpuIdle(unsigned int cpu);
 	void addCpuSchedWork(unsigned int cpu,
 			     QList<AbstractWorkItem*> &list);
 	void scaleMigration();
 	void processSchedAddTail();
 	void processFreqAddTail();
+	void processPendingWakeIdx();
 	unsigned int guessTimePrecision();
 	vtl_always_inline void processGeneric(tracetype_t ttype);
 	vtl_always_inline void updateMaxCPU(unsigned int cpu);
@@ -249,15 +341,28 @@ private:
 	vtl_always_inline void updateMinIdleState(int state);
 	void processFtrace();
 	void processPerf();
+	void threadProcessAll();
+	void threadTeardown();
+	void detachTrace();
+	void doSchedLOD();
+	void doScaleSched();
+	vtl_always_inline bool processingAborted() const;
 	void processAllFilters();
+	void prepareFilterBits();
+	void processFilterWords(unsigned int beginWord, unsigned int endWord);
 	vtl_always_inline
 		bool processPidFilter(const TraceEvent &event,
-				      QMap<int, int> &map,
-				      bool inclusive);
+				      const vtl::BitMap &bits,
+				      const QMap<int, int> &map,
+				      bool inclusive) const;
+	static vtl_always_inline bool pidInFilter(int pid,
+						  const vtl::BitMap &bits,
+						  const QMap<int, int> &map);
 	WorkQueue processingQueue;
 	WorkQueue scalingQueue;
 	WorkQueue statsQueue;
 	WorkQueue statsLimitedQueue;
+	WorkQueue filterQueue;
 	vtl::AVLTree <int, TColor> colorMap;
 	TColor black;
 	TColor white;
@@ -269,6 +374,14 @@ private:
 	QVector<double> cpuFreqScale;
 	double migrationOffset;
 	double migrationScale;
+	/* Cleared automatically when the plot deletes the plottable */
+	QPointer<MigrationPlot> migrationPlot;
+	/* Counted while the events are processed, see processGeneric() */
+	EventRateIndex eventRateIndex;
+	/* Built by buildTimeQuery() when the scheduling graphs are done */
+	TimeQuery timeQuery;
+	/* Built by buildWakeChain() when the tasks are done */
+	WakeChain wakeChain;
 	unsigned int maxCPU;
 	unsigned int nrCPUs;
 	vtl::Time endTime;
@@ -298,11 +411,47 @@ private:
 	vtl::Time filterTimeHigh;
 	vtl::Time OR_filterTimeLow;
 	vtl::Time OR_filterTimeHigh;
+	ArgFilter argFilter;
+	ArgFilter OR_argFilter;
+	/* The wakeup latencies of all tasks, in the order of wakeTimev */
+	QVector<double> wakeTimev;
+	QVector<double> wakeDelay;
+	LatencyIndex wakeLatency;
+	/* Only used during processing, see processPendingWakeIdx() */
+	QMap<int, PendingWakeIdx> pendingWakeIdx;
+	/*
+	 * The members below are derived from the filter settings above when
+	 * the filters are processed. The pid bitmaps only cover non-negative
+	 * pids, negative pids are looked up in the maps.
+	 */
+	vtl::BitMap filterCPUBits;
+	vtl::BitMap OR_filterCPUBits;
+	vtl::BitMap filterEventBits;
+	vtl::BitMap OR_filterEventBits;
+	vtl::BitMap filterPidBits;
+	vtl::BitMap OR_filterPidBits;
+	unsigned int filterIdxBegin;
+	unsigned int filterIdxEnd;
+	unsigned int OR_filterIdxBegin;
+	unsigned int OR_filterIdxEnd;
+	/*
+	 * A bit is set in filteredBits for each event that is in
+	 * filteredEvents. filteredRank contains the number of bits that are
+	 * set in all preceding words, so that the index of an event in
+	 * filteredEvents can be found quickly.
+	 */
+	vtl::BitMap filteredBits;
+	QVector<int> filteredRank;
 	static const char spaceStr[];
 	static const int spaceStrLen;
 	static const char *const cpuevents[];
 	static const int CPUEVENTS_NR;
 	const SettingStore *setstor;
+	WorkThread<TraceAnalyzer> *processingThread;
+	QAtomicInt processingPhase;
+	QAtomicInt abortRequested;
+	DetachedTrace detached;
+	WorkThread<TraceAnalyzer> *teardownThread;
 };
 
 vtl_always_inline
@@ -462,6 +611,43 @@ vtl_always_inline tracetype_t TraceAnalyzer::getTraceType() const
 	return parser->traceType;
 }
 
+vtl_always_inline
+TraceAnalyzer::processing_t TraceAnalyzer::getProcessingPhase() const
+{
+	return (processing_t) processingPhase.loadAcquire();
+}
+
+vtl_always_inline bool TraceAnalyzer::statsReady() const
+{
+	return getProcessingPhase() == PROCESSING_DONE;
+}
+
+vtl_always_inline bool TraceAnalyzer::processingAborted() const
+{
+	return abortRequested.loadAcquire() != 0;
+}
+
+vtl_always_inline MigrationPlot *TraceAnalyzer::getMigrationPlot()
+{
+	return migrationPlot.data();
+}
+
+vtl_always_inline
+const EventRateIndex *TraceAnalyzer::getEventRateIndex() const
+{
+	return &eventRateIndex;
+}
+
+vtl_always_inline const TimeQuery *TraceAnalyzer::getTimeQuery() const
+{
+	return &timeQuery;
+}
+
+vtl_always_inline const WakeChain *TraceAnalyzer::getWakeChain() const
+{
+	return &wakeChain;
+}
+
 vtl_always_inline Task *TraceAnalyzer::findTask(int pid)
 {
 	DEFINE_TASKMAP_ITERATOR(iter) = taskMap.find(pid);
@@ -471,6 +657,15 @@ vtl_always_inline Task *TraceAnalyzer::findTask(int pid)
 		return iter.value().task;
 }
 
+vtl_always_inline const Task *TraceAnalyzer::findTask(int pid) const
+{
+	DEFINE_TASKMAP_ITERATOR(iter) = taskMap.find(pid);
+	if (iter == taskMap.end())
+		return nullptr;
+	else
+		return iter.value().task;
+}
+
 vtl_always_inline
 void TraceAnalyzer::processMigrateEvent(tracetype_t ttype,
 					const TraceEvent &event,
@@ -664,6 +859,7 @@ void TraceAnalyzer::processSwitchEvent(tracetype_t ttype,
 		task->lastWakeUP = oldtime;
 	} else {
 		task->lastSleepEntry = oldtime;
+		task->sleepIdx.append(idx);
 		uint = task_state_is_flag_set(state, TASK_FLAG_UNINTERRUPTIBLE);
 		if (uint)
 			task->uninterruptibleTimev.append(oldtimeDbl);
@@ -736,11 +932,16 @@ skip:
 		delayDbl = delay.toDouble();
 		task->wakeTimev.append(newtimeDbl);
 		task->wakeDelay.append(delayDbl);
+		eventCPU->wakeTimev.append(newtimeDbl);
+		eventCPU->wakeDelay.append(delayDbl);
+		wakeTimev.append(newtimeDbl);
+		wakeDelay.append(delayDbl);
 	}
 
 	task->schedTimev.append(newtimeDbl);
 	task->schedData.append(SCHED_BIT);
 	task->schedEventIdx.append(idx);
+	task->schedInIdx.append(idx);
 
 	cpuTask = &cpuTaskMaps[cpu][newpid];
 	if (cpuTask->isNew) {
@@ -774,7 +975,7 @@ out:
 vtl_always_inline
 void TraceAnalyzer::processWakeupEvent(tracetype_t ttype,
 				       const TraceEvent &event,
-				       int /* idx */)
+				       int idx)
 {
 	int pid;
 	Task *task;
@@ -784,15 +985,34 @@ void TraceAnalyzer::processWakeupEvent(tracetype_t ttype,
 	if (!sched_wakeup_args_ok(ttype, event))
 		return;
 
-	/* Only interested in success */
-	if (!sched_wakeup_success(ttype, event))
-		return;
-
 	time = event.time;
 	pid = sched_wakeup_pid(ttype, event);
 
+	/*
+	 * The event index is used for navigation, so we want it even if the
+	 * wakeup was not successful. However, an unsuccessful wakeup must not
+	 * create a task, so if there is none yet, the index is kept aside.
+	 */
+	if (!sched_wakeup_success(ttype, event)) {
+		task = findTask(pid);
+		if (task != nullptr) {
+			task->wakeupIdx.append(idx);
+			if (event.type == SCHED_WAKEUP_NEW)
+				task->wakeupNewIdx.append(idx);
+		} else {
+			PendingWakeIdx &pending = pendingWakeIdx[pid];
+			pending.wakeupIdx.append(idx);
+			if (event.type == SCHED_WAKEUP_NEW)
+				pending.wakeupNewIdx.append(idx);
+		}
+		return;
+	}
+
 	/* Handle the woken up task */
 	task = &taskMap[pid].getTask();
+	task->wakeupIdx.append(idx);
+	if (event.type == SCHED_WAKEUP_NEW)
+		task->wakeupNewIdx.append(idx);
 	task->lastWakeUP = time;
 	if (task->isNew) {
 		task->pid = pid;
@@ -807,6 +1027,30 @@ void TraceAnalyzer::processWakeupEvent(tracetype_t ttype,
 	}
 }
 
+vtl_always_inline
+void TraceAnalyzer::processWakingEvent(tracetype_t ttype,
+				       const TraceEvent &event,
+				       int idx)
+{
+	int pid;
+	Task *task;
+
+	if (!sched_waking_args_ok(ttype, event))
+		return;
+
+	pid = sched_waking_pid(ttype, event);
+
+	/*
+	 * The waking usually comes before the wakeup that creates the task,
+	 * so the index is kept aside if there is no task yet.
+	 */
+	task = findTask(pid);
+	if (task != nullptr)
+		task->wakingIdx.append(idx);
+	else
+		pendingWakeIdx[pid].wakingIdx.append(idx);
+}
+
 vtl_always_inline
 void TraceAnalyzer::processCPUfreqEvent(tracetype_t ttype,
 					const TraceEvent &event,
@@ -912,6 +1156,7 @@ vtl_always_inline void TraceAnalyzer::processGeneric(tracetype_t ttype)
 	startTime = (*events)[0].time;
 	AbstractTask::setStartTime(startTime);
 	startTimeDbl = startTime.toDouble();
+	eventRateIndex.start(startTimeDbl);
 
 	while(true) {
 		for (i = prevIndex; i < indexReady; i++) {
@@ -919,6 +1164,8 @@ vtl_always_inline void TraceAnalyzer::processGeneric(tracetype_t ttype)
 			if (!isValidCPU(event.cpu))
 				continue;
 			updateMaxCPU(event.cpu);
+			eventRateIndex.add(event.time.toDouble(), event.cpu,
+					   event.type);
 			switch (event.type) {
 			case CPU_FREQUENCY:
 				processCPUfreqEvent(ttype, event, i);
@@ -936,6 +1183,9 @@ vtl_always_inline void TraceAnalyzer::processGeneric(tracetype_t ttype)
 			case SCHED_WAKEUP_NEW:
 				processWakeupEvent(ttype, event, i);
 				break;
+			case SCHED_WAKING:
+				processWakingEvent(ttype, event, i);
+				break;
 			case SCHED_PROCESS_FORK:
 				processForkEvent(ttype, event, i);
 				break;
@@ -946,7 +1196,7 @@ vtl_always_inline void TraceAnalyzer::processGeneric(tracetype_t ttype)
 				break;
 			}
 		}
-		if (eof)
+		if (eof || processingAborted())
 			break;
 		prevIndex = indexReady;
 		parser->waitForNextBatch(eof, indexReady);
@@ -955,19 +1205,29 @@ vtl_always_inline void TraceAnalyzer::processGeneric(tracetype_t ttype)
 	endTimeIdx = events->size() - 1;
 	AbstractTask::setEndTime(endTime);
 	endTimeDbl = endTime.toDouble();
+	eventRateIndex.finish(endTimeDbl);
 	nrCPUs = maxCPU + 1;
 	timePrecision = guessTimePrecision();
 }
 
+vtl_always_inline bool TraceAnalyzer::pidInFilter(int pid,
+						const vtl::BitMap &bits,
+						const QMap<int, int> &map)
+{
+	if (pid >= 0 && pid < FILTER_BITS_MAX)
+		return bits.test(pid);
+	return map.contains(pid);
+}
+
 vtl_always_inline
 bool TraceAnalyzer::processPidFilter(const TraceEvent &event,
-				     QMap<int, int> &map,
-				     bool inclusive)
+				     const vtl::BitMap &bits,
+				     const QMap<int, int> &map,
+				     bool inclusive) const
 {
 	sched_switch_handle sw_handle;
-	DEFINE_FILTER_PIDMAP_ITERATOR(iter);
-	iter = map.find(event.pid);
-	if (iter == map.end()) {
+
+	if (!pidInFilter(event.pid, bits, map)) {
 		tracetype_t ttype = getTraceType();
 		int pid = INT_MAX;
 		if (!inclusive)
@@ -1000,8 +1260,7 @@ bool TraceAnalyzer::processPidFilter(const TraceEvent &event,
 		default:
 			return true;
 		}
-		iter = filterPidMap.find(pid);
-		if (iter == filterPidMap.end())
+		if (!pidInFilter(pid, bits, map))
 			return true;
 	}
 	return false;
@@ -0,0 +1,292 @@
+// SPDX-License-Identifier: (GPL-2.0-or-later OR BSD-2-Clause)
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2020  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <QHash>
+
+#include "analyzer/cputask.h"
+#include "analyzer/task.h"
+#include "analyzer/traceanalyzer.h"
+#include "analyzer/utilizationmap.h"
+#include "misc/traceshark.h"
+
+/* The tasks with the same name, which are shown as one row */
+class UtilizationGroup {
+public:
+	QString name;
+	double busy;
+	QVector<const AbstractTask*> tasks;
+};
+
+static bool groupIsBusier(const UtilizationGroup *a,
+			  const UtilizationGroup *b)
+{
+	return a->busy > b->busy;
+}
+
+/*
+ * Returns the time that task has been scheduled, with the last segment
+ * running until end. This reads only the scheduling graph, so it doesn't
+ * depend on the statistics that are computed by TraceAnalyzer::doStats().
+ */
+static double busyTime(const AbstractTask *task, double end)
+{
+	const QVector<double> &timev = task->schedTimev;
+	double busy = 0;
+	int s = timev.size();
+	int i;
+
+	for (i = 0; i < s; i++) {
+		if (task->schedData.read(i) == 0)
+			continue;
+		busy += (i + 1 < s ? timev[i + 1] : end) - timev[i];
+	}
+	return busy;
+}
+
+UtilizationRow::UtilizationRow():
+	scale(1), owner(nullptr)
+{}
+
+bool UtilizationRow::compute()
+{
+	const int n = owner->nrBuckets;
+	const double norm = owner->width * scale;
+	int i, s;
+
+	values.fill(0, n);
+	s = tasks.size();
+	for (i = 0; i < s; i++)
+		addTask(tasks[i]);
+	if (norm > 0) {
+		for (i = 0; i < n; i++)
+			values[i] /= norm;
+	}
+	return false; /* No error */
+}
+
+/*
+ * Adds the time that task was scheduled to the buckets. The segments of the
+ * scheduling graph are found in the same way as in SchedLOD::build(), starting
+ * with a binary search for the segment that contains the start of the map.
+ */
+void UtilizationRow::addTask(const AbstractTask *task)
+{
+	const QVector<double> &timev = task->schedTimev;
+	const double start = owner->start;
+	const double end = owner->end;
+	const double width = owner->width;
+	const int n = owner->nrBuckets;
+	double *buckets = values.data();
+	double a, b, bstart;
+	int s = timev.size();
+	int i, j, first, last;
+
+	i = std::upper_bound(timev.begin(), timev.end(), start) -
+		timev.begin() - 1;
+	for (i = TSMAX(i, 0); i < s && timev[i] < end; i++) {
+		if (task->schedData.read(i) == 0)
+			continue;
+		a = TSMAX(timev[i], start);
+		b = i + 1 < s ? TSMIN(timev[i + 1], end) : end;
+		if (!(b > a))
+			continue;
+		first = (int) ((a - start) / width);
+		last = (int) std::ceil((b - start) / width) - 1;
+		first = TSMAX(0, TSMIN(first, n - 1));
+		last = TSMAX(first, TSMIN(last, n - 1));
+		for (j = first; j <= last; j++) {
+			bstart = start + j * width;
+			buckets[j] += TSMIN(b, bstart + width) -
+				TSMAX(a, bstart);
+		}
+	}
+}
+
+UtilizationMap::UtilizationMap():
+	nrCPUs(0), nrBuckets(0), start(0), end(0), width(0), setupDone(false)
+{}
+
+UtilizationMap::~UtilizationMap()
+{
+	clear();
+}
+
+void UtilizationMap::clear()
+{
+	int i, s;
+
+	s = workItems.size();
+	for (i = 0; i < s; i++)
+		delete workItems[i];
+	workItems.clear();
+	rows.clear();
+	nrCPUs = 0;
+	nrBuckets = 0;
+	setupDone = false;
+}
+
+/*
+ * Creates one row for the non-idle tasks of each CPU and one row for each of
+ * the MAX_GROUPS task names that have consumed the most time. The tasks with
+ * the other names are put in a row of their own.
+ */
+void UtilizationMap::setup(TraceAnalyzer *analyzer)
+{
+	QHash<QString, UtilizationGroup*> groupMap;
+	QHash<QString, UtilizationGroup*>::iterator g;
+	QVector<UtilizationGroup*> groups;
+	QVector<const AbstractTask*> others;
+	unsigned int cpu;
+	QString name;
+	double endTime;
+	int i, s;
+
+	clear();
+	nrCPUs = analyzer->getNrCPUs();
+	endTime = analyzer->getEndTime().toDouble();
+
+	for (cpu = 0; cpu < (unsigned) nrCPUs; cpu++) {
+		UtilizationRow row;
+		row.name = QString("cpu") + QString::number(cpu);
+		DEFINE_CPUTASKMAP_ITERATOR(iter);
+		for (iter = analyzer->cpuTaskMaps[cpu].begin();
+		     iter != analyzer->cpuTaskMaps[cpu].end();
+		     iter++) {
+			const CPUTask &task = iter.value();
+			if (task.pid != 0)
+				row.tasks.append(&task);
+		}
+		rows.append(row);
+	}
+
+	DEFINE_TASKMAP_ITERATOR(iter);
+	for (iter = analyzer->taskMap.begin();
+	     iter != analyzer->taskMap.end();
+	     iter++) {
+		const Task *task = iter.value().task;
+		if (task->pid == 0)
+			continue;
+		name = task->getLastName();
+		g = groupMap.find(name);
+		if (g == groupMap.end()) {
+			UtilizationGroup *group = new UtilizationGroup;
+			group->name = name;
+			group->busy = 0;
+			g = groupMap.insert(name, group);
+			groups.append(group);
+		}
+		g.value()->busy += busyTime(task, endTime);
+		g.value()->tasks.append(task);
+	}
+
+	std::sort(groups.begin(), groups.end(), groupIsBusier);
+	s = groups.size();
+	for (i = 0; i < s; i++) {
+		if (i < MAX_GROUPS)
+			addGroupRow(groups[i]->name, groups[i]->tasks, nrCPUs);
+		else
+			others += groups[i]->tasks;
+		delete groups[i];
+	}
+	if (!others.isEmpty())
+		addGroupRow(QString("other"), others, nrCPUs);
+
+	/* The rows are not moved after this, so they can be pointed to */
+	s = rows.size();
+	for (i = 0; i < s; i++) {
+		rows[i].owner = this;
+		workItems.append(new WorkItem<UtilizationRow>
+				 (&rows[i], &UtilizationRow::compute));
+	}
+	setupDone = true;
+}
+
+/*
+ * The density of a group is relative to the number of CPUs that the group
+ * could have used at the same time.
+ */
+void UtilizationMap::addGroupRow(const QString &name,
+				 const QVector<const AbstractTask*> &tasks,
+				 unsigned int cpus)
+{
+	UtilizationRow row;
+
+	row.name = name;
+	row.tasks = tasks;
+	row.scale = TSMIN((unsigned) tasks.size(), cpus);
+	if (row.scale < 1)
+		row.scale = 1;
+	rows.append(row);
+}
+
+/* Computes the rows for nrBuckets buckets between start and end */
+void UtilizationMap::compute(double startTime, double endTime, int buckets)
+{
+	int i, s;
+
+	start = startTime;
+	end = endTime;
+	nrBuckets = TSMAX(buckets, 0);
+	width = nrBuckets > 0 ? (end - start) / nrBuckets : 0;
+	if (rows.isEmpty() || !(width > 0)) {
+		nrBuckets = 0;
+		return;
+	}
+
+	s = workItems.size();
+	for (i = 0; i < s; i++)
+		queue.addWorkItem(workItems[i]);
+	queue.start();
+	queue.wait();
+}
@@ -0,0 +1,161 @@
+// SPDX-License-Identifier: (GPL-2.0-or-later OR BSD-2-Clause)
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2020  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef UTILIZATIONMAP_H
+#define UTILIZATIONMAP_H
+
+#include <QList>
+#include <QString>
+#include <QVector>
+
+#include "threads/workitem.h"
+#include "threads/workqueue.h"
+#include "vtl/compiler.h"
+
+class AbstractTask;
+class TraceAnalyzer;
+class UtilizationMap;
+
+/*
+ * A row of a UtilizationMap. The value of a bucket is the time that the tasks
+ * of the row were scheduled during the bucket, divided by the width of the
+ * bucket and by scale, so that a fully utilized row has the value 1.
+ */
+class UtilizationRow {
+	friend class UtilizationMap;
+public:
+	UtilizationRow();
+	bool compute();
+	QString name;
+	QVector<const AbstractTask*> tasks;
+	double scale;
+	QVector<double> values;
+private:
+	void addTask(const AbstractTask *task);
+	const UtilizationMap *owner;
+};
+
+/*
+ * This computes the utilization of each CPU and the density of the largest
+ * groups of tasks with the same name, in time buckets. It is used to draw an
+ * overview of traces that have so many tasks that the scheduling graphs are
+ * unreadable. The rows are computed in parallel from the scheduling graphs,
+ * for any time range and number of buckets, so that the overview can be
+ * refined when zooming in.
+ */
+class UtilizationMap {
+	friend class UtilizationRow;
+public:
+	UtilizationMap();
+	~UtilizationMap();
+	void setup(TraceAnalyzer *analyzer);
+	void clear();
+	void compute(double start, double end, int nrBuckets);
+	vtl_always_inline bool isSetup() const;
+	vtl_always_inline int nrRows() const;
+	vtl_always_inline int nrCPURows() const;
+	vtl_always_inline const UtilizationRow &getRow(int row) const;
+	vtl_always_inline int getNrBuckets() const;
+	vtl_always_inline double getStart() const;
+	vtl_always_inline double getEnd() const;
+	static const int MAX_GROUPS = 16;
+private:
+	void addGroupRow(const QString &name,
+			 const QVector<const AbstractTask*> &tasks,
+			 unsigned int cpus);
+	QVector<UtilizationRow> rows;
+	QList<WorkItem<UtilizationRow>*> workItems;
+	WorkQueue queue;
+	int nrCPUs;
+	int nrBuckets;
+	double start;
+	double end;
+	double width;
+	bool setupDone;
+};
+
+vtl_always_inline bool UtilizationMap::isSetup() const
+{
+	return setupDone;
+}
+
+vtl_always_inline int UtilizationMap::nrRows() const
+{
+	return rows.size();
+}
+
+vtl_always_inline int UtilizationMap::nrCPURows() const
+{
+	return nrCPUs;
+}
+
+vtl_always_inline const UtilizationRow &UtilizationMap::getRow(int row) const
+{
+	return rows[row];
+}
+
+vtl_always_inline int UtilizationMap::getNrBuckets() const
+{
+	return nrBuckets;
+}
+
+vtl_always_inline double UtilizationMap::getStart() const
+{
+	return start;
+}
+
+vtl_always_inline double UtilizationMap::getEnd() const
+{
+	return end;
+}
+
+#endif /* UTILIZATIONMAP_H */
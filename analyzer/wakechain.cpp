@@ -0,0 +1,274 @@
+// SPDX-License-Identifier: (GPL-2.0-or-later OR BSD-2-Clause)
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2020  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+
+#include "analyzer/task.h"
+#include "analyzer/traceanalyzer.h"
+#include "analyzer/wakechain.h"
+#include "misc/traceshark.h"
+#include "parser/genericparams.h"
+#include "parser/traceevent.h"
+#include "threads/workitem.h"
+
+/* For std::upper_bound(), finds the first link after time */
+static bool schedAfter(double time, const WakeLink &link)
+{
+	return time < link.schedTime;
+}
+
+/* Returns the index of the last link at or before time, or -1 */
+static int linkBefore(const QVector<WakeLink> &links, double time)
+{
+	return std::upper_bound(links.begin(), links.end(), time, schedAfter) -
+		links.begin() - 1;
+}
+
+TaskWakeLinks::TaskWakeLinks():
+	task(nullptr), owner(nullptr)
+{}
+
+/*
+ * Links each sched_switch that ran the task to the wakeup that preceded it.
+ * A wakeup only counts if it came after the task went to sleep, so a task
+ * that was preempted gets a link without a wakeup. Unsuccessful wakeups are
+ * skipped.
+ */
+bool TaskWakeLinks::build()
+{
+	const vtl::TList<TraceEvent> *events = owner->analyzer->events;
+	const QVector<int> &schedIn = task->schedInIdx;
+	WakeLink link;
+	int prevIn = WakeChain::NONE;
+	int prevWakeLink = WakeChain::NONE;
+	int lastSleep, bound, wakeup, waking;
+	int i, s;
+
+	s = schedIn.size();
+	links.resize(0);
+	links.reserve(s);
+
+	for (i = 0; i < s; i++) {
+		const TraceEvent &schedEvent = events->at(schedIn[i]);
+		link.schedIdx = schedIn[i];
+		link.cpu = schedEvent.cpu;
+		link.schedTime = schedEvent.time.toDouble();
+		link.wakeupIdx = WakeChain::NONE;
+		link.wakingIdx = WakeChain::NONE;
+		link.wakeTime = link.schedTime;
+		link.wakerPid = WakeChain::NONE;
+		link.wakerCPU = 0;
+
+		lastSleep = Task::findIdxBefore(task->sleepIdx, schedIn[i] - 1);
+		if (prevIn == WakeChain::NONE || lastSleep > prevIn) {
+			bound = TSMAX(lastSleep, prevIn);
+			wakeup = findWakeup(bound, schedIn[i]);
+			if (wakeup != WakeChain::NONE) {
+				link.wakeupIdx = wakeup;
+				waking = Task::findIdxBefore(task->wakingIdx,
+							     wakeup);
+				if (waking > bound)
+					link.wakingIdx = waking;
+				const TraceEvent &wakeEvent = events->at(
+					link.wakingIdx != WakeChain::NONE ?
+					link.wakingIdx : wakeup);
+				link.wakeTime = wakeEvent.time.toDouble();
+				link.wakerPid = wakeEvent.pid;
+				link.wakerCPU = wakeEvent.cpu;
+				prevWakeLink = i;
+			}
+		}
+
+		link.prevWakeLink = prevWakeLink;
+		links.append(link);
+		prevIn = schedIn[i];
+	}
+	return false; /* No error */
+}
+
+/*
+ * Returns the index of the last successful wakeup of the task that is after
+ * bound and before schedIdx, or NONE.
+ */
+int TaskWakeLinks::findWakeup(int bound, int schedIdx) const
+{
+	const vtl::TList<TraceEvent> *events = owner->analyzer->events;
+	const tracetype_t ttype = owner->analyzer->getTraceType();
+	const QVector<int> &v = task->wakeupIdx;
+	int k;
+
+	k = std::lower_bound(v.begin(), v.end(), schedIdx) - v.begin() - 1;
+	for (; k >= 0 && v[k] > bound; k--) {
+		if (sched_wakeup_success(ttype, events->at(v[k])))
+			return v[k];
+	}
+	return WakeChain::NONE;
+}
+
+WakeChain::WakeChain():
+	analyzer(nullptr), built(false)
+{}
+
+WakeChain::~WakeChain()
+{
+	clear();
+}
+
+void WakeChain::clear()
+{
+	tasks.clear();
+	taskIndex.clear();
+	analyzer = nullptr;
+	built = false;
+}
+
+/*
+ * Links all the tasks of analyzer, which must have been processed. Each task
+ * is a work item of its own, since the tasks are independent of each other.
+ */
+void WakeChain::build(TraceAnalyzer *a)
+{
+	QList<WorkItem<TaskWakeLinks>*> workList;
+	int i, s;
+
+	clear();
+	analyzer = a;
+
+	DEFINE_TASKMAP_ITERATOR(iter);
+	for (iter = analyzer->taskMap.begin();
+	     iter != analyzer->taskMap.end();
+	     iter++) {
+		const Task *task = iter.value().task;
+		if (task->pid <= 0 || task->schedInIdx.isEmpty())
+			continue;
+		taskIndex[task->pid] = tasks.size();
+		tasks.append(TaskWakeLinks());
+		tasks.last().task = task;
+		tasks.last().owner = this;
+	}
+
+	/* The vector is not resized after this, so it can be pointed to */
+	s = tasks.size();
+	for (i = 0; i < s; i++) {
+		WorkItem<TaskWakeLinks> *item = new WorkItem<TaskWakeLinks>
+			(&tasks[i], &TaskWakeLinks::build);
+		workList.append(item);
+		queue.addWorkItem(item);
+	}
+	queue.start();
+	queue.wait();
+
+	for (i = 0; i < s; i++)
+		delete workList[i];
+	built = true;
+}
+
+/* Returns the links of pid, or nullptr if it has never been switched in */
+const QVector<WakeLink> *WakeChain::getLinks(int pid) const
+{
+	QHash<int, int>::const_iterator iter = taskIndex.constFind(pid);
+
+	if (iter == taskIndex.constEnd())
+		return nullptr;
+	return &tasks[iter.value()].links;
+}
+
+/* Returns the link of the last time that pid was switched in before time */
+const WakeLink *WakeChain::findLink(int pid, double time) const
+{
+	const QVector<WakeLink> *links = getLinks(pid);
+	int idx;
+
+	if (links == nullptr)
+		return nullptr;
+	idx = linkBefore(*links, time);
+	return idx >= 0 ? &links->at(idx) : nullptr;
+}
+
+/*
+ * Follows the wake chain of pid backwards from time. The first step is the
+ * time from when pid last woke up until time, including the times that it was
+ * preempted in between. The next step is the waker, from when it woke up
+ * until the waking, and so on. The path ends when a task was woken by the
+ * idle task, or when a task has not woken up since its first switch in the
+ * trace. The links that the steps point to are valid until the chain is
+ * rebuilt or cleared.
+ */
+bool WakeChain::criticalPath(int pid, double time,
+			     QVector<WakeHop> &path) const
+{
+	const QVector<WakeLink> *links = getLinks(pid);
+	int idx = links != nullptr ? linkBefore(*links, time) : NONE;
+	int first;
+	WakeHop hop;
+
+	path.clear();
+	while (idx >= 0 && path.size() < MAX_HOPS) {
+		const WakeLink &last = links->at(idx);
+		first = last.prevWakeLink != NONE ? last.prevWakeLink : 0;
+		const WakeLink &link = links->at(first);
+		hop.pid = pid;
+		hop.start = link.schedTime;
+		hop.end = time;
+		hop.link = &link;
+		hop.last = &last;
+		path.append(hop);
+
+		if (link.wakeupIdx == NONE || link.wakerPid <= 0)
+			break;
+		pid = link.wakerPid;
+		time = link.wakeTime;
+		links = getLinks(pid);
+		idx = links != nullptr ? linkBefore(*links, time) : NONE;
+	}
+	return !path.isEmpty();
+}
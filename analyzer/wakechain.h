@@ -0,0 +1,161 @@
+// SPDX-License-Identifier: (GPL-2.0-or-later OR BSD-2-Clause)
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2020  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef WAKECHAIN_H
+#define WAKECHAIN_H
+
+#include <QHash>
+#include <QVector>
+
+#include "threads/workqueue.h"
+#include "vtl/compiler.h"
+
+class Task;
+class TraceAnalyzer;
+class WakeChain;
+
+/*
+ * Tells how a task came to run at the sched_switch schedIdx. If the task had
+ * been sleeping, then wakeupIdx is the sched_wakeup that made it runnable and
+ * the waker is the task that was running when the sched_waking, or the
+ * sched_wakeup if there is no sched_waking, happened. If the task had been
+ * preempted, then wakeupIdx is NONE and there is no waker.
+ */
+class WakeLink {
+public:
+	int schedIdx;
+	int wakeupIdx;
+	int wakingIdx;
+	unsigned int cpu;
+	double schedTime;
+	/* The time of the sched_waking or of the sched_wakeup */
+	double wakeTime;
+	int wakerPid;
+	unsigned int wakerCPU;
+	/*
+	 * The index, among the links of the task, of the last link up to and
+	 * including this one that has a wakeup, or NONE. The links in between
+	 * are preemptions, so this is where the task last woke up.
+	 */
+	int prevWakeLink;
+};
+
+/* One step of a critical path, see WakeChain::criticalPath() */
+class WakeHop {
+public:
+	int pid;
+	/* The task was running, or runnable, from start until end */
+	double start;
+	double end;
+	/* The link that started the step, i.e. where the task woke up */
+	const WakeLink *link;
+	/*
+	 * The last link before end. The links from link to last are
+	 * consecutive, and the ones after link are the preemptions of the task
+	 * during the step.
+	 */
+	const WakeLink *last;
+};
+
+/* The links of all the times that a task was switched in, sorted by time */
+class TaskWakeLinks {
+	friend class WakeChain;
+public:
+	TaskWakeLinks();
+	bool build();
+	const Task *task;
+	QVector<WakeLink> links;
+private:
+	int findWakeup(int bound, int schedIdx) const;
+	const WakeChain *owner;
+};
+
+/*
+ * The waker -> wakee graph of the whole trace. For every sched_switch that
+ * ran a task, it links the sched_waking and the sched_wakeup that preceded it
+ * to the task that did the waking, so that a wake chain can be followed
+ * backwards without searching the events. The tasks are linked in parallel
+ * when the trace has been processed.
+ *
+ * The waker is the task that was running when the waking happened, which is
+ * not the right one if the waking was done by an interrupt handler. Wakeups by
+ * the idle task end the chain, since they mean that the waking was done by an
+ * interrupt or a timer.
+ */
+class WakeChain {
+	friend class TaskWakeLinks;
+public:
+	WakeChain();
+	~WakeChain();
+	void build(TraceAnalyzer *analyzer);
+	void clear();
+	vtl_always_inline bool isBuilt() const;
+	const QVector<WakeLink> *getLinks(int pid) const;
+	const WakeLink *findLink(int pid, double time) const;
+	bool criticalPath(int pid, double time, QVector<WakeHop> &path) const;
+	static const int NONE = -1;
+	/* The number of wakers after which criticalPath() gives up */
+	static const int MAX_HOPS = 256;
+private:
+	TraceAnalyzer *analyzer;
+	QVector<TaskWakeLinks> tasks;
+	QHash<int, int> taskIndex;
+	WorkQueue queue;
+	bool built;
+};
+
+vtl_always_inline bool WakeChain::isBuilt() const
+{
+	return built;
+}
+
+#endif /* WAKECHAIN_H */
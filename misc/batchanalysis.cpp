@@ -0,0 +1,434 @@
+// SPDX-License-Identifier: (GPL-2.0-or-later OR BSD-2-Clause)
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2020  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <QDateTime>
+#include <QMap>
+
+#include "analyzer/latencyhistogram.h"
+#include "analyzer/task.h"
+#include "analyzer/timequery.h"
+#include "misc/batchanalysis.h"
+#include "misc/settingstore.h"
+#include "misc/traceshark.h"
+#include "vtl/error.h"
+
+/* The percentiles of the wakeup latencies that are written */
+static const double latencyPercentiles[] = { 50, 90, 99, 99.9 };
+static const char *const latencyPercentileNames[] = {
+	"p50", "p90", "p99", "p999"
+};
+
+static vtl_always_inline quint64 currentMsecs()
+{
+	return QDateTime::currentDateTimeUtc().toMSecsSinceEpoch();
+}
+
+BatchAnalysis::BatchAnalysis():
+	out(nullptr), phaseStart(0)
+{
+	settingStore = new SettingStore();
+	analyzer = new TraceAnalyzer(settingStore);
+}
+
+BatchAnalysis::~BatchAnalysis()
+{
+	delete analyzer;
+	delete settingStore;
+}
+
+/*
+ * Analyzes the trace in fileName and writes the results to out. The return
+ * value is the exit status of the program.
+ */
+int BatchAnalysis::run(const QString &fileName, FILE *outFile)
+{
+	int ts_errno;
+
+	out = outFile;
+	phases.clear();
+
+	startPhase();
+	ts_errno = analyzer->open(fileName);
+	if (ts_errno != 0) {
+		vtl::warn(ts_errno, "Failed to open trace file %s",
+			  fileName.toLocal8Bit().data());
+		return BSD_EX_NOINPUT;
+	}
+	endPhase("open");
+
+	startPhase();
+	analyzer->processTrace();
+	endPhase("analyze");
+
+	startPhase();
+	analyzer->doStats();
+	endPhase("stats");
+
+	startPhase();
+	analyzer->doLatencyStats();
+	endPhase("latency");
+
+	if (!queryTimes.isEmpty()) {
+		startPhase();
+		analyzer->buildTimeQuery();
+		endPhase("index");
+	}
+
+	fprintf(out, "{\n");
+	writeSummary(fileName);
+	writeTasks();
+	writeLatency();
+	writeCPUs();
+	writeQueries();
+	writePhases();
+	fprintf(out, "}\n");
+	fflush(out);
+
+	analyzer->close(&ts_errno);
+	if (ts_errno != 0)
+		vtl::warn(ts_errno, "Failed to close() trace file");
+	return 0;
+}
+
+/* Sets the times for which writeQueries() writes the state of the CPUs */
+void BatchAnalysis::setQueryTimes(const QVector<double> &times)
+{
+	queryTimes = times;
+	std::sort(queryTimes.begin(), queryTimes.end());
+}
+
+void BatchAnalysis::startPhase()
+{
+	phaseStart = currentMsecs();
+}
+
+void BatchAnalysis::endPhase(const char *name)
+{
+	Phase phase;
+
+	phase.name = name;
+	phase.msecs = currentMsecs() - phaseStart;
+	phases.append(phase);
+}
+
+void BatchAnalysis::writeSummary(const QString &fileName)
+{
+	vtl::Time start = analyzer->getStartTime();
+	vtl::Time end = analyzer->getEndTime();
+	const char *type;
+
+	switch (analyzer->getTraceType()) {
+	case TRACE_TYPE_FTRACE:
+		type = "ftrace";
+		break;
+	case TRACE_TYPE_PERF:
+		type = "perf";
+		break;
+	default:
+		type = "unknown";
+		break;
+	}
+
+	fprintf(out, "\t\"file\": ");
+	writeString(fileName);
+	fprintf(out, ",\n");
+	fprintf(out, "\t\"trace_type\": \"%s\",\n", type);
+	fprintf(out, "\t\"nr_cpus\": %u,\n", analyzer->getNrCPUs());
+	fprintf(out, "\t\"nr_events\": %d,\n", analyzer->events->size());
+	fprintf(out, "\t\"start_time\": %.9f,\n", start.toDouble());
+	fprintf(out, "\t\"end_time\": %.9f,\n", end.toDouble());
+	fprintf(out, "\t\"duration\": %.9f,\n", (end - start).toDouble());
+}
+
+/*
+ * Writes the CPU time of every task, as computed by doStats(), together with a
+ * summary of its wakeup latencies.
+ */
+void BatchAnalysis::writeTasks()
+{
+	QList<LatencyGroup> groups;
+	QMap<int, int> groupMap;
+	QMap<int, int>::const_iterator giter;
+	bool first = true;
+	int i;
+
+	analyzer->getLatencyGroups(TraceAnalyzer::LATENCY_TASK, false, groups);
+	for (i = 0; i < groups.size(); i++)
+		groupMap[groups[i].id] = i;
+
+	fprintf(out, "\t\"tasks\": [");
+	DEFINE_TASKMAP_ITERATOR(iter) = analyzer->taskMap.begin();
+	while (iter != analyzer->taskMap.end()) {
+		const Task *task = iter.value().task;
+		iter++;
+		fprintf(out, "%s\n\t\t{ \"pid\": %d, \"name\": ",
+			first ? "" : ",", task->pid);
+		first = false;
+		writeString(task->getLastName());
+		fprintf(out, ", \"cpu_time\": %.9f, \"cpu_pct\": %.2f",
+			task->accTime.toDouble(), task->accPct / 100.0);
+		fprintf(out, ", \"wakeups\": %d", task->wakeDelay.size());
+		giter = groupMap.constFind(task->pid);
+		if (giter != groupMap.constEnd()) {
+			fprintf(out, ", \"latency\": ");
+			writeHistogram(groups[giter.value()].hist);
+		}
+		fprintf(out, " }");
+	}
+	fprintf(out, "\n\t],\n");
+}
+
+void BatchAnalysis::writeLatency()
+{
+	QList<LatencyGroup> groups;
+	int i;
+
+	fprintf(out, "\t\"latency\": {\n");
+
+	analyzer->getLatencyGroups(TraceAnalyzer::LATENCY_GLOBAL, false,
+				   groups);
+	fprintf(out, "\t\t\"global\": ");
+	writeHistogram(groups.first().hist);
+	fprintf(out, ",\n");
+
+	analyzer->getLatencyGroups(TraceAnalyzer::LATENCY_CPU, false, groups);
+	fprintf(out, "\t\t\"cpus\": [");
+	for (i = 0; i < groups.size(); i++) {
+		fprintf(out, "%s\n\t\t\t{ \"cpu\": %d, \"latency\": ",
+			i == 0 ? "" : ",", groups[i].id);
+		writeHistogram(groups[i].hist);
+		fprintf(out, " }");
+	}
+	fprintf(out, "\n\t\t]\n");
+
+	fprintf(out, "\t},\n");
+}
+
+void BatchAnalysis::writeCPUs()
+{
+	unsigned int cpu;
+	unsigned int nrCPUs = analyzer->getNrCPUs();
+
+	fprintf(out, "\t\"cpus\": [");
+	for (cpu = 0; cpu < nrCPUs; cpu++) {
+		fprintf(out, "%s\n\t\t{ \"cpu\": %u, \"frequency\": ",
+			cpu == 0 ? "" : ",", cpu);
+		writeFreqResidency(cpu);
+		fprintf(out, ", \"idle\": ");
+		writeIdleResidency(cpu);
+		fprintf(out, " }");
+	}
+	fprintf(out, "\n\t],\n");
+}
+
+/*
+ * Writes how much time the CPU has spent at each frequency. The last element of
+ * the frequency vectors has been added at the end of the trace, so each element
+ * is valid until the next one.
+ */
+void BatchAnalysis::writeFreqResidency(unsigned int cpu)
+{
+	const CpuFreq &freq = analyzer->cpuFreq[cpu];
+	QMap<unsigned int, double> residency;
+	QMap<unsigned int, double>::const_iterator iter;
+	bool first = true;
+	int i, s;
+
+	s = freq.timev.size();
+	for (i = 0; i < s - 1; i++)
+		residency[(unsigned int) freq.data[i]] +=
+			freq.timev[i + 1] - freq.timev[i];
+
+	fprintf(out, "[");
+	for (iter = residency.constBegin(); iter != residency.constEnd();
+	     iter++) {
+		fprintf(out, "%s { \"khz\": %u, \"seconds\": %.9f }",
+			first ? "" : ",", iter.key(), iter.value());
+		first = false;
+	}
+	fprintf(out, " ]");
+}
+
+/*
+ * Writes how much time the CPU has spent in each idle state. The state -1 means
+ * that the CPU was not idle. The time before the first idle event is unknown
+ * and is not counted.
+ */
+void BatchAnalysis::writeIdleResidency(unsigned int cpu)
+{
+	const CpuIdle &idle = analyzer->cpuIdle[cpu];
+	double end = analyzer->getEndTime().toDouble();
+	QMap<int, double> residency;
+	QMap<int, double>::const_iterator iter;
+	bool first = true;
+	double next;
+	int i, s;
+
+	s = idle.timev.size();
+	for (i = 0; i < s; i++) {
+		next = i < s - 1 ? idle.timev[i + 1] : end;
+		/* The analyzer stores the idle state plus one */
+		residency[(int) idle.data[i] - 1] += next - idle.timev[i];
+	}
+
+	fprintf(out, "[");
+	for (iter = residency.constBegin(); iter != residency.constEnd();
+	     iter++) {
+		fprintf(out, "%s { \"state\": %d, \"seconds\": %.9f }",
+			first ? "" : ",", iter.key(), iter.value());
+		first = false;
+	}
+	fprintf(out, " ]");
+}
+
+/*
+ * Writes the task, the frequency and the idle state of each CPU at each of the
+ * times given with --at=. The tasks of a CPU are looked up with one batched
+ * query for all times.
+ */
+void BatchAnalysis::writeQueries()
+{
+	const TimeQuery *query = analyzer->getTimeQuery();
+	unsigned int nrCPUs = query->getNrCPUs();
+	QVector<QVector<int>> pids(nrCPUs);
+	unsigned int cpu;
+	const Task *task;
+	int i, pid;
+
+	if (queryTimes.isEmpty())
+		return;
+
+	for (cpu = 0; cpu < nrCPUs; cpu++)
+		query->taskOnCPU(cpu, queryTimes, pids[cpu]);
+
+	fprintf(out, "\t\"at\": [");
+	for (i = 0; i < queryTimes.size(); i++) {
+		fprintf(out, "%s\n\t\t{ \"time\": %.9f, \"cpus\": [",
+			i == 0 ? "" : ",", queryTimes[i]);
+		for (cpu = 0; cpu < nrCPUs; cpu++) {
+			pid = pids[cpu][i];
+			fprintf(out, "%s\n\t\t\t{ \"cpu\": %u, \"pid\": %d",
+				cpu == 0 ? "" : ",", cpu, pid);
+			task = pid != TimeQuery::NONE ?
+				analyzer->findTask(pid) : nullptr;
+			if (task != nullptr) {
+				fprintf(out, ", \"name\": ");
+				writeString(task->getLastName());
+			}
+			fprintf(out, ", \"khz\": %.0f, \"idle\": %d }",
+				query->cpuFrequency(cpu, queryTimes[i]),
+				query->cpuIdleState(cpu, queryTimes[i]));
+		}
+		fprintf(out, "\n\t\t] }");
+	}
+	fprintf(out, "\n\t],\n");
+}
+
+void BatchAnalysis::writePhases()
+{
+	quint64 total = 0;
+	int i;
+
+	fprintf(out, "\t\"phases\": [");
+	for (i = 0; i < phases.size(); i++) {
+		fprintf(out, "%s\n\t\t{ \"name\": \"%s\", \"msecs\": %llu }",
+			i == 0 ? "" : ",", phases[i].name,
+			(unsigned long long) phases[i].msecs);
+		total += phases[i].msecs;
+	}
+	fprintf(out, "\n\t],\n");
+	fprintf(out, "\t\"total_msecs\": %llu\n", (unsigned long long) total);
+}
+
+void BatchAnalysis::writeHistogram(const LatencyHistogram &hist)
+{
+	unsigned int i;
+
+	fprintf(out, "{ \"count\": %u", hist.count());
+	for (i = 0; i < arraylen(latencyPercentiles); i++)
+		fprintf(out, ", \"%s\": %.9f", latencyPercentileNames[i],
+			hist.percentile(latencyPercentiles[i]).toDouble());
+	fprintf(out, ", \"max\": %.9f }", hist.max().toDouble());
+}
+
+/* Writes a JSON string, with the characters that need it escaped */
+void BatchAnalysis::writeString(const QString &str)
+{
+	writeJSONString(out, str);
+}
+
+/* Writes str as a quoted JSON string with the necessary escapes */
+void BatchAnalysis::writeJSONString(FILE *out, const QString &str)
+{
+	QByteArray utf8 = str.toUtf8();
+	const char *c;
+
+	fputc('"', out);
+	for (c = utf8.constData(); *c != '\0'; c++) {
+		switch (*c) {
+		case '"':
+			fputs("\\\"", out);
+			break;
+		case '\\':
+			fputs("\\\\", out);
+			break;
+		default:
+			if ((unsigned char) *c < 0x20)
+				fprintf(out, "\\u%04x", (unsigned char) *c);
+			else
+				fputc(*c, out);
+			break;
+		}
+	}
+	fputc('"', out);
+}
@@ -0,0 +1,474 @@
+// SPDX-License-Identifier: (GPL-2.0-or-later OR BSD-2-Clause)
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2020  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <QByteArray>
+#include <QFileInfo>
+#include <QMap>
+
+extern "C" {
+#include <sys/resource.h>
+#include <sys/time.h>
+}
+
+#include "analyzer/task.h"
+#include "analyzer/traceanalyzer.h"
+#include "misc/batchanalysis.h"
+#include "misc/benchmark.h"
+#include "misc/errors.h"
+#include "misc/setting.h"
+#include "misc/settingstore.h"
+#include "misc/traceshark.h"
+#include "parser/traceline.h"
+#include "parser/tracefile.h"
+#include "parser/traceparser.h"
+#include "threads/loadbuffer.h"
+#include "threads/threadbuffer.h"
+#include "vtl/error.h"
+#include "vtl/mapcache.h"
+#include "vtl/tlist.h"
+
+/* The same buffer size as the TraceParser uses */
+#define BENCH_BUFFER_SIZE (1024 * 1024 * 2)
+
+/* Every FILTER_PID_STRIDE:th task is included by the pid filter */
+#define FILTER_PID_STRIDE (4)
+
+Benchmark::Benchmark():
+	out(nullptr), fileSize(0), nrLines(0), nrEvents(0),
+	mapFlags(vtl::MapCache::FLAG_NONE)
+{
+	settingStore = new SettingStore();
+	/* The migration graphs can only be scaled with a plot widget */
+	settingStore->setBoolValue(Setting::SHOW_MIGRATION_GRAPHS, false);
+	analyzer = new TraceAnalyzer(settingStore);
+}
+
+Benchmark::~Benchmark()
+{
+	delete analyzer;
+	delete settingStore;
+}
+
+/* Sets the flags of the MapCache, for the maps of all stages */
+void Benchmark::setMapFlags(unsigned int flags)
+{
+	mapFlags = flags;
+}
+
+/*
+ * Runs all the stages on the trace in fileName and writes the results to out.
+ * The return value is the exit status of the program.
+ */
+int Benchmark::run(const QString &fileName, FILE *outFile)
+{
+	size_t cacheSize = vtl::MapCache::getMaxSize();
+	unsigned int cacheFlags = vtl::MapCache::getFlags();
+	int ts_errno;
+
+	/*
+	 * Otherwise the maps that one stage returns would be handed out to
+	 * the next one, already faulted in, and the peak RSS of the stages
+	 * would include the cached maps.
+	 */
+	vtl::MapCache::setMaxSize(0);
+	vtl::MapCache::flush();
+	vtl::MapCache::setFlags(mapFlags);
+
+	out = outFile;
+	stages.clear();
+	fileSize = QFileInfo(fileName).size();
+	nrLines = 0;
+	nrEvents = 0;
+
+	ts_errno = benchRead(fileName);
+	if (ts_errno == 0)
+		ts_errno = benchTokenize(fileName);
+	if (ts_errno == 0)
+		ts_errno = benchParse(fileName);
+	if (ts_errno == 0)
+		ts_errno = benchAnalyze(fileName);
+	if (ts_errno != 0) {
+		vtl::warn(ts_errno, "Failed to open trace file %s",
+			  fileName.toLocal8Bit().data());
+		vtl::MapCache::setMaxSize(cacheSize);
+		vtl::MapCache::setFlags(cacheFlags);
+		return BSD_EX_NOINPUT;
+	}
+	benchFilter();
+	benchStats();
+	benchScale();
+
+	fprintf(out, "{\n");
+	fprintf(out, "\t\"file\": ");
+	BatchAnalysis::writeJSONString(out, fileName);
+	fprintf(out, ",\n");
+	fprintf(out, "\t\"bytes\": %lld,\n", (long long) fileSize);
+	fprintf(out, "\t\"nr_lines\": %lld,\n", (long long) nrLines);
+	fprintf(out, "\t\"nr_events\": %lld,\n", (long long) nrEvents);
+	fprintf(out, "\t\"nr_cpus\": %u,\n", analyzer->getNrCPUs());
+	fprintf(out, "\t\"nr_tasks\": %d,\n", analyzer->taskMap.size());
+	writeMapFlags();
+	writeStages();
+	fprintf(out, "}\n");
+	fflush(out);
+
+	analyzer->close(&ts_errno);
+	if (ts_errno != 0)
+		vtl::warn(ts_errno, "Failed to close() trace file");
+	vtl::MapCache::setMaxSize(cacheSize);
+	vtl::MapCache::setFlags(cacheFlags);
+	return 0;
+}
+
+/* Only the LoadThread, which reads the file into the load buffers */
+int Benchmark::benchRead(const QString &fileName)
+{
+	QByteArray name = fileName.toLocal8Bit();
+	TraceFile *file;
+	LoadBuffer *lbuf;
+	unsigned int curbuf = 0;
+	int ts_errno;
+	bool eof;
+
+	startStage();
+	file = new TraceFile(name.data(), ts_errno, BENCH_BUFFER_SIZE);
+	if (ts_errno != 0) {
+		delete file;
+		return ts_errno;
+	}
+
+	do {
+		lbuf = file->getLoadBuffer(curbuf);
+		lbuf->beginTokenizeBuffer();
+		eof = lbuf->isEOF();
+		lbuf->endTokenizeBuffer();
+		lbuf->beginConsumeBuffer();
+		lbuf->endConsumeBuffer();
+		curbuf++;
+		if (curbuf == NR_TBUFFERS)
+			curbuf = 0;
+	} while (!eof);
+
+	file->close(&ts_errno);
+	delete file;
+	endStage("read", true, true);
+	return ts_errno;
+}
+
+/*
+ * The LoadThread and the splitting of lines into words, in the same way as the
+ * reader thread of the TraceParser does it, except that the buffers are
+ * released immediately instead of being handed over to the parser thread.
+ */
+int Benchmark::benchTokenize(const QString &fileName)
+{
+	QByteArray name = fileName.toLocal8Bit();
+	ThreadBuffer<TraceLine> *tbuffers[NR_TBUFFERS];
+	ThreadBuffer<TraceLine> *tbuf;
+	TraceFile *file;
+	unsigned int curbuf = 0;
+	unsigned int i;
+	int ts_errno;
+	bool eof;
+
+	startStage();
+	file = new TraceFile(name.data(), ts_errno, BENCH_BUFFER_SIZE);
+	if (ts_errno != 0) {
+		delete file;
+		return ts_errno;
+	}
+
+	for (i = 0; i < NR_TBUFFERS; i++) {
+		tbuffers[i] = new ThreadBuffer<TraceLine>();
+		tbuffers[i]->loadBuffer = file->getLoadBuffer(i);
+	}
+
+	nrLines = 0;
+	tbuffers[curbuf]->beginProduceBuffer();
+	while (true) {
+		tbuf = tbuffers[curbuf];
+		file->ReadLine(&tbuf->list.increase(), tbuf);
+		if (!file->getBufferSwitch())
+			continue;
+		eof = tbuf->loadBuffer->isEOF();
+		nrLines += tbuf->list.size();
+		tbuf->endProduceBuffer();
+		tbuf->beginConsumeBuffer();
+		tbuf->endConsumeBuffer();
+		if (eof)
+			break;
+		curbuf++;
+		if (curbuf == NR_TBUFFERS)
+			curbuf = 0;
+		file->clearBufferSwitch();
+		tbuf = tbuffers[curbuf];
+		tbuf->beginProduceBuffer();
+		if (tbuf->loadBuffer->isEOF() && tbuf->loadBuffer->nRead == 0) {
+			tbuf->endProduceBuffer();
+			tbuf->beginConsumeBuffer();
+			tbuf->endConsumeBuffer();
+			break;
+		}
+	}
+
+	file->close(&ts_errno);
+	delete file;
+	for (i = 0; i < NR_TBUFFERS; i++)
+		delete tbuffers[i];
+	endStage("tokenize", true, true);
+	return ts_errno;
+}
+
+/* The complete pipeline of the TraceParser, until all events are parsed */
+int Benchmark::benchParse(const QString &fileName)
+{
+	TraceParser *parser = new TraceParser();
+	vtl::TList<TraceEvent> *events;
+	int ts_errno;
+
+	startStage();
+	ts_errno = parser->open(fileName);
+	if (ts_errno != 0) {
+		delete parser;
+		return ts_errno;
+	}
+	parser->waitForParsing();
+	endStage("parse", true, true);
+
+	events = parser->getEventsTList();
+	nrEvents = events != nullptr ? events->size() : 0;
+	parser->close(&ts_errno);
+	delete parser;
+	return ts_errno;
+}
+
+/* Parsing together with the processing of the events by the TraceAnalyzer */
+int Benchmark::benchAnalyze(const QString &fileName)
+{
+	int ts_errno;
+
+	startStage();
+	ts_errno = analyzer->open(fileName);
+	if (ts_errno != 0)
+		return ts_errno;
+	analyzer->processTrace();
+	endStage("analyze", true, true);
+	return 0;
+}
+
+/*
+ * Filters on a quarter of the tasks and on the scheduling events, which makes
+ * the analyzer go through all events.
+ */
+void Benchmark::benchFilter()
+{
+	QMap<int, int> pidMap;
+	QMap<event_t, event_t> eventMap;
+	int i = 0;
+
+	DEFINE_TASKMAP_ITERATOR(iter) = analyzer->taskMap.begin();
+	while (iter != analyzer->taskMap.end()) {
+		int pid = iter.value().task->pid;
+		if (i % FILTER_PID_STRIDE == 0)
+			pidMap[pid] = pid;
+		i++;
+		iter++;
+	}
+	eventMap[SCHED_SWITCH] = SCHED_SWITCH;
+	eventMap[SCHED_WAKEUP] = SCHED_WAKEUP;
+	eventMap[SCHED_WAKING] = SCHED_WAKING;
+
+	startStage();
+	analyzer->createPidFilter(pidMap, false, true);
+	analyzer->createEventFilter(eventMap, false);
+	analyzer->disableAllFilters();
+	endStage("filter", false, true);
+}
+
+void Benchmark::benchStats()
+{
+	startStage();
+	analyzer->doStats();
+	analyzer->doLatencyStats();
+	endStage("stats", false, false);
+}
+
+/* Scales the graphs as if every CPU had a plot area of height one */
+void Benchmark::benchScale()
+{
+	unsigned int nrCPUs = analyzer->getNrCPUs();
+	unsigned int cpu;
+	double offset = 0;
+
+	for (cpu = 0; cpu < nrCPUs; cpu++) {
+		analyzer->setSchedOffset(cpu, offset);
+		analyzer->setSchedScale(cpu, 1);
+		analyzer->setCpuFreqOffset(cpu, offset);
+		analyzer->setCpuIdleOffset(cpu, offset);
+		analyzer->setCpuFreqScale(cpu, 1);
+		analyzer->setCpuIdleScale(cpu, 1);
+		offset += 2;
+	}
+
+	startStage();
+	analyzer->doScale();
+	endStage("scale", false, false);
+}
+
+void Benchmark::startStage()
+{
+	resetPeakRSS();
+	timer.start();
+}
+
+void Benchmark::endStage(const char *name, bool readsFile, bool perEvent)
+{
+	Stage stage;
+
+	stage.nsecs = timer.nsecsElapsed();
+	stage.name = name;
+	stage.peakRSS = getPeakRSS();
+	stage.readsFile = readsFile;
+	stage.perEvent = perEvent;
+	stages.append(stage);
+}
+
+void Benchmark::writeStages()
+{
+	const double MB = 1024 * 1024;
+	double secs;
+	int i;
+
+	fprintf(out, "\t\"stages\": [");
+	for (i = 0; i < stages.size(); i++) {
+		const Stage &stage = stages[i];
+		secs = TSMAX(stage.nsecs, 1) / 1000000000.0;
+		fprintf(out, "%s\n\t\t{ \"name\": \"%s\", \"msecs\": %.3f",
+			i > 0 ? "," : "", stage.name, secs * 1000);
+		if (stage.readsFile)
+			fprintf(out, ", \"mb_per_sec\": %.1f",
+				fileSize / MB / secs);
+		if (stage.perEvent)
+			fprintf(out, ", \"events_per_sec\": %.0f",
+				nrEvents / secs);
+		fprintf(out, ", \"peak_rss_kb\": %ld }", stage.peakRSS);
+	}
+	fprintf(out, "\n\t],\n");
+	fprintf(out, "\t\"peak_rss_kb\": %ld\n", getPeakRSS());
+}
+
+void Benchmark::writeMapFlags()
+{
+	const char *sep = "";
+
+	fprintf(out, "\t\"map_flags\": \"");
+	if (mapFlags & vtl::MapCache::FLAG_TRANSPARENT_HUGE) {
+		fprintf(out, "%sthp", sep);
+		sep = ",";
+	}
+	if (mapFlags & vtl::MapCache::FLAG_EXPLICIT_HUGE) {
+		fprintf(out, "%shugetlb", sep);
+		sep = ",";
+	}
+	if (mapFlags & vtl::MapCache::FLAG_NUMA_INTERLEAVE) {
+		fprintf(out, "%snuma", sep);
+		sep = ",";
+	}
+	if (*sep == '\0')
+		fprintf(out, "none");
+	fprintf(out, "\",\n");
+}
+
+/*
+ * On Linux, the high water mark of the resident set can be reset, so that the
+ * peak of every stage can be measured separately. Elsewhere, the peak of each
+ * stage is the peak of the process so far.
+ */
+void Benchmark::resetPeakRSS()
+{
+#ifdef __linux__
+	FILE *f = fopen("/proc/self/clear_refs", "w");
+
+	if (f == nullptr)
+		return;
+	fputs("5", f);
+	fclose(f);
+#endif
+}
+
+/* Returns the peak of the resident set in kB */
+long Benchmark::getPeakRSS()
+{
+	struct rusage usage;
+#ifdef __linux__
+	char line[256];
+	long kb = -1;
+	FILE *f = fopen("/proc/self/status", "r");
+
+	if (f != nullptr) {
+		while (fgets(line, sizeof(line), f) != nullptr) {
+			if (sscanf(line, "VmHWM: %ld kB", &kb) == 1)
+				break;
+		}
+		fclose(f);
+		if (kb >= 0)
+			return kb;
+	}
+#endif
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return -1;
+#ifdef __APPLE__
+	return usage.ru_maxrss / 1024;
+#else
+	return usage.ru_maxrss;
+#endif
+}
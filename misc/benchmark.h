@@ -0,0 +1,115 @@
+// SPDX-License-Identifier: (GPL-2.0-or-later OR BSD-2-Clause)
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2020  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <cstdio>
+#include <QElapsedTimer>
+#include <QList>
+#include <QString>
+
+class SettingStore;
+class TraceAnalyzer;
+
+/*
+ * Measures the stages of loading a trace one by one and writes the results as
+ * JSON. This is what traceshark does when it is started with --benchmark. The
+ * read, tokenize and parse stages are pipelines of threads, so each of them
+ * includes the stages before it, i.e. the difference between two of them is
+ * what the added stage costs. The MapCache is disabled while the stages run,
+ * so that a stage doesn't get the memory of the previous one already faulted
+ * in, but its flags are used for the new maps. Running the benchmark with
+ * different flags shows what huge pages and NUMA interleaving are worth.
+ */
+class Benchmark
+{
+public:
+	Benchmark();
+	~Benchmark();
+	int run(const QString &fileName, FILE *out);
+	void setMapFlags(unsigned int flags);
+private:
+	class Stage {
+	public:
+		const char *name;
+		qint64 nsecs;
+		long peakRSS;
+		bool readsFile;
+		/* Whether the time is proportional to the number of events */
+		bool perEvent;
+	};
+	int benchRead(const QString &fileName);
+	int benchTokenize(const QString &fileName);
+	int benchParse(const QString &fileName);
+	int benchAnalyze(const QString &fileName);
+	void benchFilter();
+	void benchStats();
+	void benchScale();
+	void startStage();
+	void endStage(const char *name, bool readsFile, bool perEvent);
+	void writeStages();
+	static void resetPeakRSS();
+	static long getPeakRSS();
+	void writeMapFlags();
+	SettingStore *settingStore;
+	TraceAnalyzer *analyzer;
+	FILE *out;
+	QList<Stage> stages;
+	QElapsedTimer timer;
+	qint64 fileSize;
+	qint64 nrLines;
+	qint64 nrEvents;
+	unsigned int mapFlags;
+};
+
+#endif /* BENCHMARK_H */
@@ -52,13 +52,25 @@
  */
 
 #include <QApplication>
+#include <QCoreApplication>
+#include <QDir>
 #include <QString>
+#include <QStringList>
+#include <QTemporaryFile>
 #include <QtCore>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "misc/batchanalysis.h"
+#include "misc/benchmark.h"
 #include "misc/errors.h"
 #include "misc/resources.h"
+#include "misc/tracegenerator.h"
 #include "ui/mainwindow.h"
 #include "ui/tracesharkstyle.h"
 #include "vtl/error.h"
+#include "vtl/mapcache.h"
 
 #define QT4_WARNING \
 "WARNING!!! WARNING!!! WARNING!!!\n" \
@@ -70,10 +82,59 @@
 "WARNING!!! WARNING!!! WARNING!!! WARNING!!! WARNING!!! WARNING!!!\n" \
 "WARNING!!! WARNING!!! WARNING!!! WARNING!!! WARNING!!! WARNING!!!"
 
+#define OPT_BATCH "--batch"
+#define OPT_OUTPUT "--output="
+#define OPT_BENCHMARK "--benchmark"
+#define OPT_GENERATE "--generate="
+#define OPT_AT "--at="
+#define OPT_MAPFLAGS "--mapflags="
+
 static char *prgname;
+static bool batchMode = false;
+static bool benchmarkMode = false;
+static const char *outputName = nullptr;
+static const char *generateName = nullptr;
+static TraceGenerator generator;
+static QVector<double> queryTimes;
+static unsigned int mapFlags = vtl::MapCache::FLAG_NONE;
+
+/* Parses a list like "thp,numa" of the flags of the MapCache */
+static void parseMapFlags(const char *list)
+{
+	QStringList names = QString(list).split(QLatin1Char(','));
+	int i;
+
+	mapFlags = vtl::MapCache::FLAG_NONE;
+	for (i = 0; i < names.size(); i++) {
+		if (names[i] == QLatin1String("thp"))
+			mapFlags |= vtl::MapCache::FLAG_TRANSPARENT_HUGE;
+		else if (names[i] == QLatin1String("hugetlb"))
+			mapFlags |= vtl::MapCache::FLAG_EXPLICIT_HUGE;
+		else if (names[i] == QLatin1String("numa"))
+			mapFlags |= vtl::MapCache::FLAG_NUMA_INTERLEAVE;
+		else if (names[i] != QLatin1String("none"))
+			vtl::warnx("Ignoring unknown map flag %s",
+				   names[i].toLocal8Bit().data());
+	}
+}
 
-static void parseOption(const char */*opt*/)
-{}
+static void parseOption(const char *opt)
+{
+	if (!strcmp(opt, OPT_BATCH))
+		batchMode = true;
+	else if (!strcmp(opt, OPT_BENCHMARK))
+		benchmarkMode = true;
+	else if (!strncmp(opt, OPT_OUTPUT, strlen(OPT_OUTPUT)))
+		outputName = opt + strlen(OPT_OUTPUT);
+	else if (!strncmp(opt, OPT_GENERATE, strlen(OPT_GENERATE)))
+		generateName = opt + strlen(OPT_GENERATE);
+	else if (!strncmp(opt, OPT_AT, strlen(OPT_AT)))
+		queryTimes.append(atof(opt + strlen(OPT_AT)));
+	else if (!strncmp(opt, OPT_MAPFLAGS, strlen(OPT_MAPFLAGS)))
+		parseMapFlags(opt + strlen(OPT_MAPFLAGS));
+	else if (!generator.parseOption(opt))
+		vtl::warnx("Ignoring unknown option %s", opt);
+}
 
 static void parseArguments(QString *fileName, int argc, char* argv[])
 {
@@ -93,9 +154,119 @@ static void parseArguments(QString *fileName, int argc, char* argv[])
 	}
 }
 
+/*
+ * Returns true if one of the options that select a mode without widgets has
+ * been given. Only these are looked for, because the other arguments may be
+ * options of QApplication, which can only be parsed after it has removed them.
+ */
+static bool isHeadless(int argc, char* argv[])
+{
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], OPT_BATCH) ||
+		    !strcmp(argv[i], OPT_BENCHMARK) ||
+		    !strncmp(argv[i], OPT_GENERATE, strlen(OPT_GENERATE)))
+			return true;
+	}
+	return false;
+}
+
+/*
+ * Analyzes the trace without creating any widgets and writes the results to
+ * stdout, or to the file given with --output=
+ */
+static int batchMain(const QString &fileName, int argc, char* argv[])
+{
+	QCoreApplication app(argc, argv);
+	BatchAnalysis batch;
+	FILE *out = stdout;
+	int rval;
+
+	if (fileName.isEmpty()) {
+		vtl::warnx("usage: %s --batch [--output=file] [--at=time ...] "
+			   "tracefile", prgname);
+		return BSD_EX_USAGE;
+	}
+
+	if (outputName != nullptr) {
+		out = fopen(outputName, "w");
+		if (out == nullptr) {
+			vtl::warn(errno, "Failed to open %s", outputName);
+			return BSD_EX_CANTCREAT;
+		}
+	}
+
+	batch.setQueryTimes(queryTimes);
+	rval = batch.run(fileName, out);
+
+	if (out != stdout)
+		fclose(out);
+	return rval;
+}
+
+/*
+ * Measures the stages of loading fileName, or of a generated trace if no file
+ * is given. Like the batch mode, this doesn't create any widgets.
+ */
+static int benchmarkMain(const QString &fileName, int argc, char* argv[])
+{
+	QCoreApplication app(argc, argv);
+	QTemporaryFile tmpFile(QDir::tempPath() +
+			       QLatin1String("/traceshark-XXXXXX.dat"));
+	Benchmark benchmark;
+	QString traceName = fileName;
+	FILE *out = stdout;
+	int rval;
+
+	if (traceName.isEmpty() && generateName == nullptr) {
+		if (!tmpFile.open()) {
+			vtl::warnx("Failed to create a temporary file");
+			return BSD_EX_CANTCREAT;
+		}
+		tmpFile.close();
+		traceName = tmpFile.fileName();
+	} else if (traceName.isEmpty()) {
+		traceName = QString(generateName);
+	}
+
+	if (fileName.isEmpty()) {
+		if (generator.generate(traceName.toLocal8Bit().data()) != 0)
+			return BSD_EX_CANTCREAT;
+	}
+
+	if (outputName != nullptr) {
+		out = fopen(outputName, "w");
+		if (out == nullptr) {
+			vtl::warn(errno, "Failed to open %s", outputName);
+			return BSD_EX_CANTCREAT;
+		}
+	}
+
+	benchmark.setMapFlags(mapFlags);
+	rval = benchmark.run(traceName, out);
+
+	if (out != stdout)
+		fclose(out);
+	return rval;
+}
 
 int main(int argc, char* argv[])
 {
+	QString fileName;
+
+	vtl::set_strerror(ts_strerror);
+
+	if (isHeadless(argc, argv)) {
+		parseArguments(&fileName, argc, argv);
+		if (benchmarkMode)
+			return benchmarkMain(fileName, argc, argv);
+		if (generateName != nullptr)
+			return generator.generate(generateName) == 0 ?
+				0 : BSD_EX_CANTCREAT;
+		return batchMain(fileName, argc, argv);
+	}
+
 	/* must be called before QApplication is created */
 #if QT_VERSION >= QT_VERSION_CHECK(5,6,0)
 	QApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
@@ -111,9 +282,6 @@ int main(int argc, char* argv[])
 	QString appname = QLatin1String("Traceshark");
 	QRect geometry;
 	int width, height;
-	QString fileName;
-
-	vtl::set_strerror(ts_strerror);
 
 	parseArguments(&fileName, argc, argv);
 	/* Set graphicssystem to opengl if we have old enough Qt */
@@ -82,10 +82,22 @@ Setting::Setting(): supported(true), flags(FLAG_NO_FLAG), nrDep(0),
 {}
 
 
+/*
+ * In batch mode there is no QApplication and no screen, so we say that the
+ * screen is neither wide nor low resolution.
+ */
+static bool hasScreen()
+{
+	return qobject_cast<QApplication*>(QCoreApplication::instance())
+		!= nullptr;
+}
+
 bool Setting::isWideScreen()
 {
 	QRect geometry;
 
+	if (!hasScreen())
+		return false;
 	geometry = QApplication::desktop()->availableGeometry();
 	return geometry.width() > 1800;
 }
@@ -94,6 +106,8 @@ bool Setting::isLowResScreen()
 {
 	QRect geometry;
 
+	if (!hasScreen())
+		return false;
 	geometry = QApplication::desktop()->availableGeometry();
 	/* This is a heuristic */
 	return geometry.width() < 1700 && geometry.height() < 1220;
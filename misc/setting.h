@@ -78,13 +78,18 @@ public:
 		SHOW_CPUFREQ_GRAPHS,
 		SHOW_CPUIDLE_GRAPHS,
 		SHOW_MIGRATION_GRAPHS,
-		SHOW_MIGRATION_UNLIMITED,
 		OPENGL_ENABLED,
 		LINE_WIDTH,
 		IDLE_LINE_WIDTH,
 		FREQ_LINE_WIDTH,
 		MIGRATION_WIDTH,
 		EVENT_PID_FLT_INCL_ON,
+		MAP_CACHE_SIZE,
+		TRANSPARENT_HUGE_PAGES,
+		EXPLICIT_HUGE_PAGES,
+		NUMA_INTERLEAVE,
+		TILE_CACHE_SIZE,
+		SHOW_HEATMAP,
 		NR_SETTINGS,
 	} index_t;
         class Value;
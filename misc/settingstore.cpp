@@ -67,7 +67,6 @@ SettingStore::SettingStore()
 	QObject q;
 
 	Setting::Dependency schedDep(Setting::SHOW_SCHED_GRAPHS, true);
-	Setting::Dependency unlimitedDep(Setting::SHOW_MIGRATION_GRAPHS, true);
 	Setting::Dependency openglDep(Setting::OPENGL_ENABLED, true);
 	Setting::Dependency vertwakeDep(Setting::VERTICAL_WAKEUP, true);
 
@@ -109,22 +108,11 @@ SettingStore::SettingStore()
 	setKey(Setting::SHOW_CPUIDLE_GRAPHS, QString("SHOW_CPUIDLE_GRAPHS"));
 	initBoolValue(Setting::SHOW_CPUIDLE_GRAPHS, true);
 
-	QString maxstr = QString::number(MAX_NR_MIGRATIONS / 1000);
-	maxstr = maxstr + QString("k");
-	setName(Setting::SHOW_MIGRATION_GRAPHS, q.tr("Show migrations if < ")
-		+ maxstr);
+	setName(Setting::SHOW_MIGRATION_GRAPHS, q.tr("Show migrations"));
 	setKey(Setting::SHOW_MIGRATION_GRAPHS,
 	       QString("SHOW_MIGRATION_GRAPHS"));
 	initBoolValue(Setting::SHOW_MIGRATION_GRAPHS, true);
 
-	setName(Setting::SHOW_MIGRATION_UNLIMITED,
-		q.tr("Unlimited migrations"));
-	setKey(Setting::SHOW_MIGRATION_UNLIMITED,
-	       QString("SHOW_MIGRATION_UNLIMITED"));
-	initBoolValue(Setting::SHOW_MIGRATION_UNLIMITED, false);
-	initDisabledBoolValue(Setting::SHOW_MIGRATION_UNLIMITED, false);
-	addDependency(Setting::SHOW_MIGRATION_UNLIMITED, unlimitedDep);
-
 	bool opengl = has_opengl() && !Setting::isLowResScreen();
 	int width = opengl ? DEFAULT_LINE_WIDTH_OPENGL : DEFAULT_LINE_WIDTH;
 
@@ -178,6 +166,45 @@ SettingStore::SettingStore()
 	setKey(Setting::EVENT_PID_FLT_INCL_ON,
 	       QString("EVENT_PID_FLT_INCL_ON"));
 	initBoolValue(Setting::EVENT_PID_FLT_INCL_ON, false);
+
+	setName(Setting::MAP_CACHE_SIZE,
+		q.tr("Memory kept for reuse after closing a trace"));
+	setUnit(Setting::MAP_CACHE_SIZE, q.tr("MB"));
+	setKey(Setting::MAP_CACHE_SIZE, QString("MAP_CACHE_SIZE"));
+	initIntValue(Setting::MAP_CACHE_SIZE, DEFAULT_MAP_CACHE_SIZE);
+	initMaxIntValue(Setting::MAP_CACHE_SIZE, MAX_MAP_CACHE_SIZE);
+	initMinIntValue(Setting::MAP_CACHE_SIZE, MIN_MAP_CACHE_SIZE);
+	initDisabledIntValue(Setting::MAP_CACHE_SIZE, DEFAULT_MAP_CACHE_SIZE);
+
+	setName(Setting::TRANSPARENT_HUGE_PAGES,
+		q.tr("Use transparent huge pages for trace data"));
+	setKey(Setting::TRANSPARENT_HUGE_PAGES,
+	       QString("TRANSPARENT_HUGE_PAGES"));
+	initBoolValue(Setting::TRANSPARENT_HUGE_PAGES, true);
+
+	setName(Setting::EXPLICIT_HUGE_PAGES,
+		q.tr("Use reserved huge pages (hugetlbfs) for trace data"));
+	setKey(Setting::EXPLICIT_HUGE_PAGES, QString("EXPLICIT_HUGE_PAGES"));
+	initBoolValue(Setting::EXPLICIT_HUGE_PAGES, false);
+
+	setName(Setting::NUMA_INTERLEAVE,
+		q.tr("Interleave trace data over all NUMA nodes"));
+	setKey(Setting::NUMA_INTERLEAVE, QString("NUMA_INTERLEAVE"));
+	initBoolValue(Setting::NUMA_INTERLEAVE, false);
+
+	setName(Setting::TILE_CACHE_SIZE,
+		q.tr("Memory used for caching rendered parts of the plot"));
+	setUnit(Setting::TILE_CACHE_SIZE, q.tr("MB"));
+	setKey(Setting::TILE_CACHE_SIZE, QString("TILE_CACHE_SIZE"));
+	initIntValue(Setting::TILE_CACHE_SIZE, DEFAULT_TILE_CACHE_SIZE);
+	initMaxIntValue(Setting::TILE_CACHE_SIZE, MAX_TILE_CACHE_SIZE);
+	initMinIntValue(Setting::TILE_CACHE_SIZE, MIN_TILE_CACHE_SIZE);
+	initDisabledIntValue(Setting::TILE_CACHE_SIZE, DEFAULT_TILE_CACHE_SIZE);
+
+	setName(Setting::SHOW_HEATMAP,
+		q.tr("Show CPU utilization and task density heat map"));
+	setKey(Setting::SHOW_HEATMAP, QString("SHOW_HEATMAP"));
+	initBoolValue(Setting::SHOW_HEATMAP, false);
 }
 
 void SettingStore::setName(enum Setting::Index idx, const QString &n)
@@ -0,0 +1,501 @@
+// SPDX-License-Identifier: (GPL-2.0-or-later OR BSD-2-Clause)
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2020  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include "misc/tracegenerator.h"
+#include "misc/traceshark.h"
+#include "vtl/error.h"
+
+#define OPT_FORMAT "--format="
+#define OPT_CPUS "--cpus="
+#define OPT_TASKS "--tasks="
+#define OPT_EVENTS "--events="
+#define OPT_BACKTRACE "--backtrace="
+#define OPT_SEED "--seed="
+#define OPT_MIX "--mix="
+
+#define FIRST_PID (1000)
+#define TASK_PRIO (120)
+#define IDLE_EXIT (4294967295U)
+#define START_USECS (1000000000ULL)
+#define MAX_DELTA_USECS (50)
+
+static const unsigned int frequencies[] = {
+	800000, 1200000, 1600000, 2000000, 2400000, 2800000
+};
+
+static const char *const symbols[] = {
+	"__schedule", "schedule", "schedule_hrtimeout_range", "do_nanosleep",
+	"hrtimer_nanosleep", "futex_wait_queue_me", "futex_wait", "do_futex",
+	"__x64_sys_futex", "do_syscall_64", "entry_SYSCALL_64_after_hwframe",
+	"ep_poll", "do_epoll_wait", "pipe_read", "vfs_read", "ksys_read"
+};
+
+/* Relative frequencies of switch, wakeup, freq, idle and migrate */
+static const unsigned int defaultMix[TraceGenerator::NR_MIX] = {
+	40, 30, 10, 15, 5
+};
+
+TraceGenerator::TraceGenerator():
+	format(FORMAT_FTRACE), nrCPUs(4), nrTasks(64), nrEvents(1000000),
+	backtraceDepth(0), seed(1), file(nullptr), rngState(1), usecs(0),
+	written(0)
+{
+	memcpy(mix, defaultMix, sizeof(mix));
+}
+
+static bool parseUInt(const char *str, unsigned long long min,
+		      unsigned long long max, unsigned long long *value)
+{
+	char *end;
+	unsigned long long v;
+
+	errno = 0;
+	v = strtoull(str, &end, 0);
+	if (errno != 0 || end == str || *end != '\0' || v < min || v > max)
+		return false;
+	*value = v;
+	return true;
+}
+
+static bool matchOption(const char *opt, const char *name, const char **value)
+{
+	size_t len = strlen(name);
+
+	if (strncmp(opt, name, len))
+		return false;
+	*value = opt + len;
+	return true;
+}
+
+/*
+ * Returns true if opt is one of the generator options, in which case the
+ * parameter is set if the value is valid.
+ */
+bool TraceGenerator::parseOption(const char *opt)
+{
+	const char *value;
+	unsigned long long v;
+	unsigned int newMix[NR_MIX];
+	unsigned int sum;
+	char *end;
+	int i;
+
+	if (matchOption(opt, OPT_FORMAT, &value)) {
+		if (!strcmp(value, "ftrace"))
+			format = FORMAT_FTRACE;
+		else if (!strcmp(value, "perf"))
+			format = FORMAT_PERF;
+		else
+			goto invalid;
+	} else if (matchOption(opt, OPT_CPUS, &value)) {
+		if (!parseUInt(value, 1, 1024, &v))
+			goto invalid;
+		nrCPUs = v;
+	} else if (matchOption(opt, OPT_TASKS, &value)) {
+		if (!parseUInt(value, 1, 1000000, &v))
+			goto invalid;
+		nrTasks = v;
+	} else if (matchOption(opt, OPT_EVENTS, &value)) {
+		if (!parseUInt(value, 1, 1ULL << 40, &v))
+			goto invalid;
+		nrEvents = v;
+	} else if (matchOption(opt, OPT_BACKTRACE, &value)) {
+		if (!parseUInt(value, 0, 128, &v))
+			goto invalid;
+		backtraceDepth = v;
+	} else if (matchOption(opt, OPT_SEED, &value)) {
+		if (!parseUInt(value, 1, ~0ULL, &v))
+			goto invalid;
+		seed = v;
+	} else if (matchOption(opt, OPT_MIX, &value)) {
+		/* A comma separated list: switch,wakeup,freq,idle,migrate */
+		sum = 0;
+		for (i = 0; i < NR_MIX; i++) {
+			errno = 0;
+			newMix[i] = strtoul(value, &end, 10);
+			if (errno != 0 || end == value || newMix[i] > 1000)
+				goto invalid;
+			sum += newMix[i];
+			if (i < NR_MIX - 1 && *end != ',')
+				goto invalid;
+			value = end + 1;
+		}
+		if (*end != '\0' || sum == 0)
+			goto invalid;
+		memcpy(mix, newMix, sizeof(mix));
+	} else {
+		return false;
+	}
+	return true;
+invalid:
+	vtl::warnx("Ignoring invalid option %s", opt);
+	return true;
+}
+
+void TraceGenerator::setup()
+{
+	unsigned int cpu;
+	unsigned int t;
+	GenTask task;
+
+	rngState = seed;
+	usecs = START_USECS;
+	written = 0;
+
+	tasks.clear();
+	runnable.clear();
+	sleeping.clear();
+	running.fill(-1, nrCPUs);
+	cpuIdle.fill(true, nrCPUs);
+	cpuFreq.resize(nrCPUs);
+	for (cpu = 0; cpu < nrCPUs; cpu++)
+		cpuFreq[cpu] = frequencies[random(arraylen(frequencies))];
+
+	strncpy(idleName, format == FORMAT_FTRACE ? "<idle>" : "swapper",
+		sizeof(idleName));
+
+	/* Half of the tasks start out runnable and half sleeping */
+	for (t = 0; t < nrTasks; t++) {
+		task.pid = FIRST_PID + t;
+		snprintf(task.name, sizeof(task.name), "worker%u", t);
+		task.state = STATE_SLEEPING;
+		task.cpu = random(nrCPUs);
+		task.pos = -1;
+		tasks.append(task);
+		if (t % 2 == 0)
+			addTask(runnable, t, STATE_RUNNABLE);
+		else
+			addTask(sleeping, t, STATE_SLEEPING);
+	}
+}
+
+void TraceGenerator::addTask(QVector<int> &set, int t, state_t state)
+{
+	tasks[t].pos = set.size();
+	tasks[t].state = state;
+	set.append(t);
+}
+
+/* Removes the task by moving the last element of the set into its place */
+void TraceGenerator::removeTask(QVector<int> &set, int t)
+{
+	int pos = tasks[t].pos;
+	int last = set.last();
+
+	set[pos] = last;
+	tasks[last].pos = pos;
+	set.removeLast();
+	tasks[t].pos = -1;
+}
+
+int TraceGenerator::pickTask(QVector<int> &set)
+{
+	if (set.isEmpty())
+		return -1;
+	return set[random(set.size())];
+}
+
+const char *TraceGenerator::comm(int t, unsigned int cpu)
+{
+	static char swapper[20];
+
+	if (t >= 0)
+		return tasks[t].name;
+	snprintf(swapper, sizeof(swapper), "swapper/%u", cpu);
+	return swapper;
+}
+
+int TraceGenerator::pid(int t)
+{
+	return t >= 0 ? tasks[t].pid : 0;
+}
+
+TraceGenerator::mix_t TraceGenerator::pickEvent()
+{
+	unsigned int sum = 0;
+	unsigned int r;
+	int i;
+
+	for (i = 0; i < NR_MIX; i++)
+		sum += mix[i];
+	r = random(sum);
+	for (i = 0; i < NR_MIX; i++) {
+		if (r < mix[i])
+			break;
+		r -= mix[i];
+	}
+	return (mix_t) i;
+}
+
+/*
+ * Writes the beginning of a line, that is the current task of the CPU, the CPU,
+ * the timestamp and the event name.
+ */
+void TraceGenerator::writePrefix(unsigned int cpu, const char *sys,
+				 const char *event)
+{
+	int t = running[cpu];
+	const char *name = t >= 0 ? tasks[t].name : idleName;
+	unsigned long long sec = usecs / 1000000;
+	unsigned long long usec = usecs % 1000000;
+
+	if (format == FORMAT_FTRACE)
+		fprintf(file, "%16s-%-5d [%03u] %llu.%06llu: %s: ", name,
+			pid(t), cpu, sec, usec, event);
+	else
+		fprintf(file, "%16s %6d [%03u] %llu.%06llu: %s:%s: ", name,
+			pid(t), cpu, sec, usec, sys, event);
+	written++;
+}
+
+/* perf script prints the callchain below the event, followed by a blank line */
+void TraceGenerator::writeBacktrace()
+{
+	unsigned int i;
+	unsigned int s;
+
+	if (format != FORMAT_PERF || backtraceDepth == 0)
+		return;
+	for (i = 0; i < backtraceDepth; i++) {
+		s = random(arraylen(symbols));
+		fprintf(file, "\t%16llx %s+0x%x ([kernel.kallsyms])\n",
+			0xffffffff81000000ULL + s * 0x1000 + random(0x1000),
+			symbols[s], random(0x400));
+	}
+	fputc('\n', file);
+}
+
+bool TraceGenerator::genSwitch(unsigned int cpu)
+{
+	int prev = running[cpu];
+	int next;
+	const char *state = "R";
+
+	/* Occasionally let the CPU go idle, even if there is work */
+	if (prev >= 0 && random(8) == 0)
+		next = -1;
+	else
+		next = pickTask(runnable);
+	if (prev < 0 && next < 0)
+		return false;
+
+	/* The idle task leaves the idle state before it schedules */
+	if (prev < 0 && cpuIdle[cpu]) {
+		genIdle(cpu);
+		usecs++;
+	}
+
+	if (prev >= 0) {
+		if (random(2) == 0) {
+			state = "S";
+			addTask(sleeping, prev, STATE_SLEEPING);
+		} else {
+			addTask(runnable, prev, STATE_RUNNABLE);
+		}
+	}
+	if (next >= 0) {
+		removeTask(runnable, next);
+		tasks[next].state = STATE_RUNNING;
+		tasks[next].cpu = cpu;
+	}
+
+	writePrefix(cpu, "sched", "sched_switch");
+	fprintf(file,
+		"prev_comm=%s prev_pid=%d prev_prio=%d prev_state=%s ==> ",
+		comm(prev, cpu), pid(prev), TASK_PRIO, state);
+	fprintf(file, "next_comm=%s next_pid=%d next_prio=%d\n",
+		comm(next, cpu), pid(next), TASK_PRIO);
+	writeBacktrace();
+	running[cpu] = next;
+	return true;
+}
+
+bool TraceGenerator::genWakeup(unsigned int cpu)
+{
+	int t = pickTask(sleeping);
+
+	if (t < 0)
+		return false;
+	removeTask(sleeping, t);
+	addTask(runnable, t, STATE_RUNNABLE);
+
+	writePrefix(cpu, "sched", "sched_waking");
+	fprintf(file, "comm=%s pid=%d prio=%d target_cpu=%03u\n",
+		tasks[t].name, tasks[t].pid, TASK_PRIO, tasks[t].cpu);
+	writeBacktrace();
+	usecs++;
+	writePrefix(cpu, "sched", "sched_wakeup");
+	fprintf(file, "comm=%s pid=%d prio=%d target_cpu=%03u\n",
+		tasks[t].name, tasks[t].pid, TASK_PRIO, tasks[t].cpu);
+	writeBacktrace();
+	return true;
+}
+
+bool TraceGenerator::genFreq(unsigned int cpu)
+{
+	unsigned int f = frequencies[random(arraylen(frequencies))];
+
+	if (f == cpuFreq[cpu])
+		return false;
+	cpuFreq[cpu] = f;
+	writePrefix(cpu, "power", "cpu_frequency");
+	fprintf(file, "state=%u cpu_id=%u\n", f, cpu);
+	writeBacktrace();
+	return true;
+}
+
+bool TraceGenerator::genIdle(unsigned int cpu)
+{
+	unsigned int state;
+
+	/* Only a CPU that runs the idle task can enter or leave idle */
+	if (running[cpu] >= 0)
+		return false;
+	if (cpuIdle[cpu])
+		state = IDLE_EXIT;
+	else
+		state = random(3);
+	cpuIdle[cpu] = !cpuIdle[cpu];
+	writePrefix(cpu, "power", "cpu_idle");
+	fprintf(file, "state=%u cpu_id=%u\n", state, cpu);
+	writeBacktrace();
+	return true;
+}
+
+bool TraceGenerator::genMigrate(unsigned int cpu)
+{
+	int t = pickTask(runnable);
+	unsigned int orig;
+	unsigned int dest;
+
+	if (t < 0 || nrCPUs < 2)
+		return false;
+	orig = tasks[t].cpu;
+	dest = (orig + 1 + random(nrCPUs - 1)) % nrCPUs;
+	tasks[t].cpu = dest;
+	writePrefix(cpu, "sched", "sched_migrate_task");
+	fprintf(file, "comm=%s pid=%d prio=%d orig_cpu=%u dest_cpu=%u\n",
+		tasks[t].name, tasks[t].pid, TASK_PRIO, orig, dest);
+	writeBacktrace();
+	return true;
+}
+
+bool TraceGenerator::genEvent(mix_t type, unsigned int cpu)
+{
+	switch (type) {
+	case MIX_SWITCH:
+		return genSwitch(cpu);
+	case MIX_WAKEUP:
+		return genWakeup(cpu);
+	case MIX_FREQ:
+		return genFreq(cpu);
+	case MIX_IDLE:
+		return genIdle(cpu);
+	case MIX_MIGRATE:
+		return genMigrate(cpu);
+	default:
+		return false;
+	}
+}
+
+/*
+ * Writes the trace to fileName. The return value is zero or an errno value, in
+ * which case a warning has already been printed.
+ */
+int TraceGenerator::generate(const char *fileName)
+{
+	unsigned int cpu;
+	int i;
+	int rval = 0;
+
+	file = fopen(fileName, "w");
+	if (file == nullptr) {
+		rval = errno;
+		vtl::warn(rval, "Failed to open %s", fileName);
+		return rval;
+	}
+
+	setup();
+	if (format == FORMAT_FTRACE)
+		fprintf(file, "cpus=%u\n", nrCPUs);
+
+	while (written < nrEvents) {
+		usecs += 1 + random(MAX_DELTA_USECS);
+		cpu = random(nrCPUs);
+		/*
+		 * If the chosen event isn't possible in the current state, then
+		 * try the other kinds in order. As a last resort, change the
+		 * frequency, which works for any mix and any number of CPUs.
+		 */
+		if (genEvent(pickEvent(), cpu))
+			continue;
+		for (i = 0; i < NR_MIX; i++) {
+			if (mix[i] > 0 && genEvent((mix_t) i, cpu))
+				break;
+		}
+		if (i == NR_MIX)
+			genFreq(cpu);
+	}
+
+	if (ferror(file) != 0)
+		rval = errno != 0 ? errno : EIO;
+	if (fclose(file) != 0 && rval == 0)
+		rval = errno;
+	file = nullptr;
+	if (rval != 0)
+		vtl::warn(rval, "Failed to write %s", fileName);
+	return rval;
+}
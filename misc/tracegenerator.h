@@ -0,0 +1,147 @@
+// SPDX-License-Identifier: (GPL-2.0-or-later OR BSD-2-Clause)
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2020  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TRACEGENERATOR_H
+#define TRACEGENERATOR_H
+
+#include <cstdio>
+#include <QtGlobal>
+#include <QVector>
+
+#include "vtl/compiler.h"
+
+/*
+ * Writes a synthetic scheduler trace, either in the ftrace format of
+ * trace-cmd report or in the format of perf script. The trace is fully
+ * determined by the parameters and the seed, so that two runs with the same
+ * options produce identical files, which is what the benchmark mode needs in
+ * order to produce comparable numbers.
+ */
+class TraceGenerator
+{
+public:
+	typedef enum : int {
+		FORMAT_FTRACE = 0,
+		FORMAT_PERF
+	} format_t;
+	typedef enum : int {
+		MIX_SWITCH = 0,
+		MIX_WAKEUP,
+		MIX_FREQ,
+		MIX_IDLE,
+		MIX_MIGRATE,
+		NR_MIX
+	} mix_t;
+	TraceGenerator();
+	bool parseOption(const char *opt);
+	int generate(const char *fileName);
+	format_t format;
+	unsigned int nrCPUs;
+	unsigned int nrTasks;
+	quint64 nrEvents;
+	unsigned int backtraceDepth;
+	quint64 seed;
+	unsigned int mix[NR_MIX];
+private:
+	typedef enum : int {
+		STATE_RUNNING = 0,
+		STATE_RUNNABLE,
+		STATE_SLEEPING
+	} state_t;
+	class GenTask {
+	public:
+		int pid;
+		char name[20];
+		state_t state;
+		unsigned int cpu;
+		int pos;
+	};
+	void setup();
+	vtl_always_inline unsigned int random(unsigned int n);
+	mix_t pickEvent();
+	bool genEvent(mix_t type, unsigned int cpu);
+	bool genSwitch(unsigned int cpu);
+	bool genWakeup(unsigned int cpu);
+	bool genFreq(unsigned int cpu);
+	bool genIdle(unsigned int cpu);
+	bool genMigrate(unsigned int cpu);
+	void addTask(QVector<int> &set, int t, state_t state);
+	void removeTask(QVector<int> &set, int t);
+	int pickTask(QVector<int> &set);
+	void writePrefix(unsigned int cpu, const char *sys, const char *event);
+	void writeBacktrace();
+	const char *comm(int t, unsigned int cpu);
+	int pid(int t);
+	FILE *file;
+	quint64 rngState;
+	quint64 usecs;
+	quint64 written;
+	QVector<GenTask> tasks;
+	QVector<int> running;
+	QVector<int> runnable;
+	QVector<int> sleeping;
+	QVector<unsigned int> cpuFreq;
+	QVector<bool> cpuIdle;
+	char idleName[16];
+};
+
+/* xorshift64*, so that the output does not depend on the C library */
+vtl_always_inline unsigned int TraceGenerator::random(unsigned int n)
+{
+	rngState ^= rngState >> 12;
+	rngState ^= rngState << 25;
+	rngState ^= rngState >> 27;
+	return (unsigned int)
+		((rngState * 0x2545F4914F6CDD1DULL) >> 32) % n;
+}
+
+#endif /* TRACEGENERATOR_H */
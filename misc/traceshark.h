@@ -79,6 +79,12 @@
 #define DEFAULT_MAX_VRT_LATENCY (20)
 #define MIN_MAX_VRT_LATENCY (1)
 #define MAX_MAX_VRT_LATENCY (1000)
+#define DEFAULT_MAP_CACHE_SIZE (1024)
+#define MIN_MAP_CACHE_SIZE (0)
+#define MAX_MAP_CACHE_SIZE (65536)
+#define DEFAULT_TILE_CACHE_SIZE (128)
+#define MIN_TILE_CACHE_SIZE (0)
+#define MAX_TILE_CACHE_SIZE (4096)
 
 #ifdef QCUSTOMPLOT_USE_OPENGL
 #define has_opengl() (true)
@@ -94,8 +100,6 @@
 #include <QtWidgets>
 #endif
 
-#define MAX_NR_MIGRATIONS (200000)
-
 typedef enum : int {
 	TRACE_TYPE_FTRACE = 0,
 	TRACE_TYPE_PERF,
@@ -74,10 +74,10 @@ MemPool::~MemPool()
 	int i;
 	int len = exhaustList.size();
 	for (i = 0; i < len; i++) {
-		if (munmap(exhaustList[i], poolSize) != 0)
+		if (vtl::MapCache::unmap(exhaustList[i], poolSize) != 0)
 			munmap_err();
 	}
-	if (memory != nullptr && munmap(memory, poolSize) != 0)
+	if (memory != nullptr && vtl::MapCache::unmap(memory, poolSize) != 0)
 		munmap_err();
 }
 
@@ -92,7 +92,7 @@ void MemPool::reset()
 	int i;
 	int len = exhaustList.size();
 	for (i = 0; i < len; i++) {
-		if (munmap(exhaustList[i], poolSize) != 0)
+		if (vtl::MapCache::unmap(exhaustList[i], poolSize) != 0)
 			munmap_err();
 	}
 	exhaustList.clear();
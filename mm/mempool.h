@@ -61,6 +61,7 @@ extern "C" {
 
 #include "vtl/compiler.h"
 #include "vtl/error.h"
+#include "vtl/mapcache.h"
 
 class MemPool
 {
@@ -177,8 +178,7 @@ vtl_always_inline bool MemPool::commitChars(unsigned int chars)
 vtl_always_inline void MemPool::newMap()
 {
 	quint8 *ptr;
-	ptr = (quint8*) mmap(nullptr, (size_t) poolSize, PROT_READ|PROT_WRITE,
-			     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	ptr = (quint8*) vtl::MapCache::map((size_t) poolSize);
 	if (likely(ptr != MAP_FAILED)) {
 		memory = ptr;
 		next = ptr;
@@ -96,7 +96,7 @@ TraceFile::TraceFile(char *name, int &ts_errno, unsigned int bsize)
 	for (i = 0; i < NR_BUFFERS; i++) {
 		loadBuffers[i] = new LoadBuffer(bsize);
 	}
-	loadThread = new LoadThread(loadBuffers, NR_BUFFERS, fd);
+	loadThread = new LoadThread(loadBuffers, NR_BUFFERS, fd, fileSize);
 	/*
 	 * Don't start thread if something failed earlier, we go this far in
 	 * order to avoid problems in the destructor
@@ -121,6 +121,21 @@ TraceFile::~TraceFile()
 		munmap_err();
 }
 
+/*
+ * Stops the loading of the file. The consumers of the buffers will see an EOF
+ * as if the file had ended.
+ */
+void TraceFile::abortLoading()
+{
+	loadThread->requestStop();
+}
+
+/* Returns how many permille of the file that has been loaded */
+int TraceFile::getLoadProgress() const
+{
+	return loadThread->getProgress();
+}
+
 void TraceFile::close(int *ts_errno)
 {
 	*ts_errno = 0;
@@ -79,6 +79,8 @@ public:
 	TraceFile(char *name, int &ts_errno, unsigned int bsize = 1024 * 1024);
 	~TraceFile();
 	void close(int *ts_errno);
+	void abortLoading();
+	int getLoadProgress() const;
 	vtl_always_inline unsigned int
 		ReadLine(TraceLine *line, ThreadBuffer<TraceLine> *tbuffer);
 	vtl_always_inline bool atEnd() const;
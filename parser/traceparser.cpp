@@ -147,8 +147,32 @@ bool TraceParser::isOpen() const
 	return (traceFile != nullptr);
 }
 
+/*
+ * Makes the parsing finish early by letting the loading of the file end. The
+ * reader and parser threads will see an EOF and terminate.
+ */
+void TraceParser::abortParsing()
+{
+	if (traceFile != nullptr)
+		traceFile->abortLoading();
+}
+
+/* Returns how many permille of the trace file that has been loaded */
+int TraceParser::getProgress() const
+{
+	if (traceFile == nullptr)
+		return 0;
+	return traceFile->getLoadProgress();
+}
+
 void TraceParser::close(int *ts_errno)
 {
+	/*
+	 * If the parsing was aborted, then the threads may still be draining
+	 * the buffers.
+	 */
+	readerThread->wait();
+	parserThread->wait();
 	if (traceFile != nullptr) {
 		traceFile->close(ts_errno);
 		delete traceFile;
@@ -165,10 +189,35 @@ void TraceParser::close(int *ts_errno)
 	traceType = TRACE_TYPE_UNKNOWN;
 }
 
+/*
+ * Hands over the event lists to the caller, who becomes responsible for
+ * deleting them, and replaces them with empty lists. This allows the caller to
+ * free the memory of a closed trace on some other thread.
+ */
+void TraceParser::detachEvents(vtl::TList<TraceEvent> **ftrace,
+			       vtl::TList<TraceEvent> **perf)
+{
+	readerThread->wait();
+	parserThread->wait();
+	*ftrace = ftraceEvents;
+	*perf = perfEvents;
+	ftraceEvents = new vtl::TList<TraceEvent>();
+	perfEvents = new vtl::TList<TraceEvent>();
+	events = nullptr;
+}
+
+/*
+ * Waits until the reader and parser threads have processed the whole file, so
+ * that all events are in the event list.
+ */
+void TraceParser::waitForParsing()
+{
+	readerThread->wait();
+	parserThread->wait();
+}
 
 void TraceParser::threadReader()
 {
-	unsigned long long nr = 0;
 	unsigned int i = 0;
 	unsigned int curbuf = 0;
 	bool eof;
@@ -180,8 +229,7 @@ void TraceParser::threadReader()
 
 	while(true) {
 		TraceLine *line = &tbuffers[curbuf]->list.increase();
-		quint32 n = traceFile->ReadLine(line, tbuffers[curbuf]);
-		nr += n;
+		traceFile->ReadLine(line, tbuffers[curbuf]);
 		if (traceFile->getBufferSwitch()) {
 			eof = tbuffers[curbuf]->loadBuffer->isEOF();
 			tbuffers[curbuf]->endProduceBuffer();
@@ -203,8 +251,6 @@ void TraceParser::threadReader()
 			}
 		}
 	}
-
-	printf("%llu\n", nr);
 }
 
 
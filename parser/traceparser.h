@@ -89,6 +89,11 @@ public:
 	int open(const QString &fileName);
 	bool isOpen() const;
 	void close(int *ts_errno);
+	void abortParsing();
+	void waitForParsing();
+	void detachEvents(vtl::TList<TraceEvent> **ftrace,
+			  vtl::TList<TraceEvent> **perf);
+	int getProgress() const;
 	void threadParser();
 	void threadReader();
 	vtl_always_inline vtl::TList<TraceEvent> *getEventsTList() const;
@@ -0,0 +1,585 @@
+// SPDX-License-Identifier: (GPL-2.0-or-later OR BSD-2-Clause)
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2020  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*
+  This file is included by qcustomplot.h, after the definition of QCPGraphData. It should not be
+  included directly.
+
+  It specializes QCPDataContainer for QCPGraphData, so that the keys and the values are stored in
+  separate vectors instead of in a vector of QCPGraphData. The vectors are implicitly shared with
+  the caller, which means that a QCPGraph can plot the vectors of an application without making a
+  copy of them. The values are transformed with a scale and an offset when they are read, so that
+  the same data can be plotted at different positions without being rescaled. Instead of a vector
+  of values, the values can also be a constant or a bit vector.
+
+  The iterators are read-only and dereference to a temporary QCPGraphData.
+*/
+
+#ifndef QCPGRAPHDATACONTAINER_H
+#define QCPGRAPHDATACONTAINER_H
+
+#include <QVector>
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+
+template <>
+class QCPDataContainer<QCPGraphData>
+{
+public:
+  enum ValueSource { vsVector = 0, vsConstant, vsBits };
+
+  class const_iterator
+  {
+    friend class QCPDataContainer<QCPGraphData>;
+  public:
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef QCPGraphData value_type;
+    typedef ptrdiff_t difference_type;
+    typedef const QCPGraphData *pointer;
+    typedef QCPGraphData reference;
+
+    class arrow_proxy
+    {
+    public:
+      arrow_proxy(const QCPGraphData &d) : data(d) {}
+      const QCPGraphData *operator->() const { return &data; }
+    private:
+      QCPGraphData data;
+    };
+
+    const_iterator();
+    QCPGraphData operator*() const;
+    arrow_proxy operator->() const;
+    QCPGraphData operator[](difference_type n) const;
+    const_iterator &operator++();
+    const_iterator operator++(int);
+    const_iterator &operator--();
+    const_iterator operator--(int);
+    const_iterator &operator+=(difference_type n);
+    const_iterator &operator-=(difference_type n);
+    const_iterator operator+(difference_type n) const;
+    const_iterator operator-(difference_type n) const;
+    difference_type operator-(const const_iterator &other) const;
+    bool operator==(const const_iterator &other) const { return index == other.index; }
+    bool operator!=(const const_iterator &other) const { return index != other.index; }
+    bool operator<(const const_iterator &other) const { return index < other.index; }
+    bool operator>(const const_iterator &other) const { return index > other.index; }
+    bool operator<=(const const_iterator &other) const { return index <= other.index; }
+    bool operator>=(const const_iterator &other) const { return index >= other.index; }
+
+  protected:
+    const_iterator(const QCPDataContainer<QCPGraphData> *c, int i);
+    const QCPDataContainer<QCPGraphData> *container;
+    int index;
+  };
+  typedef const_iterator iterator;
+
+  QCPDataContainer();
+
+  // getters:
+  int size() const { return mKeys.size(); }
+  bool isEmpty() const { return size() == 0; }
+  bool autoSqueeze() const { return false; }
+  ValueSource valueSource() const { return mValueSource; }
+  double valueScale() const { return mValueScale; }
+  double valueOffset() const { return mValueOffset; }
+  double keyAt(int i) const;
+  double valueAt(int i) const;
+
+  // setters:
+  void setAutoSqueeze(bool enabled) { Q_UNUSED(enabled); }
+  void setValueTransform(double scale, double offset);
+
+  // non-virtual methods:
+  void set(const QCPDataContainer<QCPGraphData> &data);
+  void set(const QVector<QCPGraphData> &data, bool alreadySorted=false);
+  void set(const QVector<double> &keys, const QVector<double> &values, bool alreadySorted=false);
+  void setConstant(const QVector<double> &keys, double value);
+  void setBits(const QVector<double> &keys, const QVector<unsigned int> &bits);
+  void add(const QVector<QCPGraphData> &data, bool alreadySorted=false);
+  void add(const QCPGraphData &data);
+  void clear();
+  void sort();
+
+  const_iterator constBegin() const { return const_iterator(this, 0); }
+  const_iterator constEnd() const { return const_iterator(this, size()); }
+  const_iterator findBegin(double sortKey, bool expandedRange=true) const;
+  const_iterator findEnd(double sortKey, bool expandedRange=true) const;
+  const_iterator at(int index) const { return constBegin()+qBound(0, index, size()); }
+  QCPRange keyRange(bool &foundRange, QCP::SignDomain signDomain=QCP::sdBoth);
+  QCPRange valueRange(bool &foundRange, QCP::SignDomain signDomain=QCP::sdBoth, const QCPRange &inKeyRange=QCPRange());
+  QCPDataRange dataRange() const { return QCPDataRange(0, size()); }
+  void limitIteratorsToDataRange(const_iterator &begin, const_iterator &end, const QCPDataRange &dataRange) const;
+
+protected:
+  static const int BITS_PER_WORD = sizeof(unsigned int)*8;
+
+  // property members:
+  QVector<double> mKeys;
+  QVector<double> mValues;
+  QVector<unsigned int> mBits;
+  ValueSource mValueSource;
+  double mConstant;
+  double mValueScale;
+  double mValueOffset;
+
+  // non-virtual methods:
+  void materialize();
+  void fromVector(const QVector<QCPGraphData> &data, bool alreadySorted);
+};
+
+
+// ================================================================================
+// =================== QCPDataContainer<QCPGraphData>::const_iterator =============
+// ================================================================================
+
+inline QCPDataContainer<QCPGraphData>::const_iterator::const_iterator() :
+  container(nullptr),
+  index(0)
+{
+}
+
+inline QCPDataContainer<QCPGraphData>::const_iterator::const_iterator(const QCPDataContainer<QCPGraphData> *c, int i) :
+  container(c),
+  index(i)
+{
+}
+
+qcp_always_inline QCPGraphData QCPDataContainer<QCPGraphData>::const_iterator::operator*() const
+{
+  return QCPGraphData(container->keyAt(index), container->valueAt(index));
+}
+
+qcp_always_inline QCPDataContainer<QCPGraphData>::const_iterator::arrow_proxy QCPDataContainer<QCPGraphData>::const_iterator::operator->() const
+{
+  return arrow_proxy(**this);
+}
+
+inline QCPGraphData QCPDataContainer<QCPGraphData>::const_iterator::operator[](difference_type n) const
+{
+  return *(*this+n);
+}
+
+qcp_always_inline QCPDataContainer<QCPGraphData>::const_iterator &QCPDataContainer<QCPGraphData>::const_iterator::operator++()
+{
+  ++index;
+  return *this;
+}
+
+qcp_always_inline QCPDataContainer<QCPGraphData>::const_iterator QCPDataContainer<QCPGraphData>::const_iterator::operator++(int)
+{
+  const_iterator old = *this;
+  ++index;
+  return old;
+}
+
+qcp_always_inline QCPDataContainer<QCPGraphData>::const_iterator &QCPDataContainer<QCPGraphData>::const_iterator::operator--()
+{
+  --index;
+  return *this;
+}
+
+qcp_always_inline QCPDataContainer<QCPGraphData>::const_iterator QCPDataContainer<QCPGraphData>::const_iterator::operator--(int)
+{
+  const_iterator old = *this;
+  --index;
+  return old;
+}
+
+qcp_always_inline QCPDataContainer<QCPGraphData>::const_iterator &QCPDataContainer<QCPGraphData>::const_iterator::operator+=(difference_type n)
+{
+  index += n;
+  return *this;
+}
+
+qcp_always_inline QCPDataContainer<QCPGraphData>::const_iterator &QCPDataContainer<QCPGraphData>::const_iterator::operator-=(difference_type n)
+{
+  index -= n;
+  return *this;
+}
+
+qcp_always_inline QCPDataContainer<QCPGraphData>::const_iterator QCPDataContainer<QCPGraphData>::const_iterator::operator+(difference_type n) const
+{
+  return const_iterator(container, index+n);
+}
+
+qcp_always_inline QCPDataContainer<QCPGraphData>::const_iterator QCPDataContainer<QCPGraphData>::const_iterator::operator-(difference_type n) const
+{
+  return const_iterator(container, index-n);
+}
+
+qcp_always_inline QCPDataContainer<QCPGraphData>::const_iterator::difference_type QCPDataContainer<QCPGraphData>::const_iterator::operator-(const const_iterator &other) const
+{
+  return index-other.index;
+}
+
+inline QCPDataContainer<QCPGraphData>::const_iterator operator+(QCPDataContainer<QCPGraphData>::const_iterator::difference_type n, const QCPDataContainer<QCPGraphData>::const_iterator &it)
+{
+  return it+n;
+}
+
+
+// ================================================================================
+// =================== QCPDataContainer<QCPGraphData> =============================
+// ================================================================================
+
+inline QCPDataContainer<QCPGraphData>::QCPDataContainer() :
+  mValueSource(vsVector),
+  mConstant(0),
+  mValueScale(1),
+  mValueOffset(0)
+{
+}
+
+qcp_always_inline double QCPDataContainer<QCPGraphData>::keyAt(int i) const
+{
+  return mKeys.at(i);
+}
+
+qcp_always_inline double QCPDataContainer<QCPGraphData>::valueAt(int i) const
+{
+  switch (mValueSource)
+  {
+    case vsVector:
+      return mValues.at(i)*mValueScale + mValueOffset;
+    case vsBits:
+    {
+      unsigned int bit = (mBits.at(i/BITS_PER_WORD) >> (i%BITS_PER_WORD)) & 0x1;
+      return bit*mValueScale + mValueOffset;
+    }
+    case vsConstant:
+    default:
+      return mConstant*mValueScale + mValueOffset;
+  }
+}
+
+/*!
+  Makes this container a copy of \a data. The vectors are shared with \a data, so this is cheap.
+*/
+inline void QCPDataContainer<QCPGraphData>::set(const QCPDataContainer<QCPGraphData> &data)
+{
+  mKeys = data.mKeys;
+  mValues = data.mValues;
+  mBits = data.mBits;
+  mValueSource = data.mValueSource;
+  mConstant = data.mConstant;
+  mValueScale = data.mValueScale;
+  mValueOffset = data.mValueOffset;
+}
+
+inline void QCPDataContainer<QCPGraphData>::set(const QVector<QCPGraphData> &data, bool alreadySorted)
+{
+  clear();
+  fromVector(data, alreadySorted);
+}
+
+/*!
+  Sets the data to \a keys and \a values. The vectors are shared with the caller if they are
+  sorted, so that no copy is made. The value transform is reset to the identity.
+*/
+inline void QCPDataContainer<QCPGraphData>::set(const QVector<double> &keys, const QVector<double> &values, bool alreadySorted)
+{
+  clear();
+  mKeys = keys;
+  mValues = values;
+  if (mKeys.size() != mValues.size())
+  {
+    int n = qMin(mKeys.size(), mValues.size());
+    mKeys.resize(n);
+    mValues.resize(n);
+  }
+  if (!alreadySorted && !std::is_sorted(mKeys.constBegin(), mKeys.constEnd()))
+    sort();
+}
+
+/*!
+  Sets the data to \a keys, which must be sorted, with all values equal to \a value.
+*/
+inline void QCPDataContainer<QCPGraphData>::setConstant(const QVector<double> &keys, double value)
+{
+  clear();
+  mKeys = keys;
+  mConstant = value;
+  mValueSource = vsConstant;
+}
+
+/*!
+  Sets the data to \a keys, which must be sorted, with the values taken from \a bits, i.e. either 0
+  or 1. Bit i of the vector is stored in bit (i % 32) of bits[i / 32].
+*/
+inline void QCPDataContainer<QCPGraphData>::setBits(const QVector<double> &keys, const QVector<unsigned int> &bits)
+{
+  clear();
+  mKeys = keys;
+  if (mKeys.size() > bits.size()*BITS_PER_WORD)
+    mKeys.resize(bits.size()*BITS_PER_WORD);
+  mBits = bits;
+  mValueSource = vsBits;
+}
+
+/*!
+  Sets the transform of the values, so that a value v from the source is plotted as
+  v * \a scale + \a offset.
+*/
+inline void QCPDataContainer<QCPGraphData>::setValueTransform(double scale, double offset)
+{
+  mValueScale = scale;
+  mValueOffset = offset;
+}
+
+inline void QCPDataContainer<QCPGraphData>::add(const QVector<QCPGraphData> &data, bool alreadySorted)
+{
+  fromVector(data, alreadySorted);
+}
+
+inline void QCPDataContainer<QCPGraphData>::add(const QCPGraphData &data)
+{
+  fromVector(QVector<QCPGraphData>(1, data), true);
+}
+
+inline void QCPDataContainer<QCPGraphData>::clear()
+{
+  mKeys.clear();
+  mValues.clear();
+  mBits.clear();
+  mValueSource = vsVector;
+  mConstant = 0;
+  mValueScale = 1;
+  mValueOffset = 0;
+}
+
+inline void QCPDataContainer<QCPGraphData>::sort()
+{
+  if (std::is_sorted(mKeys.constBegin(), mKeys.constEnd()))
+    return;
+
+  const int n = size();
+  QVector<QCPGraphData> data(n);
+  for (int i=0; i<n; ++i)
+    data[i] = QCPGraphData(keyAt(i), valueAt(i));
+  std::stable_sort(data.begin(), data.end(), qcpLessThanSortKey<QCPGraphData>);
+  clear();
+  fromVector(data, true);
+}
+
+/*! \internal
+
+  Converts the values to a vector with the value transform applied, so that more data can be
+  added. This is the only operation that makes a copy of the data.
+*/
+inline void QCPDataContainer<QCPGraphData>::materialize()
+{
+  if (mValueSource == vsVector && mValueScale == 1 && mValueOffset == 0)
+    return;
+
+  const int n = size();
+  QVector<double> values(n);
+  for (int i=0; i<n; ++i)
+    values[i] = valueAt(i);
+  mValues = values;
+  mBits.clear();
+  mValueSource = vsVector;
+  mConstant = 0;
+  mValueScale = 1;
+  mValueOffset = 0;
+}
+
+inline void QCPDataContainer<QCPGraphData>::fromVector(const QVector<QCPGraphData> &data, bool alreadySorted)
+{
+  const int n = data.size();
+  if (n == 0)
+    return;
+
+  materialize();
+  double last = isEmpty() ? data.at(0).key : mKeys.at(size()-1);
+  mKeys.reserve(size()+n);
+  mValues.reserve(size()+n);
+  for (int i=0; i<n; ++i)
+  {
+    const QCPGraphData &d = data.at(i);
+    mKeys.append(d.key);
+    mValues.append(d.value);
+    if (d.key < last)
+      alreadySorted = false;
+    last = d.key;
+  }
+  if (!alreadySorted)
+    sort();
+}
+
+inline QCPDataContainer<QCPGraphData>::const_iterator QCPDataContainer<QCPGraphData>::findBegin(double sortKey, bool expandedRange) const
+{
+  if (isEmpty())
+    return constEnd();
+
+  const_iterator it = constBegin() + (std::lower_bound(mKeys.constBegin(), mKeys.constEnd(), sortKey)-mKeys.constBegin());
+  if (expandedRange && it != constBegin())
+    --it;
+  return it;
+}
+
+inline QCPDataContainer<QCPGraphData>::const_iterator QCPDataContainer<QCPGraphData>::findEnd(double sortKey, bool expandedRange) const
+{
+  if (isEmpty())
+    return constEnd();
+
+  const_iterator it = constBegin() + (std::upper_bound(mKeys.constBegin(), mKeys.constEnd(), sortKey)-mKeys.constBegin());
+  if (expandedRange && it != constEnd())
+    ++it;
+  return it;
+}
+
+inline QCPRange QCPDataContainer<QCPGraphData>::keyRange(bool &foundRange, QCP::SignDomain signDomain)
+{
+  QCPRange range;
+  bool haveLower = false;
+  bool haveUpper = false;
+  const int n = size();
+
+  if (signDomain == QCP::sdBoth) // the keys are sorted, so look for the first and the last key
+  {
+    for (int i=0; i<n; ++i)
+    {
+      if (!qIsNaN(valueAt(i)))
+      {
+        range.lower = keyAt(i);
+        haveLower = true;
+        break;
+      }
+    }
+    for (int i=n-1; i>=0; --i)
+    {
+      if (!qIsNaN(valueAt(i)))
+      {
+        range.upper = keyAt(i);
+        haveUpper = true;
+        break;
+      }
+    }
+    foundRange = haveLower && haveUpper;
+    return range;
+  }
+
+  for (int i=0; i<n; ++i)
+  {
+    if (qIsNaN(valueAt(i)))
+      continue;
+    double current = keyAt(i);
+    if (signDomain == QCP::sdNegative ? current >= 0 : current <= 0)
+      continue;
+    if (current < range.lower || !haveLower)
+    {
+      range.lower = current;
+      haveLower = true;
+    }
+    if (current > range.upper || !haveUpper)
+    {
+      range.upper = current;
+      haveUpper = true;
+    }
+  }
+  foundRange = haveLower && haveUpper;
+  return range;
+}
+
+inline QCPRange QCPDataContainer<QCPGraphData>::valueRange(bool &foundRange, QCP::SignDomain signDomain, const QCPRange &inKeyRange)
+{
+  QCPRange range;
+  const bool restrictKeyRange = inKeyRange != QCPRange();
+  bool haveLower = false;
+  bool haveUpper = false;
+  int begin = 0;
+  int end = size();
+
+  if (restrictKeyRange)
+  {
+    begin = findBegin(inKeyRange.lower).index;
+    end = findEnd(inKeyRange.upper).index;
+  }
+  for (int i=begin; i<end; ++i)
+  {
+    if (restrictKeyRange && (keyAt(i) < inKeyRange.lower || keyAt(i) > inKeyRange.upper))
+      continue;
+    double current = valueAt(i);
+    if (qIsNaN(current))
+      continue;
+    if (signDomain == QCP::sdNegative && current >= 0)
+      continue;
+    if (signDomain == QCP::sdPositive && current <= 0)
+      continue;
+    if (current < range.lower || !haveLower)
+    {
+      range.lower = current;
+      haveLower = true;
+    }
+    if (current > range.upper || !haveUpper)
+    {
+      range.upper = current;
+      haveUpper = true;
+    }
+  }
+  foundRange = haveLower && haveUpper;
+  return range;
+}
+
+inline void QCPDataContainer<QCPGraphData>::limitIteratorsToDataRange(const_iterator &begin, const_iterator &end, const QCPDataRange &dataRange) const
+{
+  QCPDataRange iteratorRange(begin-constBegin(), end-constBegin());
+  iteratorRange = iteratorRange.bounded(dataRange.bounded(this->dataRange()));
+  begin = constBegin()+iteratorRange.begin();
+  end = constBegin()+iteratorRange.end();
+}
+
+#endif // QCPGRAPHDATACONTAINER_H
@@ -1046,7 +1046,8 @@ QCPLayer::QCPLayer(QCustomPlot *parentPlot, const QString &layerName) :
   mName(layerName),
   mIndex(-1), // will be set to a proper value by the QCustomPlot layer creation function
   mVisible(true),
-  mMode(lmLogical)
+  mMode(lmLogical),
+  mRenderer(0)
 {
   // Note: no need to make sure layerName is unique, because layer
   // management is done with QCustomPlot functions.
@@ -1110,6 +1111,26 @@ void QCPLayer::setMode(QCPLayer::LayerMode mode)
   }
 }
 
+/*!
+  Sets a \a renderer that is given the chance to draw this layer into its paint buffer instead of
+  the layer drawing its layerables directly, e.g. in order to reuse contents that it has cached.
+  The layer does not take ownership of the renderer. Pass 0 to remove the renderer.
+
+  The renderer is only used when the layer is drawn into a paint buffer, exporting the plot with
+  e.g. \ref QCustomPlot::savePdf always draws the layerables directly.
+
+  \see QCPLayerRenderer
+*/
+void QCPLayer::setRenderer(QCPLayerRenderer *renderer)
+{
+  if (mRenderer != renderer)
+  {
+    mRenderer = renderer;
+    if (!mPaintBuffer.isNull())
+      mPaintBuffer.data()->setInvalidated();
+  }
+}
+
 /*! \internal
 
   Draws the contents of this layer with the provided \a painter.
@@ -1146,8 +1167,10 @@ void QCPLayer::drawToPaintBuffer()
     if (QCPPainter *painter = mPaintBuffer.data()->startPainting())
     {
       if (painter->isActive())
-        draw(painter);
-      else
+      {
+        if (!mRenderer || !mRenderer->drawLayer(this, painter))
+          draw(painter);
+      } else
         qDebug() << Q_FUNC_INFO << "paint buffer returned inactive painter";
       delete painter;
       mPaintBuffer.data()->donePainting();
@@ -1182,7 +1205,7 @@ void QCPLayer::replot()
       mParentPlot->update();
     } else
       qDebug() << Q_FUNC_INFO << "no valid paint buffer associated with this layer";
-  } else if (mMode == lmLogical)
+  } else
     mParentPlot->replot();
 }
 
@@ -1230,6 +1253,48 @@ void QCPLayer::removeChild(QCPLayerable *layerable)
 }
 
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPLayerRenderer
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*! \class QCPLayerRenderer
+  \brief Interface for objects that draw a layer into its paint buffer
+
+  A renderer is installed on a layer with \ref QCPLayer::setRenderer. When the layer is drawn into
+  its paint buffer, \ref drawLayer is called instead of the layer drawing its layerables. This
+  makes it possible to, for example, keep a cache of the rendered layer and only draw the parts
+  that have changed.
+*/
+
+/*! \fn bool QCPLayerRenderer::drawLayer(QCPLayer *layer, QCPPainter *painter)
+
+  Draws the contents of \a layer with \a painter. If this function returns false, the layer
+  draws its layerables itself, as if no renderer had been installed.
+*/
+
+/*!
+  Draws the layerables of \a layer with \a painter, in the same way as the layer would have done
+  without a renderer. Typically this is used to draw into a painter on an offscreen image.
+*/
+void QCPLayerRenderer::drawLayerables(QCPLayer *layer, QCPPainter *painter)
+{
+  layer->draw(painter);
+}
+
+/*!
+  Draws a single \a layerable with \a painter, with the same clipping and antialiasing as it would
+  get when its layer draws it. The layerable doesn't need to be on the layer that is rendered.
+*/
+void QCPLayerRenderer::drawLayerable(QCPLayerable *layerable, QCPPainter *painter)
+{
+  painter->save();
+  painter->setClipRect(layerable->clipRect().translated(0, -1));
+  layerable->applyDefaultAntialiasingHint(painter);
+  layerable->draw(painter);
+  painter->restore();
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////// QCPLayerable
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -20193,13 +20258,50 @@ void QCPGraph::setData(QSharedPointer<QCPGraphDataContainer> data)
   
   If you can guarantee that the passed data points are sorted by \a keys in ascending order, you
   can set \a alreadySorted to true, to improve performance by saving a sorting run.
+
+  If the keys are sorted, the vectors are implicitly shared with the caller and no copy of the
+  data is made. The value transform is reset, see \ref setValueTransform.
   
   \see addData
 */
 void QCPGraph::setData(const QVector<double> &keys, const QVector<double> &values, bool alreadySorted)
 {
-  mDataContainer->clear();
-  addData(keys, values, alreadySorted);
+  mDataContainer->set(keys, values, alreadySorted);
+}
+
+/*! \overload
+
+  Replaces the current data with points at the provided \a keys, which must be sorted in
+  ascending order. All points have the same \a value. The \a keys vector is implicitly shared
+  with the caller.
+
+  \see setValueTransform
+*/
+void QCPGraph::setConstantData(const QVector<double> &keys, double value)
+{
+  mDataContainer->setConstant(keys, value);
+}
+
+/*! \overload
+
+  Replaces the current data with points at the provided \a keys, which must be sorted in
+  ascending order. The value of point i is bit (i % 32) of \a bits[i / 32], i.e. either 0 or 1,
+  so it is typically combined with \ref setValueTransform. Both vectors are implicitly shared
+  with the caller.
+*/
+void QCPGraph::setBitData(const QVector<double> &keys, const QVector<unsigned int> &bits)
+{
+  mDataContainer->setBits(keys, bits);
+}
+
+/*!
+  Sets a transform that is applied to the values when they are plotted, so that a value v is
+  plotted as v * \a scale + \a offset. This makes it possible to move or resize a graph without
+  changing its data.
+*/
+void QCPGraph::setValueTransform(double scale, double offset)
+{
+  mDataContainer->setValueTransform(scale, offset);
 }
 
 /*!
@@ -628,6 +628,20 @@ protected:
 /* including file 'src/layer.h', size 6909                                   */
 /* commit de2ea9c99087e7fe956fd30e8a62dff53c6da840 2020-02-06 23:02:51 +0100 */
 
+class QCP_LIB_DECL QCPLayerRenderer
+{
+public:
+  virtual ~QCPLayerRenderer() {}
+  
+  // introduced virtual methods:
+  virtual bool drawLayer(QCPLayer *layer, QCPPainter *painter) = 0;
+  
+protected:
+  // non-virtual methods:
+  void drawLayerables(QCPLayer *layer, QCPPainter *painter);
+  void drawLayerable(QCPLayerable *layerable, QCPPainter *painter);
+};
+
 class QCP_LIB_DECL QCPLayer : public QObject
 {
   Q_OBJECT
@@ -663,10 +677,12 @@ public:
   QCPList<QCPLayerable*> &children() { return mChildren; }
   bool visible() const { return mVisible; }
   LayerMode mode() const { return mMode; }
+  QCPLayerRenderer *renderer() const { return mRenderer; }
   
   // setters:
   void setVisible(bool visible);
   void setMode(LayerMode mode);
+  void setRenderer(QCPLayerRenderer *renderer);
   
   // non-virtual methods:
   void replot();
@@ -679,6 +695,7 @@ protected:
   QCPList<QCPLayerable*> mChildren;
   bool mVisible;
   LayerMode mMode;
+  QCPLayerRenderer *mRenderer;
   
   // non-property members:
   QWeakPointer<QCPAbstractPaintBuffer> mPaintBuffer;
@@ -694,6 +711,7 @@ private:
   
   friend class QCustomPlot;
   friend class QCPLayerable;
+  friend class QCPLayerRenderer;
 };
 Q_DECLARE_METATYPE(QCPLayer::LayerMode)
 
@@ -769,6 +787,7 @@ private:
   friend class QCustomPlot;
   friend class QCPLayer;
   friend class QCPAxisRect;
+  friend class QCPLayerRenderer;
 };
 
 /* end of 'src/layer.h' */
@@ -5152,6 +5171,8 @@ public:
 };
 Q_DECLARE_TYPEINFO(QCPGraphData, Q_PRIMITIVE_TYPE);
 
+#include "qcpgraphdatacontainer.h"
+
 
 /*! \typedef QCPGraphDataContainer
   
@@ -5204,6 +5225,9 @@ public:
   // setters:
   void setData(QSharedPointer<QCPGraphDataContainer> data);
   void setData(const QVector<double> &keys, const QVector<double> &values, bool alreadySorted=false);
+  void setConstantData(const QVector<double> &keys, double value);
+  void setBitData(const QVector<double> &keys, const QVector<unsigned int> &bits);
+  void setValueTransform(double scale, double offset);
   void setLineStyle(LineStyle ls);
   void setScatterStyle(const QCPScatterStyle &style);
   void setScatterSkip(int skip);
@@ -57,6 +57,7 @@
 #include "misc/tstring.h"
 #include "threads/loadbuffer.h"
 #include "vtl/error.h"
+#include "vtl/mapcache.h"
 
 extern "C" {
 #include <unistd.h>
@@ -72,8 +73,7 @@ LoadBuffer::LoadBuffer(unsigned int size):
 	 * We need the extra byte to be able to set a null character in
 	 * TraceFile::ReadNextWord() one byte out of bounds.
 	 */
-	memory = (char*) mmap(nullptr, 2 * size + 1, PROT_READ | PROT_WRITE,
-			      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	memory = (char*) vtl::MapCache::map(2 * size + 1);
 	if (memory == MAP_FAILED)
 		mmap_err();
 	readBegin = memory + size;
@@ -81,20 +81,25 @@ LoadBuffer::LoadBuffer(unsigned int size):
 
 LoadBuffer::~LoadBuffer()
 {
-	if (munmap(memory, bufSize * 2 + 1) != 0)
+	if (vtl::MapCache::unmap(memory, bufSize * 2 + 1) != 0)
 		munmap_err();
 }
 
 /*
  * This function should be called from the IO thread until the function returns
- * true.
+ * true. If stop is true, then the buffer is delivered empty and with EOF set,
+ * without reading anything from the file.
  */
-bool LoadBuffer::produceBuffer(int fd, int64_t *filePosPtr, TString *lineBegin)
+bool LoadBuffer::produceBuffer(int fd, int64_t *filePosPtr, TString *lineBegin,
+			       bool stop)
 {
 	ssize_t nRawBytes;
 	char *c;
 
 	waitForConsumptionComplete();
+	/* A partial line is of no use if we are stopping */
+	if (stop)
+		lineBegin->len = 0;
 
 	nRead = lineBegin->len;
 	if (nRead >= bufSize)
@@ -103,7 +108,10 @@ bool LoadBuffer::produceBuffer(int fd, int64_t *filePosPtr, TString *lineBegin)
 	strncpy(buffer, lineBegin->ptr, lineBegin->len);
 
 	filePos = *filePosPtr;
-	nRawBytes = read(fd, readBegin, bufSize);
+	if (stop)
+		nRawBytes = 0;
+	else
+		nRawBytes = read(fd, readBegin, bufSize);
 
 	if (nRawBytes < 0) {
 		IOerrno = errno;
@@ -85,7 +85,8 @@ public:
 	int64_t filePos;
 	bool IOerror;
 	int IOerrno;
-	bool produceBuffer(int fd, int64_t *filePosPtr, TString *lineBegin);
+	bool produceBuffer(int fd, int64_t *filePosPtr, TString *lineBegin,
+			   bool stop = false);
 	void beginProduceBuffer();
 	void endProduceBuffer();
 	void beginTokenizeBuffer();
@@ -57,6 +57,7 @@
 #include "misc/tstring.h"
 #include "threads/loadbuffer.h"
 #include "threads/loadthread.h"
+#include "misc/traceshark.h"
 #include "vtl/error.h"
 
 extern "C" {
@@ -64,11 +65,26 @@ extern "C" {
 #include <unistd.h>
 }
 
-LoadThread::LoadThread(LoadBuffer **buffers, unsigned int nBuf, int myfd)
+LoadThread::LoadThread(LoadBuffer **buffers, unsigned int nBuf, int myfd,
+		       int64_t size)
 	: TThread(QString("LoadThread")), loadBuffers(buffers), nBuffers(nBuf),
-	  fd(myfd)
+	  fd(myfd), fileSize(size), progress(0), stopRequested(0)
 {}
 
+/*
+ * Makes the thread stop reading the file and deliver an EOF instead, so that
+ * the threads that consume the buffers will finish as if the file had ended.
+ */
+void LoadThread::requestStop()
+{
+	stopRequested.storeRelease(1);
+}
+
+int LoadThread::getProgress() const
+{
+	return progress.loadAcquire();
+}
+
 void LoadThread::run()
 {
 	unsigned int i = 0;
@@ -84,12 +100,18 @@ void LoadThread::run()
 	lineBegin.len = 0;
 
 	do {
-		eof = loadBuffers[i]->produceBuffer(fd, &filePos, &lineBegin);
+		eof = loadBuffers[i]->produceBuffer(fd, &filePos, &lineBegin,
+						    stopRequested.loadAcquire()
+						    != 0);
+		if (fileSize > 0)
+			progress.storeRelease((int) TSMIN(filePos * 1000 /
+							  fileSize, 1000));
 		i++;
 		if (i == nBuffers)
 			i = 0;
 	} while(!eof);
 
+	progress.storeRelease(1000);
 	if (munmap(lineBegin.ptr, bufSize) != 0)
 		munmap_err();
 }
@@ -54,6 +54,10 @@
 #ifndef LOADTHREAD_H
 #define LOADTHREAD_H
 
+#include <QAtomicInt>
+
+#include <cstdint>
+
 #include "threads/tthread.h"
 
 class LoadBuffer;
@@ -61,13 +65,20 @@ class LoadBuffer;
 class LoadThread : public TThread
 {
 public:
-	LoadThread(LoadBuffer **buffers, unsigned int nBuf, int myfd);
+	LoadThread(LoadBuffer **buffers, unsigned int nBuf, int myfd,
+		   int64_t size);
+	void requestStop();
+	int getProgress() const;
 protected:
 	void run();
 private:
 	LoadBuffer **loadBuffers;
 	unsigned int nBuffers;
 	int fd;
+	int64_t fileSize;
+	/* Permille of the file that has been loaded */
+	QAtomicInt progress;
+	QAtomicInt stopRequested;
 };
 
 #endif /* LOADTHREAD */
@@ -0,0 +1,151 @@
+// SPDX-License-Identifier: (GPL-2.0-or-later OR BSD-2-Clause)
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2020  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PARALLELSORT_H
+#define PARALLELSORT_H
+
+#include <algorithm>
+
+#include <QThread>
+
+#include "threads/workitem.h"
+#include "threads/workqueue.h"
+
+/*
+ * Below this number of elements, the cost of starting the threads is larger
+ * than what we would gain, so we just sort on the calling thread.
+ */
+#define PARALLELSORT_THRESHOLD (32768)
+
+template<typename T, typename Less>
+class ParallelSortPart_ {
+public:
+	T *begin;
+	T *middle;
+	T *end;
+	Less *less;
+	bool sort();
+	bool merge();
+};
+
+template<typename T, typename Less>
+bool ParallelSortPart_<T, Less>::sort()
+{
+	std::sort(begin, end, *less);
+	return false;
+}
+
+template<typename T, typename Less>
+bool ParallelSortPart_<T, Less>::merge()
+{
+	std::inplace_merge(begin, middle, end, *less);
+	return false;
+}
+
+/*
+ * Sorts the range [begin, end) with the strict weak ordering less. Large
+ * ranges are split into one part per core, which are sorted in parallel and
+ * then merged pairwise, also in parallel, until a single part remains.
+ */
+template<typename T, typename Less>
+void parallel_sort(T *begin, T *end, Less less)
+{
+	typedef ParallelSortPart_<T, Less> Part;
+	long n = end - begin;
+	long parts, partSize, width, i;
+	int cpus;
+
+	cpus = QThread::idealThreadCount();
+	parts = cpus > 1 ? cpus : 1;
+	parts = TSMIN(parts, n / (PARALLELSORT_THRESHOLD / 2));
+	if (n < PARALLELSORT_THRESHOLD || parts < 2) {
+		std::sort(begin, end, less);
+		return;
+	}
+
+	WorkQueue queue;
+	Part *part = new Part[parts];
+	WorkItem<Part> *item = new WorkItem<Part>[parts];
+
+	partSize = n / parts;
+	for (i = 0; i < parts; i++) {
+		part[i].begin = begin + i * partSize;
+		part[i].middle = part[i].begin;
+		part[i].end = i == parts - 1 ? end : part[i].begin + partSize;
+		part[i].less = &less;
+		item[i].setObjFn(&part[i], &Part::sort);
+		queue.addWorkItem(&item[i]);
+	}
+	queue.start();
+	queue.wait();
+
+	/*
+	 * Before each round, the sorted runs are width parts wide and their
+	 * extent is kept in the part that begins the run. Each merge combines
+	 * two adjacent runs, so the merges of a round never overlap.
+	 */
+	for (width = 1; width < parts; width *= 2) {
+		for (i = 0; i + width < parts; i += 2 * width) {
+			part[i].middle = part[i + width].begin;
+			part[i].end = part[i + width].end;
+			item[i].setObjFn(&part[i], &Part::merge);
+			queue.addWorkItem(&item[i]);
+		}
+		queue.start();
+		queue.wait();
+	}
+
+	delete[] item;
+	delete[] part;
+}
+
+#endif /* PARALLELSORT_H */
@@ -309,6 +309,7 @@ HEADERS       = qcustomplot/qcustomplot.h
 HEADERS      += qcustomplot/qcppointer.h
 HEADERS      += qcustomplot/qcppointer_impl.h
 HEADERS      += qcustomplot/qcplist.h
+HEADERS      += qcustomplot/qcpgraphdatacontainer.h
 }
 
 HEADERS      +=  ui/abstracttaskmodel.h
@@ -318,16 +319,24 @@ HEADERS      +=  ui/cursor.h
 HEADERS      +=  ui/cursorinfo.h
 HEADERS      +=  ui/errordialog.h
 HEADERS      +=  ui/eventinfodialog.h
+HEADERS      +=  ui/eventratestrip.h
 HEADERS      +=  ui/eventselectdialog.h
 HEADERS      +=  ui/eventselectmodel.h
 HEADERS      +=  ui/eventsmodel.h
+HEADERS      +=  ui/eventsrowcache.h
 HEADERS      +=  ui/eventswidget.h
+HEADERS      +=  ui/graphdata.h
 HEADERS      +=  ui/graphenabledialog.h
+HEADERS      +=  ui/heatmapplot.h
 HEADERS      +=  ui/infowidget.h
+HEADERS      +=  ui/latencydialog.h
+HEADERS      +=  ui/latencymodel.h
 HEADERS      +=  ui/licensedialog.h
 HEADERS      +=  ui/mainwindow.h
-HEADERS      +=  ui/migrationarrow.h
 HEADERS      +=  ui/migrationline.h
+HEADERS      +=  ui/migrationplot.h
+HEADERS      +=  ui/plotoverlay.h
+HEADERS      +=  ui/plottilecache.h
 HEADERS      +=  ui/qcustomplot.h
 HEADERS      +=  ui/statslimitedmodel.h
 HEADERS      +=  ui/statsmodel.h
@@ -336,6 +345,7 @@ HEADERS      +=  ui/taskgraph.h
 HEADERS      +=  ui/taskmodel.h
 HEADERS      +=  ui/taskrangeallocator.h
 HEADERS      +=  ui/taskselectdialog.h
+HEADERS      +=  ui/tasksortview.h
 HEADERS      +=  ui/tasktoolbar.h
 HEADERS      +=  ui/traceplot.h
 HEADERS      +=  ui/tracesharkstyle.h
@@ -343,15 +353,24 @@ HEADERS      +=  ui/valuebox.h
 HEADERS      +=  ui/yaxisticker.h
 
 HEADERS      +=  analyzer/abstracttask.h
+HEADERS      +=  analyzer/argfilter.h
 HEADERS      +=  analyzer/cpufreq.h
 HEADERS      +=  analyzer/cpu.h
 HEADERS      +=  analyzer/cpuidle.h
 HEADERS      +=  analyzer/cputask.h
+HEADERS      +=  analyzer/detachedtrace.h
+HEADERS      +=  analyzer/eventrateindex.h
+HEADERS      +=  analyzer/eventsearch.h
 HEADERS      +=  analyzer/filterstate.h
+HEADERS      +=  analyzer/latencyhistogram.h
 HEADERS      +=  analyzer/migration.h
+HEADERS      +=  analyzer/schedlod.h
 HEADERS      +=  analyzer/task.h
 HEADERS      +=  analyzer/tcolor.h
+HEADERS      +=  analyzer/timequery.h
 HEADERS      +=  analyzer/traceanalyzer.h
+HEADERS      +=  analyzer/utilizationmap.h
+HEADERS      +=  analyzer/wakechain.h
 
 HEADERS      +=  parser/fileinfo.h
 HEADERS      +=  parser/genericparams.h
@@ -372,6 +391,7 @@ HEADERS      +=  parser/perf/perfgrammar.h
 HEADERS      +=  threads/indexwatcher.h
 HEADERS      +=  threads/loadbuffer.h
 HEADERS      +=  threads/loadthread.h
+HEADERS      +=  threads/parallelsort.h
 HEADERS      +=  threads/threadbuffer.h
 HEADERS      +=  threads/tthread.h
 HEADERS      +=  threads/workitem.h
@@ -382,6 +402,8 @@ HEADERS      +=  mm/mempool.h
 HEADERS      +=  mm/stringpool.h
 HEADERS      +=  mm/stringtree.h
 
+HEADERS      +=  misc/batchanalysis.h
+HEADERS      +=  misc/benchmark.h
 HEADERS      +=  misc/chunk.h
 HEADERS      +=  misc/errors.h
 HEADERS      +=  misc/maplist.h
@@ -392,17 +414,20 @@ HEADERS      +=  misc/setting.h
 HEADERS      +=  misc/settingstore.h
 HEADERS      +=  misc/string.h
 HEADERS      +=  misc/svgresources.h
+HEADERS      +=  misc/tracegenerator.h
 HEADERS      +=  misc/traceshark.h
 HEADERS      +=  misc/translate.h
 HEADERS      +=  misc/tstring.h
 HEADERS      +=  misc/types.h
 
 HEADERS      +=  vtl/avltree.h
+HEADERS      +=  vtl/bitmap.h
 HEADERS      +=  vtl/bitvector.h
 HEADERS      +=  vtl/bsdexits.h
 HEADERS      +=  vtl/compiler.h
 HEADERS      +=  vtl/error.h
 HEADERS      +=  vtl/heapsort.h
+HEADERS      +=  vtl/mapcache.h
 HEADERS      +=  vtl/tlist.h
 HEADERS      +=  vtl/time.h
 
@@ -421,16 +446,24 @@ SOURCES      +=  ui/cursor.cpp
 SOURCES      +=  ui/cursorinfo.cpp
 SOURCES      +=  ui/errordialog.cpp
 SOURCES      +=  ui/eventinfodialog.cpp
+SOURCES      +=  ui/eventratestrip.cpp
 SOURCES      +=  ui/eventselectdialog.cpp
 SOURCES      +=  ui/eventselectmodel.cpp
 SOURCES      +=  ui/eventsmodel.cpp
+SOURCES      +=  ui/eventsrowcache.cpp
 SOURCES      +=  ui/eventswidget.cpp
+SOURCES      +=  ui/graphdata.cpp
 SOURCES      +=  ui/graphenabledialog.cpp
+SOURCES      +=  ui/heatmapplot.cpp
 SOURCES      +=  ui/infowidget.cpp
+SOURCES      +=  ui/latencydialog.cpp
+SOURCES      +=  ui/latencymodel.cpp
 SOURCES      +=  ui/licensedialog.cpp
 SOURCES      +=  ui/mainwindow.cpp
-SOURCES      +=  ui/migrationarrow.cpp
 SOURCES      +=  ui/migrationline.cpp
+SOURCES      +=  ui/migrationplot.cpp
+SOURCES      +=  ui/plotoverlay.cpp
+SOURCES      +=  ui/plottilecache.cpp
 SOURCES      +=  ui/statslimitedmodel.cpp
 SOURCES      +=  ui/statsmodel.cpp
 SOURCES      +=  ui/tableview.cpp
@@ -438,6 +471,7 @@ SOURCES      +=  ui/taskgraph.cpp
 SOURCES      +=  ui/taskmodel.cpp
 SOURCES      +=  ui/taskrangeallocator.cpp
 SOURCES      +=  ui/taskselectdialog.cpp
+SOURCES      +=  ui/tasksortview.cpp
 SOURCES      +=  ui/tasktoolbar.cpp
 SOURCES      +=  ui/traceplot.cpp
 SOURCES      +=  ui/tracesharkstyle.cpp
@@ -446,13 +480,20 @@ SOURCES      +=  ui/yaxisticker.cpp
 
 
 SOURCES      +=  analyzer/abstracttask.cpp
-SOURCES      +=  analyzer/cpufreq.cpp
-SOURCES      +=  analyzer/cpuidle.cpp
+SOURCES      +=  analyzer/argfilter.cpp
 SOURCES      +=  analyzer/cputask.cpp
+SOURCES      +=  analyzer/detachedtrace.cpp
+SOURCES      +=  analyzer/eventrateindex.cpp
+SOURCES      +=  analyzer/eventsearch.cpp
 SOURCES      +=  analyzer/filterstate.cpp
+SOURCES      +=  analyzer/latencyhistogram.cpp
+SOURCES      +=  analyzer/schedlod.cpp
 SOURCES      +=  analyzer/task.cpp
 SOURCES      +=  analyzer/tcolor.cpp
+SOURCES      +=  analyzer/timequery.cpp
 SOURCES      +=  analyzer/traceanalyzer.cpp
+SOURCES      +=  analyzer/utilizationmap.cpp
+SOURCES      +=  analyzer/wakechain.cpp
 
 SOURCES      +=  parser/fileinfo.cpp
 SOURCES      +=  parser/traceevent.cpp
@@ -473,15 +514,20 @@ SOURCES      +=  threads/workqueue.cpp
 
 SOURCES      +=  mm/mempool.cpp
 
+SOURCES      +=  misc/batchanalysis.cpp
+SOURCES      +=  misc/benchmark.cpp
 SOURCES      +=  misc/errors.cpp
 SOURCES      +=  misc/main.cpp
 SOURCES      +=  misc/setting.cpp
 SOURCES      +=  misc/settingstore.cpp
 
+SOURCES      +=  misc/tracegenerator.cpp
 SOURCES      +=  misc/translate.cpp
 
+SOURCES      +=  vtl/bitmap.cpp
 SOURCES      +=  vtl/bitvector.cpp
 SOURCES      +=  vtl/error.cpp
+SOURCES      +=  vtl/mapcache.cpp
 
 ###############################################################################
 # Directories
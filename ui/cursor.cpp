@@ -102,11 +102,15 @@ void Cursor::setPosition(const vtl::Time &t)
 	setPosition_(time.toDouble());
 }
 
+/*
+ * The cursors are on a buffered layer, so only that layer needs to be redrawn.
+ * If the layer isn't buffered, then this will replot the whole plot.
+ */
 void Cursor::setPosition_(double pos)
 {
 	start->setCoords(pos, -10000000000000000);
 	end->setCoords(pos, +10000000000000000);
-	parentPlot()->replot();
+	layer()->replot();
 	position = pos;
 }
 
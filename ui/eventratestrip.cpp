@@ -0,0 +1,139 @@
+// SPDX-License-Identifier: (GPL-2.0-or-later OR BSD-2-Clause)
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2020  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <QMouseEvent>
+#include <QPainter>
+#include <QPaintEvent>
+
+#include "analyzer/eventrateindex.h"
+#include "ui/eventratestrip.h"
+#include "misc/traceshark.h"
+
+EventRateStrip::EventRateStrip(QCustomPlot *plot, QWidget *parent):
+	QWidget(parent), customPlot(plot), index(nullptr)
+{
+	setFixedHeight(STRIP_HEIGHT);
+	setToolTip(tr("Event rate, click to zoom into the nearest burst"));
+	tsconnect(customPlot, afterReplot(), this, plotReplotted());
+}
+
+void EventRateStrip::setIndex(const EventRateIndex *idx)
+{
+	index = idx;
+	update();
+}
+
+void EventRateStrip::plotReplotted()
+{
+	if (isVisible())
+		update();
+}
+
+void EventRateStrip::paintEvent(QPaintEvent * /* event */)
+{
+	QPainter painter(this);
+	QRect rect = customPlot->axisRect()->rect();
+	const QCPRange &range = customPlot->xAxis->range();
+	int left = rect.left();
+	int w = rect.width();
+	int h = height() - 1;
+	double maxRate = 0;
+	int bar;
+	int i;
+
+	painter.fillRect(0, 0, width(), height(), palette().base());
+	if (index == nullptr || !index->isFinished() || w <= 0)
+		return;
+
+	index->getRates(range.lower, range.upper, w, EventRateIndex::ALL,
+			EventRateIndex::ALL, rates);
+	for (i = 0; i < rates.size(); i++)
+		maxRate = TSMAX(maxRate, rates[i]);
+	if (maxRate <= 0)
+		return;
+
+	painter.setPen(palette().color(QPalette::Highlight));
+	for (i = 0; i < rates.size(); i++) {
+		bar = (int) (rates[i] / maxRate * h + 0.5);
+		if (bar > 0)
+			painter.drawLine(left + i, h, left + i, h - bar + 1);
+	}
+	painter.setPen(palette().color(QPalette::Mid));
+	painter.drawLine(0, h, width(), h);
+}
+
+void EventRateStrip::mousePressEvent(QMouseEvent *event)
+{
+	QRect rect = customPlot->axisRect()->rect();
+	const QCPRange &range = customPlot->xAxis->range();
+	int x = event->x() - rect.left();
+	double colWidth;
+	double span;
+	double start;
+	double time;
+
+	if (event->button() != Qt::LeftButton || index == nullptr ||
+	    !index->isFinished() || x < 0 || x >= rect.width()) {
+		QWidget::mousePressEvent(event);
+		return;
+	}
+
+	/* Search the clicked column and its neighbors for the peak */
+	colWidth = range.size() / rect.width();
+	start = range.lower + (x - 1) * colWidth;
+	if (!index->findPeak(start, start + 3 * colWidth, EventRateIndex::ALL,
+			     EventRateIndex::ALL, time))
+		return;
+
+	span = TSMAX(ZOOM_COLUMNS * colWidth, 4 * index->getBucketWidth(0));
+	emit rangeSelected(QCPRange(time - span, time + span));
+}
@@ -62,7 +62,7 @@
 #include "mm/stringtree.h"
 
 EventSelectModel::EventSelectModel(QObject *parent):
-	QAbstractTableModel(parent), stringTree(nullptr)
+	QAbstractTableModel(parent), stringTree(nullptr), sortedMaxEvent(-1)
 {
 	eventList = new vtl::TList<event_t>;
 	errorStr = new QString(tr("Error in eventselectmodel.cpp"));
@@ -78,14 +78,25 @@ void EventSelectModel::setStringTree(const StringTree<> *stree)
 {
 	event_t event;
 	int i, maxevent;
-	eventList->clear();
-
-	stringTree = stree;
 
-	if (stree == nullptr)
+	if (stree == nullptr) {
+		eventList->clear();
+		stringTree = nullptr;
+		sortedMaxEvent = -1;
 		return;
+	}
 
+	/*
+	 * Event types are only ever added to the tree, so if it is the same
+	 * tree and no types have been added, then the list is already sorted.
+	 */
 	maxevent = (int) stree->getMaxEvent();
+	if (stree == stringTree && maxevent == sortedMaxEvent)
+		return;
+
+	eventList->clear();
+	stringTree = stree;
+	sortedMaxEvent = maxevent;
 	for (i = 0; i <= maxevent; i++) {
 		event = (event_t) i;
 		eventList->append(event);
@@ -91,6 +91,7 @@ public:
 private:
 	vtl::TList<event_t> *eventList;
 	const StringTree<> *stringTree;
+	int sortedMaxEvent;
 	QString *errorStr;
 };
 
@@ -53,6 +53,7 @@
 #include <QVariant>
 #include <QString>
 #include "ui/eventsmodel.h"
+#include "ui/eventsrowcache.h"
 #include "parser/traceevent.h"
 #include "misc/traceshark.h"
 #include "vtl/tlist.h"
@@ -60,26 +61,39 @@
 
 EventsModel::EventsModel(QObject *parent):
 	QAbstractTableModel(parent), events(nullptr), eventsPtrs(nullptr)
-{}
+{
+	rowCache = new EventsRowCache();
+}
 
 EventsModel::EventsModel(vtl::TList<TraceEvent> *e, QObject *parent):
 	QAbstractTableModel(parent), events(e), eventsPtrs(nullptr)
-{}
+{
+	rowCache = new EventsRowCache();
+	rowCache->setEvents(e);
+}
+
+EventsModel::~EventsModel()
+{
+	delete rowCache;
+}
 
 void EventsModel::setEvents(vtl::TList<TraceEvent> *e)
 {
+	rowCache->setEvents(e);
 	events = e;
 	eventsPtrs = nullptr;
 }
 
 void EventsModel::setEvents(vtl::TList<const TraceEvent*> *e)
 {
+	rowCache->setEvents(e);
 	events = nullptr;
 	eventsPtrs = e;
 }
 
 void EventsModel::clear()
 {
+	rowCache->clear();
 	events = nullptr;
 	eventsPtrs = nullptr;
 }
@@ -96,9 +110,6 @@ int EventsModel::columnCount(const QModelIndex & /* parent */) const
 
 QVariant EventsModel::data(const QModelIndex &index, int role) const
 {
-	QString str;
-	int i;
-
 	if (!index.isValid())
 		return QVariant();
 	
@@ -115,39 +126,9 @@ QVariant EventsModel::data(const QModelIndex &index, int role) const
 		if ( row >= size || row < 0)
 			return QVariant();
 
-		const TraceEvent &event = *getEventAt(row);
-		switch(column) {
-		case COLUMN_TIME:
-			return event.time.toQString();
-		case COLUMN_TASKNAME:
-			return QString(event.taskName->ptr);
-		case COLUMN_PID:
-			return QString::number(event.pid);
-		case COLUMN_CPU:
-			return QString("[") + QString::number(event.cpu) +
-				QString("]");
-		case COLUMN_TYPE:
-			return QString(event.getEventName()->ptr);
-		case COLUMN_INFO:
-			/*
-			 * If there was an integer before the event name, then
-			 * we will display that as if it had been the first 
-			 * argument of the event
-			 */
-			if (event.intArg != 0) {
-				str += QString::number(event.intArg);
-				if (event.argc > 0)
-					str += QString(tr(" "));
-			}
-			for (i = 0; i < event.argc; i++) {
-				str += QString(event.argv[i]->ptr);
-				if (i < event.argc - 1)
-					str += QString(tr(" "));
-			}
-			return str;
-		default:
-			break;
-		}
+		if (column < 0 || column >= NR_COLUMNS)
+			return QVariant();
+		return rowCache->getString(row, column);
 	}
 	return QVariant();
 }
@@ -192,6 +173,8 @@ Qt::ItemFlags EventsModel::flags(const QModelIndex &index) const
 
 void EventsModel::beginResetModel()
 {
+	/* The events may be modified or freed while the model is reset */
+	rowCache->clear();
 	QAbstractTableModel::beginResetModel();
 }
 
@@ -200,15 +183,6 @@ void EventsModel::endResetModel()
 	QAbstractTableModel::endResetModel();
 }
 
-const TraceEvent* EventsModel::getEventAt(int index) const
-{
-	if (events != nullptr)
-		return &events->at(index);
-	if (eventsPtrs != nullptr)
-		return eventsPtrs->at(index);
-	return nullptr;
-}
-
 int EventsModel::getSize() const
 {
 	if (events != nullptr)
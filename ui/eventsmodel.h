@@ -56,6 +56,7 @@
 #include <QAbstractTableModel>
 #include "vtl/compiler.h"
 
+class EventsRowCache;
 class TraceEvent;
 namespace vtl {
 	template<class T> class TList;
@@ -76,6 +77,7 @@ public:
 	} column_t;
 	EventsModel(QObject *parent = 0);
 	EventsModel(vtl::TList<TraceEvent> *e, QObject *parent = 0);
+	~EventsModel();
 	void setEvents(vtl::TList<TraceEvent> *e);
 	void setEvents(vtl::TList<const TraceEvent*> *e);
 	void clear();
@@ -94,7 +96,7 @@ public:
 private:
 	vtl::TList<TraceEvent> *events;
 	vtl::TList<const TraceEvent*> *eventsPtrs;
-	const TraceEvent* getEventAt(int index) const;
+	EventsRowCache *rowCache;
 	int getSize() const;
 };
 
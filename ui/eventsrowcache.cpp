@@ -0,0 +1,386 @@
+// SPDX-License-Identifier: (GPL-2.0-or-later OR BSD-2-Clause)
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2020  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <QByteArray>
+
+#include "parser/traceevent.h"
+#include "ui/eventsrowcache.h"
+#include "misc/traceshark.h"
+#include "vtl/tlist.h"
+
+/* The default maximum size of the cache in bytes */
+#define ROWCACHE_DEFAULT_MAXSIZE (64 * 1024 * 1024)
+
+/* How many rows ahead of the viewport that are formatted in advance */
+#define PREFETCH_ROWS (2048)
+
+/*
+ * A new prefetch is requested when the viewport has come closer than this to
+ * the end of the rows that have been prefetched.
+ */
+#define PREFETCH_MARGIN (PREFETCH_ROWS / 2)
+
+/* A rough estimate of the overhead of a QString and of a QHash node */
+#define QSTRING_OVERHEAD (32)
+#define QHASH_OVERHEAD (32)
+
+EventsRowCache::EventsRowCache():
+	first(nullptr), last(nullptr), size(0),
+	maxSize(ROWCACHE_DEFAULT_MAXSIZE), events(nullptr), eventsPtrs(nullptr),
+	lastRow(0), passRow(0), direction(1), prefetchEnd(-1), prefetchRow(-1),
+	prefetchDir(1), prefetchBusy(false), prefetchAbort(false),
+	prefetchStop(false)
+{
+	prefetchThread = new WorkThread<EventsRowCache>
+		(QString("prefetchThread"), this,
+		 &EventsRowCache::threadPrefetch);
+	prefetchThread->start();
+}
+
+EventsRowCache::~EventsRowCache()
+{
+	mutex.lock();
+	prefetchStop = true;
+	prefetchAbort = true;
+	requestCond.wakeAll();
+	mutex.unlock();
+	prefetchThread->wait();
+	delete prefetchThread;
+	freeEntries();
+}
+
+/*
+ * The events must not be modified or freed while the prefetch thread is
+ * reading them, so this must be called before that happens. The model does it
+ * in beginResetModel(), setEvents() and clear().
+ */
+void EventsRowCache::cancelPrefetch()
+{
+	prefetchAbort = true;
+	prefetchRow = -1;
+	while (prefetchBusy)
+		idleCond.wait(&mutex);
+	prefetchAbort = false;
+	prefetchEnd = -1;
+}
+
+void EventsRowCache::freeEntries()
+{
+	Entry *entry = first;
+	Entry *next;
+
+	while (entry != nullptr) {
+		next = entry->next;
+		delete entry;
+		entry = next;
+	}
+	first = nullptr;
+	last = nullptr;
+	hash.clear();
+	size = 0;
+}
+
+void EventsRowCache::setEvents(vtl::TList<TraceEvent> *e)
+{
+	mutex.lock();
+	cancelPrefetch();
+	freeEntries();
+	events = e;
+	eventsPtrs = nullptr;
+	mutex.unlock();
+}
+
+void EventsRowCache::setEvents(vtl::TList<const TraceEvent*> *e)
+{
+	mutex.lock();
+	cancelPrefetch();
+	freeEntries();
+	events = nullptr;
+	eventsPtrs = e;
+	mutex.unlock();
+}
+
+void EventsRowCache::clear()
+{
+	mutex.lock();
+	cancelPrefetch();
+	freeEntries();
+	events = nullptr;
+	eventsPtrs = nullptr;
+	mutex.unlock();
+}
+
+/*
+ * Returns the string of a cell, formats the row if it isn't in the cache and
+ * requests a prefetch if the viewport is approaching the end of the rows that
+ * have been prefetched.
+ */
+QString EventsRowCache::getString(int row, EventsModel::column_t column)
+{
+	QString columns[EventsModel::NR_COLUMNS];
+	const TraceEvent *event;
+	Entry *entry;
+	QString str;
+	int dist;
+
+	mutex.lock();
+	/*
+	 * The view asks for the rows of the viewport in ascending order, so a
+	 * backward jump means that a new pass over the viewport begins. The
+	 * direction of scrolling is given by where it begins compared to where
+	 * the previous pass began.
+	 */
+	if (row < lastRow) {
+		if (row != passRow)
+			direction = row > passRow ? 1 : -1;
+		passRow = row;
+	}
+	lastRow = row;
+
+	dist = (prefetchEnd - row) * direction;
+	if (prefetchEnd < 0 || dist < PREFETCH_MARGIN ||
+	    dist > PREFETCH_ROWS)
+		requestPrefetch(row);
+
+	entry = hash.value(row, nullptr);
+	if (entry != nullptr) {
+		unlink(entry);
+		linkFirst(entry);
+		str = entry->columns[column];
+		mutex.unlock();
+		return str;
+	}
+
+	if (row < 0 || row >= getSize()) {
+		mutex.unlock();
+		return QString();
+	}
+	/*
+	 * The events cannot go away while we format, since that can only be
+	 * done from this thread by calling setEvents() or clear().
+	 */
+	event = getEventAt(row);
+	mutex.unlock();
+
+	formatRow(*event, columns);
+
+	mutex.lock();
+	insert(row, columns);
+	mutex.unlock();
+	return columns[column];
+}
+
+/* This must be called with the mutex held */
+void EventsRowCache::requestPrefetch(int row)
+{
+	prefetchRow = row;
+	prefetchDir = direction;
+	prefetchEnd = row + direction * PREFETCH_ROWS;
+	requestCond.wakeOne();
+}
+
+/* This must be called with the mutex held */
+void EventsRowCache::insert(int row, QString *columns)
+{
+	Entry *entry;
+	int i;
+
+	if (hash.contains(row))
+		return;
+	entry = new Entry;
+	entry->row = row;
+	for (i = 0; i < EventsModel::NR_COLUMNS; i++)
+		entry->columns[i] = columns[i];
+	entry->bytes = entryBytes(entry);
+	hash.insert(row, entry);
+	linkFirst(entry);
+	size += entry->bytes;
+	evict();
+}
+
+void EventsRowCache::evict()
+{
+	Entry *entry;
+
+	while (size > maxSize && last != nullptr) {
+		entry = last;
+		unlink(entry);
+		hash.remove(entry->row);
+		size -= entry->bytes;
+		delete entry;
+	}
+}
+
+size_t EventsRowCache::entryBytes(const Entry *entry)
+{
+	size_t bytes = sizeof(Entry) + QHASH_OVERHEAD;
+	int i;
+
+	for (i = 0; i < EventsModel::NR_COLUMNS; i++)
+		bytes += entry->columns[i].size() * sizeof(QChar) +
+			QSTRING_OVERHEAD;
+	return bytes;
+}
+
+/*
+ * Formats all columns of an event. The TStrings know their lengths, so we can
+ * convert them without scanning for the terminating null character, and the
+ * info column is assembled as UTF-8 and converted only once.
+ */
+void EventsRowCache::formatRow(const TraceEvent &event, QString *columns)
+{
+	const TString *name = event.getEventName();
+	QByteArray info;
+	char buf[40];
+	int len;
+	int i;
+
+	if (event.time.sprint(buf))
+		columns[EventsModel::COLUMN_TIME] = QString::fromLatin1(buf);
+	else
+		columns[EventsModel::COLUMN_TIME] = QString();
+	columns[EventsModel::COLUMN_TASKNAME] =
+		QString::fromUtf8(event.taskName->ptr, event.taskName->len);
+	columns[EventsModel::COLUMN_PID] = QString::number(event.pid);
+	len = snprintf(buf, sizeof(buf), "[%u]", event.cpu);
+	columns[EventsModel::COLUMN_CPU] = QString::fromLatin1(buf, len);
+	columns[EventsModel::COLUMN_TYPE] = QString::fromUtf8(name->ptr,
+							      name->len);
+
+	/*
+	 * If there was an integer before the event name, then we will display
+	 * that as if it had been the first argument of the event
+	 */
+	len = event.argc;
+	for (i = 0; i < event.argc; i++)
+		len += event.argv[i]->len;
+	if (event.intArg != 0)
+		len += snprintf(buf, sizeof(buf), "%d", event.intArg);
+	info.reserve(len);
+	if (event.intArg != 0) {
+		info.append(buf);
+		if (event.argc > 0)
+			info.append(' ');
+	}
+	for (i = 0; i < event.argc; i++) {
+		info.append(event.argv[i]->ptr, event.argv[i]->len);
+		if (i < event.argc - 1)
+			info.append(' ');
+	}
+	columns[EventsModel::COLUMN_INFO] = QString::fromUtf8(info.constData(),
+							      info.size());
+}
+
+/*
+ * The prefetch thread waits for requests and formats the rows that follow the
+ * requested row in the direction of scrolling. A new request supersedes the
+ * one that is being processed.
+ */
+void EventsRowCache::threadPrefetch()
+{
+	QString columns[EventsModel::NR_COLUMNS];
+	const TraceEvent *event;
+	int row;
+	int dir;
+	int i;
+
+	mutex.lock();
+	while (true) {
+		while (!prefetchStop && prefetchRow < 0)
+			requestCond.wait(&mutex);
+		if (prefetchStop)
+			break;
+
+		row = prefetchRow;
+		dir = prefetchDir;
+		prefetchRow = -1;
+		prefetchBusy = true;
+
+		for (i = 0; i < PREFETCH_ROWS; i++, row += dir) {
+			if (prefetchAbort || prefetchRow >= 0)
+				break;
+			if (row < 0 || row >= getSize())
+				break;
+			if (hash.contains(row))
+				continue;
+			event = getEventAt(row);
+			mutex.unlock();
+			formatRow(*event, columns);
+			mutex.lock();
+			if (prefetchAbort)
+				break;
+			insert(row, columns);
+		}
+
+		prefetchBusy = false;
+		idleCond.wakeAll();
+	}
+	mutex.unlock();
+}
+
+const TraceEvent *EventsRowCache::getEventAt(int index) const
+{
+	if (events != nullptr)
+		return &events->at(index);
+	if (eventsPtrs != nullptr)
+		return eventsPtrs->at(index);
+	return nullptr;
+}
+
+int EventsRowCache::getSize() const
+{
+	if (events != nullptr)
+		return events->size();
+	if (eventsPtrs != nullptr)
+		return eventsPtrs->size();
+	return 0;
+}
@@ -0,0 +1,155 @@
+// SPDX-License-Identifier: (GPL-2.0-or-later OR BSD-2-Clause)
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2020  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef EVENTSROWCACHE_H
+#define EVENTSROWCACHE_H
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QWaitCondition>
+
+#include "ui/eventsmodel.h"
+#include "threads/workthread.h"
+#include "vtl/compiler.h"
+
+class TraceEvent;
+namespace vtl {
+	template<class T> class TList;
+}
+
+/*
+ * This caches the formatted strings of the rows of the EventsModel, so that
+ * rows that are repainted don't need to be formatted again. The least recently
+ * used rows are evicted when the cache grows beyond maxSize bytes. A thread
+ * formats the rows ahead of the viewport in the direction of scrolling, so
+ * that they are usually in the cache by the time they are shown.
+ */
+class EventsRowCache
+{
+public:
+	EventsRowCache();
+	~EventsRowCache();
+	void setEvents(vtl::TList<TraceEvent> *e);
+	void setEvents(vtl::TList<const TraceEvent*> *e);
+	void clear();
+	QString getString(int row, EventsModel::column_t column);
+	static void formatRow(const TraceEvent &event, QString *columns);
+	void threadPrefetch();
+private:
+	class Entry {
+	public:
+		int row;
+		size_t bytes;
+		Entry *prev;
+		Entry *next;
+		QString columns[EventsModel::NR_COLUMNS];
+	};
+	void cancelPrefetch();
+	void freeEntries();
+	void insert(int row, QString *columns);
+	void evict();
+	void requestPrefetch(int row);
+	vtl_always_inline void unlink(Entry *entry);
+	vtl_always_inline void linkFirst(Entry *entry);
+	const TraceEvent *getEventAt(int index) const;
+	int getSize() const;
+	static size_t entryBytes(const Entry *entry);
+	QMutex mutex;
+	QWaitCondition requestCond;
+	QWaitCondition idleCond;
+	QHash<int, Entry*> hash;
+	/* The most recently used entry is first in the list */
+	Entry *first;
+	Entry *last;
+	size_t size;
+	size_t maxSize;
+	vtl::TList<TraceEvent> *events;
+	vtl::TList<const TraceEvent*> *eventsPtrs;
+	WorkThread<EventsRowCache> *prefetchThread;
+	/* These are used to detect the direction of scrolling */
+	int lastRow;
+	int passRow;
+	int direction;
+	/* The row after the last one that has been requested for prefetch */
+	int prefetchEnd;
+	int prefetchRow;
+	int prefetchDir;
+	bool prefetchBusy;
+	bool prefetchAbort;
+	bool prefetchStop;
+};
+
+vtl_always_inline void EventsRowCache::unlink(Entry *entry)
+{
+	if (entry->prev != nullptr)
+		entry->prev->next = entry->next;
+	else
+		first = entry->next;
+	if (entry->next != nullptr)
+		entry->next->prev = entry->prev;
+	else
+		last = entry->prev;
+}
+
+vtl_always_inline void EventsRowCache::linkFirst(Entry *entry)
+{
+	entry->prev = nullptr;
+	entry->next = first;
+	if (first != nullptr)
+		first->prev = entry;
+	else
+		last = entry;
+	first = entry;
+}
+
+#endif /* EVENTSROWCACHE_H */
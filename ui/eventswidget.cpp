@@ -51,7 +51,10 @@
  */
 
 #include <QTableView>
+#include <QTimer>
+#include <algorithm>
 #include <cmath>
+#include "analyzer/eventsearch.h"
 #include "vtl/tlist.h"
 #include "ui/eventsmodel.h"
 #include "ui/eventswidget.h"
@@ -76,6 +79,7 @@ EventsWidget::EventsWidget(QWidget *parent):
 					      const QItemSelection &),
 		  this, handleSelectionChanged(const QItemSelection &,
 					       const QItemSelection &));
+	createSearch();
 }
 
 EventsWidget::EventsWidget(vtl::TList<TraceEvent> *e, QWidget *parent):
@@ -96,14 +100,29 @@ EventsWidget::EventsWidget(vtl::TList<TraceEvent> *e, QWidget *parent):
 					      const QItemSelection &),
 		  this, handleSelectionChanged(const QItemSelection &,
 					       const QItemSelection &));
+	createSearch();
 }
 
 EventsWidget::~EventsWidget()
 {
+	delete eventSearch;
+}
+
+void EventsWidget::createSearch()
+{
+	eventSearch = new EventSearch();
+	searchTimer = new QTimer(this);
+	searchTimer->setInterval(100);
+	searchStartRow = 0;
+	searchJumpPending = false;
+	searchDone = true;
+	baseTitle = windowTitle();
+	tsconnect(searchTimer, timeout(), this, searchTimeout());
 }
 
 void EventsWidget::setEvents(vtl::TList<TraceEvent> *e)
 {
+	stopSearch();
 	eventsModel->setEvents(e);
 	events = e;
 	eventsPtrs = nullptr;
@@ -111,6 +130,7 @@ void EventsWidget::setEvents(vtl::TList<TraceEvent> *e)
 
 void EventsWidget::setEvents(vtl::TList<const TraceEvent*> *e)
 {
+	stopSearch();
 	eventsModel->setEvents(e);
 	events = nullptr;
 	eventsPtrs = e;
@@ -118,6 +138,7 @@ void EventsWidget::setEvents(vtl::TList<const TraceEvent*> *e)
 
 void EventsWidget::clear()
 {
+	stopSearch();
 	eventsModel->clear();
 	events = nullptr;
 	eventsPtrs = nullptr;
@@ -130,6 +151,8 @@ void EventsWidget::clearScrollTime()
 
 void EventsWidget::beginResetModel()
 {
+	/* The search must not run while the events are being changed */
+	stopSearch();
 	eventsModel->beginResetModel();
 	events = nullptr;
 	eventsPtrs = nullptr;
@@ -331,3 +354,133 @@ vtl::Time EventsWidget::getSavedScroll()
 		return scrollTime;
 	return 0;
 }
+
+/*
+ * Starts a search of the events that are shown. A text that begins and ends
+ * with a slash is a regular expression, anything else is searched for
+ * literally. The first match at or after the selected event is selected as
+ * soon as it has been found.
+ */
+bool EventsWidget::startSearch(const QString &text, QString *errmsg)
+{
+	QString pattern = text;
+	bool regex = false;
+
+	stopSearch();
+	if (text.size() > 2 && text.startsWith(QLatin1Char('/')) &&
+	    text.endsWith(QLatin1Char('/'))) {
+		pattern = text.mid(1, text.size() - 2);
+		regex = true;
+	}
+
+	if (!eventSearch->start(pattern, regex, events, eventsPtrs, errmsg))
+		return false;
+
+	searchStartRow = TSMAX(getSelectedRow(), 0);
+	searchJumpPending = true;
+	searchDone = false;
+	searchTimer->start();
+	updateSearchTitle();
+	return true;
+}
+
+void EventsWidget::stopSearch()
+{
+	eventSearch->stop();
+	searchTimer->stop();
+	searchMatches.clear();
+	searchJumpPending = false;
+	searchDone = true;
+	updateSearchTitle();
+}
+
+void EventsWidget::findNext()
+{
+	jumpToMatch(getSelectedRow() + 1, true);
+}
+
+void EventsWidget::findPrevious()
+{
+	jumpToMatch(getSelectedRow() - 1, false);
+}
+
+/*
+ * Selects the first match at or after row if forward is true, otherwise the
+ * last match at or before row. The search wraps around when it has finished.
+ * While it is still running, a match after row is selected when it is found.
+ */
+void EventsWidget::jumpToMatch(int row, bool forward)
+{
+	QVector<int>::const_iterator iter;
+
+	if (!eventSearch->isActive())
+		return;
+
+	if (forward) {
+		iter = std::lower_bound(searchMatches.constBegin(),
+					searchMatches.constEnd(), row);
+		if (iter != searchMatches.constEnd()) {
+			scrollTo(*iter);
+		} else if (!searchDone) {
+			searchStartRow = row;
+			searchJumpPending = true;
+		} else if (!searchMatches.isEmpty()) {
+			scrollTo(searchMatches.first());
+		}
+	} else {
+		iter = std::upper_bound(searchMatches.constBegin(),
+					searchMatches.constEnd(), row);
+		if (iter != searchMatches.constBegin())
+			scrollTo(*(iter - 1));
+		else if (searchDone && !searchMatches.isEmpty())
+			scrollTo(searchMatches.last());
+	}
+}
+
+void EventsWidget::searchTimeout()
+{
+	QVector<int>::const_iterator iter;
+
+	searchDone = eventSearch->collectMatches(searchMatches);
+
+	if (searchJumpPending) {
+		iter = std::lower_bound(searchMatches.constBegin(),
+					searchMatches.constEnd(),
+					searchStartRow);
+		if (iter != searchMatches.constEnd()) {
+			scrollTo(*iter);
+			searchJumpPending = false;
+		} else if (searchDone) {
+			if (!searchMatches.isEmpty())
+				scrollTo(searchMatches.first());
+			searchJumpPending = false;
+		}
+	}
+
+	if (searchDone)
+		searchTimer->stop();
+	updateSearchTitle();
+}
+
+void EventsWidget::updateSearchTitle()
+{
+	QString title;
+
+	if (!eventSearch->isActive()) {
+		setWindowTitle(baseTitle);
+		return;
+	}
+	title = baseTitle + tr(" - %1 matches").arg(searchMatches.size());
+	if (!searchDone)
+		title += tr(", searching...");
+	setWindowTitle(title);
+}
+
+int EventsWidget::getSelectedRow()
+{
+	const QModelIndexList list = tableView->selectedIndexes();
+
+	if (list.isEmpty())
+		return -1;
+	return list[0].row();
+}
@@ -54,10 +54,14 @@
 #define EVENTSWIDGET_H
 
 #include <QDockWidget>
+#include <QString>
+#include <QVector>
 #include "misc/traceshark.h"
 #include "vtl/time.h"
 #include "ui/eventsmodel.h"
 
+class EventSearch;
+class QTimer;
 class TableView;
 class EventsModel;
 class TraceEvent;
@@ -84,6 +88,10 @@ public:
 	void scrollToSaved();
 	vtl::Time getSavedScroll();
 	const TraceEvent *getSelectedEvent();
+	bool startSearch(const QString &text, QString *errmsg);
+	void stopSearch();
+	void findNext();
+	void findPrevious();
 public slots:
 	void show();
 signals:
@@ -94,6 +102,7 @@ private slots:
 	void handleDoubleClick(const QModelIndex &index);
 	void handleSelectionChanged(const QItemSelection &selected,
 				    const QItemSelection &deselected);
+	void searchTimeout();
 private:
 	TableView *tableView;
 	EventsModel *eventsModel;
@@ -102,6 +111,17 @@ private:
 	bool saveScrollTime;
 	vtl::Time scrollTime;
 	const TraceEvent *selectedEvent;
+	EventSearch *eventSearch;
+	QTimer *searchTimer;
+	QVector<int> searchMatches;
+	QString baseTitle;
+	int searchStartRow;
+	bool searchJumpPending;
+	bool searchDone;
+	void createSearch();
+	void updateSearchTitle();
+	void jumpToMatch(int row, bool forward);
+	int getSelectedRow();
 	int findBestMatch(const vtl::Time &time);
 	int binarySearch(const vtl::Time &time, int start, int end);
 	const TraceEvent* getEventAt(int index) const;
@@ -1,7 +1,7 @@
 // SPDX-License-Identifier: (GPL-2.0-or-later OR BSD-2-Clause)
 /*
  * Traceshark - a visualizer for visualizing ftrace and perf traces
- * Copyright (C) 2015, 2016, 2020  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ * Copyright (C) 2020  Viktor Rosendahl <viktor.rosendahl@gmail.com>
  *
  * This file is dual licensed: you can use it either under the terms of
  * the GPL, or the BSD license, at your option.
@@ -50,18 +50,29 @@
  *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include "ui/migrationarrow.h"
+#ifndef GRAPHDATA_H
+#define GRAPHDATA_H
 
-MigrationArrow::MigrationArrow(double start, double end, double time,
-			       const QColor &color, QCustomPlot *parent,
-			       int width):
-	QCPItemLine(parent)
-{
-	QPen pen;
-	QCPItemLine::start->setCoords(time, start);
-	QCPItemLine::end->setCoords(time, end);
-	pen.setColor(color);
-	pen.setWidth(width);
-	setPen(pen);
-	setHead(QCPLineEnding::esFlatArrow);
+#include <QVector>
+
+class QCPGraph;
+
+namespace vtl {
+	class BitVector;
 }
+
+/*
+ * These functions set the data of a QCPGraph so that a value v is plotted as
+ * v * scale + offset. The bundled QCustomPlot shares the vectors with the
+ * caller and applies the scale and offset when plotting. A system QCustomPlot
+ * gets a scaled copy of the data. The keys must be sorted.
+ */
+void graphSetScaledData(QCPGraph *graph, const QVector<double> &keys,
+			const QVector<double> &values, double scale,
+			double offset);
+void graphSetConstantData(QCPGraph *graph, const QVector<double> &keys,
+			  double value);
+void graphSetBitData(QCPGraph *graph, const QVector<double> &keys,
+		     const vtl::BitVector &bits, double scale, double offset);
+
+#endif /* GRAPHDATA_H */
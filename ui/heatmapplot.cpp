@@ -0,0 +1,227 @@
+// SPDX-License-Identifier: (GPL-2.0-or-later OR BSD-2-Clause)
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2020  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+#include "analyzer/utilizationmap.h"
+#include "ui/heatmapplot.h"
+#include "misc/traceshark.h"
+
+HeatMapPlot::HeatMapPlot(QCPAxis *keyAxis, QCPAxis *valueAxis,
+			 UtilizationMap *map_):
+	QCPAbstractPlottable(keyAxis, valueAxis), map(map_), offset(0),
+	rowHeight(1), nrRows(0)
+{
+	setSelectable(QCP::stNone);
+	/* Unused parts are white and fully used parts are black */
+	gradient = QCPColorGradient(QCPColorGradient::gpHot).inverted();
+}
+
+void HeatMapPlot::setGeometry(double offset_, double rowHeight_)
+{
+	offset = offset_;
+	rowHeight = rowHeight_;
+}
+
+void HeatMapPlot::computeOverview(double start, double end)
+{
+	map->compute(start, end, OVERVIEW_BUCKETS);
+	renderImage(overview);
+	detail = MapImage();
+}
+
+/*
+ * Computes a detailed map of the visible range and of one range size on each
+ * side of it, if the overview is too coarse for the pixel width of the range
+ * and the current detailed map doesn't cover it. Returns true if the plot has
+ * changed.
+ */
+bool HeatMapPlot::refine(const QCPRange &range, int pixels)
+{
+	double pixelWidth, width, lower, upper;
+
+	if (pixels <= 0 || overview.image.isNull())
+		return false;
+
+	pixelWidth = range.size() / pixels;
+	width = (overview.end - overview.start) / overview.image.width();
+	if (pixelWidth >= width / 2) {
+		if (detail.image.isNull())
+			return false;
+		detail = MapImage();
+		return true;
+	}
+
+	lower = TSMAX(range.lower, overview.start);
+	upper = TSMIN(range.upper, overview.end);
+	if (!detail.image.isNull()) {
+		width = (detail.end - detail.start) / detail.image.width();
+		if (detail.start <= lower && detail.end >= upper &&
+		    width <= pixelWidth * 2 && width >= pixelWidth / 2)
+			return false;
+	}
+
+	lower = TSMAX(range.lower - range.size(), overview.start);
+	upper = TSMIN(range.upper + range.size(), overview.end);
+	if (!(upper > lower))
+		return false;
+	map->compute(lower, upper, (int) std::ceil((upper - lower) /
+						   pixelWidth));
+	renderImage(detail);
+	return true;
+}
+
+/* Renders the rows that map has computed, the first row at the bottom */
+void HeatMapPlot::renderImage(MapImage &mapImage)
+{
+	const QCPRange dataRange(0, 1);
+	int columns = map->getNrBuckets();
+	int row;
+
+	nrRows = map->nrRows();
+	mapImage.start = map->getStart();
+	mapImage.end = map->getEnd();
+	if (columns <= 0 || nrRows <= 0) {
+		mapImage.image = QImage();
+		return;
+	}
+
+	mapImage.image = QImage(columns, nrRows, QImage::Format_RGB32);
+	for (row = 0; row < nrRows; row++) {
+		const QVector<double> &values = map->getRow(row).values;
+		QRgb *line = (QRgb*) mapImage.image.scanLine(nrRows - 1 - row);
+		gradient.colorize(values.constData(), dataRange, line,
+				  columns);
+	}
+}
+
+double HeatMapPlot::selectTest(const QPointF &/*pos*/,
+			       bool /*onlySelectable*/,
+			       QVariant */*details*/) const
+{
+	return -1;
+}
+
+QCPRange HeatMapPlot::getKeyRange(bool &foundRange,
+				  QCP::SignDomain /*inSignDomain*/) const
+{
+	QCPRange range(overview.start, overview.end);
+
+	foundRange = !overview.image.isNull();
+	return range;
+}
+
+QCPRange HeatMapPlot::getValueRange(bool &foundRange,
+				    QCP::SignDomain /*inSignDomain*/,
+				    const QCPRange &/*inKeyRange*/) const
+{
+	QCPRange range(offset, offset + nrRows * rowHeight);
+
+	foundRange = !overview.image.isNull();
+	return range;
+}
+
+void HeatMapPlot::draw(QCPPainter *painter)
+{
+	if (mKeyAxis.isNull() || mValueAxis.isNull())
+		return;
+
+	painter->setRenderHint(QPainter::SmoothPixmapTransform, false);
+	drawImage(painter, overview);
+	drawImage(painter, detail);
+}
+
+/*
+ * Draws the columns of the image that are visible. Only whole columns are
+ * drawn, so that the image is never resampled at a fraction of a column.
+ */
+void HeatMapPlot::drawImage(QCPPainter *painter,
+			    const MapImage &mapImage) const
+{
+	QCPAxis *keyAxis = mKeyAxis.data();
+	QCPAxis *valueAxis = mValueAxis.data();
+	const QCPRange &range = keyAxis->range();
+	double lower, upper, width, x0, x1, y0, y1;
+	int columns, first, last;
+
+	if (mapImage.image.isNull())
+		return;
+
+	lower = TSMAX(range.lower, mapImage.start);
+	upper = TSMIN(range.upper, mapImage.end);
+	if (!(upper > lower))
+		return;
+
+	columns = mapImage.image.width();
+	width = (mapImage.end - mapImage.start) / columns;
+	first = (int) std::floor((lower - mapImage.start) / width);
+	last = (int) std::ceil((upper - mapImage.start) / width);
+	first = TSMAX(0, TSMIN(first, columns - 1));
+	last = TSMAX(first + 1, TSMIN(last, columns));
+
+	x0 = keyAxis->coordToPixel(mapImage.start + first * width);
+	x1 = keyAxis->coordToPixel(mapImage.start + last * width);
+	y0 = valueAxis->coordToPixel(offset + nrRows * rowHeight);
+	y1 = valueAxis->coordToPixel(offset);
+	painter->drawImage(QRectF(QPointF(x0, y0), QPointF(x1, y1)),
+			   mapImage.image,
+			   QRectF(first, 0, last - first, nrRows));
+}
+
+void HeatMapPlot::drawLegendIcon(QCPPainter *painter, const QRectF &rect)
+	const
+{
+	QLinearGradient fill(rect.topLeft(), rect.topRight());
+
+	fill.setColorAt(0, Qt::white);
+	fill.setColorAt(1, Qt::black);
+	painter->fillRect(rect, QBrush(fill));
+}
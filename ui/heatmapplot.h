@@ -0,0 +1,111 @@
+// SPDX-License-Identifier: (GPL-2.0-or-later OR BSD-2-Clause)
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2020  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef HEATMAPPLOT_H
+#define HEATMAPPLOT_H
+
+#include <QImage>
+#include "ui/qcustomplot.h"
+
+class UtilizationMap;
+
+/*
+ * This draws the rows of a UtilizationMap as a heat map with a single
+ * plottable, so that an overview of a trace with a huge number of tasks is
+ * drawn with one image instead of one graph per task. The overview covers the
+ * whole trace. When zooming in so far that the overview gets too coarse, a
+ * detailed map of the visible range is computed by refine() and drawn on top
+ * of it.
+ */
+class HeatMapPlot : public QCPAbstractPlottable
+{
+	Q_OBJECT
+public:
+	HeatMapPlot(QCPAxis *keyAxis, QCPAxis *valueAxis, UtilizationMap *map);
+	void setGeometry(double offset, double rowHeight);
+	void computeOverview(double start, double end);
+	bool refine(const QCPRange &range, int pixels);
+	virtual double selectTest(const QPointF &pos, bool onlySelectable,
+				  QVariant *details = 0) const;
+	virtual QCPRange getKeyRange(bool &foundRange,
+				     QCP::SignDomain inSignDomain = QCP::sdBoth)
+		const;
+	virtual QCPRange getValueRange(bool &foundRange,
+				       QCP::SignDomain inSignDomain
+				       = QCP::sdBoth,
+				       const QCPRange &inKeyRange = QCPRange())
+		const;
+	static const int OVERVIEW_BUCKETS = 4096;
+protected:
+	virtual void draw(QCPPainter *painter);
+	virtual void drawLegendIcon(QCPPainter *painter, const QRectF &rect)
+		const;
+private:
+	class MapImage {
+	public:
+		MapImage(): start(0), end(0) {}
+		QImage image;
+		double start;
+		double end;
+	};
+	void renderImage(MapImage &mapImage);
+	void drawImage(QCPPainter *painter, const MapImage &mapImage) const;
+	UtilizationMap *map;
+	MapImage overview;
+	MapImage detail;
+	QCPColorGradient gradient;
+	double offset;
+	double rowHeight;
+	int nrRows;
+};
+
+#endif /* HEATMAPPLOT_H */
@@ -0,0 +1,177 @@
+// SPDX-License-Identifier: (GPL-2.0-or-later OR BSD-2-Clause)
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2020  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <QCheckBox>
+#include <QComboBox>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QList>
+#include <QPushButton>
+#include <QVBoxLayout>
+#include <QWidget>
+
+#include "analyzer/traceanalyzer.h"
+#include "ui/latencydialog.h"
+#include "ui/latencymodel.h"
+#include "ui/tableview.h"
+#include "misc/traceshark.h"
+
+/* The indices of the combo box must match TraceAnalyzer::latencygroup_t */
+LatencyDialog::LatencyDialog(QWidget *parent)
+	: QDockWidget(tr("Wakeup Latency"), parent), analyzer(nullptr)
+{
+	QWidget *widget = new QWidget(this);
+	QVBoxLayout *mainLayout =  new QVBoxLayout(widget);
+	setWidget(widget);
+	QHBoxLayout *buttonLayout = new QHBoxLayout();
+	QHBoxLayout *settingLayout = new QHBoxLayout();
+
+	latencyView = new TableView(this, TableView::TABLE_ROWSELECT);
+	latencyModel = new LatencyModel(latencyView);
+	latencyView->setModel(latencyModel);
+
+	mainLayout->addWidget(latencyView);
+	mainLayout->addLayout(settingLayout);
+	mainLayout->addLayout(buttonLayout);
+
+	groupBox = new QComboBox();
+	groupBox->addItem(QString(tr("All tasks")));
+	groupBox->addItem(QString(tr("Per CPU")));
+	groupBox->addItem(QString(tr("Per process name")));
+	groupBox->addItem(QString(tr("Per task")));
+	groupBox->setCurrentIndex(TraceAnalyzer::LATENCY_GLOBAL);
+
+	QLabel *boxlabel = new QLabel(tr("Only between the cursors"));
+	cursorBox = new QCheckBox();
+	cursorBox->setChecked(false);
+
+	settingLayout->addStretch();
+	settingLayout->addWidget(groupBox);
+	settingLayout->addWidget(boxlabel);
+	settingLayout->addWidget(cursorBox);
+	settingLayout->addStretch();
+
+	QPushButton *closeButton = new QPushButton(tr("Close"));
+	QPushButton *updateButton = new QPushButton(tr("Update"));
+	buttonLayout->addStretch();
+	buttonLayout->addWidget(closeButton);
+	buttonLayout->addWidget(updateButton);
+	buttonLayout->addStretch();
+
+	tsconnect(closeButton, clicked(), this, closeClicked());
+	tsconnect(updateButton, clicked(), this, refresh());
+	tsconnect(groupBox, currentIndexChanged(int), this, refresh());
+	tsconnect(cursorBox, stateChanged(int), this, refresh());
+	tsconnect(latencyView, doubleClicked(const QModelIndex &),
+		  this, handleDoubleClick(const QModelIndex &));
+}
+
+LatencyDialog::~LatencyDialog()
+{}
+
+void LatencyDialog::setAnalyzer(TraceAnalyzer *az)
+{
+	analyzer = az;
+}
+
+void LatencyDialog::clear()
+{
+	latencyModel->beginResetModel();
+	latencyModel->clear();
+	latencyModel->endResetModel();
+}
+
+void LatencyDialog::refresh()
+{
+	QList<LatencyGroup> groups;
+	TraceAnalyzer::latencygroup_t type;
+
+	if (analyzer == nullptr || !analyzer->isOpen() ||
+	    !analyzer->statsReady()) {
+		clear();
+		return;
+	}
+
+	type = (TraceAnalyzer::latencygroup_t) groupBox->currentIndex();
+	analyzer->getLatencyGroups(type, cursorBox->isChecked(), groups);
+
+	latencyModel->beginResetModel();
+	latencyModel->setGroups(groups);
+	latencyModel->endResetModel();
+	if (QDockWidget::isVisible())
+		latencyView->resizeColumnsToContents();
+}
+
+void LatencyDialog::show()
+{
+	QDockWidget::show();
+	refresh();
+}
+
+void LatencyDialog::closeClicked()
+{
+	QDockWidget::hide();
+	emit QDockWidgetNeedsRemoval(this);
+}
+
+void LatencyDialog::handleDoubleClick(const QModelIndex &index)
+{
+	bool ok;
+	int pid;
+
+	if (groupBox->currentIndex() != TraceAnalyzer::LATENCY_TASK)
+		return;
+
+	pid = latencyModel->rowToId(index.row(), ok);
+	if (ok)
+		emit taskDoubleClicked(pid);
+}
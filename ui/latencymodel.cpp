@@ -0,0 +1,237 @@
+// SPDX-License-Identifier: (GPL-2.0-or-later OR BSD-2-Clause)
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2020  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "vtl/heapsort.h"
+#include "vtl/tlist.h"
+
+#include "analyzer/traceanalyzer.h"
+#include "ui/latencymodel.h"
+#include "misc/traceshark.h"
+
+LatencyModel::LatencyModel(QObject *parent):
+	QAbstractTableModel(parent)
+{
+	rowList = new vtl::TList<LatencyRow*>;
+	errorStr = new QString(tr("Error in latencymodel.cpp"));
+}
+
+LatencyModel::~LatencyModel()
+{
+	clear();
+	delete rowList;
+	delete errorStr;
+}
+
+void LatencyModel::clear()
+{
+	int i, s;
+
+	s = rowList->size();
+	for (i = 0; i < s; i++)
+		delete rowList->at(i);
+	rowList->clear();
+}
+
+/*
+ * The percentiles are computed here, once, so that data() doesn't need to
+ * walk the histograms each time that a cell is painted.
+ */
+void LatencyModel::setGroups(const QList<LatencyGroup> &groups)
+{
+	LatencyRow *row;
+	int i, s;
+
+	clear();
+	s = groups.size();
+	for (i = 0; i < s; i++) {
+		const LatencyGroup &group = groups.at(i);
+		const LatencyHistogram &hist = group.hist;
+		if (hist.count() == 0)
+			continue;
+		row = new LatencyRow;
+		row->name = group.name;
+		row->id = group.id;
+		row->count = hist.count();
+		row->p50 = hist.percentile(50);
+		row->p99 = hist.percentile(99);
+		row->p999 = hist.percentile(99.9);
+		row->max = hist.max();
+		rowList->append(row);
+	}
+
+	/* The groups with the worst tail latency come first */
+	vtl::heapsort<vtl::TList, LatencyRow*>(
+		*rowList, [] (LatencyRow *&a, LatencyRow *&b) -> int {
+			if (a->p99 < b->p99)
+				return 1;
+			if (a->p99 > b->p99)
+				return -1;
+			if (a->max < b->max)
+				return 1;
+			if (a->max > b->max)
+				return -1;
+			int cmp = a->name.compare(b->name);
+			if (cmp != 0)
+				return cmp;
+			return a->id - b->id;
+		});
+}
+
+int LatencyModel::rowCount(const QModelIndex & /* index */) const
+{
+	return rowList->size();
+}
+
+int LatencyModel::columnCount(const QModelIndex & /* index */) const
+{
+	return 7; /* Number from data() and headerData() */
+}
+
+int LatencyModel::rowToId(int row, bool &ok) const
+{
+	if (row < 0 || row >= rowList->size()) {
+		ok = false;
+		return -1;
+	}
+	ok = true;
+	return rowList->at(row)->id;
+}
+
+QVariant LatencyModel::data(const QModelIndex &index, int role) const
+{
+	if (!index.isValid())
+		return QVariant();
+
+	if (role == Qt::TextAlignmentRole)
+		return int(Qt::AlignLeft | Qt::AlignVCenter);
+
+	if (role == Qt::DisplayRole) {
+		int r = index.row();
+		int column = index.column();
+
+		if (r < 0 || r >= rowList->size())
+			return QVariant();
+
+		const LatencyRow *row = rowList->at(r);
+
+		switch(column) {
+		case 0:
+			return row->name;
+		case 1:
+			if (row->id >= 0)
+				return QString::number(row->id);
+			return QString();
+		case 2:
+			return QString::number(row->count);
+		case 3:
+			return row->p50.toQString();
+		case 4:
+			return row->p99.toQString();
+		case 5:
+			return row->p999.toQString();
+		case 6:
+			return row->max.toQString();
+		default:
+			break;
+		}
+	}
+	return QVariant();
+}
+
+bool LatencyModel::setData(const QModelIndex &/*index*/, const QVariant
+			   &/*value*/, int /*role*/)
+{
+	return false;
+}
+
+QVariant LatencyModel::headerData(int section,
+				  Qt::Orientation orientation,
+				  int role) const
+{
+	if (role == Qt::DisplayRole && orientation == Qt::Horizontal) {
+		switch(section) {
+		case 0:
+			return QString(tr("Name"));
+		case 1:
+			return QString(tr("ID"));
+		case 2:
+			return QString(tr("Wakeups"));
+		case 3:
+			return QString(tr("p50"));
+		case 4:
+			return QString(tr("p99"));
+		case 5:
+			return QString(tr("p99.9"));
+		case 6:
+			return QString(tr("Max"));
+		default:
+			return *errorStr;
+		}
+	}
+	return QVariant();
+}
+
+Qt::ItemFlags LatencyModel::flags(const QModelIndex &index) const
+{
+	Qt::ItemFlags flags = QAbstractItemModel::flags(index);
+	return flags;
+}
+
+void LatencyModel::beginResetModel()
+{
+	QAbstractTableModel::beginResetModel();
+}
+
+void LatencyModel::endResetModel()
+{
+	QAbstractTableModel::endResetModel();
+}
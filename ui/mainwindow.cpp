@@ -54,18 +54,27 @@
 
 #include <QApplication>
 #include <QDateTime>
+#include <QInputDialog>
 #include <QList>
+#include <QProgressDialog>
 #include <QScrollBar>
+#include <QTimer>
+#include <QToolTip>
 #include <QVBoxLayout>
 #include <QToolBar>
 
 #include "ui/cursor.h"
 #include "ui/eventinfodialog.h"
+#include "ui/eventratestrip.h"
 #include "ui/eventswidget.h"
 #include "analyzer/traceanalyzer.h"
+#include "analyzer/utilizationmap.h"
 #include "ui/errordialog.h"
+#include "ui/graphdata.h"
 #include "ui/graphenabledialog.h"
+#include "ui/heatmapplot.h"
 #include "ui/infowidget.h"
+#include "ui/latencydialog.h"
 #include "ui/licensedialog.h"
 #include "ui/mainwindow.h"
 #include "ui/migrationline.h"
@@ -88,6 +97,7 @@
 #include "ui/qcustomplot.h"
 #include "vtl/compiler.h"
 #include "vtl/error.h"
+#include "vtl/mapcache.h"
 
 
 #define TOOLTIP_OPEN			\
@@ -126,6 +136,19 @@
 #define TOOLTIP_TIMEFILTER		\
 "Filter on the time interval specified by the current position of the cursors"
 
+#define TOOLTIP_ARGFILTER		\
+"Filter on an expression of the event arguments, such as prev_state == D"
+
+#define TOOLTIP_FIND			\
+"Search the task names, event names and arguments of the events, /text/ is a \
+regular expression"
+
+#define TOOLTIP_FINDNEXT		\
+"Select the next event that matches the search"
+
+#define TOOLTIP_FINDPREVIOUS		\
+"Select the previous event that matches the search"
+
 #define TOOLTIP_GRAPHENABLE		\
 "Select which types of graphs should be enabled"
 
@@ -144,6 +167,9 @@
 #define TOOLTIP_GETSTATS_TIMELIMITED	\
 "Show the dialog with statistics that are time limited by the cursors"
 
+#define TOOLTIP_SHOWLATENCY		\
+"Show the percentiles of the wakeup latencies"
+
 #define TOOLTIP_FIND_SLEEP		\
 "Find the next sched_switch event that puts the selected task to sleep"
 
@@ -156,6 +182,13 @@
 #define FIND_WAKING_DIRECT_TOOLTIP	\
 "Find the waking event of the selected task that precedes the active cursor"
 
+#define SHOW_WAKE_CHAIN_TOOLTIP	\
+"Highlight the chain of wakers that led to the selected task running at the " \
+"active cursor"
+
+#define HIDE_WAKE_CHAIN_TOOLTIP	\
+"Remove the highlighted wake chain"
+
 #define REMOVE_TASK_TOOLTIP		\
 "Remove the unified graph for this task"
 
@@ -219,6 +252,13 @@ const double MainWindow::cpuSpacing = 100;
 const double MainWindow::cpuHeight = 800;
 const double MainWindow::pixelZoomFactor = 33;
 const double MainWindow::refDpiY = 96;
+/*
+ * The graphs of the lanes that are within this many times the size of the
+ * visible range of the y axis are created in advance of being scrolled to.
+ */
+const double MainWindow::laneMargin = 1;
+const double MainWindow::heatMapSectionOffset = 100;
+const double MainWindow::heatMapRowHeight = 500;
 /*
  * const double migrateHeight doesn't exist. The value used is the
  * dynamically calculated inc variable in MainWindow::computeLayout()
@@ -250,7 +290,7 @@ const QColor MainWindow::UNINT_COLOR = QColor(205, 0, 205);
 
 MainWindow::MainWindow():
 	tracePlot(nullptr), scrollBarUpdate(false), graphEnableDialog(nullptr),
-	filterActive(false)
+	filterActive(false), traceShown(false), processingStart(0)
 {
 	settingStore = new SettingStore();
 	loadSettings();
@@ -278,6 +318,8 @@ MainWindow::MainWindow():
 	tsconnect(scrollBar, valueChanged(int), this, scrollBarChanged(int));
 	tsconnect(tracePlot->yAxis, rangeChanged(QCPRange), this,
 		  yAxisChanged(QCPRange));
+	tsconnect(tracePlot->xAxis, rangeChanged(QCPRange), this,
+		  xAxisChanged(QCPRange));
 	tsconnect(tracePlot->yAxis,
 		  selectionChanged (const QCPAxis::SelectableParts &),
 		  this,
@@ -303,11 +345,13 @@ void MainWindow::createTracePlot()
 	QString mainLayerName = QString("main");
 	QString cursorLayerName = QString("cursor");
 	QCPLayer *mainLayer;
+	QVBoxLayout *traceLayout;
 	yaxisTicker = new YAxisTicker();
 	QSharedPointer<QCPAxisTicker> ticker((QCPAxisTicker*) (yaxisTicker));
 
 	tracePlot = new TracePlot(plotWidget);
 	setupOpenGL();
+	setupTileCache();
 
 	tracePlot->yAxis->setTicker(ticker);
 	tracePlot->yAxis->setSelectableParts(QCPAxis::spAxis);
@@ -315,17 +359,30 @@ void MainWindow::createTracePlot()
 	taskRangeAllocator = new TaskRangeAllocator(schedHeight
 						    + schedSpacing);
 	taskRangeAllocator->setStart(bugWorkAroundOffset);
+	utilizationMap = new UtilizationMap();
+	heatMapPlot = nullptr;
+	heatMapOffset = 0;
+	wakeChainCurve = nullptr;
 
 	mainLayer = tracePlot->layer(mainLayerName);
 
 	tracePlot->addLayer(cursorLayerName, mainLayer, QCustomPlot::limAbove);
 	cursorLayer = tracePlot->layer(cursorLayerName);
+	tracePlot->setOverlayLayer(cursorLayer);
 
 	tracePlot->setCurrentLayer(mainLayerName);
 
 	tracePlot->setAutoAddPlottableToLegend(false);
 	tracePlot->hide();
-	plotLayout->addWidget(tracePlot);
+
+	/* The event rate strip is aligned with the plot, right above it */
+	eventRateStrip = new EventRateStrip(tracePlot, plotWidget);
+	eventRateStrip->hide();
+	traceLayout = new QVBoxLayout();
+	traceLayout->setSpacing(0);
+	traceLayout->addWidget(eventRateStrip);
+	traceLayout->addWidget(tracePlot);
+	plotLayout->addLayout(traceLayout);
 
 	tracePlot->setInteractions(QCP::iRangeDrag | QCP::iRangeZoom |
 				   QCP::iSelectAxes | QCP::iSelectLegend |
@@ -393,11 +450,13 @@ MainWindow::~MainWindow()
 	delete analyzer;
 	delete tracePlot;
 	delete taskRangeAllocator;
+	delete utilizationMap;
 	delete licenseDialog;
 	delete eventInfoDialog;
 	delete taskSelectDialog;
 	delete statsDialog;
 	delete statsLimitedDialog;
+	delete latencyDialog;
 	delete eventSelectDialog;
 	delete cpuSelectDialog;
 	delete graphEnableDialog;
@@ -417,6 +476,7 @@ void MainWindow::closeEvent(QCloseEvent *event)
 	cpuSelectDialog->hide();
 	statsDialog->hide();
 	statsLimitedDialog->hide();
+	latencyDialog->hide();
 	event->accept();
 	/* event->ignore() could be used to refuse to close the window */
 }
@@ -450,93 +510,175 @@ void MainWindow::openFile(const QString &name)
 		return;
 	}
 
-	if (analyzer->isOpen()) {
-		quint64 start, process, layout, rescale, showt, eventsw;
-		quint64 scursor, tshow;
+	if (!analyzer->isOpen()) {
+		setStatus(STATUS_ERROR);
+		vtl::warnx("Unknown error when opening trace!");
+		return;
+	}
 
-		clearPlot();
-		setupOpenGL();
+	clearPlot();
+	setupOpenGL();
+
+	traceFile = name;
+	traceShown = false;
+	/*
+	 * The scheduling graphs are scaled by the processing thread, so the
+	 * scale and the wakeup maximum must be set before it is started.
+	 */
+	CPUTask::setVerticalWakeupMAX(settingStore->getValue(
+		Setting::MAX_VRT_WAKEUP_LATENCY).intv());
+	analyzer->setSchedScales(schedHeight);
+	processingStart = QDateTime::currentDateTimeUtc().toMSecsSinceEpoch();
+	analyzer->startProcessing();
 
-		start = QDateTime::currentDateTimeUtc().toMSecsSinceEpoch();
+	setStatus(STATUS_PROCESSING, &name);
+	setCloseActionsEnabled(true);
+	progressDialog->setLabelText(tr("Loading and analyzing the trace..."));
+	progressDialog->setRange(0, 1000);
+	progressDialog->setValue(0);
+	processingTimer->start();
+}
 
-		processTrace();
-		process = QDateTime::currentDateTimeUtc().toMSecsSinceEpoch();
+/*
+ * Follows the background processing of a newly opened trace. The trace is
+ * shown when the processing thread is done, including the scaling of the
+ * scheduling graphs and the statistics.
+ */
+void MainWindow::processingTimeout()
+{
+	TraceAnalyzer::processing_t phase = analyzer->getProcessingPhase();
 
-		computeLayout();
-		layout = QDateTime::currentDateTimeUtc().toMSecsSinceEpoch();
+	switch (phase) {
+	case TraceAnalyzer::PROCESSING_ANALYZE:
+		progressDialog->setValue(analyzer->getLoadProgress());
+		return;
+	case TraceAnalyzer::PROCESSING_LOD:
+	case TraceAnalyzer::PROCESSING_STATS:
+		if (progressDialog->maximum() != 0) {
+			progressDialog->setLabelText(
+				tr("Preparing the graphs..."));
+			progressDialog->setRange(0, 0);
+		}
+		progressDialog->setValue(0);
+		return;
+	default:
+		break;
+	}
 
-		eventsWidget->beginResetModel();
-		eventsWidget->setEvents(analyzer->events);
-		if (analyzer->events->size() > 0)
-			setEventActionsEnabled(true);
+	/* The legend and the task dialogs read the statistics */
+	processingTimer->stop();
+	if (!traceShown)
+		showProcessedTrace();
+	finishProcessing();
+}
+
+void MainWindow::cancelProcessing()
+{
+	if (analyzer->isOpen())
+		closeTrace();
+}
+
+void MainWindow::showProcessedTrace()
+{
+	quint64 start, layout, rescale, showt, eventsw;
+	quint64 scursor, tshow;
+
+	progressDialog->reset();
+	start = QDateTime::currentDateTimeUtc().toMSecsSinceEpoch();
+
+	processTrace();
+	computeLayout();
+	layout = QDateTime::currentDateTimeUtc().toMSecsSinceEpoch();
+
+	eventsWidget->beginResetModel();
+	eventsWidget->setEvents(analyzer->events);
+	if (analyzer->events->size() > 0)
 		setEventActionsEnabled(true);
-		eventsWidget->endResetModel();
+	setEventActionsEnabled(true);
+	eventsWidget->endResetModel();
 
-		taskSelectDialog->beginResetModel();
-		taskSelectDialog->setTaskMap(&analyzer->taskMap,
-					     analyzer->getNrCPUs());
-		taskSelectDialog->endResetModel();
+	taskSelectDialog->beginResetModel();
+	taskSelectDialog->setTaskMap(&analyzer->taskMap,
+				     analyzer->getNrCPUs());
+	taskSelectDialog->endResetModel();
 
-		eventSelectDialog->beginResetModel();
-		eventSelectDialog->setStringTree(TraceEvent::getStringTree());
-		eventSelectDialog->endResetModel();
+	eventSelectDialog->beginResetModel();
+	eventSelectDialog->setStringTree(TraceEvent::getStringTree());
+	eventSelectDialog->endResetModel();
 
-		cpuSelectDialog->beginResetModel();
-		cpuSelectDialog->setNrCPUs(analyzer->getNrCPUs());
-		cpuSelectDialog->endResetModel();
+	cpuSelectDialog->beginResetModel();
+	cpuSelectDialog->setNrCPUs(analyzer->getNrCPUs());
+	cpuSelectDialog->endResetModel();
 
-		eventsw = QDateTime::currentDateTimeUtc().toMSecsSinceEpoch();
+	eventsw = QDateTime::currentDateTimeUtc().toMSecsSinceEpoch();
 
-		setupCursors();
-		scursor = QDateTime::currentDateTimeUtc().toMSecsSinceEpoch();
+	setupCursors();
+	scursor = QDateTime::currentDateTimeUtc().toMSecsSinceEpoch();
 
-		rescaleTrace();
-		rescale = QDateTime::currentDateTimeUtc().toMSecsSinceEpoch();
+	/* The scaling has been done by the processing thread */
+	analyzer->doRelayout();
+	rescale = QDateTime::currentDateTimeUtc().toMSecsSinceEpoch();
 
-		computeStats();
-		statsDialog->beginResetModel();
-		statsDialog->setTaskMap(&analyzer->taskMap,
-					analyzer->getNrCPUs());
-		statsDialog->endResetModel();
+	showTrace();
+	savePlotSettings();
+	showt = QDateTime::currentDateTimeUtc().toMSecsSinceEpoch();
 
-		statsLimitedDialog->beginResetModel();
-		statsLimitedDialog->setTaskMap(&analyzer->taskMap,
-					       analyzer->getNrCPUs());
-		statsLimitedDialog->endResetModel();
+	tracePlot->show();
+	updateSchedLOD(tracePlot->xAxis->range());
+	tshow = QDateTime::currentDateTimeUtc().toMSecsSinceEpoch();
+
+	printf("processTrace() took %.6lf s\n"
+	       "computeLayout() took %.6lf s\n"
+	       "updating EventsWidget took %.6lf s\n"
+	       "setupCursors() took %.6lf s\n"
+	       "doRelayout() took %.6lf s\n"
+	       "showTrace() took %.6lf s\n"
+	       "tracePlot->show took %.6lf s\n",
+	       (double) (start - processingStart) / 1000,
+	       (double) (layout - start) / 1000,
+	       (double) (eventsw - layout) / 1000,
+	       (double) (scursor - eventsw) / 1000,
+	       (double) (rescale - scursor) / 1000,
+	       (double) (showt - rescale) / 1000,
+	       (double) (tshow - showt) / 1000);
+	fflush(stdout);
+	tracePlot->legend->setVisible(true);
+	traceShown = true;
+}
+
+/* This is called when the statistics have been computed in the background */
+void MainWindow::finishProcessing()
+{
+	quint64 done;
 
-		showTrace();
-		showt = QDateTime::currentDateTimeUtc().toMSecsSinceEpoch();
-
-		tracePlot->show();
-		tshow = QDateTime::currentDateTimeUtc().toMSecsSinceEpoch();
-
-		setStatus(STATUS_FILE, &name);
-
-		printf("processTrace() took %.6lf s\n"
-		       "computeLayout() took %.6lf s\n"
-		       "updating EventsWidget took %.6lf s\n"
-		       "setupCursors() took %.6lf s\n"
-		       "rescaleTrace() took %.6lf s\n"
-		       "showTrace() took %.6lf s\n"
-		       "tracePlot->show took %.6lf s\n",
-		       (double) (process - start) / 1000,
-		       (double) (layout - process) / 1000,
-		       (double) (eventsw - layout) / 1000,
-		       (double) (scursor - eventsw) / 1000,
-		       (double) (rescale - scursor) / 1000,
-		       (double) (showt - rescale) / 1000,
-		       (double) (tshow - showt) / 1000);
-		fflush(stdout);
-		tracePlot->legend->setVisible(true);
-		setCloseActionsEnabled(true);
-		if (analyzer->events->size() <= 0)
-			vtl::warnx("You have opened an empty trace!");
-		else
-			setTraceActionsEnabled(true);
-	} else {
-		setStatus(STATUS_ERROR);
-		vtl::warnx("Unknown error when opening trace!");
-	}
+	statsDialog->beginResetModel();
+	statsDialog->setTaskMap(&analyzer->taskMap, analyzer->getNrCPUs());
+	statsDialog->endResetModel();
+
+	/*
+	 * The dialogs may have been left open from the previous trace, they
+	 * have been empty until now.
+	 */
+	statsLimitedDialog->beginResetModel();
+	if (statsLimitedDialog->isVisible())
+		analyzer->doLimitedStats();
+	statsLimitedDialog->setTaskMap(&analyzer->taskMap,
+				       analyzer->getNrCPUs());
+	statsLimitedDialog->endResetModel();
+
+	if (latencyDialog->isVisible())
+		latencyDialog->refresh();
+
+	done = QDateTime::currentDateTimeUtc().toMSecsSinceEpoch();
+	printf("opening took %.6lf s in total\n",
+	       (double) (done - processingStart) / 1000);
+	fflush(stdout);
+
+	setStatus(STATUS_FILE, &traceFile);
+	if (analyzer->events->size() <= 0)
+		vtl::warnx("You have opened an empty trace!");
+	else
+		setTraceActionsEnabled(true);
 }
 
 void MainWindow::resizeEvent(QResizeEvent */*event*/)
@@ -555,9 +697,9 @@ void MainWindow::resizeEvent(QResizeEvent */*event*/)
 	}
 }
 
+/* Fetches the results of the background processing that the plot needs */
 void MainWindow::processTrace()
 {
-	analyzer->processTrace();
 	startTime = analyzer->getStartTime().toDouble();
 	endTime = analyzer->getEndTime().toDouble();
 }
@@ -566,6 +708,7 @@ void MainWindow::computeLayout()
 {
 	unsigned int cpu;
 	unsigned int nrCPUs;
+	int row;
 	unsigned int offset;
 	QString label;
 	double inc, o, p;
@@ -576,6 +719,25 @@ void MainWindow::computeLayout()
 	nrCPUs = analyzer->getNrCPUs();
 	ticks.resize(0);
 	tickLabels.resize(0);
+	schedLanes.resize(0);
+	cpuLanes.resize(0);
+
+	/*
+	 * The heat map is at the bottom, so that the first view of a trace
+	 * shows it and not the scheduling graphs of a few CPUs.
+	 */
+	if (settingStore->getValue(Setting::SHOW_HEATMAP).boolv()) {
+		offset += heatMapSectionOffset;
+		heatMapOffset = offset;
+
+		if (!utilizationMap->isSetup())
+			utilizationMap->setup(analyzer);
+		for (row = 0; row < utilizationMap->nrRows(); row++) {
+			ticks.append(offset + heatMapRowHeight / 2);
+			tickLabels.append(utilizationMap->getRow(row).name);
+			offset += heatMapRowHeight;
+		}
+	}
 
 	if (analyzer->enableMigrations()) {
 		offset += migrateSectionOffset;
@@ -588,7 +750,9 @@ void MainWindow::computeLayout()
 		color = QColor(135, 206, 250); /* Light sky blue */
 		label = QString("fork/exit");
 		ticks.append(offset);
-		new MigrationLine(startTime, endTime, offset, color, tracePlot);
+		migrationLines.append(new MigrationLine(startTime, endTime,
+							offset, color,
+							tracePlot));
 		tickLabels.append(label);
 		o = offset;
 		p = inc / nrCPUs ;
@@ -597,8 +761,10 @@ void MainWindow::computeLayout()
 			label = QString("cpu") + QString::number(cpu);
 			ticks.append(o);
 			tickLabels.append(label);
-			new MigrationLine(startTime, endTime, o, color,
-					  tracePlot);
+			migrationLines.append(new MigrationLine(startTime,
+								endTime, o,
+								color,
+								tracePlot));
 		}
 
 		offset += inc;
@@ -612,6 +778,7 @@ void MainWindow::computeLayout()
 		for (cpu = 0; cpu < nrCPUs; cpu++) {
 			analyzer->setSchedOffset(cpu, offset);
 			analyzer->setSchedScale(cpu, schedHeight);
+			schedLanes.append(offset);
 			label = QString("cpu") + QString::number(cpu);
 			ticks.append(offset);
 			tickLabels.append(label);
@@ -628,6 +795,7 @@ void MainWindow::computeLayout()
 			analyzer->setCpuIdleOffset(cpu, offset);
 			analyzer->setCpuFreqScale(cpu, cpuHeight);
 			analyzer->setCpuIdleScale(cpu, cpuHeight);
+			cpuLanes.append(offset);
 			label = QString("cpu") + QString::number(cpu);
 			ticks.append(offset);
 			tickLabels.append(label);
@@ -649,17 +817,26 @@ void MainWindow::rescaleTrace()
 	analyzer->doScale();
 }
 
-void MainWindow::computeStats()
-{
-	analyzer->doStats();
-}
-
 void MainWindow::clearPlot()
 {
 	cursors[TShark::RED_CURSOR] = nullptr;
 	cursors[TShark::BLUE_CURSOR] = nullptr;
 	tracePlot->clearItems();
 	tracePlot->clearPlottables();
+	tracePlot->invalidateTiles();
+	migrationLines.clear();
+	cpuIdleGraphs.clear();
+	cpuFreqGraphs.clear();
+	schedLaneShown.clear();
+	schedLaneGraphs.clear();
+	cpuLaneShown.clear();
+	heatMapPlot = nullptr;
+	heatMapTimer->stop();
+	wakeChainCurve = nullptr;
+	wakeChainPath.clear();
+	utilizationMap->clear();
+	eventRateStrip->setIndex(nullptr);
+	eventRateStrip->hide();
 	tracePlot->hide();
 	scrollBar->hide();
 	TaskGraph::clearMap();
@@ -670,7 +847,6 @@ void MainWindow::clearPlot()
 
 void MainWindow::showTrace()
 {
-	unsigned int cpu;
 	int precision = 7;
 	double extra = 0;
 	QColor color;
@@ -688,87 +864,74 @@ void MainWindow::showTrace()
 	yaxisTicker->setTickVectorLabels(tickLabels);
 	tracePlot->yAxis->setTicks(true);
 
+	cpuIdleGraphs.fill(nullptr, analyzer->getMaxCPU() + 1);
+	cpuFreqGraphs.fill(nullptr, analyzer->getMaxCPU() + 1);
+	schedLaneShown.fill(false, analyzer->getMaxCPU() + 1);
+	schedLaneGraphs.fill(false, analyzer->getMaxCPU() + 1);
+	cpuLaneShown.fill(false, analyzer->getMaxCPU() + 1);
+	eventRateStrip->setIndex(analyzer->getEventRateIndex());
+	eventRateStrip->show();
 
-	if (!settingStore->getValue(Setting::SHOW_CPUFREQ_GRAPHS).boolv() &&
-	    !settingStore->getValue(Setting::SHOW_CPUIDLE_GRAPHS).boolv())
-		goto skipIdleFreqGraphs;
-
-	/* Show CPU frequency and idle graphs */
-	for (cpu = 0; cpu <= analyzer->getMaxCPU(); cpu++) {
-		QPen pen = QPen();
-		QPen penF = QPen();
-
-		QCPGraph *graph;
-		QString name;
-		QCPScatterStyle style;
-
-		if (settingStore->getValue(Setting::SHOW_CPUIDLE_GRAPHS)
-		    .boolv()) {
-			const int lwidth = settingStore->getValue(
-				Setting::IDLE_LINE_WIDTH).intv();
-			const double adjsize = adjustScatterSize(CPUIDLE_SIZE,
-								 lwidth);
-			graph = tracePlot->addGraph(tracePlot->xAxis,
-						    tracePlot->yAxis);
-			graph->setSelectable(QCP::stNone);
-			name = QString(tr("cpuidle")) + QString::number(cpu);
-			style = QCPScatterStyle(CPUIDLE_SHAPE, adjsize);
-			pen.setColor(Qt::red);
-			pen.setWidth(lwidth);
-			style.setPen(pen);
-			graph->setScatterStyle(style);
-			pen.setColor(Qt::green);
-			graph->setPen(pen);
-			graph->setName(name);
-			graph->setAdaptiveSampling(true);
-			graph->setLineStyle(QCPGraph::lsStepLeft);
-			graph->setData(analyzer->cpuIdle[cpu].timev,
-				       analyzer->cpuIdle[cpu].scaledData);
-		}
+	/*
+	 * The graphs are only created for the lanes that are close to the
+	 * visible range, the rest are created when scrolled to.
+	 */
+	updateLanes();
+	updateHeatMap();
 
-		if (settingStore->getValue(Setting::SHOW_CPUFREQ_GRAPHS)
-		    .boolv()) {
-			graph = tracePlot->addGraph(tracePlot->xAxis,
-						    tracePlot->yAxis);
-			graph->setSelectable(QCP::stNone);
-			name = QString(tr("cpufreq")) + QString::number(cpu);
-			penF.setColor(Qt::blue);
-			penF.setWidth(settingStore
-				      ->getValue(Setting::FREQ_LINE_WIDTH)
-				      .intv());
-			graph->setPen(penF);
-			graph->setName(name);
-			graph->setAdaptiveSampling(true);
-			graph->setLineStyle(QCPGraph::lsStepLeft);
-			graph->setData(analyzer->cpuFreq[cpu].timev,
-				       analyzer->cpuFreq[cpu].scaledData);
-		}
-	}
+	tracePlot->replot();
+}
 
-skipIdleFreqGraphs:
+void MainWindow::addCpuIdleGraph(unsigned int cpu)
+{
+	QPen pen = QPen();
+	QCPGraph *graph;
+	QString name;
+	QCPScatterStyle style;
+	const int lwidth = settingStore->getValue(Setting::IDLE_LINE_WIDTH)
+		.intv();
+	const double adjsize = adjustScatterSize(CPUIDLE_SIZE, lwidth);
 
-	/* Show scheduling graphs */
-	for (cpu = 0; cpu <= analyzer->getMaxCPU(); cpu++) {
-		DEFINE_CPUTASKMAP_ITERATOR(iter) = analyzer->
-			cpuTaskMaps[cpu].begin();
-		while(iter != analyzer->cpuTaskMaps[cpu].end()) {
-			CPUTask &task = iter.value();
-			iter++;
+	graph = tracePlot->addGraph(tracePlot->xAxis, tracePlot->yAxis);
+	graph->setSelectable(QCP::stNone);
+	name = QString(tr("cpuidle")) + QString::number(cpu);
+	style = QCPScatterStyle(CPUIDLE_SHAPE, adjsize);
+	pen.setColor(Qt::red);
+	pen.setWidth(lwidth);
+	style.setPen(pen);
+	graph->setScatterStyle(style);
+	pen.setColor(Qt::green);
+	graph->setPen(pen);
+	graph->setName(name);
+	graph->setAdaptiveSampling(true);
+	graph->setLineStyle(QCPGraph::lsStepLeft);
+	graphSetScaledData(graph, analyzer->cpuIdle[cpu].timev,
+			   analyzer->cpuIdle[cpu].data,
+			   analyzer->cpuIdle[cpu].scale,
+			   analyzer->cpuIdle[cpu].offset);
+	cpuIdleGraphs[cpu] = graph;
+}
 
-			addSchedGraph(task, cpu);
-			if (settingStore->getValue(Setting::SHOW_SCHED_GRAPHS)
-			    .boolv())
-			{
-				addHorizontalWakeupGraph(task);
-				addWakeupGraph(task);
-				addPreemptedGraph(task);
-				addStillRunningGraph(task);
-				addUninterruptibleGraph(task);
-			}
-		}
-	}
+void MainWindow::addCpuFreqGraph(unsigned int cpu)
+{
+	QPen pen = QPen();
+	QCPGraph *graph;
+	QString name;
 
-	tracePlot->replot();
+	graph = tracePlot->addGraph(tracePlot->xAxis, tracePlot->yAxis);
+	graph->setSelectable(QCP::stNone);
+	name = QString(tr("cpufreq")) + QString::number(cpu);
+	pen.setColor(Qt::blue);
+	pen.setWidth(settingStore->getValue(Setting::FREQ_LINE_WIDTH).intv());
+	graph->setPen(pen);
+	graph->setName(name);
+	graph->setAdaptiveSampling(true);
+	graph->setLineStyle(QCPGraph::lsStepLeft);
+	graphSetScaledData(graph, analyzer->cpuFreq[cpu].timev,
+			   analyzer->cpuFreq[cpu].data,
+			   analyzer->cpuFreq[cpu].scale,
+			   analyzer->cpuFreq[cpu].offset);
+	cpuFreqGraphs[cpu] = graph;
 }
 
 /*
@@ -813,6 +976,7 @@ void MainWindow::loadSettings()
 	if (ts_errno != 0)
 		vtl::warn(ts_errno, "Failed to load settings from %s",
 			  TS_SETTING_FILENAME);
+	setupMapCache();
 }
 
 void MainWindow::setupCursors()
@@ -847,13 +1011,18 @@ void MainWindow::setupCursors(const vtl::Time &redtime,
 void MainWindow::setupCursors_(vtl::Time redtime, const double &red,
 			       vtl::Time bluetime, const double &blue)
 {
+	QCPLayer *layer = tracePlot->currentLayer();
+
+	/*
+	 * Create the cursors directly on their own layer, so that they never
+	 * cause the tiles of the main layer to be invalidated.
+	 */
+	tracePlot->setCurrentLayer(cursorLayer);
 	cursors[TShark::RED_CURSOR] = new Cursor(tracePlot,
 						 TShark::RED_CURSOR);
 	cursors[TShark::BLUE_CURSOR] = new Cursor(tracePlot,
 						  TShark::BLUE_CURSOR);
-
-	cursors[TShark::RED_CURSOR]->setLayer(cursorLayer);
-	cursors[TShark::BLUE_CURSOR]->setLayer(cursorLayer);
+	tracePlot->setCurrentLayer(layer);
 
 	cursors[TShark::RED_CURSOR]->setPosition(redtime);
 	cursorPos[TShark::RED_CURSOR] = red;
@@ -881,7 +1050,7 @@ void MainWindow::addSchedGraph(CPUTask &cpuTask, unsigned int cpu)
 	graph->setPen(pen);
 	graph->setTask(task);
 	if (settingStore->getValue(Setting::SHOW_SCHED_GRAPHS).boolv())
-		graph->setData(cpuTask.schedTimev, cpuTask.scaledSchedData);
+		graph->setSchedLOD(&cpuTask);
 	/*
 	 * Save a pointer to the graph object in the task. The destructor of
 	 * AbstractClass will delete this when it is destroyed.
@@ -889,6 +1058,170 @@ void MainWindow::addSchedGraph(CPUTask &cpuTask, unsigned int cpu)
 	cpuTask.graph = graph;
 }
 
+/*
+ * Returns the scheduling graph of task on cpu. The graph is created if its
+ * lane has not been shown, because the selection, the legend and the unified
+ * task graphs can refer to the graphs of any CPU.
+ */
+TaskGraph *MainWindow::cpuTaskGraph(CPUTask *task, unsigned int cpu)
+{
+	if (task->graph == nullptr) {
+		addSchedGraph(*task, cpu);
+		updateSchedLOD(tracePlot->xAxis->range());
+		if (cpu < (unsigned) schedLaneShown.size() &&
+		    !schedLaneShown[cpu])
+			schedLaneGraphs[cpu] = true;
+	}
+	return task->graph;
+}
+
+/*
+ * Creates the graphs of the lanes that are within laneMargin times the size
+ * of the visible range of the y axis and removes the graphs of the lanes that
+ * are twice as far away. This way, the number of plottables depends on the
+ * zoom and not on the number of CPUs. The ticks and their labels are set for
+ * all lanes by computeLayout().
+ */
+void MainWindow::updateLanes()
+{
+	const QCPRange &range = tracePlot->yAxis->range();
+	const double margin = range.size() * laneMargin;
+	unsigned int cpu;
+	double lower, upper;
+	bool wanted, kept;
+	bool added = false;
+
+	for (cpu = 0; cpu < (unsigned) schedLaneShown.size(); cpu++) {
+		wanted = false;
+		kept = false;
+		if (cpu < (unsigned) schedLanes.size()) {
+			lower = schedLanes[cpu];
+			upper = lower + schedHeight + schedSpacing;
+			wanted = upper >= range.lower - margin &&
+				lower <= range.upper + margin;
+			kept = upper >= range.lower - 2 * margin &&
+				lower <= range.upper + 2 * margin;
+		}
+		if (wanted && !schedLaneShown[cpu]) {
+			showSchedLane(cpu);
+			added = true;
+		} else if (!kept &&
+			   (schedLaneShown[cpu] || schedLaneGraphs[cpu])) {
+			hideSchedLane(cpu);
+		}
+	}
+
+	for (cpu = 0; cpu < (unsigned) cpuLaneShown.size(); cpu++) {
+		wanted = false;
+		kept = false;
+		if (cpu < (unsigned) cpuLanes.size()) {
+			lower = cpuLanes[cpu];
+			upper = lower + cpuHeight + cpuSpacing;
+			wanted = upper >= range.lower - margin &&
+				lower <= range.upper + margin;
+			kept = upper >= range.lower - 2 * margin &&
+				lower <= range.upper + 2 * margin;
+		}
+		if (wanted && !cpuLaneShown[cpu])
+			showCpuLane(cpu);
+		else if (!kept && cpuLaneShown[cpu])
+			hideCpuLane(cpu);
+	}
+
+	if (added)
+		updateSchedLOD(tracePlot->xAxis->range());
+}
+
+void MainWindow::showSchedLane(unsigned int cpu)
+{
+	DEFINE_CPUTASKMAP_ITERATOR(iter);
+
+	for (iter = analyzer->cpuTaskMaps[cpu].begin();
+	     iter != analyzer->cpuTaskMaps[cpu].end();
+	     iter++) {
+		CPUTask &task = iter.value();
+		if (task.graph == nullptr)
+			addSchedGraph(task, cpu);
+		addHorizontalWakeupGraph(task);
+		addWakeupGraph(task);
+		addPreemptedGraph(task);
+		addStillRunningGraph(task);
+		addUninterruptibleGraph(task);
+	}
+	schedLaneShown[cpu] = true;
+	schedLaneGraphs[cpu] = false;
+}
+
+/*
+ * Removes the graphs of the lane, except the scheduling graphs that are
+ * pinned. These are released by a later call, when they are no longer pinned.
+ */
+void MainWindow::hideSchedLane(unsigned int cpu)
+{
+	bool pinned = false;
+	DEFINE_CPUTASKMAP_ITERATOR(iter);
+
+	for (iter = analyzer->cpuTaskMaps[cpu].begin();
+	     iter != analyzer->cpuTaskMaps[cpu].end();
+	     iter++) {
+		CPUTask &task = iter.value();
+		removeWakeupGraph(&task.horizontalWakeupGraph,
+				  &task.horizontalErrorBars);
+		removeWakeupGraph(&task.verticalWakeupGraph,
+				  &task.verticalErrorBars);
+		removeAccessoryGraph(&task.preemptedGraph);
+		removeAccessoryGraph(&task.runningGraph);
+		removeAccessoryGraph(&task.uninterruptibleGraph);
+		if (task.graph == nullptr)
+			continue;
+		if (schedGraphPinned(task)) {
+			pinned = true;
+		} else {
+			task.graph->destroy();
+			task.graph = nullptr;
+		}
+	}
+	schedLaneShown[cpu] = false;
+	schedLaneGraphs[cpu] = pinned;
+}
+
+void MainWindow::showCpuLane(unsigned int cpu)
+{
+	updateCpuGraphs(cpu);
+	cpuLaneShown[cpu] = true;
+}
+
+void MainWindow::hideCpuLane(unsigned int cpu)
+{
+	if (cpuIdleGraphs[cpu] != nullptr) {
+		tracePlot->removeGraph(cpuIdleGraphs[cpu]);
+		cpuIdleGraphs[cpu] = nullptr;
+	}
+	if (cpuFreqGraphs[cpu] != nullptr) {
+		tracePlot->removeGraph(cpuFreqGraphs[cpu]);
+		cpuFreqGraphs[cpu] = nullptr;
+	}
+	cpuLaneShown[cpu] = false;
+}
+
+/*
+ * The scheduling graph of a task can not be removed when its lane is scrolled
+ * away if it is selected, in the legend or used for the legend of the unified
+ * graph of the task, because those keep pointers to it.
+ */
+bool MainWindow::schedGraphPinned(CPUTask &cpuTask)
+{
+	Task *task;
+
+	if (cpuTask.graph->getQCPGraph()->selected())
+		return true;
+	if (taskToolBar->legendContains(cpuTask.pid))
+		return true;
+	task = analyzer->findTask(cpuTask.pid);
+	return task != nullptr && task->graph != nullptr &&
+		task->graph->getTaskGraphForLegend() == cpuTask.graph;
+}
+
 void MainWindow::addHorizontalWakeupGraph(CPUTask &task)
 {
 	if (!settingStore->getValue(Setting::HORIZONTAL_WAKEUP).boolv())
@@ -909,13 +1242,16 @@ void MainWindow::addHorizontalWakeupGraph(CPUTask &task)
 	graph->setScatterStyle(style);
 	graph->setLineStyle(QCPGraph::lsNone);
 	graph->setAdaptiveSampling(true);
-	graph->setData(task.wakeTimev, task.wakeHeight);
+	graphSetConstantData(graph, task.wakeTimev,
+			     task.getScaledHeight(WAKEUP_HEIGHT));
 	errorBars->setData(task.wakeDelay, task.wakeZero);
 	errorBars->setErrorType(QCPErrorBars::etKeyError);
 	errorBars->setPen(pen);
 	errorBars->setWhiskerWidth(4);
 	errorBars->setDataPlottable(graph);
 	/* errorBars->setSymbolGap(0); */
+	task.horizontalWakeupGraph = graph;
+	task.horizontalErrorBars = errorBars;
 }
 
 void MainWindow::addWakeupGraph(CPUTask &task)
@@ -939,23 +1275,29 @@ void MainWindow::addWakeupGraph(CPUTask &task)
 	graph->setScatterStyle(style);
 	graph->setLineStyle(QCPGraph::lsNone);
 	graph->setAdaptiveSampling(true);
-	graph->setData(task.wakeTimev, task.wakeHeight);
+	graphSetConstantData(graph, task.wakeTimev,
+			     task.getScaledHeight(WAKEUP_HEIGHT));
 	errorBars->setData(task.wakeZero, task.verticalDelay);
 	errorBars->setErrorType(QCPErrorBars::etValueError);
 	errorBars->setPen(pen);
 	errorBars->setWhiskerWidth(4);
 	errorBars->setDataPlottable(graph);
+	task.verticalWakeupGraph = graph;
+	task.verticalErrorBars = errorBars;
 }
 
-void MainWindow::addGenericAccessoryGraph(const QString &name,
+void MainWindow::addGenericAccessoryGraph(QCPGraph **graphPtr,
+					  const QString &name,
 					  const QVector<double> &timev,
-					  const QVector<double> &scaledData,
+					  double height,
 					  QCPScatterStyle::ScatterShape sshape,
 					  double size,
 					  const QColor &color)
 {
-	if (timev.size() == 0)
+	if (timev.size() == 0) {
+		*graphPtr = nullptr;
 		return;
+	}
 	const int lwidth = settingStore->getValue(Setting::LINE_WIDTH).intv();
 	const double adjsize = adjustScatterSize(size, lwidth);
 	/* Add still running graph on top of the other two...*/
@@ -971,37 +1313,41 @@ void MainWindow::addGenericAccessoryGraph(const QString &name,
 	graph->setScatterStyle(style);
 	graph->setLineStyle(QCPGraph::lsNone);
 	graph->setAdaptiveSampling(true);
-	graph->setData(timev, scaledData);
+	graphSetConstantData(graph, timev, height);
+	*graphPtr = graph;
 }
 
 void MainWindow::addPreemptedGraph(CPUTask &task)
 {
-	addGenericAccessoryGraph(PREEMPTED_NAME, task.preemptedTimev,
-				 task.scaledPreemptedData,
+	addGenericAccessoryGraph(&task.preemptedGraph, PREEMPTED_NAME,
+				 task.preemptedTimev,
+				 task.getScaledHeight(FLOOR_HEIGHT),
 				 PREEMPTED_SHAPE, PREEMPTED_SIZE,
 				 PREEMPTED_COLOR);
 }
 
 void MainWindow::addStillRunningGraph(CPUTask &task)
 {
-	addGenericAccessoryGraph(RUNNING_NAME, task.runningTimev,
-				 task.scaledRunningData,
+	addGenericAccessoryGraph(&task.runningGraph, RUNNING_NAME,
+				 task.runningTimev,
+				 task.getScaledHeight(FLOOR_HEIGHT),
 				 RUNNING_SHAPE, RUNNING_SIZE,
 				 RUNNING_COLOR);
 }
 
 void MainWindow::addUninterruptibleGraph(CPUTask &task)
 {
-	addGenericAccessoryGraph(UNINT_NAME,
+	addGenericAccessoryGraph(&task.uninterruptibleGraph, UNINT_NAME,
 				 task.uninterruptibleTimev,
-				 task.scaledUninterruptibleData,
+				 task.getScaledHeight(FLOOR_HEIGHT),
 				 UNINT_SHAPE, UNINT_SIZE,
 				 UNINT_COLOR);
 }
 
 /*
  * These are actions that should be enabled whenever we have a non-empty
- * trace open
+ * trace open. Some of them read the statistics, so this must not be called
+ * before finishProcessing().
  */
 void MainWindow::setTraceActionsEnabled(bool e)
 {
@@ -1018,8 +1364,14 @@ void MainWindow::setTraceActionsEnabled(bool e)
 	filterCPUsAction->setEnabled(e);
 	showEventsAction->setEnabled(e);
 	timeFilterAction->setEnabled(e);
+	argFilterAction->setEnabled(e);
+	findAction->setEnabled(e);
+	findNextAction->setEnabled(e);
+	findPreviousAction->setEnabled(e);
 	showStatsAction->setEnabled(e);
 	showStatsTimeLimitedAction->setEnabled(e);
+	showLatencyAction->setEnabled(e);
+	hideWakeChainAction->setEnabled(e);
 }
 
 void MainWindow::setLegendActionsEnabled(bool e)
@@ -1042,6 +1394,7 @@ void MainWindow::setTaskActionsEnabled(bool e)
 {
 	findWakeupAction->setEnabled(e);
 	findWakingDirectAction->setEnabled(e);
+	showWakeChainAction->setEnabled(e);
 	findSleepAction->setEnabled(e);
 	taskFilterAction->setEnabled(e);
 	taskFilterLimitedAction->setEnabled(e);
@@ -1088,6 +1441,16 @@ void MainWindow::closeTrace()
 	int ts_errno = 0;
 
 	startt = QDateTime::currentDateTimeUtc().toMSecsSinceEpoch();
+
+	/*
+	 * A trace that is still being processed in the background must be
+	 * stopped before we start to tear it down.
+	 */
+	processingTimer->stop();
+	progressDialog->reset();
+	analyzer->abortProcessing();
+	traceShown = false;
+
 	resetFilters();
 
 	eventsWidget->beginResetModel();
@@ -1107,6 +1470,8 @@ void MainWindow::closeTrace()
 	statsLimitedDialog->setTaskMap(nullptr, 0);
 	statsLimitedDialog->endResetModel();
 
+	latencyDialog->clear();
+
 	eventSelectDialog->beginResetModel();
 	eventSelectDialog->setStringTree(nullptr);
 	eventSelectDialog->endResetModel();
@@ -1432,6 +1797,125 @@ void MainWindow::yAxisChanged(QCPRange /*range*/)
 {
 	if (!scrollBarUpdate)
 		configureScrollBar();
+	updateLanes();
+}
+
+void MainWindow::xAxisChanged(QCPRange range)
+{
+	updateSchedLOD(range);
+	if (heatMapPlot != nullptr)
+		heatMapTimer->start();
+}
+
+/*
+ * Replaces the heat map with a more detailed one when the zooming has come to
+ * rest, because it is computed from the scheduling graphs of all tasks.
+ */
+void MainWindow::refineHeatMap()
+{
+	if (heatMapPlot == nullptr || !tracePlot->isVisible())
+		return;
+	if (heatMapPlot->refine(tracePlot->xAxis->range(),
+				tracePlot->xAxis->axisRect()->width())) {
+		tracePlot->invalidateTiles();
+		tracePlot->replot();
+	}
+}
+
+void MainWindow::eventRateRangeSelected(const QCPRange &range)
+{
+	if (!tracePlot->isVisible())
+		return;
+	tracePlot->xAxis->setRange(range);
+	tracePlot->replot();
+}
+
+/*
+ * Shows what the CPU of the lane under the mouse was doing at the time under
+ * the mouse: the running task in a scheduling lane, the frequency and idle
+ * state in a CPU lane.
+ */
+void MainWindow::plotToolTip(const QPoint &pos, const QPoint &globalPos)
+{
+	const TimeQuery *query = analyzer->getTimeQuery();
+	double time = tracePlot->xAxis->pixelToCoord(pos.x());
+	double value = tracePlot->yAxis->pixelToCoord(pos.y());
+	unsigned int cpu;
+	QString text;
+	Task *task;
+	int pid;
+	int state;
+
+	if (!tracePlot->isVisible() || !query->isBuilt()) {
+		QToolTip::hideText();
+		return;
+	}
+
+	for (cpu = 0; cpu < (unsigned) schedLanes.size(); cpu++) {
+		if (value < schedLanes[cpu] ||
+		    value >= schedLanes[cpu] + schedHeight + schedSpacing)
+			continue;
+		pid = query->taskOnCPU(cpu, time);
+		task = pid != TimeQuery::NONE ? analyzer->findTask(pid) :
+			nullptr;
+		if (task != nullptr)
+			text = QString("cpu%1: %2:%3").arg(cpu)
+				.arg(task->getLastName()).arg(pid);
+		else
+			text = QString("cpu%1: idle").arg(cpu);
+	}
+
+	for (cpu = 0; cpu < (unsigned) cpuLanes.size(); cpu++) {
+		if (value < cpuLanes[cpu] ||
+		    value >= cpuLanes[cpu] + cpuHeight + cpuSpacing)
+			continue;
+		text = QString("cpu%1: %2 kHz").arg(cpu)
+			.arg(query->cpuFrequency(cpu, time), 0, 'f', 0);
+		state = query->cpuIdleState(cpu, time);
+		if (state >= 0)
+			text += QString(", idle state %1").arg(state);
+		else if (state == TimeQuery::NOT_IDLE)
+			text += QString(", not idle");
+	}
+
+	if (text.isEmpty())
+		QToolTip::hideText();
+	else
+		QToolTip::showText(globalPos, text, tracePlot);
+}
+
+/*
+ * Switches the scheduling graphs to the level of detail that matches the
+ * visible time range, so that a replot never needs to iterate over many more
+ * points than there are pixels.
+ */
+void MainWindow::updateSchedLOD(const QCPRange &range)
+{
+	unsigned int cpu;
+	double pixelWidth;
+	int pixels;
+
+	/* The graphs may be in the middle of being recreated if not visible */
+	if (!tracePlot->isVisible() || !analyzer->isOpen())
+		return;
+	if (!settingStore->getValue(Setting::SHOW_SCHED_GRAPHS).boolv())
+		return;
+
+	pixels = tracePlot->xAxis->axisRect()->width();
+	if (pixels <= 0)
+		return;
+	pixelWidth = range.size() / pixels;
+
+	for (cpu = 0; cpu <= analyzer->getMaxCPU(); cpu++) {
+		DEFINE_CPUTASKMAP_ITERATOR(iter);
+		for (iter = analyzer->cpuTaskMaps[cpu].begin();
+		     iter != analyzer->cpuTaskMaps[cpu].end();
+		     iter++) {
+			CPUTask &task = iter.value();
+			if (task.graph != nullptr)
+				task.graph->updateLOD(pixelWidth);
+		}
+	}
 }
 
 void MainWindow::plotDoubleClicked(QMouseEvent *event)
@@ -1612,6 +2096,25 @@ void MainWindow::createActions()
 	timeFilterAction->setToolTip(tr(TOOLTIP_TIMEFILTER));
 	tsconnect(timeFilterAction, triggered(), this, timeFilter());
 
+	argFilterAction = new QAction(tr("Filter on &arguments..."), this);
+	argFilterAction->setToolTip(tr(TOOLTIP_ARGFILTER));
+	tsconnect(argFilterAction, triggered(), this, argFilter());
+
+	findAction = new QAction(tr("&Find events..."), this);
+	findAction->setShortcuts(QKeySequence::Find);
+	findAction->setToolTip(tr(TOOLTIP_FIND));
+	tsconnect(findAction, triggered(), this, findEvents());
+
+	findNextAction = new QAction(tr("Find &next"), this);
+	findNextAction->setShortcuts(QKeySequence::FindNext);
+	findNextAction->setToolTip(tr(TOOLTIP_FINDNEXT));
+	tsconnect(findNextAction, triggered(), this, findNext());
+
+	findPreviousAction = new QAction(tr("Find &previous"), this);
+	findPreviousAction->setShortcuts(QKeySequence::FindPrevious);
+	findPreviousAction->setToolTip(tr(TOOLTIP_FINDPREVIOUS));
+	tsconnect(findPreviousAction, triggered(), this, findPrevious());
+
 	graphEnableAction = new QAction(tr("Select &graphs..."), this);
 	graphEnableAction->setIcon(QIcon(RESSRC_GPH_GRAPHENABLE));
 	graphEnableAction->setToolTip(tr(TOOLTIP_GRAPHENABLE));
@@ -1674,6 +2177,10 @@ void MainWindow::createActions()
 	tsconnect(showStatsTimeLimitedAction, triggered(), this,
 		  showStatsTimeLimited());
 
+	showLatencyAction = new QAction(tr("Show wakeup &latency..."), this);
+	showLatencyAction->setToolTip(TOOLTIP_SHOWLATENCY);
+	tsconnect(showLatencyAction, triggered(), this, showLatency());
+
 	exitAction = new QAction(tr("E&xit"), this);
 	exitAction->setShortcuts(QKeySequence::Quit);
 	exitAction->setToolTip(tr(TOOLTIP_EXIT));
@@ -1760,6 +2267,16 @@ void MainWindow::createActions()
 	tsconnect(findWakingDirectAction, triggered(), this,
 		  findWakingDirectTriggered());
 
+	showWakeChainAction = new QAction(tr("Show wa&ke chain"), this);
+	showWakeChainAction->setToolTip(tr(SHOW_WAKE_CHAIN_TOOLTIP));
+	tsconnect(showWakeChainAction, triggered(), this,
+		  showWakeChainTriggered());
+
+	hideWakeChainAction = new QAction(tr("&Hide wake chain"), this);
+	hideWakeChainAction->setToolTip(tr(HIDE_WAKE_CHAIN_TOOLTIP));
+	tsconnect(hideWakeChainAction, triggered(), this,
+		  hideWakeChainTriggered());
+
 	findSleepAction = new QAction(tr("Find sched_switch &sleep event"),
 				      this);
 	findSleepAction->setIcon(QIcon(RESSRC_GPH_FIND_SLEEP));
@@ -1873,10 +2390,15 @@ void MainWindow::createMenus()
 	viewMenu->addAction(filterCPUsAction);
 	viewMenu->addAction(showEventsAction);
 	viewMenu->addAction(timeFilterAction);
+	viewMenu->addAction(argFilterAction);
 	viewMenu->addAction(resetFiltersAction);
+	viewMenu->addAction(findAction);
+	viewMenu->addAction(findNextAction);
+	viewMenu->addAction(findPreviousAction);
 	viewMenu->addAction(graphEnableAction);
 	viewMenu->addAction(showStatsAction);
 	viewMenu->addAction(showStatsTimeLimitedAction);
+	viewMenu->addAction(showLatencyAction);
 
 	taskMenu = menuBar()->addMenu(tr("&Task"));
 	taskMenu->addAction(addToLegendAction);
@@ -1884,6 +2406,8 @@ void MainWindow::createMenus()
 	taskMenu->addAction(findWakeupAction);
 	taskMenu->addAction(findWakingAction);
 	taskMenu->addAction(findWakingDirectAction);
+	taskMenu->addAction(showWakeChainAction);
+	taskMenu->addAction(hideWakeChainAction);
 	taskMenu->addAction(findSleepAction);
 	taskMenu->addAction(addTaskGraphAction);
 	taskMenu->addAction(removeTaskGraphAction);
@@ -1916,6 +2440,7 @@ void MainWindow::createStatusBar()
 	statusStrings[STATUS_NOFILE] = new QString(tr("No file loaded"));
 	statusStrings[STATUS_FILE] = new QString(tr("Loaded file "));
 	statusStrings[STATUS_ERROR] = new QString(tr("An error has occurred"));
+	statusStrings[STATUS_PROCESSING] = new QString(tr("Processing file "));
 
 	setStatus(STATUS_NOFILE);
 }
@@ -1938,10 +2463,30 @@ void MainWindow::createDialogs()
 	statsDialog->setAllowedAreas(Qt::LeftDockWidgetArea);
 	statsLimitedDialog->setAllowedAreas(Qt::RightDockWidgetArea);
 
+	latencyDialog = new LatencyDialog(nullptr);
+	latencyDialog->setAllowedAreas(Qt::RightDockWidgetArea);
+	latencyDialog->setAnalyzer(analyzer);
+
 	eventSelectDialog = new EventSelectDialog();
 	cpuSelectDialog = new CPUSelectDialog();
 	graphEnableDialog = new GraphEnableDialog(settingStore, nullptr);
 
+	/*
+	 * The progress dialog is not modal, so that the user can keep using
+	 * the window while a trace is being processed.
+	 */
+	progressDialog = new QProgressDialog(this);
+	progressDialog->setWindowTitle(tr("Opening trace"));
+	progressDialog->setMinimumDuration(500);
+	progressDialog->setAutoClose(false);
+	progressDialog->setAutoReset(false);
+	progressDialog->reset();
+	processingTimer = new QTimer(this);
+	processingTimer->setInterval(100);
+	heatMapTimer = new QTimer(this);
+	heatMapTimer->setInterval(100);
+	heatMapTimer->setSingleShot(true);
+
 	vtl::set_error_handler(errorDialog);
 }
 
@@ -1959,6 +2504,10 @@ void MainWindow::plotConnections()
 		  legendDoubleClick(QCPLegend*, QCPAbstractLegendItem*));
 	tsconnect(tracePlot, mouseDoubleClick(QMouseEvent*),
 		  this, plotDoubleClicked(QMouseEvent*));
+	tsconnect(eventRateStrip, rangeSelected(const QCPRange &),
+		  this, eventRateRangeSelected(const QCPRange &));
+	tsconnect(tracePlot, toolTipRequested(const QPoint &, const QPoint &),
+		  this, plotToolTip(const QPoint &, const QPoint &));
 }
 
 void MainWindow::widgetConnections()
@@ -2025,6 +2574,12 @@ void MainWindow::dialogConnections()
 	tsconnect(statsLimitedDialog, taskDoubleClicked(int),
 		  this, taskTriggered(int));
 
+	/* the latency dialog */
+	tsconnect(latencyDialog, QDockWidgetNeedsRemoval(QDockWidget*),
+		  this, removeQDockWidget(QDockWidget*));
+	tsconnect(latencyDialog, taskDoubleClicked(int),
+		  this, taskTriggered(int));
+
 	/* the CPU filter dialog */
 	tsconnect(cpuSelectDialog, createFilter(QMap<unsigned, unsigned> &,
 						bool),
@@ -2040,6 +2595,11 @@ void MainWindow::dialogConnections()
 	/* graph enable dialog */
 	tsconnect(graphEnableDialog, settingsChanged(),
 		  this, consumeSettings());
+
+	/* the progress of the trace processing */
+	tsconnect(processingTimer, timeout(), this, processingTimeout());
+	tsconnect(heatMapTimer, timeout(), this, refineHeatMap());
+	tsconnect(progressDialog, canceled(), this, cancelProcessing());
 }
 
 void MainWindow::setStatus(status_t status, const QString *fileName)
@@ -2138,7 +2698,7 @@ void MainWindow::addTaskToLegend(int pid)
 	unsigned int cpu;
 
 	/*
-	 * Let's find a per CPU taskGraph, because they are always created,
+	 * Let's find a per CPU taskGraph, because they can always be created,
 	 * the unified graphs only exist for those that have been chosen to be
 	 * displayed by the user
 	 */
@@ -2151,7 +2711,7 @@ void MainWindow::addTaskToLegend(int pid)
 	if (cpuTask == nullptr)
 		return;
 
-	taskToolBar->addTaskGraphToLegend(cpuTask->graph);
+	taskToolBar->addTaskGraphToLegend(cpuTaskGraph(cpuTask, cpu));
 }
 
 void MainWindow::setEventsWidgetEvents()
@@ -2210,6 +2770,65 @@ void MainWindow::timeFilter(void)
 	updateResetFiltersEnabled();
 }
 
+void MainWindow::argFilter(void)
+{
+	QString expr;
+	QString errmsg;
+	bool ok;
+	vtl::Time saved;
+
+	expr = QInputDialog::getText(this, tr("Filter on arguments"),
+				     tr("Expression:"), QLineEdit::Normal,
+				     argFilterExpr, &ok);
+	if (!ok)
+		return;
+
+	saved = eventsWidget->getSavedScroll();
+	eventsWidget->beginResetModel();
+	ok = analyzer->createArgFilter(expr, false, &errmsg);
+	setEventsWidgetEvents();
+	eventsWidget->endResetModel();
+	scrollTo(saved);
+	updateResetFiltersEnabled();
+
+	if (!ok) {
+		vtl::warnx("Invalid filter expression: %s",
+			   errmsg.toLocal8Bit().data());
+		return;
+	}
+	argFilterExpr = expr;
+}
+
+void MainWindow::findEvents()
+{
+	QString text;
+	QString errmsg;
+	bool ok;
+
+	text = QInputDialog::getText(this, tr("Find events"),
+				     tr("Text or /regular expression/:"),
+				     QLineEdit::Normal, findText, &ok);
+	if (!ok)
+		return;
+
+	eventsWidget->show();
+	if (!eventsWidget->startSearch(text, &errmsg)) {
+		vtl::warnx("Invalid search: %s", errmsg.toLocal8Bit().data());
+		return;
+	}
+	findText = text;
+}
+
+void MainWindow::findNext()
+{
+	eventsWidget->findNext();
+}
+
+void MainWindow::findPrevious()
+{
+	eventsWidget->findPrevious();
+}
+
 void MainWindow::createEventCPUFilter(const TraceEvent &event)
 {
 	eventCPUMap.clear();
@@ -2324,6 +2943,9 @@ void MainWindow::resetFilters()
 {
 	vtl::Time saved;
 
+	/* Also when closing, so that the next trace doesn't get the old one */
+	argFilterExpr.clear();
+
 	if (!analyzer->isFiltered())
 		return;
 
@@ -2397,7 +3019,49 @@ void MainWindow::exportEventsTriggered()
 	exportEvents(TraceAnalyzer::EXPORT_TYPE_ALL);
 }
 
+/*
+ * Only a change of the OpenGL or the scheduling graph setting requires the
+ * whole plot to be rebuilt. The other settings are applied only to the
+ * plottables that they affect.
+ */
 void MainWindow::consumeSettings()
+{
+	setupMapCache();
+	setupTileCache();
+
+	/* If the trace is still processed, then it will use the new settings */
+	if (!analyzer->isOpen() || !traceShown) {
+		setupOpenGL();
+		graphEnableDialog->checkConsumption();
+		return;
+	}
+
+	if (settingChanged(Setting::OPENGL_ENABLED) ||
+	    settingChanged(Setting::SHOW_SCHED_GRAPHS))
+		rebuildPlot();
+	else
+		updatePlot();
+
+	savePlotSettings();
+	graphEnableDialog->checkConsumption();
+}
+
+/* Saves the settings that the plot currently reflects */
+void MainWindow::savePlotSettings()
+{
+	int i;
+
+	for (i = 0; i < Setting::NR_SETTINGS; i++)
+		plotSettings[i] = settingStore->getValue((enum Setting::Index)
+							 i);
+}
+
+bool MainWindow::settingChanged(enum Setting::Index idx) const
+{
+	return settingStore->getValue(idx) != plotSettings[idx];
+}
+
+void MainWindow::rebuildPlot()
 {
 	unsigned int cpu;
 	QList<int> taskGraphs;
@@ -2410,12 +3074,6 @@ void MainWindow::consumeSettings()
 	TaskGraph *selected_graph;
 	enum TaskGraph::GraphType graph_type;
 
-	if (!analyzer->isOpen()) {
-		setupOpenGL();
-		graphEnableDialog->checkConsumption();
-		return;
-	}
-
 	/* Save the PIDs of the tasks that have a task graph */
 	taskGraphs = taskRangeAllocator->getPidList();
 
@@ -2456,6 +3114,13 @@ void MainWindow::consumeSettings()
 			CPUTask &task = iter.value();
 			delete task.graph;
 			task.graph = nullptr;
+			task.horizontalWakeupGraph = nullptr;
+			task.horizontalErrorBars = nullptr;
+			task.verticalWakeupGraph = nullptr;
+			task.verticalErrorBars = nullptr;
+			task.preemptedGraph = nullptr;
+			task.runningGraph = nullptr;
+			task.uninterruptibleGraph = nullptr;
 		}
 	}
 
@@ -2474,6 +3139,7 @@ void MainWindow::consumeSettings()
 			delete task->graph;
 			task->graph = nullptr;
 			task->wakeUpGraph = nullptr;
+			task->wakeUpErrorBars = nullptr;
 			task->runningGraph = nullptr;
 			task->preemptedGraph = nullptr;
 			task->uninterruptibleGraph = nullptr;
@@ -2487,6 +3153,7 @@ void MainWindow::consumeSettings()
 	tracePlot->show();
 
 	tracePlot->xAxis->setRange(savedRangeX);
+	updateSchedLOD(savedRangeX);
 	/* Restore the task graphs from the list */
 	QList<int>::const_iterator j;
 	for (j = taskGraphs.begin(); j != taskGraphs.end(); j++)
@@ -2511,7 +3178,357 @@ void MainWindow::consumeSettings()
 		updateAddToLegendAction();
 		updateTaskGraphActions();
 	}
-	graphEnableDialog->checkConsumption();
+}
+
+void MainWindow::updatePlot()
+{
+	unsigned int cpu;
+	QList<int> taskGraphs;
+	MigrationPlot *migrationPlot;
+	const bool showSched = settingStore->getValue(
+		Setting::SHOW_SCHED_GRAPHS).boolv();
+	const bool horizontal = settingStore->getValue(
+		Setting::HORIZONTAL_WAKEUP).boolv();
+	const bool vertical = settingStore->getValue(
+		Setting::VERTICAL_WAKEUP).boolv();
+	const bool horizontalChanged = showSched &&
+		settingChanged(Setting::HORIZONTAL_WAKEUP);
+	const bool verticalChanged = showSched &&
+		settingChanged(Setting::VERTICAL_WAKEUP);
+	const bool wakeupMaxChanged = showSched &&
+		settingChanged(Setting::MAX_VRT_WAKEUP_LATENCY);
+	const bool lineWidthChanged = settingChanged(Setting::LINE_WIDTH);
+	const int lwidth = settingStore->getValue(Setting::LINE_WIDTH).intv();
+	bool laneShown;
+
+	if (settingChanged(Setting::SHOW_MIGRATION_GRAPHS) ||
+	    settingChanged(Setting::SHOW_HEATMAP) ||
+	    settingChanged(Setting::SHOW_CPUFREQ_GRAPHS) ||
+	    settingChanged(Setting::SHOW_CPUIDLE_GRAPHS)) {
+		relayoutPlot();
+	} else if (settingChanged(Setting::MIGRATION_WIDTH)) {
+		migrationPlot = analyzer->getMigrationPlot();
+		if (migrationPlot != nullptr)
+			migrationPlot->setWidth(settingStore->getValue(
+					Setting::MIGRATION_WIDTH).intv());
+	}
+
+	if (settingChanged(Setting::IDLE_LINE_WIDTH) ||
+	    settingChanged(Setting::FREQ_LINE_WIDTH))
+		restyleCpuGraphs();
+
+	if (wakeupMaxChanged) {
+		CPUTask::setVerticalWakeupMAX(settingStore->getValue(
+			Setting::MAX_VRT_WAKEUP_LATENCY).intv());
+		analyzer->doScaleWakeup();
+	}
+
+	if (!horizontalChanged && !verticalChanged && !wakeupMaxChanged &&
+	    !lineWidthChanged)
+		goto out;
+
+	for (cpu = 0; cpu <= analyzer->getMaxCPU(); cpu++) {
+		/* The graphs of the other lanes are created when scrolled to */
+		laneShown = schedLaneShown[cpu];
+		DEFINE_CPUTASKMAP_ITERATOR(iter);
+		for (iter = analyzer->cpuTaskMaps[cpu].begin();
+		     iter != analyzer->cpuTaskMaps[cpu].end();
+		     iter++) {
+			CPUTask &task = iter.value();
+			if (horizontalChanged) {
+				if (horizontal && laneShown)
+					addHorizontalWakeupGraph(task);
+				else
+					removeWakeupGraph(
+						&task.horizontalWakeupGraph,
+						&task.horizontalErrorBars);
+			}
+			if (verticalChanged) {
+				if (vertical && laneShown)
+					addWakeupGraph(task);
+				else
+					removeWakeupGraph(
+						&task.verticalWakeupGraph,
+						&task.verticalErrorBars);
+			} else if (wakeupMaxChanged &&
+				   task.verticalErrorBars != nullptr) {
+				task.verticalErrorBars->setData(
+					task.wakeZero, task.verticalDelay);
+			}
+			if (lineWidthChanged)
+				restyleSchedGraphs(task, lwidth);
+		}
+	}
+
+	if (lineWidthChanged) {
+		taskGraphs = taskRangeAllocator->getPidList();
+		QList<int>::const_iterator j;
+		for (j = taskGraphs.begin(); j != taskGraphs.end(); j++) {
+			Task *task = analyzer->findTask(*j);
+			if (task != nullptr)
+				restyleTaskGraphs(task, lwidth);
+		}
+	}
+
+out:
+	tracePlot->invalidateTiles();
+	tracePlot->replot();
+}
+
+/*
+ * Moves the sections of the plot to the offsets of a new layout. The graphs
+ * share their data with the analyzer, so they are moved by only giving them
+ * new offsets. The migration graph is recreated because its lanes also
+ * change.
+ */
+void MainWindow::relayoutPlot()
+{
+	unsigned int cpu;
+	const bool showSched = settingStore->getValue(
+		Setting::SHOW_SCHED_GRAPHS).boolv();
+
+	removeMigrationGraph();
+	computeLayout();
+	if (!taskRangeAllocator->isEmpty())
+		bottom = taskRangeAllocator->getBottom();
+
+	tracePlot->yAxis->setTicks(false);
+	yaxisTicker->setTickVector(ticks);
+	yaxisTicker->setTickVectorLabels(tickLabels);
+	tracePlot->yAxis->setTicks(true);
+
+	analyzer->doRelayout();
+	updateHeatMap();
+
+	for (cpu = 0; cpu <= analyzer->getMaxCPU(); cpu++) {
+		if (cpuLaneShown[cpu])
+			updateCpuGraphs(cpu);
+		if (!showSched)
+			continue;
+		DEFINE_CPUTASKMAP_ITERATOR(iter);
+		for (iter = analyzer->cpuTaskMaps[cpu].begin();
+		     iter != analyzer->cpuTaskMaps[cpu].end();
+		     iter++)
+			moveSchedGraphs(iter.value());
+	}
+
+	updateLanes();
+	updateSchedLOD(tracePlot->xAxis->range());
+	updateWakeChain();
+}
+
+/* Adds, removes or moves the heat map according to the layout */
+void MainWindow::updateHeatMap()
+{
+	if (!settingStore->getValue(Setting::SHOW_HEATMAP).boolv()) {
+		if (heatMapPlot != nullptr) {
+			tracePlot->removePlottable(heatMapPlot);
+			heatMapPlot = nullptr;
+		}
+		return;
+	}
+
+	if (heatMapPlot == nullptr) {
+		heatMapPlot = new HeatMapPlot(tracePlot->xAxis,
+					      tracePlot->yAxis,
+					      utilizationMap);
+		heatMapPlot->setGeometry(heatMapOffset, heatMapRowHeight);
+		heatMapPlot->computeOverview(startTime, endTime);
+		heatMapTimer->start();
+	} else {
+		heatMapPlot->setGeometry(heatMapOffset, heatMapRowHeight);
+	}
+}
+
+void MainWindow::removeMigrationGraph()
+{
+	QVector<MigrationLine*>::const_iterator iter;
+	MigrationPlot *migrationPlot = analyzer->getMigrationPlot();
+
+	for (iter = migrationLines.begin(); iter != migrationLines.end();
+	     iter++)
+		tracePlot->removeItem(*iter);
+	migrationLines.resize(0);
+
+	if (migrationPlot != nullptr)
+		tracePlot->removePlottable(migrationPlot);
+}
+
+/* Adds, removes or moves the cpuidle and cpufreq graphs of cpu */
+void MainWindow::updateCpuGraphs(unsigned int cpu)
+{
+	const CpuIdle &idle = analyzer->cpuIdle[cpu];
+	const CpuFreq &freq = analyzer->cpuFreq[cpu];
+
+	if (settingStore->getValue(Setting::SHOW_CPUIDLE_GRAPHS).boolv()) {
+		if (cpuIdleGraphs[cpu] == nullptr)
+			addCpuIdleGraph(cpu);
+		else
+			graphSetScaledData(cpuIdleGraphs[cpu], idle.timev,
+					   idle.data, idle.scale,
+					   idle.offset);
+	} else if (cpuIdleGraphs[cpu] != nullptr) {
+		tracePlot->removeGraph(cpuIdleGraphs[cpu]);
+		cpuIdleGraphs[cpu] = nullptr;
+	}
+
+	if (settingStore->getValue(Setting::SHOW_CPUFREQ_GRAPHS).boolv()) {
+		if (cpuFreqGraphs[cpu] == nullptr)
+			addCpuFreqGraph(cpu);
+		else
+			graphSetScaledData(cpuFreqGraphs[cpu], freq.timev,
+					   freq.data, freq.scale,
+					   freq.offset);
+	} else if (cpuFreqGraphs[cpu] != nullptr) {
+		tracePlot->removeGraph(cpuFreqGraphs[cpu]);
+		cpuFreqGraphs[cpu] = nullptr;
+	}
+}
+
+/* Moves the scheduling graph of task and its accessory graphs */
+void MainWindow::moveSchedGraphs(CPUTask &task)
+{
+	QCPGraph *qcpGraph;
+	const double wakeHeight = task.getScaledHeight(WAKEUP_HEIGHT);
+	const double floorHeight = task.getScaledHeight(FLOOR_HEIGHT);
+
+	if (task.graph != nullptr) {
+		qcpGraph = task.graph->getQCPGraph();
+		bool selected = qcpGraph->selected();
+		task.graph->setSchedLOD(&task);
+		if (selected)
+			selectQCPGraph(qcpGraph);
+	}
+	if (task.horizontalWakeupGraph != nullptr)
+		graphSetConstantData(task.horizontalWakeupGraph,
+				     task.wakeTimev, wakeHeight);
+	if (task.verticalWakeupGraph != nullptr)
+		graphSetConstantData(task.verticalWakeupGraph,
+				     task.wakeTimev, wakeHeight);
+	if (task.preemptedGraph != nullptr)
+		graphSetConstantData(task.preemptedGraph,
+				     task.preemptedTimev, floorHeight);
+	if (task.runningGraph != nullptr)
+		graphSetConstantData(task.runningGraph,
+				     task.runningTimev, floorHeight);
+	if (task.uninterruptibleGraph != nullptr)
+		graphSetConstantData(task.uninterruptibleGraph,
+				     task.uninterruptibleTimev, floorHeight);
+}
+
+void MainWindow::removeAccessoryGraph(QCPGraph **graphPtr)
+{
+	if (*graphPtr != nullptr) {
+		tracePlot->removeGraph(*graphPtr);
+		*graphPtr = nullptr;
+	}
+}
+
+void MainWindow::removeWakeupGraph(QCPGraph **graphPtr,
+				   QCPErrorBars **errorBarsPtr)
+{
+	if (*errorBarsPtr != nullptr) {
+		tracePlot->removePlottable(*errorBarsPtr);
+		*errorBarsPtr = nullptr;
+	}
+	if (*graphPtr != nullptr) {
+		tracePlot->removeGraph(*graphPtr);
+		*graphPtr = nullptr;
+	}
+}
+
+void MainWindow::restyleCpuGraphs()
+{
+	unsigned int cpu;
+	QCPGraph *graph;
+	QPen pen;
+	const int iwidth = settingStore->getValue(Setting::IDLE_LINE_WIDTH)
+		.intv();
+	const int fwidth = settingStore->getValue(Setting::FREQ_LINE_WIDTH)
+		.intv();
+
+	for (cpu = 0; cpu < (unsigned) cpuIdleGraphs.size(); cpu++) {
+		graph = cpuIdleGraphs[cpu];
+		if (graph == nullptr)
+			continue;
+		restyleAccessoryGraph(graph, CPUIDLE_SIZE, iwidth);
+		pen = graph->pen();
+		pen.setWidth(iwidth);
+		graph->setPen(pen);
+	}
+
+	for (cpu = 0; cpu < (unsigned) cpuFreqGraphs.size(); cpu++) {
+		graph = cpuFreqGraphs[cpu];
+		if (graph == nullptr)
+			continue;
+		pen = graph->pen();
+		pen.setWidth(fwidth);
+		graph->setPen(pen);
+	}
+}
+
+void MainWindow::restyleSchedGraphs(CPUTask &task, int lwidth)
+{
+	QPen pen;
+
+	if (task.graph != nullptr) {
+		pen = task.graph->getQCPGraph()->pen();
+		pen.setWidth(lwidth);
+		task.graph->setPen(pen);
+	}
+	restyleWakeupGraph(task.horizontalWakeupGraph,
+			   task.horizontalErrorBars, lwidth);
+	restyleWakeupGraph(task.verticalWakeupGraph, task.verticalErrorBars,
+			   lwidth);
+	restyleAccessoryGraph(task.preemptedGraph, PREEMPTED_SIZE, lwidth);
+	restyleAccessoryGraph(task.runningGraph, RUNNING_SIZE, lwidth);
+	restyleAccessoryGraph(task.uninterruptibleGraph, UNINT_SIZE, lwidth);
+}
+
+void MainWindow::restyleTaskGraphs(Task *task, int lwidth)
+{
+	QPen pen;
+
+	if (task->graph != nullptr) {
+		pen = task->graph->getQCPGraph()->pen();
+		pen.setWidth(lwidth);
+		task->graph->setPen(pen);
+	}
+	restyleWakeupGraph(task->wakeUpGraph, task->wakeUpErrorBars, lwidth);
+	restyleAccessoryGraph(task->preemptedGraph, PREEMPTED_SIZE, lwidth);
+	restyleAccessoryGraph(task->runningGraph, RUNNING_SIZE, lwidth);
+	restyleAccessoryGraph(task->uninterruptibleGraph, UNINT_SIZE, lwidth);
+}
+
+void MainWindow::restyleWakeupGraph(QCPGraph *graph, QCPErrorBars *errorBars,
+				    int lwidth)
+{
+	if (graph == nullptr)
+		return;
+
+	QCPScatterStyle style = graph->scatterStyle();
+	QPen pen = style.pen();
+
+	pen.setWidth(lwidth);
+	style.setPen(pen);
+	graph->setScatterStyle(style);
+	if (errorBars != nullptr)
+		errorBars->setPen(pen);
+}
+
+void MainWindow::restyleAccessoryGraph(QCPGraph *graph, double size,
+				       int lwidth)
+{
+	if (graph == nullptr)
+		return;
+
+	QCPScatterStyle style = graph->scatterStyle();
+	QPen pen = style.pen();
+
+	pen.setWidth(lwidth);
+	style.setPen(pen);
+	style.setSize(adjustScatterSize(size, lwidth));
+	graph->setScatterStyle(style);
 }
 
 void MainWindow::addTaskGraph(int pid)
@@ -2541,7 +3558,7 @@ void MainWindow::addTaskGraph(int pid)
 		if (cpuTask != nullptr)
 			break;
 	}
-	if (cpuTask == nullptr || cpuTask->graph == nullptr) {
+	if (cpuTask == nullptr || cpuTaskGraph(cpuTask, cpu) == nullptr) {
 		taskRangeAllocator->putTaskRange(taskRange);
 		return;
 	}
@@ -2559,13 +3576,9 @@ void MainWindow::addTaskGraph(int pid)
 
 	task->offset = taskRange->lower;
 	task->scale = schedHeight;
-	task->doScale();
 	task->doScaleWakeup();
-	task->doScaleRunning();
-	task->doScalePreempted();
-	task->doScaleUnint();
 
-	taskGraph->setData(task->schedTimev, task->scaledSchedData);
+	taskGraph->setSchedData(task);
 	task->graph = taskGraph;
 
 	/* Add the horizontal wakeup graph as well */
@@ -2579,13 +3592,15 @@ void MainWindow::addTaskGraph(int pid)
 	graph->setScatterStyle(style);
 	graph->setLineStyle(QCPGraph::lsNone);
 	graph->setAdaptiveSampling(true);
-	graph->setData(task->wakeTimev, task->wakeHeight);
+	graphSetConstantData(graph, task->wakeTimev,
+			     task->getScaledHeight(WAKEUP_HEIGHT));
 	errorBars->setData(task->wakeDelay, task->wakeZero);
 	errorBars->setErrorType(QCPErrorBars::etKeyError);
 	errorBars->setPen(pen);
 	errorBars->setWhiskerWidth(4);
 	errorBars->setDataPlottable(graph);
 	task->wakeUpGraph = graph;
+	task->wakeUpErrorBars = errorBars;
 
 	addStillRunningTaskGraph(task);
 	addPreemptedTaskGraph(task);
@@ -2614,7 +3629,7 @@ void MainWindow::doLegendCheck()
 void MainWindow::addAccessoryTaskGraph(QCPGraph **graphPtr,
 				       const QString &name,
 				       const QVector<double> &timev,
-				       const QVector<double> &scaledData,
+				       double height,
 				       QCPScatterStyle::ScatterShape sshape,
 				       double size,
 				       const QColor &color)
@@ -2637,21 +3652,23 @@ void MainWindow::addAccessoryTaskGraph(QCPGraph **graphPtr,
 	graph->setScatterStyle(style);
 	graph->setLineStyle(QCPGraph::lsNone);
 	graph->setAdaptiveSampling(true);
-	graph->setData(timev, scaledData);
+	graphSetConstantData(graph, timev, height);
 	*graphPtr = graph;
 }
 
 void MainWindow::addStillRunningTaskGraph(Task *task)
 {
 	addAccessoryTaskGraph(&task->runningGraph, RUNNING_NAME,
-			      task->runningTimev, task->scaledRunningData,
+			      task->runningTimev,
+			      task->getScaledHeight(FLOOR_HEIGHT),
 			      RUNNING_SHAPE, RUNNING_SIZE, RUNNING_COLOR);
 }
 
 void MainWindow::addPreemptedTaskGraph(Task *task)
 {
 	addAccessoryTaskGraph(&task->preemptedGraph, PREEMPTED_NAME,
-			      task->preemptedTimev, task->scaledPreemptedData,
+			      task->preemptedTimev,
+			      task->getScaledHeight(FLOOR_HEIGHT),
 			      PREEMPTED_SHAPE, PREEMPTED_SIZE, PREEMPTED_COLOR);
 }
 
@@ -2659,7 +3676,7 @@ void MainWindow::addUninterruptibleTaskGraph(Task *task)
 {
 	addAccessoryTaskGraph(&task->uninterruptibleGraph, UNINT_NAME,
 			      task->uninterruptibleTimev,
-			      task->scaledUninterruptibleData,
+			      task->getScaledHeight(FLOOR_HEIGHT),
 			      UNINT_SHAPE, UNINT_SIZE, UNINT_COLOR);
 }
 
@@ -2683,6 +3700,11 @@ void MainWindow::removeTaskGraph(int pid)
 		task->graph = nullptr;
 	}
 
+	if (task->wakeUpErrorBars != nullptr) {
+		tracePlot->removePlottable(task->wakeUpErrorBars);
+		task->wakeUpErrorBars = nullptr;
+	}
+
 	if (task->wakeUpGraph != nullptr) {
 		tracePlot->removeGraph(task->wakeUpGraph);
 		task->wakeUpGraph = nullptr;
@@ -2740,6 +3762,11 @@ void MainWindow::clearTaskGraphsTriggered()
 		task->graph->destroy();
 		task->graph = nullptr;
 
+		if (task->wakeUpErrorBars != nullptr) {
+			tracePlot->removePlottable(task->wakeUpErrorBars);
+			task->wakeUpErrorBars = nullptr;
+		}
+
 		if (task->wakeUpGraph != nullptr) {
 			tracePlot->removeGraph(task->wakeUpGraph);
 			task->wakeUpGraph = nullptr;
@@ -2887,6 +3914,17 @@ void MainWindow::showStatsTimeLimited()
 		addDockWidget(Qt::RightDockWidgetArea, statsLimitedDialog);
 }
 
+void MainWindow::showLatency()
+{
+	if (latencyDialog->isVisible()) {
+		latencyDialog->hide();
+		return;
+	}
+	latencyDialog->show();
+	if (dockWidgetArea(latencyDialog) == Qt::NoDockWidgetArea)
+		addDockWidget(Qt::RightDockWidgetArea, latencyDialog);
+}
+
 void MainWindow::removeQDockWidget(QDockWidget *widget)
 {
 	if (dockWidgetArea(widget) != Qt::NoDockWidgetArea)
@@ -3014,7 +4052,7 @@ void MainWindow::showWaking(const TraceEvent *wakeupevent)
 
 void MainWindow::checkStatsTimeLimited()
 {
-	if (statsLimitedDialog->isVisible()) {
+	if (statsLimitedDialog->isVisible() && analyzer->statsReady()) {
 		statsLimitedDialog->beginResetModel();
 		analyzer->doLimitedStats();
 		statsLimitedDialog->setTaskMap(&analyzer->taskMap,
@@ -3051,6 +4089,7 @@ void MainWindow::selectTaskByPid(int pid, const unsigned int *preferred_cpu,
 	unsigned int cpu;
 	int maxSize;
 	CPUTask *maxTask;
+	unsigned int maxCPU;
 
 	/* Deselect the selected task */
 	tracePlot->deselectAll();
@@ -3091,21 +4130,25 @@ do_cpugraph:
 	if (preferred_cpu == nullptr) {
 		maxTask = nullptr;
 		maxSize = -1;
+		maxCPU = 0;
 		for (cpu = 0; cpu < analyzer->getNrCPUs(); cpu++) {
 			cpuTask = analyzer->findCPUTask(pid, cpu);
 			if (cpuTask != nullptr) {
 				if (cpuTask->schedTimev.size() > maxSize) {
 					maxSize = cpuTask->schedTimev.size();
 					maxTask = cpuTask;
+					maxCPU = cpu;
 				}
 			}
 		}
 		cpuTask = maxTask;
+		cpu = maxCPU;
 	} else {
 		cpuTask = analyzer->findCPUTask(pid, *preferred_cpu);
+		cpu = *preferred_cpu;
 	}
 	/* If we can't find what we expected we warn the user */
-	if (cpuTask == nullptr || cpuTask->graph == nullptr) {
+	if (cpuTask == nullptr || cpuTaskGraph(cpuTask, cpu) == nullptr) {
 		oops_warnx();
 		goto out;
 	}
@@ -3165,6 +4208,34 @@ void MainWindow::setupOpenGL()
 	settingStore->setBoolValue(Setting::OPENGL_ENABLED, isOpenGLEnabled());
 }
 
+/*
+ * Sets how much memory of closed traces that is kept for the next trace and how
+ * the memory of new traces is backed.
+ */
+void MainWindow::setupMapCache()
+{
+	size_t mbytes = settingStore->getValue(Setting::MAP_CACHE_SIZE).intv();
+	unsigned int flags = vtl::MapCache::FLAG_NONE;
+
+	if (settingStore->getValue(Setting::TRANSPARENT_HUGE_PAGES).boolv())
+		flags |= vtl::MapCache::FLAG_TRANSPARENT_HUGE;
+	if (settingStore->getValue(Setting::EXPLICIT_HUGE_PAGES).boolv())
+		flags |= vtl::MapCache::FLAG_EXPLICIT_HUGE;
+	if (settingStore->getValue(Setting::NUMA_INTERLEAVE).boolv())
+		flags |= vtl::MapCache::FLAG_NUMA_INTERLEAVE;
+
+	vtl::MapCache::setMaxSize(mbytes * 1024 * 1024);
+	vtl::MapCache::setFlags(flags);
+}
+
+/* Sets how much memory that is used for caching the rendered plot */
+void MainWindow::setupTileCache()
+{
+	qint64 mbytes = settingStore->getValue(Setting::TILE_CACHE_SIZE).intv();
+
+	tracePlot->setTileCacheSize(mbytes * 1024 * 1024);
+}
+
 /* Adds the currently selected task to the legend */
 void MainWindow::addToLegendTriggered()
 {
@@ -3201,6 +4272,115 @@ void MainWindow::findWakingDirectTriggered()
 	showWakeupOrWaking(taskToolBar->getPid(), SCHED_WAKING);
 }
 
+/*
+ * Computes the critical path of the selected task at the active cursor and
+ * highlights it. The visible range is extended to the start of the path.
+ */
+void MainWindow::showWakeChainTriggered()
+{
+	const WakeChain *chain = analyzer->getWakeChain();
+	int activeIdx = infoWidget->getCursorIdx();
+	int pid = taskToolBar->getPid();
+	QCPRange range = tracePlot->xAxis->range();
+	double time;
+	double start;
+
+	if (pid == 0 || !chain->isBuilt())
+		return;
+	if (activeIdx != TShark::RED_CURSOR &&
+	    activeIdx != TShark::BLUE_CURSOR) {
+		return;
+	}
+	if (cursors[activeIdx] == nullptr)
+		return;
+
+	time = cursors[activeIdx]->getPosition();
+	chain->criticalPath(pid, time, wakeChainPath);
+	if (!updateWakeChain())
+		vtl::warnx("Parts of the wake chain are on CPUs that are not "
+			   "shown");
+	if (wakeChainPath.isEmpty()) {
+		tracePlot->replot();
+		return;
+	}
+
+	start = wakeChainPath.last().start;
+	if (start < range.lower || time > range.upper) {
+		range.lower = TSMIN(range.lower, start - range.size() / 20);
+		range.upper = TSMAX(range.upper, time + range.size() / 20);
+		tracePlot->xAxis->setRange(range);
+	}
+	tracePlot->replot();
+}
+
+void MainWindow::hideWakeChainTriggered()
+{
+	wakeChainPath.clear();
+	updateWakeChain();
+	tracePlot->replot();
+}
+
+/*
+ * Draws wakeChainPath, with each part of a step on the scheduling graph of the
+ * CPU where it ran. The parts on CPUs without a scheduling graph, e.g. because
+ * the scheduling graphs are not shown, are left out and a gap is left in the
+ * line. Returns false if some part was left out.
+ */
+bool MainWindow::updateWakeChain()
+{
+	QCPLayer *layer = tracePlot->currentLayer();
+	QPen pen = QPen();
+	QVector<double> keys;
+	QVector<double> values;
+	const WakeLink *link;
+	double y, end;
+	bool complete = true;
+	bool gap = false;
+	int i;
+
+	if (wakeChainCurve != nullptr) {
+		tracePlot->removePlottable(wakeChainCurve);
+		wakeChainCurve = nullptr;
+	}
+
+	for (i = 0; i < wakeChainPath.size(); i++) {
+		const WakeHop &hop = wakeChainPath[i];
+		end = hop.end;
+		for (link = hop.last; link >= hop.link; link--) {
+			if (link->cpu >= (unsigned) schedLanes.size()) {
+				complete = false;
+				gap = !keys.isEmpty();
+				end = link->schedTime;
+				continue;
+			}
+			/* A NaN point breaks the curve */
+			if (gap) {
+				keys.append(qQNaN());
+				values.append(qQNaN());
+				gap = false;
+			}
+			y = schedLanes[link->cpu] + SCHED_HEIGHT * schedHeight;
+			keys.append(end);
+			values.append(y);
+			keys.append(link->schedTime);
+			values.append(y);
+			end = link->schedTime;
+		}
+	}
+	if (keys.isEmpty())
+		return complete;
+
+	tracePlot->setCurrentLayer(cursorLayer);
+	wakeChainCurve = new QCPCurve(tracePlot->xAxis, tracePlot->yAxis);
+	tracePlot->setCurrentLayer(layer);
+	wakeChainCurve->setSelectable(QCP::stNone);
+	pen.setColor(Qt::magenta);
+	pen.setWidth(settingStore->getValue(Setting::LINE_WIDTH).intv() + 2);
+	wakeChainCurve->setPen(pen);
+	wakeChainCurve->setData(keys, values);
+	return complete;
+}
+
 /* Finds the next sched_switch event that puts the task to sleep */
 void MainWindow::findSleepTriggered()
 {
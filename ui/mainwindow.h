@@ -91,7 +91,9 @@ class QLabel;
 class QMenu;
 class QPlainTextEdit;
 class QMouseEvent;
+class QProgressDialog;
 class QScrollBar;
+class QTimer;
 class QToolBar;
 class QVBoxLayhout;
 QT_END_NAMESPACE
@@ -104,8 +106,12 @@ class CPUTask;
 class ErrorDialog;
 class GraphEnableDialog;
 class LicenseDialog;
+class MigrationLine;
 class EventInfoDialog;
+class EventRateStrip;
 class QCPAbstractPlottable;
+class QCPErrorBars;
+class QCPCurve;
 class QCPGraph;
 class QCPLayer;
 class QCPLegend;
@@ -118,8 +124,11 @@ class TraceEvent;
 class TaskRangeAllocator;
 class TaskSelectDialog;
 class EventSelectDialog;
+class HeatMapPlot;
+class LatencyDialog;
 class CPUSelectDialog;
 class YAxisTicker;
+class UtilizationMap;
 
 class MainWindow : public QMainWindow
 {
@@ -146,6 +155,10 @@ private slots:
 	void configureScrollBar();
 	void scrollBarChanged(int value);
 	void yAxisChanged(QCPRange range);
+	void xAxisChanged(QCPRange range);
+	void refineHeatMap();
+	void eventRateRangeSelected(const QCPRange &range);
+	void plotToolTip(const QPoint &pos, const QPoint &globalPos);
 	void plotDoubleClicked(QMouseEvent *event);
 	void infoValueChanged(vtl::Time value, int nr);
 	void moveActiveCursor(vtl::Time time);
@@ -183,12 +196,19 @@ private slots:
 	void resetEventFilter();
 	void resetFilters();
 	void timeFilter();
+	void argFilter();
+	void findEvents();
+	void findNext();
+	void findPrevious();
 	void exportEvents(TraceAnalyzer::exporttype_t export_type);
 	void exportEventsTriggered();
 	void exportCPUTriggered();
 	void consumeSettings();
+	void processingTimeout();
+	void cancelProcessing();
 	void showStats();
 	void showStatsTimeLimited();
+	void showLatency();
 	void removeQDockWidget(QDockWidget *widget);
 	void taskFilter();
 
@@ -199,6 +219,8 @@ private slots:
 	void findWakeupTriggered();
 	void findWakingTriggered();
 	void findWakingDirectTriggered();
+	void showWakeChainTriggered();
+	void hideWakeChainTriggered();
 	void removeTaskGraphTriggered();
 	void clearTaskGraphsTriggered();
 	void taskFilterTriggered();
@@ -215,6 +237,7 @@ private:
 		STATUS_NOFILE = 0,
 		STATUS_FILE,
 		STATUS_ERROR,
+		STATUS_PROCESSING,
 		STATUS_NR
 	} status_t;
 
@@ -241,11 +264,17 @@ private:
 
 	/* Functions for opening and processing a trace*/
 	void processTrace();
+	void showProcessedTrace();
+	void finishProcessing();
 	void computeLayout();
-	void computeStats();
 	void rescaleTrace();
 	void clearPlot();
 	void showTrace();
+	void rebuildPlot();
+	void updatePlot();
+	void relayoutPlot();
+	void savePlotSettings();
+	bool settingChanged(enum Setting::Index idx) const;
 	double adjustScatterSize(double defsize, int linewidth);
 	double maxZoomVSize();
 	double autoZoomVSize();
@@ -259,26 +288,50 @@ private:
 	void setupCursors_(vtl::Time redtime, const double &red,
 			   vtl::Time bluetime, const double &blue);
 	void updateResetFiltersEnabled();
+	void addCpuIdleGraph(unsigned int cpu);
+	void addCpuFreqGraph(unsigned int cpu);
+	void updateCpuGraphs(unsigned int cpu);
+	void restyleCpuGraphs();
+	void removeMigrationGraph();
+	void updateHeatMap();
+	bool updateWakeChain();
 	void addSchedGraph(CPUTask &task, unsigned int cpu);
+	TaskGraph *cpuTaskGraph(CPUTask *task, unsigned int cpu);
+	void updateLanes();
+	void showSchedLane(unsigned int cpu);
+	void hideSchedLane(unsigned int cpu);
+	void showCpuLane(unsigned int cpu);
+	void hideCpuLane(unsigned int cpu);
+	bool schedGraphPinned(CPUTask &task);
 	void addHorizontalWakeupGraph(CPUTask &task);
 	void addWakeupGraph(CPUTask &task);
 	void addPreemptedGraph(CPUTask &task);
 	void addStillRunningGraph(CPUTask &task);
 	void addUninterruptibleGraph(CPUTask &task);
-	void addGenericAccessoryGraph(const QString &name,
+	void addGenericAccessoryGraph(QCPGraph **graphPtr,
+				      const QString &name,
 				      const QVector<double> &timev,
-				      const QVector<double> &scaledData,
+				      double height,
 				      QCPScatterStyle::ScatterShape sshape,
 				      double size,
 				      const QColor &color);
 	void addAccessoryTaskGraph(QCPGraph **graphPtr, const QString &name,
 				   const QVector<double> &timev,
-				   const QVector<double> &scaledData,
+				   double height,
 				   QCPScatterStyle::ScatterShape sshape,
 				   double size, const QColor &color);
 	void addStillRunningTaskGraph(Task *task);
 	void addPreemptedTaskGraph(Task *task);
 	void addUninterruptibleTaskGraph(Task *task);
+	void moveSchedGraphs(CPUTask &task);
+	void removeAccessoryGraph(QCPGraph **graphPtr);
+	void removeWakeupGraph(QCPGraph **graphPtr,
+			       QCPErrorBars **errorBarsPtr);
+	void restyleSchedGraphs(CPUTask &task, int lwidth);
+	void restyleTaskGraphs(Task *task, int lwidth);
+	void restyleWakeupGraph(QCPGraph *graph, QCPErrorBars *errorBars,
+				int lwidth);
+	void restyleAccessoryGraph(QCPGraph *graph, double size, int lwidth);
 	void setTraceActionsEnabled(bool e);
 	void setLegendActionsEnabled(bool e);
 	void setCloseActionsEnabled(bool e);
@@ -299,6 +352,9 @@ private:
 			     preference_t preference);
 	bool isOpenGLEnabled();
 	void setupOpenGL();
+	void setupMapCache();
+	void setupTileCache();
+	void updateSchedLOD(const QCPRange &range);
 	void updateTaskGraphActions();
 	void updateAddToLegendAction();
 	TaskGraph *selectedGraph();
@@ -314,6 +370,8 @@ private:
 	EventsWidget *eventsWidget;
 	InfoWidget *infoWidget;
 	QString traceFile;
+	QString argFilterExpr;
+	QString findText;
 
 	QMenu *fileMenu;
 	QMenu *viewMenu;
@@ -340,12 +398,17 @@ private:
 	QAction *filterCPUsAction;
 	QAction *showEventsAction;
 	QAction *timeFilterAction;
+	QAction *argFilterAction;
+	QAction *findAction;
+	QAction *findNextAction;
+	QAction *findPreviousAction;
 	QAction *graphEnableAction;
 	QAction *resetFiltersAction;
 	QAction *exportEventsAction;
 	QAction *exportCPUAction;
 	QAction *showStatsAction;
 	QAction *showStatsTimeLimitedAction;
+	QAction *showLatencyAction;
 
 	QAction *backTraceAction;
 	QAction *eventCPUAction;
@@ -366,6 +429,8 @@ private:
 	QAction *findWakeupAction;
 	QAction *findWakingAction;
 	QAction *findWakingDirectAction;
+	QAction *showWakeChainAction;
+	QAction *hideWakeChainAction;
 	QAction *removeTaskGraphAction;
 	QAction *clearTaskGraphsAction;
 	QAction *taskFilterAction;
@@ -379,9 +444,12 @@ private:
 	TaskSelectDialog *taskSelectDialog;
 	TaskSelectDialog *statsDialog;
 	TaskSelectDialog *statsLimitedDialog;
+	LatencyDialog *latencyDialog;
 	EventSelectDialog *eventSelectDialog;
 	CPUSelectDialog *cpuSelectDialog;
 	GraphEnableDialog *graphEnableDialog;
+	QProgressDialog *progressDialog;
+	QTimer *processingTimer;
 
 	static const double bugWorkAroundOffset;
 	static const double schedSectionOffset;
@@ -392,6 +460,9 @@ private:
 	static const double cpuHeight;
 	static const double pixelZoomFactor;
 	static const double refDpiY;
+	static const double laneMargin;
+	static const double heatMapSectionOffset;
+	static const double heatMapRowHeight;
 	/*
 	 * const double migrateHeight doesn't exist. The value used is the
 	 * dynamically calculated inc variable in MainWindow::computeLayout()
@@ -423,9 +494,40 @@ private:
 	double endTime;
 	QVector<double> ticks;
 	QVector<QString> tickLabels;
+	QVector<MigrationLine*> migrationLines;
+	QVector<QCPGraph*> cpuIdleGraphs;
+	QVector<QCPGraph*> cpuFreqGraphs;
+	/*
+	 * The offsets of the scheduling and cpufreq/cpuidle lanes of each CPU,
+	 * empty if the section is not shown, and whether the graphs of a lane
+	 * have been created.
+	 */
+	QVector<double> schedLanes;
+	QVector<double> cpuLanes;
+	QVector<bool> schedLaneShown;
+	QVector<bool> cpuLaneShown;
+	/*
+	 * Whether a lane that is not shown has scheduling graphs, which were
+	 * created by cpuTaskGraph() or kept by hideSchedLane() because they
+	 * were pinned. They are released when the lane is hidden again.
+	 */
+	QVector<bool> schedLaneGraphs;
+	UtilizationMap *utilizationMap;
+	HeatMapPlot *heatMapPlot;
+	QTimer *heatMapTimer;
+	double heatMapOffset;
+	EventRateStrip *eventRateStrip;
+	/* The highlighted critical path, see showWakeChainTriggered() */
+	QVector<WakeHop> wakeChainPath;
+	QCPCurve *wakeChainCurve;
+	/* The values of the settings that the plot was last built with */
+	Setting::Value plotSettings[Setting::NR_SETTINGS];
 	Cursor *cursors[TShark::NR_CURSORS];
 	SettingStore *settingStore;
 	bool filterActive;
+	/* Whether the trace being opened has been shown in the plot */
+	bool traceShown;
+	quint64 processingStart;
 	double cursorPos[TShark::NR_CURSORS];
 	QMap<unsigned, unsigned> eventCPUMap;
 	QMap<int, int> eventPIDMap;
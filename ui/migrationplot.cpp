@@ -0,0 +1,250 @@
+// SPDX-License-Identifier: (GPL-2.0-or-later OR BSD-2-Clause)
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2020  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <climits>
+#include "ui/migrationplot.h"
+#include "misc/traceshark.h"
+
+MigrationPlot::MigrationPlot(QCPAxis *keyAxis, QCPAxis *valueAxis):
+	QCPAbstractPlottable(keyAxis, valueAxis),
+	head(QCPLineEnding::esFlatArrow), offset(0), unit(1), nrLanes(0),
+	width(1)
+{
+	setSelectable(QCP::stNone);
+}
+
+void MigrationPlot::setGeometry(double offset_, double unit_)
+{
+	offset = offset_;
+	unit = unit_;
+}
+
+void MigrationPlot::setWidth(int width_)
+{
+	width = width_;
+}
+
+void MigrationPlot::reserve(int size)
+{
+	points.reserve(size);
+}
+
+void MigrationPlot::addMigration(double time, int from, int to,
+				 const QColor &color)
+{
+	MigrationPoint p;
+
+	p.time = time;
+	p.from = from;
+	p.to = to;
+	p.color = color.rgb();
+	points.append(p);
+	nrLanes = TSMAX(nrLanes, TSMAX(from, to) + 1);
+}
+
+double MigrationPlot::selectTest(const QPointF &/*pos*/,
+				 bool /*onlySelectable*/,
+				 QVariant */*details*/) const
+{
+	return -1;
+}
+
+QCPRange MigrationPlot::getKeyRange(bool &foundRange,
+				    QCP::SignDomain inSignDomain) const
+{
+	QCPRange range;
+
+	foundRange = false;
+	if (points.isEmpty())
+		return range;
+	range.lower = points.first().time;
+	range.upper = points.last().time;
+	if (inSignDomain == QCP::sdPositive) {
+		if (range.upper <= 0)
+			return range;
+		range.lower = TSMAX(range.lower, range.upper * 1e-11);
+	} else if (inSignDomain == QCP::sdNegative) {
+		if (range.lower >= 0)
+			return range;
+		range.upper = TSMIN(range.upper, range.lower * 1e-11);
+	}
+	foundRange = true;
+	return range;
+}
+
+QCPRange MigrationPlot::getValueRange(bool &foundRange,
+				      QCP::SignDomain /*inSignDomain*/,
+				      const QCPRange &/*inKeyRange*/) const
+{
+	QCPRange range(offset, offset + (nrLanes - 1) * unit);
+
+	foundRange = !points.isEmpty();
+	return range;
+}
+
+/* Returns the index of the first migration with a time >= time */
+int MigrationPlot::findFirst(double time) const
+{
+	int low = 0;
+	int high = points.size();
+
+	while (low < high) {
+		int mid = low + (high - low) / 2;
+		if (points[mid].time < time)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	return low;
+}
+
+/* Returns the index of the first migration with a time > time */
+int MigrationPlot::findLast(double time) const
+{
+	int low = 0;
+	int high = points.size();
+
+	while (low < high) {
+		int mid = low + (high - low) / 2;
+		if (points[mid].time <= time)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	return low;
+}
+
+QPointF MigrationPlot::orient(double key, double value) const
+{
+	if (mKeyAxis->orientation() == Qt::Horizontal)
+		return QPointF(key, value);
+	return QPointF(value, key);
+}
+
+void MigrationPlot::draw(QCPPainter *painter)
+{
+	QCPAxis *keyAxis = mKeyAxis.data();
+	QCPAxis *valueAxis = mValueAxis.data();
+	QCPRange range;
+	QPen pen;
+	QRgb color;
+	int first, last, i;
+
+	if (keyAxis == nullptr || valueAxis == nullptr || points.isEmpty())
+		return;
+
+	range = keyAxis->range();
+	first = findFirst(range.lower);
+	last = findLast(range.upper);
+	if (first >= last)
+		return;
+
+	laneValues.resize(nrLanes);
+	for (i = 0; i < nrLanes; i++)
+		laneValues[i] = valueAxis->coordToPixel(offset + i * unit);
+
+	/*
+	 * lastColumn holds the last pixel column where an arrow was drawn for
+	 * each pair of lanes. Another arrow between the same lanes in the same
+	 * column would be drawn exactly on top of the previous one. It is only
+	 * filled when the number of lanes changes, after that only the pairs
+	 * in drawnPairs are reset at the end of each draw.
+	 */
+	if (lastColumn.size() != nrLanes * nrLanes)
+		lastColumn.fill(INT_MIN, nrLanes * nrLanes);
+
+	applyDefaultAntialiasingHint(painter);
+	pen.setWidth(width);
+	color = points[first].color;
+	pen.setColor(QColor(color));
+	painter->setPen(pen);
+	painter->setBrush(Qt::SolidPattern);
+
+	for (i = first; i < last; i++) {
+		const MigrationPoint &p = points[i];
+		double key = keyAxis->coordToPixel(p.time);
+		int column = (int) key;
+		int pair = p.from * nrLanes + p.to;
+
+		if (lastColumn[pair] == column)
+			continue;
+		if (lastColumn[pair] == INT_MIN)
+			drawnPairs.append(pair);
+		lastColumn[pair] = column;
+
+		if (p.color != color) {
+			color = p.color;
+			pen.setColor(QColor(color));
+			painter->setPen(pen);
+		}
+
+		QCPVector2D s(orient(key, laneValues[p.from]));
+		QCPVector2D e(orient(key, laneValues[p.to]));
+		if (qFuzzyIsNull((s - e).lengthSquared()))
+			continue;
+		painter->drawLine(s.toPointF(), e.toPointF());
+		head.draw(painter, e, e - s);
+	}
+
+	for (i = 0; i < drawnPairs.size(); i++)
+		lastColumn[drawnPairs[i]] = INT_MIN;
+	drawnPairs.resize(0);
+}
+
+void MigrationPlot::drawLegendIcon(QCPPainter *painter, const QRectF &rect)
+	const
+{
+	applyDefaultAntialiasingHint(painter);
+	painter->setPen(mPen);
+	painter->drawLine(QLineF(rect.left(), rect.center().y(),
+				 rect.right(), rect.center().y()));
+}
@@ -0,0 +1,118 @@
+// SPDX-License-Identifier: (GPL-2.0-or-later OR BSD-2-Clause)
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2020  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef MIGRATIONPLOT_H
+#define MIGRATIONPLOT_H
+
+#include <QColor>
+#include <QVector>
+#include "ui/qcustomplot.h"
+
+/*
+ * A compact representation of a migration. The from and to fields are lane
+ * numbers, i.e. the CPU number plus one, so that lane 0 can be used for
+ * forks and exits.
+ */
+class MigrationPoint
+{
+public:
+	double time;
+	short from;
+	short to;
+	QRgb color;
+};
+
+/*
+ * This class draws all migration arrows with a single plottable. The arrows
+ * must be added in time order, so that the visible range can be found with a
+ * binary search. When there are multiple arrows between the same pair of
+ * lanes within the same pixel column, only the first one is drawn.
+ */
+class MigrationPlot : public QCPAbstractPlottable
+{
+	Q_OBJECT
+public:
+	MigrationPlot(QCPAxis *keyAxis, QCPAxis *valueAxis);
+	void setGeometry(double offset, double unit);
+	void setWidth(int width);
+	void reserve(int size);
+	void addMigration(double time, int from, int to, const QColor &color);
+	virtual double selectTest(const QPointF &pos, bool onlySelectable,
+				  QVariant *details = 0) const;
+	virtual QCPRange getKeyRange(bool &foundRange,
+				     QCP::SignDomain inSignDomain = QCP::sdBoth)
+		const;
+	virtual QCPRange getValueRange(bool &foundRange,
+				       QCP::SignDomain inSignDomain
+				       = QCP::sdBoth,
+				       const QCPRange &inKeyRange = QCPRange())
+		const;
+protected:
+	virtual void draw(QCPPainter *painter);
+	virtual void drawLegendIcon(QCPPainter *painter, const QRectF &rect)
+		const;
+private:
+	int findFirst(double time) const;
+	int findLast(double time) const;
+	QPointF orient(double key, double value) const;
+	QVector<MigrationPoint> points;
+	QVector<int> lastColumn;
+	QVector<int> drawnPairs;
+	QVector<double> laneValues;
+	QCPLineEnding head;
+	double offset;
+	double unit;
+	int nrLanes;
+	int width;
+};
+
+#endif /* MIGRATIONPLOT_H */
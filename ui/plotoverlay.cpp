@@ -1,7 +1,7 @@
 // SPDX-License-Identifier: (GPL-2.0-or-later OR BSD-2-Clause)
 /*
  * Traceshark - a visualizer for visualizing ftrace and perf traces
- * Copyright (C) 2014, 2015, 2016  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ * Copyright (C) 2020  Viktor Rosendahl <viktor.rosendahl@gmail.com>
  *
  * This file is dual licensed: you can use it either under the terms of
  * the GPL, or the BSD license, at your option.
@@ -50,14 +50,29 @@
  *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include "analyzer/cpuidle.h"
+#include "ui/plotoverlay.h"
+#include "ui/plottilecache.h"
 
-bool CpuIdle::doScale()
+PlotOverlay::PlotOverlay(QCPLayer *data, const PlotTileCache *cache):
+	dataLayer(data), tileCache(cache)
+{}
+
+bool PlotOverlay::drawLayer(QCPLayer *layer, QCPPainter *painter)
 {
-	int i;
-	int s = data.size();
-	scaledData.resize(s);
-	for (i = 0; i < s; i++)
-		scaledData[i] = data[i] * scale + offset;
-	return false; /* No error */	
+	QCPList<QCPLayerable*> &list = dataLayer->children();
+	QCPAbstractPlottable *plottable;
+
+	if (!tileCache->isActive()) {
+		drawLayerables(layer, painter);
+		return true;
+	}
+
+	for (auto iter = list.begin(); iter != list.end(); iter++) {
+		plottable = qobject_cast<QCPAbstractPlottable*>(*iter);
+		if (plottable != nullptr && plottable->selected() &&
+		    plottable->realVisibility())
+			drawLayerable(plottable, painter);
+	}
+	drawLayerables(layer, painter);
+	return true;
 }
@@ -1,7 +1,7 @@
 // SPDX-License-Identifier: (GPL-2.0-or-later OR BSD-2-Clause)
 /*
  * Traceshark - a visualizer for visualizing ftrace and perf traces
- * Copyright (C) 2015, 2017, 2020  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ * Copyright (C) 2020  Viktor Rosendahl <viktor.rosendahl@gmail.com>
  *
  * This file is dual licensed: you can use it either under the terms of
  * the GPL, or the BSD license, at your option.
@@ -50,20 +50,30 @@
  *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#ifndef MIGRATIONARROW_H
-#define MIGRATIONARROW_H
+#ifndef PLOTOVERLAY_H
+#define PLOTOVERLAY_H
 
-#include <QColor>
 #include "ui/qcustomplot.h"
 
-class MigrationArrow : public QCPItemLine
+class PlotTileCache;
+
+/*
+ * This draws a buffered layer that is on top of the data layers, so that it
+ * can be replotted without drawing the data. It draws the selected plottables
+ * of the data layer followed by its own layerables, e.g. the cursors. The
+ * tiles of the data layer are rendered without selection, so selecting a
+ * graph only requires the overlay to be drawn again. If the data layer was not
+ * drawn from the tiles, then it already has the selection and only the
+ * layerables of the overlay are drawn.
+ */
+class PlotOverlay : public QCPLayerRenderer
 {
-	Q_OBJECT
 public:
-	MigrationArrow(double start, double end, double time,
-		       const QColor &color, QCustomPlot *parent, int width);
+	PlotOverlay(QCPLayer *data, const PlotTileCache *cache);
+	bool drawLayer(QCPLayer *layer, QCPPainter *painter);
 private:
-	QCPLineEnding head;
+	QCPLayer *dataLayer;
+	const PlotTileCache *tileCache;
 };
 
-#endif /* MIGRATIONARROW_H */
+#endif /* PLOTOVERLAY_H */
@@ -0,0 +1,625 @@
+// SPDX-License-Identifier: (GPL-2.0-or-later OR BSD-2-Clause)
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2020  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+#include <cstring>
+
+#include <QTimer>
+
+#include "ui/plottilecache.h"
+#include "misc/traceshark.h"
+#include "vtl/compiler.h"
+
+/* Two spans are considered equal if they differ less than this fraction */
+#define SPAN_TOLERANCE (1e-9)
+
+/* Tolerance, in tiles, when deciding which tiles are visible */
+#define TILE_EPSILON (1e-6)
+
+/* The grid is recreated if the view is panned this many tiles from it */
+#define TILE_MAX_INDEX (1 << 28)
+
+/*
+ * The number of pixels that a plottable may draw outside of its time range,
+ * because of pen widths and scatter symbols.
+ */
+#define TILE_MARGIN (16)
+
+static vtl_always_inline quint64 mix(quint64 h, quint64 v)
+{
+	h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+	return h;
+}
+
+static vtl_always_inline quint64 mixDouble(quint64 h, double d)
+{
+	quint64 v;
+
+	memcpy(&v, &d, sizeof(v));
+	return mix(h, v);
+}
+
+static vtl_always_inline bool sameSpan(double a, double b)
+{
+	return fabs(a - b) <= fabs(b) * SPAN_TOLERANCE;
+}
+
+PlotTileCache::PlotTileCache(QCustomPlot *parent):
+	QObject(parent), plot(parent), tileLayer(nullptr), generation(0),
+	useCounter(0), frameStart(0), nrVisible(0), size(0),
+	maxSize((qint64) DEFAULT_TILE_CACHE_SIZE * 1024 * 1024),
+	active(false), gridValid(false), gridRatio(1), originX(0), originY(0),
+	spanX(1), spanY(1)
+{
+	prefetchTimer = new QTimer(this);
+	prefetchTimer->setSingleShot(true);
+	prefetchTimer->setInterval(0);
+	tsconnect(prefetchTimer, timeout(), this, prefetchTimeout());
+}
+
+PlotTileCache::~PlotTileCache()
+{
+	clearTiles();
+}
+
+void PlotTileCache::setMaxSize(qint64 bytes)
+{
+	maxSize = bytes;
+	if (maxSize <= 0)
+		invalidate();
+	else
+		evict(useCounter + 1);
+}
+
+/* Drops all tiles and forgets the state of all layerables */
+void PlotTileCache::invalidate()
+{
+	clearTiles();
+	children.clear();
+}
+
+/* Drops the tiles that overlap keyRange */
+void PlotTileCache::invalidate(const QCPRange &keyRange)
+{
+	QCPRange valueRange(-QCPRange::maxRange, QCPRange::maxRange);
+
+	invalidate(keyRange, valueRange);
+}
+
+/* Drops the tiles that overlap the area of keyRange and valueRange */
+void PlotTileCache::invalidate(const QCPRange &keyRange,
+			       const QCPRange &valueRange)
+{
+	QHash<quint64, Tile*>::iterator iter;
+	double margin, vmargin, lower, upper, vlower, vupper;
+
+	if (!gridValid)
+		return;
+
+	margin = spanX * TILE_MARGIN / gridArea.width();
+	vmargin = spanY * TILE_MARGIN / gridArea.height();
+	iter = tiles.begin();
+	while (iter != tiles.end()) {
+		Tile *tile = iter.value();
+		lower = originX + tile->i * spanX;
+		upper = lower + spanX;
+		vlower = originY + tile->j * spanY;
+		vupper = vlower + spanY;
+		if (upper >= keyRange.lower - margin &&
+		    lower <= keyRange.upper + margin &&
+		    vupper >= valueRange.lower - vmargin &&
+		    vlower <= valueRange.upper + vmargin) {
+			size -= tileBytes();
+			delete tile;
+			iter = tiles.erase(iter);
+		} else {
+			iter++;
+		}
+	}
+}
+
+void PlotTileCache::clearTiles()
+{
+	QHash<quint64, Tile*>::iterator iter;
+
+	for (iter = tiles.begin(); iter != tiles.end(); iter++)
+		delete iter.value();
+	tiles.clear();
+	prefetchQueue.clear();
+	size = 0;
+}
+
+bool PlotTileCache::drawLayer(QCPLayer *layer, QCPPainter *painter)
+{
+	int i, j, i0, i1, j0, j1;
+	Tile *tile;
+
+	active = false;
+
+	/* The tiles are rendered with the raster engine only */
+	if (maxSize <= 0 || plot->openGl()) {
+		if (!tiles.isEmpty())
+			invalidate();
+		return false;
+	}
+
+	tileLayer = layer;
+	if (!checkGrid())
+		return false;
+	checkLayerables();
+
+	visibleTiles(i0, i1, j0, j1);
+	nrVisible = (i1 - i0 + 1) * (j1 - j0 + 1);
+	if (nrVisible * tileBytes() > maxSize)
+		return false;
+
+	frameStart = useCounter + 1;
+	painter->save();
+	painter->setClipRect(gridArea);
+	for (j = j0; j <= j1; j++) {
+		for (i = i0; i <= i1; i++) {
+			tile = tiles.value(tileKey(i, j), nullptr);
+			if (tile == nullptr)
+				tile = renderTile(i, j);
+			tile->lastUse = ++useCounter;
+			drawTile(painter, tile);
+		}
+	}
+	painter->restore();
+	evict(frameStart);
+
+	/* Prepare the tiles that are likely to be needed next */
+	prefetchQueue.clear();
+	for (j = j0; j <= j1; j++) {
+		schedulePrefetch(i0 - 1, j);
+		schedulePrefetch(i1 + 1, j);
+	}
+	for (i = i0; i <= i1; i++) {
+		schedulePrefetch(i, j0 - 1);
+		schedulePrefetch(i, j1 + 1);
+	}
+	if (!prefetchQueue.isEmpty())
+		prefetchTimer->start();
+	active = true;
+	return true;
+}
+
+/*
+ * Returns true if the last replot of the layer was drawn from the tiles, i.e.
+ * without the selection.
+ */
+bool PlotTileCache::isActive() const
+{
+	return active;
+}
+
+/*
+ * QCPLayer::draw() clips the layerables to their clip rect moved up by one
+ * pixel, so we do the same with the area of the tiles. This also means that
+ * a layerable on the layer that is not clipped to the axis rect will be
+ * clipped by the tiles.
+ */
+bool PlotTileCache::gridMatches() const
+{
+	QCPAxis *xaxis = plot->xAxis;
+	QCPAxis *yaxis = plot->yAxis;
+	QCPRange xrange, yrange;
+	QRect area;
+
+	if (!gridValid)
+		return false;
+
+	area = xaxis->axisRect()->rect().translated(0, -1);
+	xrange = xaxis->range();
+	yrange = yaxis->range();
+
+	return area == gridArea &&
+		plot->bufferDevicePixelRatio() == gridRatio &&
+		sameSpan(xrange.size(), spanX) &&
+		sameSpan(yrange.size(), spanY) &&
+		fabs((xrange.lower - originX) / spanX) < TILE_MAX_INDEX &&
+		fabs((yrange.lower - originY) / spanY) < TILE_MAX_INDEX;
+}
+
+/* Returns false if the plot can't be drawn with tiles */
+bool PlotTileCache::checkGrid()
+{
+	QCPAxis *xaxis = plot->xAxis;
+	QCPAxis *yaxis = plot->yAxis;
+	QRect area;
+
+	if (xaxis == nullptr || yaxis == nullptr ||
+	    xaxis->scaleType() != QCPAxis::stLinear ||
+	    yaxis->scaleType() != QCPAxis::stLinear)
+		return false;
+
+	area = xaxis->axisRect()->rect().translated(0, -1);
+	if (area.width() <= 0 || area.height() <= 0)
+		return false;
+
+	if (gridMatches())
+		return true;
+
+	/* The zoom level has changed, start a new grid at the current view */
+	clearTiles();
+	gridValid = true;
+	gridArea = area;
+	gridRatio = plot->bufferDevicePixelRatio();
+	originX = xaxis->range().lower;
+	originY = yaxis->range().lower;
+	spanX = xaxis->range().size();
+	spanY = yaxis->range().size();
+	return true;
+}
+
+/*
+ * Compares the layerables with their state at the previous replot and drops
+ * the tiles that are affected by the layerables that have changed.
+ */
+void PlotTileCache::checkLayerables()
+{
+	QCPList<QCPLayerable*> &list = tileLayer->children();
+	QHash<const QCPLayerable*, Child>::iterator c;
+	quint64 sig;
+
+	generation++;
+	for (auto iter = list.begin(); iter != list.end(); iter++) {
+		QCPLayerable *layerable = *iter;
+		sig = signature(layerable);
+		c = children.find(layerable);
+		if (c == children.end()) {
+			Child child;
+			child.signature = sig;
+			child.generation = generation;
+			fillChild(layerable, child);
+			invalidateChild(child);
+			children.insert(layerable, child);
+			continue;
+		}
+		Child &child = c.value();
+		if (child.signature != sig) {
+			invalidateChild(child);
+			child.signature = sig;
+			fillChild(layerable, child);
+			invalidateChild(child);
+		}
+		child.generation = generation;
+	}
+
+	/* The layerables that were not found have been removed */
+	c = children.begin();
+	while (c != children.end()) {
+		if (c.value().generation != generation) {
+			invalidateChild(c.value());
+			c = children.erase(c);
+		} else {
+			c++;
+		}
+	}
+}
+
+void PlotTileCache::invalidateChild(const Child &child)
+{
+	switch (child.extent) {
+	case EXTENT_EMPTY:
+		break;
+	case EXTENT_KEYS:
+		invalidate(child.keyRange);
+		break;
+	case EXTENT_AREA:
+		invalidate(child.keyRange, child.valueRange);
+		break;
+	case EXTENT_ALL:
+	default:
+		clearTiles();
+		break;
+	}
+}
+
+void PlotTileCache::fillChild(QCPLayerable *layerable, Child &child)
+{
+	QCPAbstractPlottable *plottable;
+	bool found = false;
+
+	if (!layerable->realVisibility()) {
+		child.extent = EXTENT_EMPTY;
+		return;
+	}
+
+	plottable = qobject_cast<QCPAbstractPlottable*>(layerable);
+	if (plottable == nullptr) {
+		child.extent = EXTENT_ALL;
+		return;
+	}
+
+	child.keyRange = plottable->getKeyRange(found);
+	if (!found) {
+		child.extent = EXTENT_EMPTY;
+		return;
+	}
+
+	/*
+	 * The value range allows the lanes of the plot to be changed without
+	 * dropping the tiles of the other lanes.
+	 */
+	child.valueRange = plottable->getValueRange(found);
+	child.extent = found ? EXTENT_AREA : EXTENT_KEYS;
+}
+
+/*
+ * Computes a hash of the properties of a layerable that affect how it is
+ * drawn. The data of the graphs is shared with the analyzer, so it is only
+ * represented by its size and value transform. The selection of plottables is
+ * left out, because they are drawn without it, see renderTile().
+ */
+quint64 PlotTileCache::signature(QCPLayerable *layerable)
+{
+	QCPAbstractPlottable *plottable;
+	QCPPlottableInterface1D *interface;
+	QCPAbstractItem *item;
+	QCPGraph *graph;
+	quint64 h = 0;
+
+	h = mix(h, layerable->realVisibility());
+
+	plottable = qobject_cast<QCPAbstractPlottable*>(layerable);
+	if (plottable != nullptr) {
+		const QPen &pen = plottable->pen();
+		const QBrush &brush = plottable->brush();
+
+		h = mix(h, pen.color().rgba());
+		h = mixDouble(h, pen.widthF());
+		h = mix(h, pen.style());
+		h = mix(h, brush.color().rgba());
+		h = mix(h, brush.style());
+		interface = plottable->interface1D();
+		if (interface != nullptr)
+			h = mix(h, interface->dataCount());
+		graph = qobject_cast<QCPGraph*>(plottable);
+		if (graph != nullptr) {
+			h = mix(h, graph->lineStyle());
+			h = mix(h, graph->scatterStyle().shape());
+			h = mixDouble(h, graph->scatterStyle().size());
+			h = mixDouble(h, graph->data()->valueScale());
+			h = mixDouble(h, graph->data()->valueOffset());
+		}
+		return h;
+	}
+
+	item = qobject_cast<QCPAbstractItem*>(layerable);
+	if (item != nullptr) {
+		QList<QCPItemPosition*> positions = item->positions();
+		QList<QCPItemPosition*>::const_iterator iter;
+
+		h = mix(h, item->selected());
+		for (iter = positions.begin(); iter != positions.end();
+		     iter++) {
+			h = mixDouble(h, (*iter)->key());
+			h = mixDouble(h, (*iter)->value());
+		}
+	}
+	return h;
+}
+
+void PlotTileCache::visibleTiles(int &i0, int &i1, int &j0, int &j1) const
+{
+	const QCPRange &xrange = plot->xAxis->range();
+	const QCPRange &yrange = plot->yAxis->range();
+
+	i0 = (int) floor((xrange.lower - originX) / spanX + TILE_EPSILON);
+	i1 = (int) ceil((xrange.upper - originX) / spanX - TILE_EPSILON) - 1;
+	i1 = TSMAX(i0, i1);
+	j0 = (int) floor((yrange.lower - originY) / spanY + TILE_EPSILON);
+	j1 = (int) ceil((yrange.upper - originY) / spanY - TILE_EPSILON) - 1;
+	j1 = TSMAX(j0, j1);
+}
+
+/*
+ * Renders a tile by temporarily setting the axes to the range of the tile.
+ * The selected plottables are also temporarily deselected, because the
+ * selection is drawn on the overlay layer, so that selecting a graph does not
+ * invalidate any tiles. The signals are blocked, so that nothing else in the
+ * program notices these changes.
+ */
+PlotTileCache::Tile *PlotTileCache::renderTile(int i, int j)
+{
+	QCPAxis *xaxis = plot->xAxis;
+	QCPAxis *yaxis = plot->yAxis;
+	QCPRange xsaved = xaxis->range();
+	QCPRange ysaved = yaxis->range();
+	QCPRange xrange(originX + i * spanX, originX + (i + 1) * spanX);
+	QCPRange yrange(originY + j * spanY, originY + (j + 1) * spanY);
+	bool xblocked = xaxis->blockSignals(true);
+	bool yblocked = yaxis->blockSignals(true);
+	QCPList<QCPLayerable*> &list = tileLayer->children();
+	QList<QCPAbstractPlottable*> selected;
+	QList<QCPDataSelection> selections;
+	QList<bool> blocked;
+	QCPAbstractPlottable *plottable;
+	Tile *tile = new Tile;
+	int k;
+
+	for (auto iter = list.begin(); iter != list.end(); iter++) {
+		plottable = qobject_cast<QCPAbstractPlottable*>(*iter);
+		if (plottable == nullptr || !plottable->selected())
+			continue;
+		selected.append(plottable);
+		selections.append(plottable->selection());
+		blocked.append(plottable->blockSignals(true));
+		plottable->setSelection(QCPDataSelection());
+	}
+
+	xaxis->setRange(xrange);
+	yaxis->setRange(yrange);
+
+	tile->i = i;
+	tile->j = j;
+	tile->lastUse = 0;
+#ifdef QCP_DEVICEPIXELRATIO_SUPPORTED
+	tile->image = QImage(gridArea.size() * gridRatio,
+			     QImage::Format_ARGB32_Premultiplied);
+	tile->image.setDevicePixelRatio(gridRatio);
+#else
+	tile->image = QImage(gridArea.size(),
+			     QImage::Format_ARGB32_Premultiplied);
+#endif
+	tile->image.fill(Qt::transparent);
+
+	QCPPainter painter(&tile->image);
+	painter.setRenderHint(QPainter::HighQualityAntialiasing);
+	painter.translate(-gridArea.topLeft());
+	drawLayerables(tileLayer, &painter);
+	painter.end();
+
+	tile->anchor = QPointF(xaxis->coordToPixel(xrange.lower),
+			       yaxis->coordToPixel(yrange.upper)) -
+		QPointF(gridArea.topLeft());
+
+	xaxis->setRange(xsaved);
+	yaxis->setRange(ysaved);
+	xaxis->blockSignals(xblocked);
+	yaxis->blockSignals(yblocked);
+
+	for (k = 0; k < selected.size(); k++) {
+		selected[k]->setSelection(selections[k]);
+		selected[k]->blockSignals(blocked[k]);
+	}
+
+	tiles.insert(tileKey(i, j), tile);
+	size += tileBytes();
+	return tile;
+}
+
+void PlotTileCache::drawTile(QCPPainter *painter, const Tile *tile) const
+{
+	double lower = originX + tile->i * spanX;
+	double upper = originY + (tile->j + 1) * spanY;
+	QPointF pos = QPointF(plot->xAxis->coordToPixel(lower),
+			      plot->yAxis->coordToPixel(upper)) - tile->anchor;
+
+	painter->drawImage(QPoint(qRound(pos.x()), qRound(pos.y())),
+			   tile->image);
+}
+
+/* Evicts the least recently used tiles, except those used since keepFrom */
+void PlotTileCache::evict(quint64 keepFrom)
+{
+	QHash<quint64, Tile*>::iterator iter, oldest;
+
+	while (size > maxSize) {
+		oldest = tiles.end();
+		for (iter = tiles.begin(); iter != tiles.end(); iter++) {
+			if (iter.value()->lastUse >= keepFrom)
+				continue;
+			if (oldest == tiles.end() ||
+			    iter.value()->lastUse < oldest.value()->lastUse)
+				oldest = iter;
+		}
+		if (oldest == tiles.end())
+			break;
+		delete oldest.value();
+		tiles.erase(oldest);
+		size -= tileBytes();
+	}
+}
+
+void PlotTileCache::schedulePrefetch(int i, int j)
+{
+	QPoint tile(i, j);
+
+	if (tiles.contains(tileKey(i, j)) || prefetchQueue.contains(tile))
+		return;
+	/* Only prefetch tiles that can be kept together with the visible */
+	if ((nrVisible + prefetchQueue.size() + 1) * tileBytes() > maxSize)
+		return;
+	prefetchQueue.append(tile);
+}
+
+/* Renders one prefetched tile at a time, so that the GUI stays responsive */
+void PlotTileCache::prefetchTimeout()
+{
+	QPoint next;
+	Tile *tile;
+
+	if (prefetchQueue.isEmpty())
+		return;
+
+	/* The plot may have changed since the tiles were scheduled */
+	if (tileLayer == nullptr || !plot->isVisible() || plot->openGl() ||
+	    !gridMatches()) {
+		prefetchQueue.clear();
+		return;
+	}
+
+	next = prefetchQueue.takeFirst();
+	if (!tiles.contains(tileKey(next.x(), next.y()))) {
+		tile = renderTile(next.x(), next.y());
+		tile->lastUse = ++useCounter;
+		evict(frameStart);
+	}
+
+	if (!prefetchQueue.isEmpty())
+		prefetchTimer->start();
+}
+
+qint64 PlotTileCache::tileBytes() const
+{
+	qint64 w = (qint64) ceil(gridArea.width() * gridRatio);
+	qint64 h = (qint64) ceil(gridArea.height() * gridRatio);
+
+	return w * h * 4;
+}
+
+quint64 PlotTileCache::tileKey(int i, int j)
+{
+	return ((quint64) (quint32) i << 32) | (quint64) (quint32) j;
+}
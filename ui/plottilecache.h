@@ -0,0 +1,166 @@
+// SPDX-License-Identifier: (GPL-2.0-or-later OR BSD-2-Clause)
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2020  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PLOTTILECACHE_H
+#define PLOTTILECACHE_H
+
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QObject>
+#include <QPoint>
+#include <QPointF>
+#include <QRect>
+
+#include "ui/qcustomplot.h"
+
+QT_BEGIN_NAMESPACE
+class QTimer;
+QT_END_NAMESPACE
+
+/*
+ * This renders a layer of the plot into tiles, which are images that each
+ * cover the size of the axis rect at the current zoom level. The tiles are
+ * positioned on a grid in plot coordinates, so when the plot is panned, the
+ * visible part is composited from the tiles that are already rendered and at
+ * most the tiles that have come into view need to be rendered. The tiles next
+ * to the visible ones are rendered in advance when the GUI is idle.
+ *
+ * The selected plottables are drawn without their selection, which is instead
+ * drawn by the PlotOverlay on the layer above. When the layer is not drawn from
+ * the tiles, it is drawn normally, with the selection, and isActive() tells the
+ * PlotOverlay not to draw it again.
+ *
+ * A change of the zoom level or of the size of the axis rect drops all tiles.
+ * The layerables are checked at every replot, so that a layerable that has
+ * been added, removed or modified only drops the tiles that overlap its time
+ * and value ranges. Changes that are not visible in the checked properties need
+ * to be signaled with invalidate().
+ */
+class PlotTileCache : public QObject, public QCPLayerRenderer
+{
+	Q_OBJECT
+public:
+	PlotTileCache(QCustomPlot *parent);
+	~PlotTileCache();
+	bool drawLayer(QCPLayer *layer, QCPPainter *painter);
+	bool isActive() const;
+	void setMaxSize(qint64 bytes);
+	void invalidate();
+	void invalidate(const QCPRange &keyRange);
+	void invalidate(const QCPRange &keyRange, const QCPRange &valueRange);
+private slots:
+	void prefetchTimeout();
+private:
+	class Tile {
+	public:
+		int i;
+		int j;
+		QImage image;
+		/* Where the lower key and upper value were drawn */
+		QPointF anchor;
+		quint64 lastUse;
+	};
+	typedef enum : int {
+		EXTENT_EMPTY = 0,
+		EXTENT_KEYS,
+		EXTENT_AREA,
+		EXTENT_ALL
+	} extent_t;
+	class Child {
+	public:
+		quint64 signature;
+		extent_t extent;
+		QCPRange keyRange;
+		QCPRange valueRange;
+		unsigned int generation;
+	};
+	bool gridMatches() const;
+	bool checkGrid();
+	void clearTiles();
+	void checkLayerables();
+	void invalidateChild(const Child &child);
+	void visibleTiles(int &i0, int &i1, int &j0, int &j1) const;
+	Tile *renderTile(int i, int j);
+	void drawTile(QCPPainter *painter, const Tile *tile) const;
+	void evict(quint64 keepFrom);
+	void schedulePrefetch(int i, int j);
+	qint64 tileBytes() const;
+	static quint64 tileKey(int i, int j);
+	static quint64 signature(QCPLayerable *layerable);
+	static void fillChild(QCPLayerable *layerable, Child &child);
+	QCustomPlot *plot;
+	QCPLayer *tileLayer;
+	QHash<quint64, Tile*> tiles;
+	QHash<const QCPLayerable*, Child> children;
+	QList<QPoint> prefetchQueue;
+	QTimer *prefetchTimer;
+	unsigned int generation;
+	quint64 useCounter;
+	/* The tiles used by the last replot have lastUse >= frameStart */
+	quint64 frameStart;
+	int nrVisible;
+	qint64 size;
+	qint64 maxSize;
+	/* Whether the last replot of the layer was drawn from the tiles */
+	bool active;
+	/* The grid of tiles at the current zoom level */
+	bool gridValid;
+	QRect gridArea;
+	double gridRatio;
+	double originX;
+	double originY;
+	double spanX;
+	double spanY;
+};
+
+#endif /* PLOTTILECACHE_H */
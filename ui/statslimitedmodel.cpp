@@ -51,10 +51,9 @@
  */
 
 #include "vtl/avltree.h"
-#include "vtl/heapsort.h"
-#include "vtl/tlist.h"
 
 #include "ui/statslimitedmodel.h"
+#include "ui/tasksortview.h"
 #include "misc/traceshark.h"
 #include "analyzer/task.h"
 
@@ -63,7 +62,7 @@ static const char swappername[] = "swapper";
 StatsLimitedModel::StatsLimitedModel(QObject *parent):
 	AbstractTaskModel(parent)
 {
-	taskList = new vtl::TList<const Task*>;
+	taskList = new TaskSortView(TaskSortView::SORT_CURSORTIME, true);
 	errorStr = new QString(tr("Error in taskmodel.cpp"));
 	idleTask = new Task;
 	idleTask->pid = 0;
@@ -84,20 +83,17 @@ void StatsLimitedModel::setTaskMap(vtl::AVLTree<int, TaskHandle> *map,
 	vtl::Time delta =
 		AbstractTask::higherTimeLimit - AbstractTask::lowerTimeLimit;
 
-	taskList->clear();
-
-	if (map == nullptr)
+	if (map == nullptr) {
+		taskList->clear();
 		return;
+	}
 
 	idleTask->cursorTime = delta * nrcpus;
 
 	DEFINE_TASKMAP_ITERATOR(iter) = map->begin();
 	while (iter != map->end()) {
 		Task *task = iter.value().task;
-		if (!task->cursorTime.isZero()) {
-			taskList->append(task);
-			idleTask->cursorTime -= task->cursorTime;
-		}
+		idleTask->cursorTime -= task->cursorTime;
 		iter++;
 	}
 
@@ -105,25 +101,11 @@ void StatsLimitedModel::setTaskMap(vtl::AVLTree<int, TaskHandle> *map,
 		(10000 * (idleTask->cursorTime.toDouble() / delta.toDouble() +
 			  0.00005));
 
-	/* Add a fake idle task for event filtering purposes */
-	taskList->append(idleTask);
-
-	vtl::heapsort<vtl::TList, const Task*>(
-		*taskList, [] (const Task *&a, const Task *&b) -> int {
-			const QString &as = *a->displayName;
-			const QString &bs = *b->displayName;
-
-			if (a->cursorTime < b->cursorTime)
-				return 1;
-			if (a->cursorTime > b->cursorTime)
-				return -1;
-
-			int cmp1 = as.compare(bs);
-			if (cmp1 != 0)
-				return cmp1;
-			long cmp2 = (long) a->pid - (long) b->pid;
-			return (int) cmp2;
-		});
+	/*
+	 * Add a fake idle task for event filtering purposes. Tasks that have
+	 * not run between the cursors are left out of the view.
+	 */
+	taskList->update(map, idleTask);
 }
 
 int StatsLimitedModel::rowCount(const QModelIndex & /* index */) const
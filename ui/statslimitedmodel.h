@@ -57,13 +57,11 @@
 #include "vtl/avltree.h"
 #include "misc/traceshark.h"
 
-namespace vtl {
-       template<class T> class TList;
-}
 
 
 class Task;
 class TaskHandle;
+class TaskSortView;
 
 QT_BEGIN_NAMESPACE
 class QStringList;
@@ -92,7 +90,7 @@ public:
 	void endResetModel();
 	Qt::ItemFlags flags(const QModelIndex &index) const;
 private:
-	vtl::TList<const Task*> *taskList;
+	TaskSortView *taskList;
 	QString *errorStr;
 	Task *idleTask;
 };
@@ -51,10 +51,9 @@
  */
 
 #include "vtl/avltree.h"
-#include "vtl/heapsort.h"
-#include "vtl/tlist.h"
 
 #include "ui/statsmodel.h"
+#include "ui/tasksortview.h"
 #include "misc/traceshark.h"
 #include "analyzer/task.h"
 
@@ -63,7 +62,7 @@ static const char swappername[] = "swapper";
 StatsModel::StatsModel(QObject *parent):
 	AbstractTaskModel(parent)
 {
-	taskList = new vtl::TList<const Task*>;
+	taskList = new TaskSortView(TaskSortView::SORT_ACCTIME);
 	errorStr = new QString(tr("Error in taskmodel.cpp"));
 	idleTask = new Task;
 	idleTask->pid = 0;
@@ -83,17 +82,16 @@ void StatsModel::setTaskMap(vtl::AVLTree<int, TaskHandle> *map,
 {
 	vtl::Time delta = AbstractTask::endTime - AbstractTask::startTime;
 
-	taskList->clear();
-
-	if (map == nullptr)
+	if (map == nullptr) {
+		taskList->clear();
 		return;
+	}
 
 	idleTask->accTime = delta * nrcpus;
 
 	DEFINE_TASKMAP_ITERATOR(iter) = map->begin();
 	while (iter != map->end()) {
 		Task *task = iter.value().task;
-		taskList->append(task);
 		idleTask->accTime -= task->accTime;
 		iter++;
 	}
@@ -103,24 +101,7 @@ void StatsModel::setTaskMap(vtl::AVLTree<int, TaskHandle> *map,
 			  0.00005));
 
 	/* Add a fake idle task for event filtering purposes */
-	taskList->append(idleTask);
-
-	vtl::heapsort<vtl::TList, const Task*>(
-		*taskList, [] (const Task *&a, const Task *&b) -> int {
-			const QString &as = *a->displayName;
-			const QString &bs = *b->displayName;
-
-			if (a->accTime < b->accTime)
-				return 1;
-			if (a->accTime > b->accTime)
-				return -1;
-
-			int cmp1 = as.compare(bs);
-			if (cmp1 != 0)
-				return cmp1;
-			long cmp2 = (long) a->pid - (long) b->pid;
-			return (int) cmp2;
-		});
+	taskList->update(map, idleTask);
 }
 
 int StatsModel::rowCount(const QModelIndex & /* index */) const
@@ -50,8 +50,10 @@
  *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include "ui/graphdata.h"
 #include "ui/qcustomplot.h"
 #include "ui/taskgraph.h"
+#include "analyzer/cputask.h"
 #include "analyzer/task.h"
 
 QMap<QCPGraph *, TaskGraph *> TaskGraph::graphDir;
@@ -59,7 +61,7 @@ QMap<QCPGraph *, TaskGraph *> TaskGraph::graphDir;
 TaskGraph::TaskGraph(QCustomPlot *parent, unsigned int cpu_,
 		     enum GraphType g):
 	plot(parent), task(nullptr), taskGraph(nullptr), cpu(cpu_),
-	graph_type(g)
+	graph_type(g), lodTask(nullptr), lodLevel(-1)
 {
 	graph = parent->addGraph(parent->xAxis, parent->yAxis);
 	graphDir[graph] = this;
@@ -125,11 +127,61 @@ void TaskGraph::setTaskGraphForLegend(TaskGraph *legendTaskGraph)
 	taskGraph = legendTaskGraph;
 }
 
-void TaskGraph::setData(const QVector<double > &keys,
-			const QVector<double> &values,
-			bool alreadySorted)
+/*
+ * The graph shares the scheduling vectors of schedTask and scales the values
+ * when it is plotted, so no scaled copy of the data is needed.
+ */
+void TaskGraph::setSchedData(const AbstractTask *schedTask)
 {
-	graph->setData(keys, values, alreadySorted);
+	graphSetBitData(graph, schedTask->schedTimev, schedTask->schedData,
+			schedTask->getSchedScale(), schedTask->offset);
+}
+
+/*
+ * Sets the scheduling graph of cpuTask as the data of this graph. The data is
+ * later switched between the raw data and the levels of the LOD pyramid by
+ * updateLOD().
+ */
+void TaskGraph::setSchedLOD(CPUTask *cpuTask)
+{
+	lodTask = cpuTask;
+	lodLevel = -1;
+	setSchedData(cpuTask);
+}
+
+/*
+ * Selects the level of the LOD pyramid that matches pixelWidth, which is the
+ * time that one pixel corresponds to. Returns true if the data was changed.
+ */
+bool TaskGraph::updateLOD(double pixelWidth)
+{
+	QVector<double> keys;
+	QVector<double> values;
+	int level;
+	bool selected;
+
+	if (lodTask == nullptr)
+		return false;
+
+	level = lodTask->schedLOD.findLevel(pixelWidth);
+	if (level == lodLevel)
+		return false;
+
+	lodLevel = level;
+	selected = graph->selected();
+	if (level < 0) {
+		setSchedData(lodTask);
+	} else {
+		lodTask->getLODData(level, keys, values);
+		graph->setData(keys, values, true);
+	}
+
+	/* A selection must be extended to cover the new data */
+	if (selected && graph->dataCount() > 0) {
+		QCPDataRange wholeRange(0, graph->dataCount() - 1);
+		graph->setSelection(QCPDataSelection(wholeRange));
+	}
+	return true;
 }
 
 TaskGraph *TaskGraph::fromQCPGraph(QCPGraph *g)
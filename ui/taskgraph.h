@@ -57,6 +57,8 @@
 #include <QVector>
 #include <QMap>
 
+class AbstractTask;
+class CPUTask;
 class LegendGraph;
 class Task;
 class QCustomPlot;
@@ -79,9 +81,9 @@ public:
 	void setPen(const QPen &pen);
 	bool addToLegend();
 	bool removeFromLegend() const;
-	void setData(const QVector<double > &keys,
-		     const QVector<double> &values,
-		     bool alreadySorted = false);
+	void setSchedData(const AbstractTask *schedTask);
+	void setSchedLOD(CPUTask *cpuTask);
+	bool updateLOD(double pixelWidth);
 	static TaskGraph *fromQCPGraph(QCPGraph *g);
 	static void clearMap();
 	QCPGraph *getQCPGraph();
@@ -96,6 +98,8 @@ private:
 	QCPGraph *legendGraph;
 	unsigned int cpu;
 	enum GraphType graph_type;
+	CPUTask *lodTask;
+	int lodLevel;
 	static QMap<QCPGraph *, TaskGraph *> graphDir;
 };
 
@@ -51,10 +51,9 @@
  */
 
 #include "vtl/avltree.h"
-#include "vtl/heapsort.h"
-#include "vtl/tlist.h"
 
 #include "ui/taskmodel.h"
+#include "ui/tasksortview.h"
 #include "misc/traceshark.h"
 #include "analyzer/task.h"
 
@@ -63,7 +62,7 @@ static const char swappername[] = "swapper";
 TaskModel::TaskModel(QObject *parent):
 	AbstractTaskModel(parent)
 {
-	taskList = new vtl::TList<const Task*>;
+	taskList = new TaskSortView(TaskSortView::SORT_NAME);
 	errorStr = new QString(tr("Error in taskmodel.cpp"));
 	idleTask = new Task;
 	idleTask->pid = 0;
@@ -81,31 +80,13 @@ TaskModel::~TaskModel()
 void TaskModel::setTaskMap(vtl::AVLTree<int, TaskHandle> *map,
 			   unsigned int /*nrcpus*/)
 {
-	taskList->clear();
-
-	if (map == nullptr)
+	if (map == nullptr) {
+		taskList->clear();
 		return;
-
-	DEFINE_TASKMAP_ITERATOR(iter) = map->begin();
-	while (iter != map->end()) {
-		Task *task = iter.value().task;
-		taskList->append(task);
-		iter++;
 	}
 
 	/* Add a fake idle task for event filtering purposes */
-	taskList->append(idleTask);
-
-	vtl::heapsort<vtl::TList, const Task*>(
-		*taskList, [] (const Task *&a, const Task *&b) -> int {
-			const QString &as = *a->displayName;
-			const QString &bs = *b->displayName;
-			int cmp1 = as.compare(bs);
-			if (cmp1 != 0)
-				return cmp1;
-			long cmp2 = (long) a->pid - (long) b->pid;
-			return (int) cmp2;
-		});
+	taskList->update(map, idleTask);
 }
 
 int TaskModel::rowCount(const QModelIndex & /* index */) const
@@ -0,0 +1,183 @@
+// SPDX-License-Identifier: (GPL-2.0-or-later OR BSD-2-Clause)
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2020  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "threads/parallelsort.h"
+#include "ui/tasksortview.h"
+#include "misc/traceshark.h"
+
+TaskSortView::TaskSortView(sort_t kind, bool nonzero):
+	sortKind(kind), onlyNonZero(nonzero), extraTask(nullptr)
+{}
+
+void TaskSortView::clear()
+{
+	tasks.clear();
+	scratch.clear();
+	nameOrder.clear();
+	nameRank.clear();
+	metrics.clear();
+	entries.clear();
+}
+
+void TaskSortView::update(vtl::AVLTree<int, TaskHandle> *map,
+			  const Task *extra)
+{
+	int i, n;
+
+	if (map == nullptr) {
+		clear();
+		return;
+	}
+
+	extraTask = extra;
+	scratch.clear();
+	scratch.reserve(tasks.size());
+	DEFINE_TASKMAP_ITERATOR(iter) = map->begin();
+	while (iter != map->end()) {
+		scratch.append(iter.value().task);
+		iter++;
+	}
+	if (extra != nullptr)
+		scratch.append(extra);
+
+	/*
+	 * The display names are generated when the trace is analyzed and do
+	 * not change after that, so the name ranks only need to be recomputed
+	 * if we have been given a different set of tasks.
+	 */
+	if (scratch != tasks) {
+		tasks.swap(scratch);
+		sortNames();
+		metrics.clear();
+		entries.clear();
+	}
+
+	n = tasks.size();
+	if (sortKind == SORT_NAME) {
+		if (entries.size() == n)
+			return;
+		entries.resize(n);
+		for (i = 0; i < n; i++) {
+			Entry &e = entries[i];
+			e.index = nameOrder.at(i);
+			e.rank = i;
+		}
+		return;
+	}
+
+	if (metrics.size() == n) {
+		for (i = 0; i < n; i++) {
+			if (!(metrics.at(i) == metricOf(tasks.at(i))))
+				break;
+		}
+		if (i == n)
+			return;
+	}
+	sortMetric();
+}
+
+void TaskSortView::sortNames()
+{
+	const QVector<const Task*> &t = tasks;
+	int i, n;
+
+	n = tasks.size();
+	nameOrder.resize(n);
+	nameRank.resize(n);
+	for (i = 0; i < n; i++)
+		nameOrder[i] = i;
+
+	parallel_sort(nameOrder.data(), nameOrder.data() + n,
+		      [&t] (int a, int b) -> bool {
+			      const Task *ta = t.at(a);
+			      const Task *tb = t.at(b);
+			      int cmp = ta->displayName->compare(
+				      *tb->displayName);
+			      if (cmp != 0)
+				      return cmp < 0;
+			      return ta->pid < tb->pid;
+		      });
+
+	for (i = 0; i < n; i++)
+		nameRank[nameOrder.at(i)] = i;
+}
+
+void TaskSortView::sortMetric()
+{
+	int i, n;
+
+	n = tasks.size();
+	metrics.resize(n);
+	entries.clear();
+	entries.reserve(n);
+	for (i = 0; i < n; i++) {
+		vtl::Time m = metricOf(tasks.at(i));
+		metrics[i] = m;
+		if (onlyNonZero && m.isZero() && tasks.at(i) != extraTask)
+			continue;
+		Entry e;
+		e.metric = m;
+		e.rank = nameRank.at(i);
+		e.index = i;
+		entries.append(e);
+	}
+
+	/* Largest metric first, ties are broken by the name order */
+	parallel_sort(entries.data(), entries.data() + entries.size(),
+		      [] (const Entry &a, const Entry &b) -> bool {
+			      if (a.metric > b.metric)
+				      return true;
+			      if (a.metric < b.metric)
+				      return false;
+			      return a.rank < b.rank;
+		      });
+}
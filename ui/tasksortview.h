@@ -0,0 +1,122 @@
+// SPDX-License-Identifier: (GPL-2.0-or-later OR BSD-2-Clause)
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2020  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TASKSORTVIEW_H
+#define TASKSORTVIEW_H
+
+#include <QVector>
+
+#include "analyzer/task.h"
+#include "vtl/avltree.h"
+#include "vtl/compiler.h"
+#include "vtl/time.h"
+
+/*
+ * A sorted view of the tasks in a task map. The view is a permutation of the
+ * tasks, so nothing is copied, and the ordering by name is computed only when
+ * the set of tasks changes. The sort is keyed by a precomputed name rank, so
+ * that sorting by a time metric compares two integers and two times, instead
+ * of two QStrings. With nonzero set, tasks whose metric is zero are left out
+ * of the view, except for the extra task, which is always included. If
+ * neither the tasks nor their metrics have changed since the last update, then
+ * the previous order is kept as it is.
+ */
+class TaskSortView {
+public:
+	typedef enum : int {
+		SORT_NAME = 0,
+		SORT_ACCTIME,
+		SORT_CURSORTIME
+	} sort_t;
+	TaskSortView(sort_t kind, bool nonzero = false);
+	void update(vtl::AVLTree<int, TaskHandle> *map, const Task *extra);
+	void clear();
+	vtl_always_inline int size() const;
+	vtl_always_inline const Task *at(int row) const;
+private:
+	class Entry {
+	public:
+		vtl::Time metric;
+		int rank;
+		int index;
+	};
+	void sortNames();
+	void sortMetric();
+	vtl_always_inline const vtl::Time &metricOf(const Task *task) const;
+	sort_t sortKind;
+	bool onlyNonZero;
+	const Task *extraTask;
+	QVector<const Task*> tasks;
+	QVector<const Task*> scratch;
+	QVector<int> nameOrder;
+	QVector<int> nameRank;
+	QVector<vtl::Time> metrics;
+	QVector<Entry> entries;
+};
+
+vtl_always_inline int TaskSortView::size() const
+{
+	return entries.size();
+}
+
+vtl_always_inline const Task *TaskSortView::at(int row) const
+{
+	return tasks.at(entries.at(row).index);
+}
+
+vtl_always_inline const vtl::Time &TaskSortView::metricOf(const Task *task)
+	const
+{
+	return sortKind == SORT_CURSORTIME ? task->cursorTime : task->accTime;
+}
+
+#endif /* TASKSORTVIEW_H */
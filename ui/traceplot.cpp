@@ -50,14 +50,72 @@
  *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <QHelpEvent>
+
+#include "ui/plotoverlay.h"
+#include "ui/plottilecache.h"
 #include "ui/traceplot.h"
 
+/*
+ * The plottables are on the main layer, which is drawn through the tile
+ * cache, so that panning the plot does not need to draw all of them again.
+ */
 TracePlot::TracePlot(QWidget *parent):
-	QCustomPlot(parent)
-{}
+	QCustomPlot(parent), overlay(nullptr)
+{
+	tileCache = new PlotTileCache(this);
+	layer(QString("main"))->setRenderer(tileCache);
+}
+
+TracePlot::~TracePlot()
+{
+	delete overlay;
+}
+
+/*
+ * The overlay layer gets its own paint buffer, so that it can be replotted
+ * without the layers below it, when e.g. a cursor is moved. It also draws the
+ * selected plottables of the main layer.
+ */
+void TracePlot::setOverlayLayer(QCPLayer *overlayLayer)
+{
+	if (overlay == nullptr)
+		overlay = new PlotOverlay(layer(QString("main")), tileCache);
+	overlayLayer->setMode(QCPLayer::lmBuffered);
+	overlayLayer->setRenderer(overlay);
+}
 
 QCPLayerable *TracePlot::getLayerableAt(const QPointF &pos, bool onlySelectable,
 					QVariant *selectionDetails)
 {
 	return QCustomPlot::layerableAt(pos, onlySelectable, selectionDetails);
 }
+
+/* A size of zero disables the tile cache */
+void TracePlot::setTileCacheSize(qint64 bytes)
+{
+	tileCache->setMaxSize(bytes);
+}
+
+/*
+ * The text of a tooltip depends on what is plotted at the position, which
+ * only the owner of the plot knows, so it is asked for it with a signal.
+ */
+bool TracePlot::event(QEvent *event)
+{
+	if (event->type() == QEvent::ToolTip) {
+		QHelpEvent *helpEvent = static_cast<QHelpEvent*>(event);
+		emit toolTipRequested(helpEvent->pos(), helpEvent->globalPos());
+		return true;
+	}
+	return QCustomPlot::event(event);
+}
+
+/*
+ * This needs to be called when the plottables have been changed in a way that
+ * the tile cache doesn't detect by itself.
+ */
+void TracePlot::invalidateTiles()
+{
+	tileCache->invalidate();
+}
@@ -55,6 +55,9 @@
 
 #include "ui/qcustomplot.h"
 
+class PlotOverlay;
+class PlotTileCache;
+
 class TracePlot : public QCustomPlot
 {
 	Q_OBJECT
@@ -62,6 +65,17 @@ public:
 	TracePlot(QWidget *parent = 0);
 	QCPLayerable *getLayerableAt(const QPointF &pos, bool onlySelectable,
 				     QVariant *selectionDetails = 0);
+	~TracePlot();
+	void setOverlayLayer(QCPLayer *overlayLayer);
+	void setTileCacheSize(qint64 bytes);
+	void invalidateTiles();
+signals:
+	void toolTipRequested(const QPoint &pos, const QPoint &globalPos);
+protected:
+	bool event(QEvent *event);
+private:
+	PlotTileCache *tileCache;
+	PlotOverlay *overlay;
 };
 
 #endif /* TRACEPLOT_H */
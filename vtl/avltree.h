@@ -200,6 +200,7 @@ public:
 	vtl_always_inline iterator findInsert(const T &key, bool &newEntry);
 
 	void clear();
+	vtl_always_inline void swap(AVLTree<T, U, BALANCE, ALLOC, CF> &other);
 	vtl_always_inline iterator begin() const;
 	vtl_always_inline iterator end() const;
 	protected:
@@ -1021,6 +1022,16 @@ void AVLTree<T, U, BALANCE, ALLOC, CF>::clear()
 	}
 }
 
+template <class T, class U, avlbalance_t BALANCE, typename ALLOC, typename CF>
+vtl_always_inline void
+AVLTree<T, U, BALANCE, ALLOC, CF>::swap(AVLTree<T, U, BALANCE, ALLOC,
+					CF> &other)
+{
+	std::swap(root, other.root);
+	std::swap(size_, other.size_);
+	std::swap(alloc, other.alloc);
+}
+
 }
 
 #endif /* VTL_AVLTREE_H */
@@ -1,7 +1,7 @@
 // SPDX-License-Identifier: (GPL-2.0-or-later OR BSD-2-Clause)
 /*
  * Traceshark - a visualizer for visualizing ftrace and perf traces
- * Copyright (C) 2014, 2015, 2016  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ * Copyright (C) 2020  Viktor Rosendahl <viktor.rosendahl@gmail.com>
  *
  * This file is dual licensed: you can use it either under the terms of
  * the GPL, or the BSD license, at your option.
@@ -50,14 +50,27 @@
  *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include "analyzer/cpufreq.h"
+#include "vtl/bitmap.h"
 
-bool CpuFreq::doScale()
+namespace vtl {
+
+BitMap::BitMap() :
+nrBits(0)
+{}
+
+/* This will also clear all bits */
+void BitMap::resize(unsigned int nrBits_)
+{
+	unsigned int nrWords_ = (nrBits_ + BITS_PER_WORD - 1) / BITS_PER_WORD;
+
+	array.fill(0, nrWords_);
+	nrBits = nrBits_;
+}
+
+void BitMap::clear()
 {
-	int i;
-	int s = data.size();
-	scaledData.resize(s);
-	for (i = 0; i < s; i++)
-		scaledData[i] = data[i] * scale + offset;
-	return false; /* No error */	
+	QVector<word_t>().swap(array);
+	nrBits = 0;
+}
+
 }
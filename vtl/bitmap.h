@@ -0,0 +1,167 @@
+// SPDX-License-Identifier: (GPL-2.0-or-later OR BSD-2-Clause)
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2020  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _VTL_BITMAP_H
+#define _VTL_BITMAP_H
+
+#include <cstdint>
+#include <QVector>
+#include "vtl/compiler.h"
+
+namespace vtl {
+
+/*
+ * A fixed size bitmap, which unlike the BitVector is meant to be accessed
+ * a word at a time. Different words may be written by different threads
+ * concurrently, as long as the size is not changed.
+ */
+class BitMap
+{
+public:
+	typedef uint64_t word_t;
+	static const unsigned int BITS_PER_WORD = sizeof(word_t) * 8;
+	BitMap();
+	void resize(unsigned int nrBits);
+	void clear();
+	vtl_always_inline unsigned int size() const;
+	vtl_always_inline unsigned int nrWords() const;
+	vtl_always_inline bool test(unsigned int index) const;
+	vtl_always_inline void set(unsigned int index);
+	vtl_always_inline word_t word(unsigned int windex) const;
+	vtl_always_inline void setWord(unsigned int windex, word_t word);
+	static vtl_always_inline word_t rangeMask(unsigned int windex,
+						  unsigned int begin,
+						  unsigned int end);
+	static vtl_always_inline unsigned int popcount(word_t word);
+private:
+	unsigned int nrBits;
+	QVector<word_t> array;
+};
+
+vtl_always_inline unsigned int BitMap::size() const
+{
+	return nrBits;
+}
+
+vtl_always_inline unsigned int BitMap::nrWords() const
+{
+	return array.size();
+}
+
+/* Returns false for indices that are outside of the bitmap */
+vtl_always_inline bool BitMap::test(unsigned int index) const
+{
+	unsigned int windex = index / BITS_PER_WORD;
+	unsigned int bitnr = index % BITS_PER_WORD;
+
+	if (index >= nrBits)
+		return false;
+	return ((array[windex] >> bitnr) & 0x1) != 0;
+}
+
+vtl_always_inline void BitMap::set(unsigned int index)
+{
+	unsigned int windex = index / BITS_PER_WORD;
+	unsigned int bitnr = index % BITS_PER_WORD;
+
+	array[windex] |= ((word_t) 0x1) << bitnr;
+}
+
+vtl_always_inline BitMap::word_t BitMap::word(unsigned int windex) const
+{
+	return array[windex];
+}
+
+vtl_always_inline void BitMap::setWord(unsigned int windex, word_t word)
+{
+	array[windex] = word;
+}
+
+/*
+ * Returns a mask for the word with index windex, where the bits that
+ * correspond to indices in the interval [begin, end) are set
+ */
+vtl_always_inline BitMap::word_t BitMap::rangeMask(unsigned int windex,
+						   unsigned int begin,
+						   unsigned int end)
+{
+	unsigned int wbegin = windex * BITS_PER_WORD;
+	unsigned int wend = wbegin + BITS_PER_WORD;
+	word_t mask = ~((word_t) 0);
+
+	if (begin >= wend || end <= wbegin || begin >= end)
+		return 0;
+	if (begin > wbegin)
+		mask &= mask << (begin - wbegin);
+	if (end < wend)
+		mask &= ~((~((word_t) 0)) << (end - wbegin));
+	return mask;
+}
+
+vtl_always_inline unsigned int BitMap::popcount(word_t word)
+{
+#if defined(__GNUC__) || defined (__clang__)
+	return __builtin_popcountll(word);
+#else
+	unsigned int count = 0;
+
+	while (word != 0) {
+		word &= word - 1;
+		count++;
+	}
+	return count;
+#endif
+}
+
+}
+
+#endif /* _VTL_BITMAP_H */
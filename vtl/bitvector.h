@@ -61,17 +61,18 @@ namespace vtl {
 class BitVector
 {
 public:
+	typedef unsigned int word_t;
 	BitVector();
 	vtl_always_inline bool readbool(unsigned int index) const;
 	vtl_always_inline void appendbool(bool value);
 	vtl_always_inline unsigned int read(unsigned int index) const;
 	vtl_always_inline void append(unsigned int value);
 	vtl_always_inline unsigned int size() const;
+	vtl_always_inline const QVector<word_t> &words() const;
 	void clear();
 	void softclear();
 private:
 	static const unsigned int INCREASE_NR = 1024;
-	typedef unsigned int word_t;
 	static const unsigned int BITVECTOR_BITS_PER_WORD = sizeof(word_t)
 		* 8;
 	unsigned int nrElements;
@@ -145,6 +146,15 @@ vtl_always_inline unsigned int BitVector::size() const
 	return nrElements;
 }
 
+/*
+ * Element i is stored in bit (i % BITVECTOR_BITS_PER_WORD) of word
+ * (i / BITVECTOR_BITS_PER_WORD). The vector may have more words than needed.
+ */
+vtl_always_inline const QVector<BitVector::word_t> &BitVector::words() const
+{
+	return array;
+}
+
 }
 
 #endif /* _BITVECTOR_H */
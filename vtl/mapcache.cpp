@@ -0,0 +1,363 @@
+// SPDX-License-Identifier: (GPL-2.0-or-later OR BSD-2-Clause)
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2020  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+
+extern "C" {
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+}
+
+#include <QAtomicInt>
+
+#include "vtl/error.h"
+#include "vtl/mapcache.h"
+
+#define MAPCACHE_DEFAULT_MAXSIZE ((size_t) 1024 * 1024 * 1024)
+#define MAPCACHE_DEFAULT_HUGEPAGESIZE ((size_t) 2 * 1024 * 1024)
+
+/* From linux/mempolicy.h, which we don't want to depend on */
+#define MAPCACHE_MPOL_INTERLEAVE (3)
+/* The nodes that fit in the mask that we pass to mbind() */
+#define MAPCACHE_MAX_NUMA_NODES (sizeof(unsigned long) * CHAR_BIT)
+#define MAPCACHE_NODE_ONLINE "/sys/devices/system/node/online"
+
+namespace vtl {
+
+QMutex MapCache::mutex;
+QList<MapCache::Entry> MapCache::entries;
+size_t MapCache::cachedSize = 0;
+size_t MapCache::maxSize = MAPCACHE_DEFAULT_MAXSIZE;
+unsigned int MapCache::flags = MapCache::FLAG_NONE;
+
+/*
+ * Returns a map of len bytes, or MAP_FAILED, in which case errno is set, just
+ * like mmap().
+ */
+void *MapCache::map(size_t len)
+{
+	int i;
+	void *addr;
+	unsigned int f;
+
+	mutex.lock();
+	/* The most recently returned map is the most likely to be resident */
+	for (i = entries.size() - 1; i >= 0; i--) {
+		if (entries[i].len == len) {
+			addr = entries[i].addr;
+			entries.removeAt(i);
+			cachedSize -= len;
+			mutex.unlock();
+			return addr;
+		}
+	}
+	f = flags;
+	mutex.unlock();
+
+	return newMap(len, f);
+}
+
+void *MapCache::newMap(size_t len, unsigned int f)
+{
+	void *addr;
+	static const size_t hsize = hugePageSize();
+	const bool huge = len >= hsize;
+
+#ifdef MAP_HUGETLB
+	/*
+	 * The length of a hugetlb map must be a multiple of the huge page size,
+	 * otherwise munmap() would fail. If no huge pages have been reserved,
+	 * then mmap() fails and we fall back to normal pages.
+	 */
+	if ((f & FLAG_EXPLICIT_HUGE) && huge && len % hsize == 0) {
+		addr = mmap(nullptr, len, PROT_READ | PROT_WRITE,
+			    MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if (addr != MAP_FAILED) {
+			if ((f & FLAG_NUMA_INTERLEAVE) &&
+			    !interleave(addr, len))
+				interleaveWarn();
+			return addr;
+		}
+	}
+#endif
+
+	addr = mmap(nullptr, len, PROT_READ | PROT_WRITE,
+		    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (addr == MAP_FAILED)
+		return addr;
+
+#ifdef MADV_HUGEPAGE
+	/* This fails if the kernel doesn't support transparent huge pages */
+	if ((f & FLAG_TRANSPARENT_HUGE) && huge)
+		madvise(addr, len, MADV_HUGEPAGE);
+#endif
+	if ((f & FLAG_NUMA_INTERLEAVE) && !interleave(addr, len))
+		interleaveWarn();
+	return addr;
+}
+
+/*
+ * Sets the NUMA policy of a new map, so that its pages are spread over the
+ * online nodes when they are faulted in. This is done with the raw system
+ * call, so that we don't need to depend on libnuma. Returns false if mbind()
+ * failed, in which case errno is set. With less than two nodes online, there
+ * is nothing to interleave over and nothing is done.
+ */
+bool MapCache::interleave(void *addr, size_t len)
+{
+#ifdef SYS_mbind
+	static const unsigned long nodemask = onlineNodes();
+
+	if ((nodemask & (nodemask - 1)) == 0)
+		return true;
+	/* The kernel only looks at the first maxnode - 1 bits of the mask */
+	return syscall(SYS_mbind, addr, len, MAPCACHE_MPOL_INTERLEAVE,
+		       &nodemask, (unsigned long) MAPCACHE_MAX_NUMA_NODES + 1,
+		       0U) == 0;
+#else
+	(void) addr;
+	(void) len;
+	return true;
+#endif
+}
+
+/*
+ * Warns that a map could not be interleaved. This is only done once, since it
+ * is likely to fail in the same way for every map.
+ */
+void MapCache::interleaveWarn()
+{
+	static QAtomicInt warned(0);
+	int e = errno;
+
+	if (warned.testAndSetRelaxed(0, 1))
+		vtl::warn(e, "mbind() failed, the memory will not be "
+			  "interleaved over the NUMA nodes");
+}
+
+/*
+ * Returns the mask of the online NUMA nodes, from a list like "0-3,6". The
+ * nodes that don't fit in the mask are left out. Returns 0 if the list cannot
+ * be read.
+ */
+unsigned long MapCache::onlineNodes()
+{
+	unsigned long mask = 0;
+	unsigned long first, last, node;
+	char line[256];
+	char *p, *end;
+	FILE *fp;
+
+	fp = fopen(MAPCACHE_NODE_ONLINE, "r");
+	if (fp == nullptr)
+		return 0;
+	p = fgets(line, sizeof(line), fp);
+	fclose(fp);
+	if (p == nullptr)
+		return 0;
+
+	while (true) {
+		first = strtoul(p, &end, 10);
+		if (end == p)
+			break;
+		last = first;
+		p = end;
+		if (*p == '-') {
+			last = strtoul(p + 1, &end, 10);
+			if (end == p + 1)
+				break;
+			p = end;
+		}
+		for (node = first; node <= last &&
+			     node < MAPCACHE_MAX_NUMA_NODES; node++)
+			mask |= 1UL << node;
+		if (*p != ',')
+			break;
+		p++;
+	}
+	return mask;
+}
+
+/* Returns the default huge page size, as reported in /proc/meminfo */
+size_t MapCache::hugePageSize()
+{
+	size_t hsize = MAPCACHE_DEFAULT_HUGEPAGESIZE;
+	FILE *fp;
+	char line[128];
+	unsigned long kbytes;
+
+	fp = fopen("/proc/meminfo", "r");
+	if (fp == nullptr)
+		return hsize;
+	while (fgets(line, sizeof(line), fp) != nullptr) {
+		if (sscanf(line, "Hugepagesize: %lu kB", &kbytes) == 1) {
+			if (kbytes > 0)
+				hsize = (size_t) kbytes * 1024;
+			break;
+		}
+	}
+	fclose(fp);
+	return hsize;
+}
+
+/*
+ * Returns a map that was obtained with map(). The return value is the same as
+ * for munmap().
+ */
+int MapCache::unmap(void *addr, size_t len)
+{
+	QList<Entry> evicted;
+	Entry entry;
+
+#ifdef MADV_FREE
+	/*
+	 * This fails on kernels older than 4.5, in that case the pages will
+	 * stay resident until the map is reused or evicted.
+	 */
+	madvise(addr, len, MADV_FREE);
+#endif
+	entry.addr = addr;
+	entry.len = len;
+
+	mutex.lock();
+	if (len > maxSize) {
+		mutex.unlock();
+		return munmap(addr, len);
+	}
+	evict(len, evicted);
+	entries.append(entry);
+	cachedSize += len;
+	mutex.unlock();
+
+	unmapEvicted(evicted);
+	return 0;
+}
+
+void MapCache::setMaxSize(size_t bytes)
+{
+	QList<Entry> evicted;
+
+	mutex.lock();
+	maxSize = bytes;
+	evict(0, evicted);
+	mutex.unlock();
+
+	unmapEvicted(evicted);
+}
+
+size_t MapCache::getMaxSize()
+{
+	return maxSize;
+}
+
+/*
+ * Sets the flags for maps that are created from now on. Maps that are already
+ * in the cache are not affected.
+ */
+void MapCache::setFlags(unsigned int f)
+{
+	mutex.lock();
+	flags = f;
+	mutex.unlock();
+}
+
+unsigned int MapCache::getFlags()
+{
+	unsigned int f;
+
+	mutex.lock();
+	f = flags;
+	mutex.unlock();
+	return f;
+}
+
+/* Unmaps all cached maps */
+void MapCache::flush()
+{
+	QList<Entry> evicted;
+
+	mutex.lock();
+	evicted.swap(entries);
+	cachedSize = 0;
+	mutex.unlock();
+
+	unmapEvicted(evicted);
+}
+
+/*
+ * Removes the oldest entries until there is room for len bytes. The mutex must
+ * be held by the caller.
+ */
+void MapCache::evict(size_t len, QList<Entry> &evicted)
+{
+	while (!entries.isEmpty() && cachedSize + len > maxSize) {
+		const Entry &entry = entries.first();
+		cachedSize -= entry.len;
+		evicted.append(entry);
+		entries.removeFirst();
+	}
+}
+
+void MapCache::unmapEvicted(const QList<Entry> &evicted)
+{
+	int i;
+
+	for (i = 0; i < evicted.size(); i++) {
+		if (munmap(evicted[i].addr, evicted[i].len) != 0)
+			munmap_err();
+	}
+}
+
+}
@@ -0,0 +1,123 @@
+// SPDX-License-Identifier: (GPL-2.0-or-later OR BSD-2-Clause)
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2020  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef VTL_MAPCACHE_H
+#define VTL_MAPCACHE_H
+
+#include <cstddef>
+#include <QList>
+#include <QMutex>
+
+#include "vtl/compiler.h"
+
+namespace vtl {
+
+/*
+ * A process wide cache of anonymous memory maps. The TList, MemPool and
+ * LoadBuffer classes get their memory from here and return it here, instead of
+ * calling mmap() and munmap() directly. A returned map is kept, as long as the
+ * total size of the cache stays below the maximum size, and is handed out again
+ * when a map of the same size is requested. This way, when a trace is closed
+ * and a similarly sized trace is opened, most of the memory does not need to be
+ * mapped and faulted in again.
+ *
+ * The cached maps are marked with MADV_FREE, so that the kernel can reclaim
+ * them if it runs short of memory. This means that the contents of a map from
+ * map() are undefined, it may or may not contain stale data.
+ *
+ * New maps that are large enough can optionally be backed by huge pages, in
+ * order to reduce the TLB misses when large event lists are scanned, and be
+ * interleaved over the online NUMA nodes, so that the threads that scan them
+ * do not find all of the memory on a remote node.
+ */
+class MapCache
+{
+public:
+	typedef enum Flag : unsigned int {
+		FLAG_NONE               = 0,
+		/* Use MADV_HUGEPAGE */
+		FLAG_TRANSPARENT_HUGE   = 1,
+		/* Use MAP_HUGETLB, falls back to the other flags on failure */
+		FLAG_EXPLICIT_HUGE      = 2,
+		/* Use an interleaving NUMA policy */
+		FLAG_NUMA_INTERLEAVE    = 4,
+	} flag_t;
+	static void *map(size_t len);
+	static int unmap(void *addr, size_t len);
+	static void setMaxSize(size_t bytes);
+	static size_t getMaxSize();
+	static void setFlags(unsigned int f);
+	static unsigned int getFlags();
+	static void flush();
+private:
+	class Entry {
+	public:
+		void *addr;
+		size_t len;
+	};
+	static void evict(size_t len, QList<Entry> &evicted);
+	static void unmapEvicted(const QList<Entry> &evicted);
+	static void *newMap(size_t len, unsigned int f);
+	static size_t hugePageSize();
+	static bool interleave(void *addr, size_t len);
+	static void interleaveWarn();
+	static unsigned long onlineNodes();
+	static QMutex mutex;
+	static QList<Entry> entries;
+	static size_t cachedSize;
+	static size_t maxSize;
+	static unsigned int flags;
+};
+
+}
+
+#endif /* VTL_MAPCACHE_H */
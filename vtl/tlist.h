@@ -62,6 +62,7 @@ extern "C" {
 
 #include "vtl/compiler.h"
 #include "vtl/error.h"
+#include "vtl/mapcache.h"
 
 namespace vtl {
 
@@ -159,9 +160,7 @@ template<class T>
 void TList<T>::setupMem()
 {
 	int maxNrMaps = mapFromIndex(TLIST_MAP_MASK) + 1;
-	mapArray = (T**) mmap(nullptr, (size_t) maxNrMaps * sizeof(T*),
-			     PROT_READ | PROT_WRITE,
-			     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	mapArray = (T**) MapCache::map((size_t) maxNrMaps * sizeof(T*));
 	if (unlikely(mapArray == MAP_FAILED))
 		mmap_err();
 	addMem();
@@ -170,9 +169,8 @@ void TList<T>::setupMem()
 template<class T>
 void TList<T>::addMem()
 {
-	mapArray[nrMaps] = (T*) mmap(nullptr, (size_t) TLIST_MAP_NR_ELEMENTS *
-				sizeof(T), PROT_READ | PROT_WRITE,
-				MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	mapArray[nrMaps] = (T*) MapCache::map((size_t) TLIST_MAP_NR_ELEMENTS *
+					      sizeof(T));
 	if (unlikely(mapArray[nrMaps] == MAP_FAILED))
 		mmap_err();
 	nrMaps++;
@@ -184,7 +182,8 @@ void TList<T>::decMem()
 	int r;
 
 	nrMaps--;
-	r = munmap(mapArray[nrMaps], TLIST_MAP_NR_ELEMENTS * sizeof(T));
+	r = MapCache::unmap(mapArray[nrMaps],
+			    TLIST_MAP_NR_ELEMENTS * sizeof(T));
 	if (unlikely(r != 0))
 		munmap_err();
 }
@@ -197,11 +196,12 @@ void TList<T>::clearAll()
 	int r;
 
 	for (i = 0; i < nrMaps; i++) {
-		r = munmap(mapArray[i], TLIST_MAP_NR_ELEMENTS * sizeof(T));
+		r = MapCache::unmap(mapArray[i],
+				    TLIST_MAP_NR_ELEMENTS * sizeof(T));
 		if (unlikely(r != 0))
 			munmap_err();
 	}
-	r = munmap(mapArray, maxNrMaps * sizeof(T*));
+	r = MapCache::unmap(mapArray, maxNrMaps * sizeof(T*));
 	if (unlikely(r != 0))
 		munmap_err();
 	nrMaps = 0;